@@ -0,0 +1,51 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/buffer.hpp"
+#include "hlib/test.hpp"
+
+using namespace hlib;
+
+HLIB_BENCHMARK("Buffer Append", "[buffer]")
+{
+    char const data[64]{};
+    Buffer buffer;
+    buffer.reserve(sizeof(data) * 1024);
+
+    state.setBytesProcessed(sizeof(data));
+    while (true == state.keepRunning()) {
+        if (buffer.size() + sizeof(data) > buffer.capacity()) {
+            buffer.clear();
+        }
+        buffer.append(data, sizeof(data));
+        test::do_not_optimize(buffer.data());
+    }
+}
+
+HLIB_BENCHMARK("Buffer Reserve", "[buffer]")
+{
+    while (true == state.keepRunning()) {
+        Buffer buffer;
+        test::do_not_optimize(buffer.reserve(4096));
+    }
+}
@@ -0,0 +1,64 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/connection_pool.hpp"
+#include "hlib/file.hpp"
+#include "hlib/test.hpp"
+#include <sys/socket.h>
+
+using namespace hlib;
+
+HLIB_BENCHMARK("ConnectionPool Checkout Release", "[connection_pool]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+
+    Handle<int, -1> listener(socket(AF_INET, SOCK_STREAM, 0), file::fd_close);
+    SockAddr address("127.0.0.1:0");
+    HVERIFY(0 == bind(listener.get(), static_cast<sockaddr const*>(address), address.length()));
+    HVERIFY(0 == listen(listener.get(), 1));
+
+    sockaddr_storage storage{};
+    socklen_t length = sizeof(storage);
+    HVERIFY(0 == getsockname(listener.get(), reinterpret_cast<sockaddr*>(&storage), &length));
+    address = storage;
+
+    ConnectionPool pool(event_loop);
+    Handle<int, -1> connection(file::fd_close);
+
+    auto on_checkout = [&](Handle<int, -1> fd, int /* error */) noexcept {
+        connection = std::move(fd);
+    };
+
+    pool.checkout(address, on_checkout);
+    while (-1 == connection.get()) {
+        event_loop->dispatch(time::Duration(time::MSec(1)));
+    }
+
+    ConnectionPool::OnCheckout callback(on_checkout);
+
+    while (true == state.keepRunning()) {
+        pool.release(address, std::move(connection));
+        pool.checkout(address, callback);
+    }
+    test::do_not_optimize(pool.metrics().reused);
+}
@@ -0,0 +1,45 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/cpu.hpp"
+#include "hlib/test.hpp"
+
+using namespace hlib;
+
+HLIB_BENCHMARK("CPUMonitor Update", "[cpu]")
+{
+    CPUMonitor cpu_monitor;
+    HVERIFY(true == cpu_monitor.initialize().success());
+
+    while (true == state.keepRunning()) {
+        HVERIFY(true == cpu_monitor.update().success());
+    }
+    test::do_not_optimize(cpu_monitor.busy());
+}
+
+HLIB_BENCHMARK("CPU Thread Usage", "[cpu]")
+{
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(cpu_get_thread_usage().value().user);
+    }
+}
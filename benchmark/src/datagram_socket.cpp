@@ -0,0 +1,62 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/datagram_socket.hpp"
+#include "hlib/test.hpp"
+
+using namespace hlib;
+
+HLIB_BENCHMARK("DatagramSocket Batch 64", "[datagram_socket]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+
+    DatagramSocket server(event_loop, 64, 256);
+    server.open(SockAddr("127.0.0.1:0"), 0, 0);
+
+    DatagramSocket client(event_loop, 64, 256);
+    client.open(SockAddr("127.0.0.1:0"), 0, 0);
+
+    std::uint8_t payload[200] = {};
+    std::vector<DatagramSocket::Datagram> datagrams(64);
+    for (DatagramSocket::Datagram& datagram : datagrams) {
+        datagram.data = payload;
+        datagram.size = sizeof(payload);
+        datagram.address = server.getLocalAddress();
+    }
+
+    std::size_t received = 0;
+    server.receive([&](DatagramSocket::Datagram const* /* datagrams */, std::size_t count) noexcept {
+        received += count;
+    });
+
+    while (true == state.keepRunning()) {
+        HVERIFY(datagrams.size() == client.send(datagrams.data(), datagrams.size()));
+
+        received = 0;
+        while (received < datagrams.size()) {
+            event_loop->dispatch(time::Duration(0));
+        }
+    }
+
+    state.setBytesProcessed(datagrams.size() * sizeof(payload));
+}
@@ -0,0 +1,54 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/event_loop.hpp"
+#include "hlib/test.hpp"
+#include <unistd.h>
+
+using namespace hlib;
+
+HLIB_BENCHMARK("EventLoop Dispatch", "[event_loop]")
+{
+    int fds[2];
+    HVERIFY(0 == pipe(fds));
+
+    EventLoop event_loop;
+    std::uint64_t count{ 0 };
+
+    event_loop.add(fds[0], EventLoop::Read, [&](int fd, std::uint32_t /* events */) {
+        char c;
+        HVERIFY(1 == read(fd, &c, 1));
+        ++count;
+    });
+
+    while (true == state.keepRunning()) {
+        char const c = 'x';
+        HVERIFY(1 == write(fds[1], &c, 1));
+        event_loop.dispatch(time::Duration(0));
+    }
+    test::do_not_optimize(count);
+
+    event_loop.remove(fds[0]);
+    close(fds[0]);
+    close(fds[1]);
+}
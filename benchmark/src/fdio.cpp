@@ -0,0 +1,126 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/event_loop.hpp"
+#include "hlib/fdio.hpp"
+#include "hlib/test.hpp"
+#include <cstdio>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace hlib;
+
+namespace
+{
+
+constexpr std::size_t file_size = 64 * 1024 * 1024;
+
+// Returns a temporary file of file_size bytes.
+FILE* make_file()
+{
+    std::string payload(1024 * 1024, '\0');
+    for (std::size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<char>('a' + i % 26);
+    }
+
+    FILE* file = tmpfile();
+    HVERIFY(nullptr != file);
+    for (std::size_t i = 0; i < file_size / payload.size(); ++i) {
+        HVERIFY(1 == fwrite(payload.data(), payload.size(), 1, file));
+    }
+    HVERIFY(0 == fflush(file));
+    return file;
+}
+
+void drain(int fd)
+{
+    char buffer[65536];
+    while (::read(fd, buffer, sizeof(buffer)) > 0) {
+    }
+}
+
+} // namespace
+
+HLIB_BENCHMARK("Relay Read Write", "[fdio]")
+{
+    FILE* file = make_file();
+
+    state.setBytesProcessed(file_size);
+    while (true == state.keepRunning()) {
+        HVERIFY(0 == lseek(fileno(file), 0, SEEK_SET));
+
+        int sockets[2];
+        HVERIFY(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+        std::thread reader(drain, sockets[1]);
+
+        char buffer[65536];
+        ssize_t length;
+        std::size_t transferred{ 0 };
+        while ((length = ::read(fileno(file), buffer, sizeof(buffer))) > 0) {
+            for (ssize_t offset = 0; offset < length;) {
+                offset += ::write(sockets[0], buffer + offset, length - offset);
+            }
+            transferred += length;
+        }
+
+        ::close(sockets[0]);
+        reader.join();
+        ::close(sockets[1]);
+        test::do_not_optimize(transferred);
+    }
+
+    fclose(file);
+}
+
+HLIB_BENCHMARK("FileDescriptorRelay", "[fdio]")
+{
+    FILE* file = make_file();
+    auto event_loop = std::make_shared<EventLoop>();
+    FileDescriptorRelay relay(event_loop);
+
+    state.setBytesProcessed(file_size);
+    while (true == state.keepRunning()) {
+        HVERIFY(0 == lseek(fileno(file), 0, SEEK_SET));
+
+        int sockets[2];
+        HVERIFY(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+        std::thread reader(drain, sockets[1]);
+
+        std::size_t transferred{ 0 };
+        relay.pipe(fileno(file), sockets[0], [&](std::size_t size, int /* error */) {
+            transferred = size;
+            ::close(sockets[0]);
+            event_loop->interrupt();
+        });
+        if (true == relay.active()) {
+            event_loop->dispatch();
+        }
+
+        reader.join();
+        ::close(sockets[1]);
+        test::do_not_optimize(transferred);
+    }
+
+    fclose(file);
+}
@@ -0,0 +1,218 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/buffer.hpp"
+#include "hlib/file.hpp"
+#include "hlib/test.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace hlib;
+
+namespace
+{
+
+std::string make_temporary_file(std::string const& name, std::string const& content)
+{
+    std::string filepath = (std::filesystem::temp_directory_path() / name).string();
+
+    std::ofstream stream(filepath, std::ios::binary);
+    stream.write(content.data(), content.size());
+    return filepath;
+}
+
+std::string make_lines_file(std::string const& name)
+{
+    std::string line(79, 'x');
+    line += '\n';
+
+    std::string content;
+    for (std::size_t i = 0; i < 64 * 1024 * 1024 / line.size(); ++i) {
+        content += line;
+    }
+    return make_temporary_file(name, content);
+}
+
+std::string const mime_data("\0\0\0\x18" "ftypmp42", 12);
+
+} // namespace
+
+HLIB_BENCHMARK("Write Fdatasync x64", "[file]")
+{
+    std::string const filepath = make_temporary_file("hlib_file_writer.benchmark", "");
+    std::string const record(128, 'x');
+
+    state.setBytesProcessed(64 * record.size());
+    while (true == state.keepRunning()) {
+        int fd = open(filepath.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+        for (int i = 0; i < 64; ++i) {
+            (void)!::write(fd, record.data(), record.size());
+            fdatasync(fd);
+        }
+        HVERIFY(0 == close(fd));
+    }
+
+    std::filesystem::remove(filepath);
+}
+
+HLIB_BENCHMARK("FileWriter x64 8 Committers", "[file]")
+{
+    std::string const filepath = make_temporary_file("hlib_file_writer.benchmark", "");
+    std::string const record(128, 'x');
+
+    file::FileWriterOptions options;
+    options.commit_latency = time::USec(200);
+
+    state.setBytesProcessed(64 * record.size());
+    while (true == state.keepRunning()) {
+        state.pauseTiming();
+        make_temporary_file("hlib_file_writer.benchmark", "");
+        file::FileWriter writer(filepath, options);
+        state.resumeTiming();
+
+        std::vector<std::thread> committers;
+        for (int i = 0; i < 8; ++i) {
+            committers.emplace_back([&] {
+                for (int j = 0; j < 8; ++j) {
+                    writer.append(record.data(), record.size());
+                    writer.commit();
+                }
+            });
+        }
+        for (std::thread& committer : committers) {
+            committer.join();
+        }
+        test::do_not_optimize(writer.metrics().syncs);
+    }
+
+    std::filesystem::remove(filepath);
+}
+
+HLIB_BENCHMARK("MIME Type", "[file]")
+{
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(file::get_mime_type(mime_data.data(), mime_data.size(), "").size());
+    }
+}
+
+HLIB_BENCHMARK("MIME Type From File", "[file]")
+{
+    std::string const filepath = make_temporary_file("hlib_mime_type.benchmark", mime_data);
+
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(file::get_mime_type_from_file(filepath, "").size());
+    }
+
+    std::filesystem::remove(filepath);
+}
+
+HLIB_BENCHMARK("Read Lines", "[file]")
+{
+    std::string const filepath = make_lines_file("hlib_mapped_file.benchmark");
+
+    state.setBytesProcessed(std::filesystem::file_size(filepath));
+    while (true == state.keepRunning()) {
+        Buffer buffer = file::read(filepath);
+        std::string_view view(static_cast<char const*>(buffer.data()), buffer.size());
+        test::do_not_optimize(std::count(view.begin(), view.end(), '\n'));
+    }
+
+    std::filesystem::remove(filepath);
+}
+
+HLIB_BENCHMARK("MappedFile Lines", "[file]")
+{
+    std::string const filepath = make_lines_file("hlib_mapped_file.benchmark");
+
+    state.setBytesProcessed(std::filesystem::file_size(filepath));
+    while (true == state.keepRunning()) {
+        file::MappedFile mapped(filepath, file::MappedFile::Sequential);
+        std::string_view view = mapped.view();
+        test::do_not_optimize(std::count(view.begin(), view.end(), '\n'));
+    }
+
+    std::filesystem::remove(filepath);
+}
+
+HLIB_BENCHMARK("Read FILE Batches", "[file]")
+{
+    std::string const filepath = make_lines_file("hlib_mapped_file.benchmark");
+
+    state.setBytesProcessed(std::filesystem::file_size(filepath));
+    while (true == state.keepRunning()) {
+        FILE* file = fopen(filepath.c_str(), "rb");
+        Buffer buffer = file::read(file, 64 * 1024);
+        fclose(file);
+        test::do_not_optimize(buffer.size());
+    }
+
+    std::filesystem::remove(filepath);
+}
+
+HLIB_BENCHMARK("Read Options", "[file]")
+{
+    std::string const filepath = make_lines_file("hlib_mapped_file.benchmark");
+    file::ReadOptions options;
+
+    state.setBytesProcessed(std::filesystem::file_size(filepath));
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(file::read(filepath, options).size());
+    }
+
+    std::filesystem::remove(filepath);
+}
+
+HLIB_BENCHMARK("Read Options 4 Threads", "[file]")
+{
+    std::string const filepath = make_lines_file("hlib_mapped_file.benchmark");
+    file::ReadOptions options;
+    options.threads = 4;
+
+    state.setBytesProcessed(std::filesystem::file_size(filepath));
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(file::read(filepath, options).size());
+    }
+
+    std::filesystem::remove(filepath);
+}
+
+HLIB_BENCHMARK("Read Options 4 Threads Direct", "[file]")
+{
+    std::string const filepath = make_lines_file("hlib_mapped_file.benchmark");
+    file::ReadOptions options;
+    options.threads = 4;
+    options.direct = true;
+
+    state.setBytesProcessed(std::filesystem::file_size(filepath));
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(file::read(filepath, options).size());
+    }
+
+    std::filesystem::remove(filepath);
+}
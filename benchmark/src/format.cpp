@@ -0,0 +1,63 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/format.hpp"
+#include "hlib/test.hpp"
+#include <cstdint>
+#include <cstdio>
+
+using namespace hlib;
+
+namespace
+{
+
+std::uint8_t const octets[] = { 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0 };
+
+} // namespace
+
+HLIB_BENCHMARK("Format snprintf", "[format]")
+{
+    while (true == state.keepRunning()) {
+        char string[32];
+        test::do_not_optimize(snprintf(string, sizeof(string), "%02x%02x%02x%02x-%02x%02x-%02x%02x",
+            octets[0], octets[1], octets[2], octets[3], octets[4], octets[5], octets[6], octets[7]));
+        test::do_not_optimize(string);
+    }
+}
+
+HLIB_BENCHMARK("Format Buffer", "[format]")
+{
+    while (true == state.keepRunning()) {
+        FormatBuffer<32> string;
+        HLIB_FORMAT_TO(string, "{:02x}{:02x}{:02x}{:02x}-{:02x}{:02x}-{:02x}{:02x}",
+            octets[0], octets[1], octets[2], octets[3], octets[4], octets[5], octets[6], octets[7]);
+        test::do_not_optimize(string.size());
+    }
+}
+
+HLIB_BENCHMARK("Format", "[format]")
+{
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(HLIB_FORMAT("{}:{}", "127.0.0.1", 8080).size());
+    }
+}
@@ -21,15 +21,11 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 //
-#pragma once
+#include "hlib/test.hpp"
 
-#include "hlib/base.hpp"
-#include <string>
+HLIB_BENCHMARK_COUNT_ALLOCATIONS()
 
-namespace hlib
+int main(int argc, char* argv[])
 {
-
-std::string format(char const* format_string, ...) noexcept;
-bool format_to(std::string& string, char const* format_string, ...) noexcept;
-
-} // namespace hlib
+    return hlib::test::benchmark_main(argc, argv);
+}
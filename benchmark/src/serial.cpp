@@ -0,0 +1,80 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/buffer.hpp"
+#include "hlib/serial.hpp"
+#include "hlib/sink.hpp"
+#include "hlib/source.hpp"
+#include "hlib/test.hpp"
+
+using namespace hlib;
+
+HLIB_BENCHMARK("Serializer Big Endian", "[serial]")
+{
+    auto sink = make_sink<Buffer>(64);
+
+    state.setBytesProcessed(1 + 2 + 4 + 8 + 8);
+    while (true == state.keepRunning()) {
+        sink.get().clear();
+
+        be::Serializer serializer(sink);
+        serializer.transform<std::uint8_t>(13)
+                  .transform<std::uint16_t>(11)
+                  .transform<std::uint32_t>(1971)
+                  .transform<std::uint64_t>(13111971)
+                  .transform<double>(3.14159);
+        test::do_not_optimize(sink.get().data());
+    }
+}
+
+HLIB_BENCHMARK("Deserializer Big Endian", "[serial]")
+{
+    auto sink = make_sink<Buffer>(64);
+    be::Serializer serializer(sink);
+    serializer.transform<std::uint8_t>(13)
+              .transform<std::uint16_t>(11)
+              .transform<std::uint32_t>(1971)
+              .transform<std::uint64_t>(13111971)
+              .transform<double>(3.14159);
+
+    Buffer const& buffer = sink.get();
+
+    std::uint8_t u8;
+    std::uint16_t u16;
+    std::uint32_t u32;
+    std::uint64_t u64;
+    double d;
+
+    state.setBytesProcessed(buffer.size());
+    while (true == state.keepRunning()) {
+        auto source = make_source_ref(buffer);
+
+        be::Deserializer deserializer(source);
+        deserializer.transform<std::uint8_t>(u8)
+                    .transform<std::uint16_t>(u16)
+                    .transform<std::uint32_t>(u32)
+                    .transform<std::uint64_t>(u64)
+                    .transform<double>(d);
+        test::do_not_optimize(u64);
+    }
+}
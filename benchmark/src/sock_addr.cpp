@@ -0,0 +1,72 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/sock_addr.hpp"
+#include "hlib/test.hpp"
+#include <unordered_map>
+
+using namespace hlib;
+
+HLIB_BENCHMARK("SockAddr Parse IPv4", "[sockaddr]")
+{
+    SockAddr sa;
+
+    while (true == state.keepRunning()) {
+        HVERIFY(true == sa.parse("192.168.100.200:8443", SockAddr::All, std::nothrow));
+        test::do_not_optimize(sa);
+    }
+}
+
+HLIB_BENCHMARK("SockAddr Parse IPv6", "[sockaddr]")
+{
+    SockAddr sa;
+
+    while (true == state.keepRunning()) {
+        HVERIFY(true == sa.parse("[fe80::1b39:432b:a559:b42c]:8443", SockAddr::All, std::nothrow));
+        test::do_not_optimize(sa);
+    }
+}
+
+HLIB_BENCHMARK("SockAddr Format IPv6", "[sockaddr]")
+{
+    SockAddr const sa("[fe80::1b39:432b:a559:b42c]:8443");
+    char buffer[SockAddr::MaxStringSize];
+
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(format_sock_addr(buffer, sizeof(buffer), sa));
+    }
+}
+
+HLIB_BENCHMARK("SockAddr Hash Lookup", "[sockaddr]")
+{
+    std::unordered_map<SockAddr, int> peers;
+    for (int i = 0; i < 1024; ++i) {
+        peers.emplace(SockAddr("10.0." + std::to_string(i / 256) + "." + std::to_string(i % 256) + ":80"), i);
+    }
+
+    SockAddr const sa("10.0.2.17:80");
+
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(peers.find(sa));
+    }
+}
@@ -0,0 +1,217 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/buffer.hpp"
+#include "hlib/string.hpp"
+#include "hlib/test.hpp"
+#include <cctype>
+#include <cstdlib>
+#include <vector>
+
+using namespace hlib;
+
+namespace
+{
+
+std::string make_text()
+{
+    std::string text;
+    for (int i = 0; i < 64; ++i) {
+        text += "  lorem ipsum,dolor,sit,amet  \n";
+    }
+    return text;
+}
+
+std::vector<std::string> make_numbers()
+{
+    std::vector<std::string> values;
+    for (int i = 0; i < 1000; ++i) {
+        values.push_back(std::to_string(i * 7919));
+    }
+    return values;
+}
+
+std::string const user_agent = "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36";
+
+} // namespace
+
+HLIB_BENCHMARK("Base64 Encode", "[string]")
+{
+    std::string const data = make_text();
+    Buffer buffer;
+    buffer.reserve(base64_encode_get_length(data.size()));
+
+    state.setBytesProcessed(data.size());
+    while (true == state.keepRunning()) {
+        buffer.clear();
+        HVERIFY(true == base64_encode(buffer, data.data(), data.size()));
+        test::do_not_optimize(buffer.data());
+    }
+}
+
+HLIB_BENCHMARK("Base64 Decode", "[string]")
+{
+    std::string const text = make_text();
+    std::string const encoded = base64_encode(text.data(), text.size());
+    Buffer buffer;
+    buffer.reserve(base64_decode_get_size(encoded.size()));
+
+    state.setBytesProcessed(encoded.size());
+    while (true == state.keepRunning()) {
+        buffer.clear();
+        HVERIFY(true == base64_decode(buffer, encoded.data(), encoded.size()));
+        test::do_not_optimize(buffer.data());
+    }
+}
+
+HLIB_BENCHMARK("Split", "[string]")
+{
+    std::string const text = make_text();
+
+    state.setBytesProcessed(text.size());
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(split(text, ',').size());
+    }
+}
+
+HLIB_BENCHMARK("Split View", "[string]")
+{
+    std::string const text = make_text();
+
+    state.setBytesProcessed(text.size());
+    while (true == state.keepRunning()) {
+        std::size_t count{ 0 };
+        for (std::string_view token : split_view(text, ',')) {
+            count += trim_view(token).size();
+        }
+        test::do_not_optimize(count);
+    }
+}
+
+HLIB_BENCHMARK("Split Line", "[string]")
+{
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(split(user_agent, ' ').size());
+    }
+}
+
+HLIB_BENCHMARK("Split View Line", "[string]")
+{
+    while (true == state.keepRunning()) {
+        std::size_t count{ 0 };
+        for (std::string_view token : split_view(user_agent, ' ')) {
+            count += token.size();
+        }
+        test::do_not_optimize(count);
+    }
+}
+
+HLIB_BENCHMARK("Split Line isspace", "[string]")
+{
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(split(user_agent, isspace).size());
+    }
+}
+
+HLIB_BENCHMARK("Split View Line IsSpace", "[string]")
+{
+    while (true == state.keepRunning()) {
+        std::size_t count{ 0 };
+        for (std::string_view token : split_view(user_agent, IsSpace())) {
+            count += token.size();
+        }
+        test::do_not_optimize(count);
+    }
+}
+
+HLIB_BENCHMARK("Trim", "[string]")
+{
+    std::string const padded = "    " + user_agent + "\r\n";
+
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(trim(padded).size());
+    }
+}
+
+HLIB_BENCHMARK("Trim View", "[string]")
+{
+    std::string const padded = "    " + user_agent + "\r\n";
+
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(trim_view(padded).size());
+    }
+}
+
+HLIB_BENCHMARK("strtol", "[string]")
+{
+    std::vector<std::string> const values = make_numbers();
+
+    while (true == state.keepRunning()) {
+        long sum{ 0 };
+        for (std::string const& value : values) {
+            std::string_view slice(value);
+            sum += strtol(std::string(slice).c_str(), nullptr, 10);
+        }
+        test::do_not_optimize(sum);
+    }
+}
+
+HLIB_BENCHMARK("stoi32", "[string]")
+{
+    std::vector<std::string> const values = make_numbers();
+
+    while (true == state.keepRunning()) {
+        long sum{ 0 };
+        for (std::string const& value : values) {
+            sum += stoi32(std::string_view(value), 10, std::nothrow).value_or(0);
+        }
+        test::do_not_optimize(sum);
+    }
+}
+
+HLIB_BENCHMARK("strtod", "[string]")
+{
+    std::vector<std::string> const values = make_numbers();
+
+    while (true == state.keepRunning()) {
+        double sum{ 0 };
+        for (std::string const& value : values) {
+            std::string_view slice(value);
+            sum += strtod(std::string(slice).c_str(), nullptr);
+        }
+        test::do_not_optimize(sum);
+    }
+}
+
+HLIB_BENCHMARK("stof64", "[string]")
+{
+    std::vector<std::string> const values = make_numbers();
+
+    while (true == state.keepRunning()) {
+        double sum{ 0 };
+        for (std::string const& value : values) {
+            sum += stof64(std::string_view(value), std::nothrow).value_or(0);
+        }
+        test::do_not_optimize(sum);
+    }
+}
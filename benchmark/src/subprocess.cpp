@@ -0,0 +1,97 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/event_loop.hpp"
+#include "hlib/subprocess.hpp"
+#include "hlib/test.hpp"
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace hlib;
+
+namespace
+{
+
+constexpr int pool_count = 64;
+
+} // namespace
+
+// The fork() based path Subprocess used before, closing every possible file
+// descriptor in the child.
+HLIB_BENCHMARK("Subprocess Fork", "[subprocess]")
+{
+    while (true == state.keepRunning()) {
+        int pid = fork();
+        if (0 == pid) {
+            int const max_fd = sysconf(_SC_OPEN_MAX);
+            for (int fd = STDERR_FILENO + 1; fd < max_fd; ++fd) {
+                ::close(fd);
+            }
+            execlp("true", "true", nullptr);
+            _exit(127);
+        }
+
+        int status;
+        waitpid(pid, &status, 0);
+        test::do_not_optimize(status);
+    }
+}
+
+HLIB_BENCHMARK("Subprocess", "[subprocess]")
+{
+    while (true == state.keepRunning()) {
+        Subprocess process;
+        test::do_not_optimize(process.run("true", {}));
+    }
+}
+
+HLIB_BENCHMARK("Subprocess x64", "[subprocess]")
+{
+    while (true == state.keepRunning()) {
+        int result{ 0 };
+        for (int i = 0; i < pool_count; ++i) {
+            Subprocess process;
+            result += process.run("true", {});
+        }
+        test::do_not_optimize(result);
+    }
+}
+
+HLIB_BENCHMARK("SubprocessPool x64", "[subprocess]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+    SubprocessPool pool(event_loop, 8);
+
+    while (true == state.keepRunning()) {
+        int completed{ 0 };
+        for (int i = 0; i < pool_count; ++i) {
+            pool.run("true", {}, [&](Result<int> const& /* return_code */, Buffer& /* output */, Buffer& /* error */) noexcept {
+                if (pool_count == ++completed) {
+                    event_loop->interrupt();
+                }
+            });
+        }
+        event_loop->dispatch();
+        test::do_not_optimize(completed);
+    }
+}
@@ -0,0 +1,134 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/test.hpp"
+#include "hlib/time.hpp"
+#include <array>
+#include <ctime>
+
+using namespace hlib;
+
+HLIB_BENCHMARK("ISO8601 To String Local", "[time]")
+{
+    time::Clock const clock = time::now_utc();
+
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(to_string_local(clock, true));
+    }
+}
+
+HLIB_BENCHMARK("ISO8601 Format Local", "[time]")
+{
+    std::array<char, time::ISO8601::MaxSize> buffer;
+    time::Clock const clock = time::now_utc();
+
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(time::format_iso8601(buffer.data(), buffer.size(), clock,
+            time::ISO8601::Date | time::ISO8601::Time | time::ISO8601::Milliseconds));
+    }
+}
+
+HLIB_BENCHMARK("ISO8601 Format UTC", "[time]")
+{
+    std::array<char, time::ISO8601::MaxSize> buffer;
+    time::Clock const clock = time::now_utc();
+
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(time::format_iso8601(buffer.data(), buffer.size(), clock,
+            time::ISO8601::Date | time::ISO8601::Time | time::ISO8601::Milliseconds | time::ISO8601::Utc));
+    }
+}
+
+HLIB_BENCHMARK("ISO8601 strptime", "[time]")
+{
+    std::string const iso8601 = to_string_utc(time::now_utc(), true);
+
+    while (true == state.keepRunning()) {
+        std::tm tm_time{};
+        strptime(iso8601.c_str(), "%Y-%m-%dT%H:%M:%S", &tm_time);
+        test::do_not_optimize(timegm(&tm_time));
+    }
+}
+
+HLIB_BENCHMARK("ISO8601 To Clock", "[time]")
+{
+    std::string const iso8601 = to_string_utc(time::now_utc(), true);
+
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(time::to_clock(iso8601, std::nothrow).value().tv_sec);
+    }
+}
+
+HLIB_BENCHMARK("Now", "[time]")
+{
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(time::now());
+    }
+}
+
+HLIB_BENCHMARK("Now Coarse", "[time]")
+{
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(time::now(CLOCK_MONOTONIC_COARSE));
+    }
+}
+
+HLIB_BENCHMARK("Fast Now", "[time]")
+{
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(time::fast_now());
+    }
+}
+
+HLIB_BENCHMARK("Now Ns", "[time]")
+{
+    while (true == state.keepRunning()) {
+        test::do_not_optimize(time::now_ns());
+    }
+}
+
+HLIB_BENCHMARK("Duration Arithmetic", "[time]")
+{
+    time::Duration duration(time::USec(3));
+
+    while (true == state.keepRunning()) {
+        time::Clock clock(1, 999999999);
+        for (int i = 0; i < 100; ++i) {
+            clock += duration;
+        }
+        test::do_not_optimize((clock - time::Clock(1, 0)).to<time::NSec>().value());
+    }
+}
+
+HLIB_BENCHMARK("DurationNs Arithmetic", "[time]")
+{
+    time::DurationNs duration_ns(time::USec(3));
+
+    while (true == state.keepRunning()) {
+        time::TimePoint point(1999999999);
+        for (int i = 0; i < 100; ++i) {
+            point += duration_ns;
+        }
+        test::do_not_optimize((point - time::TimePoint(1000000000)).count());
+    }
+}
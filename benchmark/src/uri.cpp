@@ -0,0 +1,123 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/test.hpp"
+#include "hlib/uri.hpp"
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace hlib;
+
+namespace
+{
+
+std::vector<std::string> const corpus = {
+    "https://john.doe@www.example.com:123/forum/questions/?tag=networking&order=newest#top",
+    "http://example.com/",
+    "https://api.example.com/v1/users/12345/orders?page=2&per_page=50&sort=-created_at",
+    "wss://stream.example.net:8443/live/feed?token=abcdef0123456789",
+    "/static/js/app.min.js?v=20240101",
+    "ldap://[2001:db8::7]/c=GB?objectClass?one",
+    "mailto:John.Doe@example.com",
+    "http://cdn.example.org/images/2024/01/photo%20with%20spaces.jpg"
+};
+
+std::size_t get_corpus_size()
+{
+    std::size_t size{ 0 };
+    for (std::string const& string : corpus) {
+        size += string.size();
+    }
+    return size;
+}
+
+// The std::regex based uri_parse() this parser replaced.
+URI regex_parse(std::string const& string)
+{
+    static std::regex const uri_regex(
+        R"(^(([^:\/?#]+):)?(//([^\/?#]*))?([^?#]*)(\?([^#]*))?(#(.*))?)",
+        std::regex::extended
+    );
+
+    std::smatch matches;
+    std::regex_match(string, matches, uri_regex);
+
+    URI uri;
+    uri.scheme = matches[2].str();
+    uri.host = matches[4].str();
+    uri.path = matches[5].str();
+    uri.query = matches[7].str();
+    uri.fragment = matches[9].str();
+    return uri;
+}
+
+} // namespace
+
+HLIB_BENCHMARK("URI Parse Regex", "[uri]")
+{
+    state.setBytesProcessed(get_corpus_size());
+    while (true == state.keepRunning()) {
+        std::size_t size{ 0 };
+        for (std::string const& string : corpus) {
+            size += regex_parse(string).path.size();
+        }
+        test::do_not_optimize(size);
+    }
+}
+
+HLIB_BENCHMARK("URI Parse", "[uri]")
+{
+    state.setBytesProcessed(get_corpus_size());
+    while (true == state.keepRunning()) {
+        std::size_t size{ 0 };
+        for (std::string const& string : corpus) {
+            size += uri_parse(string).path.size();
+        }
+        test::do_not_optimize(size);
+    }
+}
+
+HLIB_BENCHMARK("URI Parse View", "[uri]")
+{
+    state.setBytesProcessed(get_corpus_size());
+    while (true == state.keepRunning()) {
+        std::size_t size{ 0 };
+        for (std::string const& string : corpus) {
+            size += uri_parse_view(string).path.size();
+        }
+        test::do_not_optimize(size);
+    }
+}
+
+HLIB_BENCHMARK("URI Encoding Escape", "[uri]")
+{
+    state.setBytesProcessed(get_corpus_size());
+    while (true == state.keepRunning()) {
+        std::size_t size{ 0 };
+        for (std::string const& string : corpus) {
+            size += uri_encoding_escape(string).size();
+        }
+        test::do_not_optimize(size);
+    }
+}
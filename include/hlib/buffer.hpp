@@ -76,6 +76,11 @@ public:
     void* reserveZeroed(std::size_t capacity, std::nothrow_t) noexcept;
     void* reserveZeroed(std::size_t capacity);
 
+    // Reserves capacity at an address aligned to alignment, a power of two,
+    // e.g. for O_DIRECT I/O. Alignment is lost when the buffer reallocates.
+    void* reserveAligned(std::size_t capacity, std::size_t alignment, std::nothrow_t) noexcept;
+    void* reserveAligned(std::size_t capacity, std::size_t alignment);
+
     void* extend(std::size_t capacity, std::nothrow_t) noexcept;
     void* extend(std::size_t capacity);
     void* extendZeroed(std::size_t capacity, std::nothrow_t) noexcept;
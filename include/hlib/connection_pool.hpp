@@ -0,0 +1,184 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include "hlib/base.hpp"
+#include "hlib/event_loop.hpp"
+#include "hlib/memory.hpp"
+#include "hlib/sock_addr.hpp"
+#include "hlib/socket.hpp"
+#include "hlib/time.hpp"
+#include "hlib/timer.hpp"
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace hlib
+{
+
+// Pool of outbound connections keyed by peer address. Connections are
+// checked out as connected non-blocking file descriptors, for example to
+// open a Socket with, and released back to the pool to be reused. Idle
+// connections closed by their peer are detected and dropped. Peers without
+// idle connections or waiting checkouts are forgotten. A pool and its event
+// loop must be used from one thread.
+class ConnectionPool final
+{
+    HLIB_NOT_COPYABLE(ConnectionPool);
+    HLIB_NOT_MOVABLE(ConnectionPool);
+
+public:
+    struct Options
+    {
+        // Maximum number of idle connections kept per peer.
+        std::size_t max_idle{ 8 };
+
+        // Maximum number of connects in flight across all peers. Further
+        // checkouts wait for a connect to complete.
+        std::size_t max_connecting{ 64 };
+
+        // Idle connections are closed after this time, or kept if 0.
+        time::DurationNs idle_timeout{ time::Sec(60) };
+
+        int type{ SOCK_STREAM };
+        int protocol{ 0 };
+        SocketOptions socket_options;
+    };
+
+    struct Metrics
+    {
+        std::uint64_t checkouts{ 0 };
+        std::uint64_t reused{ 0 };
+        std::uint64_t connects{ 0 };
+        std::uint64_t failures{ 0 };
+        std::uint64_t waits{ 0 };       // Checkouts that waited for the connect limit.
+        std::uint64_t closed{ 0 };      // Idle connections closed by their peer.
+        std::uint64_t expired{ 0 };     // Idle connections closed after the idle timeout.
+        std::uint64_t discarded{ 0 };   // Releases beyond the idle limit.
+
+        // Time from checkout to callback.
+        time::DurationNs wait_time;
+        time::DurationNs max_wait_time;
+
+        double reuseRate() const noexcept;
+        time::DurationNs averageWaitTime() const noexcept;
+    };
+
+    // Connected socket or an invalid handle and an errno value on failure.
+    typedef std::function<void(Handle<int, -1> fd, int error)> OnCheckout;
+
+public:
+    ConnectionPool(std::weak_ptr<EventLoop> event_loop);
+    ConnectionPool(std::weak_ptr<EventLoop> event_loop, Options options);
+    // Calls back checkouts still connecting or waiting with ECANCELED, which
+    // must not use the pool anymore.
+    ~ConnectionPool();
+
+    // Calls back with an idle connection to address if available, which
+    // is synchronous, or with a new connection.
+    void checkout(SockAddr const& address, OnCheckout callback);
+
+    // Returns a connection to address to the pool. A checkout of address
+    // waiting for the connect limit is called back with it synchronously,
+    // otherwise it is closed if the peer already has the maximum number of
+    // idle connections.
+    void release(SockAddr const& address, Handle<int, -1> fd);
+
+    std::size_t idle(SockAddr const& address) const noexcept;
+    std::size_t peers() const noexcept;
+    std::size_t connecting() const noexcept;
+    std::size_t waiting() const noexcept;
+    Metrics const& metrics() const noexcept;
+
+    // Closes all idle connections.
+    void clear() noexcept;
+
+private:
+    struct Peer;
+
+    struct Idle
+    {
+        Handle<int, -1> fd;
+        time::TimePoint since;
+        Peer* peer;
+    };
+
+    struct Waiter
+    {
+        OnCheckout callback;
+        time::TimePoint started;
+    };
+
+    struct Peer
+    {
+        SockAddr address;
+        std::list<Idle> idle;
+        std::deque<Waiter> waiters;
+
+        // Entries in m_queue, which exceed waiters by those that release()
+        // served directly.
+        std::size_t queued{ 0 };
+    };
+
+    struct Connecting
+    {
+        Handle<int, -1> fd;
+        OnCheckout callback;
+        time::TimePoint started;
+    };
+
+    std::weak_ptr<EventLoop> m_event_loop;
+    Options m_options;
+
+    std::unordered_map<SockAddr, Peer> m_peers;
+    std::unordered_map<int, Connecting> m_connecting;
+
+    // Peers with waiting checkouts, once per checkout in order of arrival.
+    std::deque<Peer*> m_queue;
+    std::size_t m_waiting{ 0 };
+
+    // List nodes of closed idle connections, recycled by release().
+    std::list<Idle> m_spare;
+
+    Timer m_timer;
+    bool m_timer_armed{ false };
+
+    Metrics m_metrics;
+
+    Peer& peer(SockAddr const& address);
+    void connect(Peer& peer, OnCheckout callback, time::TimePoint started);
+    bool reuse(Peer& peer, OnCheckout& callback, time::TimePoint started);
+    void deliver(OnCheckout const& callback, time::TimePoint started, Handle<int, -1> fd, int error);
+    void next();
+    void retire(std::list<Idle>::iterator it) noexcept;
+    void prune(Peer& peer) noexcept;
+
+    void onConnect(int fd, std::uint32_t events);
+    void onIdle(std::list<Idle>::iterator it, std::uint32_t events);
+    void onTimeout();
+};
+
+} // namespace hlib
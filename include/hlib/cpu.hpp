@@ -24,7 +24,12 @@
 #pragma once
 
 #include "hlib/base.hpp"
+#include "hlib/file.hpp"
+#include "hlib/memory.hpp"
 #include "hlib/result.hpp"
+#include "hlib/time.hpp"
+#include <string>
+#include <sys/types.h>
 #include <vector>
 
 namespace hlib
@@ -35,6 +40,86 @@ Result<int> cpu_get_count() noexcept;
 Result<int> cpu_get_frequency(int cpu) noexcept;
 Result<std::size_t> cpu_get_cache_size(int cpu, int cache_index) noexcept;
 
+// Restricts the calling thread to the given CPUs.
+Result<> cpu_set_affinity(std::vector<int> const& cpus) noexcept;
+Result<> cpu_set_affinity(int cpu) noexcept;
+Result<std::vector<int>> cpu_get_affinity() noexcept;
+
+// CPU time consumed by a thread or process.
+struct CPUUsage
+{
+    pid_t id{ 0 };
+    char name[16]{};
+    time::DurationNs user;
+    time::DurationNs system;
+};
+
+// Usage of the calling thread and of the process, using getrusage().
+Result<CPUUsage> cpu_get_thread_usage() noexcept;
+Result<CPUUsage> cpu_get_process_usage() noexcept;
+
+// Usage of every thread of the process, from /proc/self/task/*/stat. The
+// vector is reused, so repeated calls do not allocate once it has grown.
+Result<> cpu_get_thread_usages(std::vector<CPUUsage>& usages) noexcept;
+
+// Snapshot of the CPU topology of the online CPUs, parsed once from
+// /sys/devices/system/cpu and /sys/devices/system/node.
+class CPUTopology final
+{
+public:
+    struct Cache
+    {
+        int level{ 0 };
+        std::string type;
+        std::size_t size{ 0 };
+        std::size_t line_size{ 0 };
+        std::vector<int> cpus;
+    };
+
+    struct CPU
+    {
+        int id{ -1 };
+        int core{ -1 };
+        int package{ -1 };
+        int node{ 0 };
+
+        // SMT siblings on the same physical core, including this CPU.
+        std::vector<int> siblings;
+
+        // Indices into caches().
+        std::vector<std::size_t> caches;
+    };
+
+public:
+    CPUTopology() = default;
+
+    std::vector<CPU> const& cpus() const noexcept;
+    std::vector<Cache> const& caches() const noexcept;
+    std::vector<int> const& nodes() const noexcept;
+
+    CPU const* cpu(int id) const noexcept;
+
+    // Online CPUs on the node, or all online CPUs if node is negative.
+    std::vector<int> cpusOfNode(int node = -1) const;
+
+    // One CPU per physical core, the lowest numbered SMT sibling, on the
+    // node or on all nodes if node is negative.
+    std::vector<int> physicalCores(int node = -1) const;
+
+    // CPUs sharing the cache of the given level with cpu.
+    std::vector<int> sharingCache(int cpu, int level) const;
+
+    // Root is the sysfs system devices directory.
+    Result<> initialize(std::string const& root = "/sys/devices/system") noexcept;
+
+private:
+    std::vector<CPU> m_cpus;
+    std::vector<Cache> m_caches;
+    std::vector<int> m_nodes;
+
+    void load(std::string const& root);
+};
+
 class CPUMonitor final
 {
     HLIB_NOT_COPYABLE(CPUMonitor);
@@ -76,6 +161,8 @@ public:
     std::int64_t busy(int cpu = -1) const noexcept;
 
     Result<> initialize() noexcept;
+
+    // Samples /proc/stat, which is kept open. Does not allocate.
     Result<> update() noexcept;
 
 private:
@@ -87,7 +174,10 @@ private:
     std::vector<Statistics> m_cpu_previous;
     std::vector<Statistics> m_cpu_current;
 
-    Statistics parse(std::string const& line) const noexcept;
+    Handle<int, -1> m_fd{ -1, file::fd_close };
+    std::vector<char> m_buffer;
+
+    Statistics parse(char const*& first, char const* last) const noexcept;
 };
 
 } // namespace hlib
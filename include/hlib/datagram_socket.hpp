@@ -0,0 +1,122 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include "hlib/base.hpp"
+#include "hlib/event_loop.hpp"
+#include "hlib/memory.hpp"
+#include "hlib/result.hpp"
+#include "hlib/sock_addr.hpp"
+#include <sys/socket.h>
+#include <vector>
+
+namespace hlib
+{
+
+// Datagram socket on an event loop that receives and sends batches of
+// datagrams with recvmmsg() and sendmmsg(). Received datagrams point into
+// slots that are allocated once and reused for every batch.
+class DatagramSocket final
+{
+    HLIB_NOT_COPYABLE(DatagramSocket);
+    HLIB_NOT_MOVABLE(DatagramSocket);
+
+public:
+    static constexpr std::uint32_t ReuseAddr{ 0x01 };
+    static constexpr std::uint32_t ReusePort{ 0x02 };
+
+    // Receive coalesced UDP datagrams (GRO). A slot then holds several
+    // segments of segment_size bytes each, so the datagram size should
+    // allow for 64 KiB.
+    static constexpr std::uint32_t GRO{ 0x04 };
+
+    struct Datagram
+    {
+        std::uint8_t const* data{ nullptr };
+        std::size_t size{ 0 };
+
+        // Peer address. On send, empty for the connected peer.
+        SockAddr address;
+
+        // On send, splits data into UDP segments of this size (GSO). On
+        // receive, the size of the coalesced segments, or 0.
+        std::uint16_t segment_size{ 0 };
+    };
+
+    typedef std::function<void(Datagram const* datagrams, std::size_t count)> OnReceived;
+    typedef std::function<void(int error)> OnError;
+
+public:
+    DatagramSocket(std::weak_ptr<EventLoop> event_loop,
+        std::size_t batch_size = 64, std::size_t datagram_size = 2048);
+    ~DatagramSocket();
+
+    int fd() const noexcept;
+    SockAddr getLocalAddress() const noexcept;
+
+    void setErrorCallback(OnError callback) noexcept;
+
+    Result<> open(SockAddr const& address, int protocol, std::uint32_t options, std::nothrow_t) noexcept;
+    void open(SockAddr const& address, int protocol, std::uint32_t options);
+
+    Result<> connect(SockAddr const& address, std::nothrow_t) noexcept;
+    void connect(SockAddr const& address);
+
+    // Calls back with each batch of received datagrams until called with
+    // a null callback.
+    void receive(OnReceived callback);
+
+    // Sends up to count datagrams without blocking. Returns the number of
+    // datagrams sent, which is less than count if the send buffer is full.
+    Result<std::size_t> send(Datagram const* datagrams, std::size_t count, std::nothrow_t) noexcept;
+    std::size_t send(Datagram const* datagrams, std::size_t count);
+
+    void close() noexcept;
+
+private:
+    std::weak_ptr<EventLoop> m_event_loop;
+    Handle<int, -1> m_fd;
+
+    OnReceived m_on_received;
+    OnError m_on_error;
+
+    std::size_t m_batch_size;
+    std::size_t m_datagram_size;
+    bool m_gro{ false };
+
+    std::vector<std::uint8_t> m_buffer;
+    std::vector<iovec> m_iovecs;
+    std::vector<sockaddr_storage> m_addresses;
+    std::vector<std::uint8_t> m_control;
+    std::vector<mmsghdr> m_headers;
+    std::vector<Datagram> m_datagrams;
+
+    std::vector<iovec> m_send_iovecs;
+    std::vector<std::uint8_t> m_send_control;
+    std::vector<mmsghdr> m_send_headers;
+
+    void onReceive(int fd, std::uint32_t events);
+};
+
+} // namespace hlib
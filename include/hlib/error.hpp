@@ -28,6 +28,7 @@
 #include <stdexcept>
 #include <string>
 #include <system_error>
+#include <type_traits>
 
 namespace hlib
 {
@@ -37,6 +38,14 @@ class Error final
 public:
     Error() = default;
 
+    // Error without an exception object, which is only created by toss().
+    // The context must have static storage duration, e.g. a string literal.
+    Error(std::error_code const& code, char const* context = nullptr) noexcept
+        : m_code(code)
+        , m_context(context)
+    {
+    }
+
     Error(std::exception_ptr const& ptr)
         : m_exception(ptr)
     {
@@ -49,29 +58,37 @@ public:
 
     template<typename T, typename = std::enable_if_t<std::is_base_of<std::exception, T>::value>>
     Error(T const& exception)
-        : m_exception(std::make_exception_ptr(exception))
+        : m_code(code_of(exception))
+        , m_exception(std::make_exception_ptr(exception))
     {
     }
 
     template<typename T, typename = std::enable_if_t<std::is_base_of<std::exception, T>::value>>
     Error(T&& exception)
-        : m_exception(std::make_exception_ptr(std::forward<T>(exception)))
+        : m_code(code_of(exception))
+        , m_exception(std::make_exception_ptr(std::forward<T>(exception)))
     {
     }
 
     Error& operator=(std::exception_ptr ptr) {
+        m_code.clear();
+        m_context = nullptr;
         m_exception = std::move(ptr);
         return *this;
     }
 
     template<typename T, typename = std::enable_if_t<std::is_base_of<std::exception, T>::value>>
     Error& operator =(T const& exception) {
+        m_code = code_of(exception);
+        m_context = nullptr;
         m_exception = std::make_exception_ptr(exception);
         return *this;
     }
 
     template<typename T, typename = std::enable_if_t<std::is_base_of<std::exception, T>::value>>
     Error& operator =(T&& exception) noexcept {
+        m_code = code_of(exception);
+        m_context = nullptr;
         m_exception = std::make_exception_ptr(std::forward<T>(exception));
         return *this;
     }
@@ -84,7 +101,21 @@ public:
     [[noreturn]] void toss() const;
 
 private:
+    std::error_code m_code;
+    char const* m_context{ nullptr };
     std::exception_ptr m_exception;
+
+    template<typename T>
+    static std::error_code code_of(T const& exception) noexcept
+    {
+        if constexpr (true == std::is_base_of<std::system_error, T>::value) {
+            return exception.code();
+        }
+        else {
+            (void)exception;
+            return {};
+        }
+    }
 };
 
 inline bool operator ==(bool is_set, Error const& error)
@@ -112,6 +143,10 @@ std::string get_error_string();
 
 std::error_code make_error_code(int posix_errno);
 
+// Cheap alternatives to make_system_error() for Results, see Error.
+Error make_error(int posix_errno) noexcept;
+Error make_error(int posix_errno, char const* context) noexcept;
+
 std::system_error make_system_error(int posix_errno);
 std::system_error make_system_error(int posix_errno, std::string const& what);
 std::system_error make_system_error(int posix_errno, std::error_category& category, std::string const& what);
@@ -48,6 +48,7 @@ public:
     static constexpr std::uint32_t Error{ EPOLLERR };
     static constexpr std::uint32_t Hup{ EPOLLHUP };
     static constexpr std::uint32_t RdHup{ EPOLLRDHUP };
+    static constexpr std::uint32_t EdgeTriggered{ EPOLLET };
 
     typedef std::function<void(int fd, std::uint32_t events)> Callback;
 
@@ -57,6 +58,11 @@ public:
     int fd() const noexcept;
     std::thread::id threadId() const noexcept;
 
+    // Loop time, read once per dispatch iteration before invoking the
+    // callback, and after it when dispatching with a timeout. Cheaper than
+    // time::now() for callbacks on the loop thread.
+    time::TimePoint now() const noexcept;
+
     void add(int fd, std::uint32_t events, Callback callback);
     Result<> modify(int fd, std::uint32_t events, std::nothrow_t) noexcept;
     void modify(int fd, std::uint32_t events);
@@ -74,6 +80,7 @@ private:
     Handle<int, -1> m_fd;
     file::Pipe m_pipe;
     bool m_interrupt{ false };
+    time::TimePoint m_now;
 
     std::mutex m_mutex;
 
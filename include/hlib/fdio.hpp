@@ -24,11 +24,13 @@
 #pragma once
 
 #include "hlib/base.hpp"
+#include "hlib/buffer.hpp"
 #include "hlib/event_loop.hpp"
 #include "hlib/memory.hpp"
 #include "hlib/sink.hpp"
 #include "hlib/source.hpp"
 #include <deque>
+#include <limits>
 #include <string>
 
 namespace hlib
@@ -92,5 +94,82 @@ private:
     void callbackAndClose(int error);
 };
 
+class FileDescriptorRelay final
+{
+    HLIB_NOT_COPYABLE(FileDescriptorRelay);
+    HLIB_NOT_MOVABLE(FileDescriptorRelay);
+
+public:
+    static constexpr std::size_t Unlimited{ std::numeric_limits<std::size_t>::max() };
+
+    typedef std::function<void(std::size_t size, int error)> OnCompleted;
+
+public:
+    std::shared_ptr<void> user;
+
+    // FileDescriptorRelay pipes data from a source to a destination file
+    // descriptor without passing it through userspace. It uses splice() when
+    // either side is a pipe, sendfile() when the source is a regular file and
+    // otherwise splices through an intermediate pipe. When the kernel does not
+    // support either for the file descriptors, it falls back to read() and
+    // write().
+    //
+    // The relay duplicates the file descriptors, the caller keeps ownership
+    // of the originals but shall not read from the source or write to the
+    // destination while piping. Pollable file descriptors are switched to
+    // non-blocking mode. Transfer stops when the source reaches end-of-file,
+    // when size bytes have been transferred or on error, after which the
+    // completion callback reports the number of bytes written to the
+    // destination. When neither side is pollable, pipe() completes
+    // synchronously.
+    //
+    FileDescriptorRelay(std::weak_ptr<EventLoop> event_loop) noexcept;
+    ~FileDescriptorRelay();
+
+    bool active() const noexcept;
+    std::size_t transferred() const noexcept;
+
+    Result<> pipe(int source_fd, int destination_fd, OnCompleted callback, std::size_t size, std::nothrow_t) noexcept;
+    void pipe(int source_fd, int destination_fd, OnCompleted callback, std::size_t size = Unlimited);
+
+    void cancel() noexcept;
+
+private:
+    enum Mode
+    {
+        Splice,
+        SendFile,
+        SplicePipe,
+        Copy
+    };
+
+    std::weak_ptr<EventLoop> m_event_loop;
+    Mode m_mode{ Splice };
+
+    Handle<int, -1> m_source;
+    Handle<int, -1> m_destination;
+    bool m_source_polled{ false };
+    bool m_destination_polled{ false };
+
+    file::Pipe m_pipe;
+    Buffer m_buffer;
+    std::size_t m_buffer_offset{ 0 };
+    std::size_t m_capacity{ 0 };
+    std::size_t m_staged{ 0 };
+
+    bool m_eof{ false };
+    std::size_t m_remaining{ 0 };
+    std::size_t m_transferred{ 0 };
+
+    OnCompleted m_on_completed;
+
+    void onEvent(int fd, std::uint32_t events);
+
+    ssize_t fill(std::size_t size) noexcept;
+    ssize_t drain() noexcept;
+    void transfer();
+    void complete(int error);
+};
+
 } // namespace hlib
 
@@ -27,11 +27,17 @@
 #include "hlib/buffer.hpp"
 #include "hlib/memory.hpp"
 #include "hlib/result.hpp"
+#include "hlib/time.hpp"
 #include <array>
+#include <condition_variable>
+#include <deque>
 #include <cstdio>
 #include <filesystem>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
 
 namespace hlib
 {
@@ -81,6 +87,28 @@ Result<Buffer> read(int fd, std::size_t batch_size, std::nothrow_t) noexcept;
 Result<Buffer> read(std::string const& filepath, std::nothrow_t) noexcept;
        Buffer  read(std::string const& filepath);
 
+//
+// Ingestion
+//
+struct ReadOptions
+{
+    // Bypass the page cache using O_DIRECT, falls back to buffered reads when
+    // the file system does not support it.
+    bool direct{ false };
+
+    // Bytes per read, rounded up to the direct I/O alignment.
+    std::size_t chunk_size{ 4 * 1024 * 1024 };
+
+    // Number of threads reading chunks of a regular file concurrently.
+    std::size_t threads{ 1 };
+};
+
+// Reads a file in one buffer, preallocated from the file's size. Regular
+// files are read with positional reads and readahead hints, files without a
+// size, like pipes and /proc files, are read in chunks until end-of-file.
+Result<Buffer> read(std::string const& filepath, ReadOptions const& options, std::nothrow_t) noexcept;
+       Buffer  read(std::string const& filepath, ReadOptions const& options);
+
 //
 // void const*
 //
@@ -117,8 +145,19 @@ Result<std::size_t> write(int fd, Buffer const& buffer, std::nothrow_t) noexcept
 Result<> write(std::string const& filepath, Buffer const& buffer, std::nothrow_t) noexcept;
 void     write(std::string const& filepath, Buffer const& buffer);
 
-std::string get_mime_type_from_extension(std::string const& extension, std::string const& default_mime_type);
-std::string get_mime_type_from_file(std::string const& pathname, std::string const& default_mime_type);
+// MIME type lookups return views into static storage, or default_mime_type
+// when the type is not known.
+std::string_view get_mime_type_from_extension(std::string_view extension, std::string_view default_mime_type) noexcept;
+
+// Content sniffing of the first bytes of data against a table of magic
+// signatures.
+std::string_view get_mime_type(void const* data, std::size_t size, std::string_view default_mime_type) noexcept;
+std::string_view get_mime_type(Source& source, std::string_view default_mime_type) noexcept;
+
+// Content sniffing of a regular file, falling back to its extension. Results
+// are cached by inode and modification time.
+Result<std::string_view> get_mime_type_from_file(std::string const& pathname, std::string_view default_mime_type, std::nothrow_t) noexcept;
+       std::string_view  get_mime_type_from_file(std::string const& pathname, std::string_view default_mime_type);
 
 Result<> fd_set_non_blocking(int fd, bool enable, std::nothrow_t) noexcept;
 void fd_set_non_blocking(int fd, bool enable);
@@ -197,6 +236,169 @@ private:
     std::array<Handle<int, -1>, 2> m_fds;
 };
 
+// Read-only memory mapping of a file. The mapping can be used as a Source
+// with make_source() and make_shared_source(), as a std::string_view or as a
+// range of bytes, without copying the file's contents.
+class MappedFile final
+{
+    HLIB_NOT_COPYABLE(MappedFile);
+
+public:
+    // madvise() hints, applied on a best effort basis. Normal resets the
+    // Sequential and Random access patterns.
+    static constexpr std::uint32_t Normal{ 0x00 };
+    static constexpr std::uint32_t Sequential{ 0x01 };
+    static constexpr std::uint32_t Random{ 0x02 };
+    static constexpr std::uint32_t WillNeed{ 0x04 };
+    static constexpr std::uint32_t HugePage{ 0x08 };
+
+public:
+    MappedFile() noexcept = default;
+    MappedFile(std::string const& filepath, std::uint32_t advice, std::error_code& error_code) noexcept;
+    MappedFile(std::string const& filepath, std::uint32_t advice = Sequential);
+    MappedFile(MappedFile&& that) noexcept;
+    ~MappedFile();
+
+    MappedFile& operator =(MappedFile&& that) noexcept;
+
+    void const* data() const noexcept;
+    std::size_t size() const noexcept;
+    bool empty() const noexcept;
+
+    std::byte const* begin() const noexcept;
+    std::byte const* end() const noexcept;
+
+    std::string_view view() const noexcept;
+    std::string_view view(std::size_t offset, std::size_t size) const noexcept;
+
+    // Like Buffer::extract(), but returns a view of the data from offset up to
+    // sentinel and advances offset past it, or returns an empty view when
+    // sentinel is not found.
+    std::string_view extract(std::size_t& offset, std::string_view const& sentinel, bool include_sentinel) const noexcept;
+
+    Result<> open(std::string const& filepath, std::uint32_t advice, std::nothrow_t) noexcept;
+    void open(std::string const& filepath, std::uint32_t advice = Sequential);
+    Result<> open(int fd, std::uint32_t advice, std::nothrow_t) noexcept;
+    void open(int fd, std::uint32_t advice = Sequential);
+    void close() noexcept;
+
+    Result<> advise(std::size_t offset, std::size_t size, std::uint32_t advice, std::nothrow_t) noexcept;
+    void advise(std::size_t offset, std::size_t size, std::uint32_t advice);
+
+private:
+    void* m_data{ nullptr };
+    std::size_t m_size{ 0 };
+};
+
+std::shared_ptr<SourceAdapter<MappedFile>> make_shared_source_mapped_file(std::string const& filepath, std::uint32_t advice = MappedFile::Sequential);
+
+struct FileWriterOptions
+{
+    // Pending bytes that trigger a write, at least alignment.
+    std::size_t batch_size{ 1024 * 1024 };
+
+    // Writes triggered by batch_size end on a multiple of alignment, the
+    // remainder is held back for the next batch. Commits write everything.
+    std::size_t alignment{ 4096 };
+
+    // Size of the buffers small appends are gathered in.
+    std::size_t chunk_size{ 64 * 1024 };
+
+    // Time a commit waits for other writers to join before syncing.
+    time::Duration commit_latency{ time::USec(500) };
+
+    // Write and sync from a dedicated I/O thread instead of the appending
+    // and committing threads.
+    bool io_thread{ false };
+};
+
+// Append-only file writer for journals. Appends are gathered in chunks and
+// written in batches with pwritev(). commit() makes all data appended before
+// it durable, concurrent commits are coalesced into a single fdatasync(),
+// either by the first committing thread or by the I/O thread. FileWriter is
+// thread-safe.
+class FileWriter final
+{
+    HLIB_NOT_COPYABLE(FileWriter);
+    HLIB_NOT_MOVABLE(FileWriter);
+
+public:
+    struct Batch
+    {
+        std::size_t size;
+        std::size_t commits;
+        time::Duration write_latency;
+        time::Duration sync_latency;
+    };
+
+    struct Metrics
+    {
+        std::uint64_t batches{ 0 };
+        std::uint64_t bytes{ 0 };
+        std::uint64_t syncs{ 0 };
+        std::uint64_t commits{ 0 };
+        time::Duration write_latency;
+        time::Duration sync_latency;
+        time::Duration max_batch_latency;
+        std::size_t max_batch_size{ 0 };
+    };
+
+    typedef std::function<void(Batch const& batch)> OnBatch;
+
+public:
+    FileWriter() noexcept;
+    FileWriter(std::string const& filepath, FileWriterOptions const& options = FileWriterOptions());
+    ~FileWriter();
+
+    std::size_t size() const noexcept;
+    Metrics metrics() const noexcept;
+
+    void setBatchCallback(OnBatch callback) noexcept;
+
+    Result<> open(std::string const& filepath, FileWriterOptions const& options, std::nothrow_t) noexcept;
+    void open(std::string const& filepath, FileWriterOptions const& options = FileWriterOptions());
+
+    Result<> append(void const* data, std::size_t size, std::nothrow_t) noexcept;
+    void append(void const* data, std::size_t size);
+    Result<> append(Buffer&& buffer, std::nothrow_t) noexcept;
+    void append(Buffer&& buffer);
+
+    Result<> flush(std::nothrow_t) noexcept;
+    void flush();
+
+    Result<> commit(std::nothrow_t) noexcept;
+    void commit();
+
+    Result<> close(std::nothrow_t) noexcept;
+    void close();
+
+private:
+    FileWriterOptions m_options;
+    Handle<int, -1> m_fd;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::thread m_thread;
+    bool m_stop{ false };
+    bool m_writing{ false };
+    int m_error{ 0 };
+
+    std::deque<Buffer> m_chunks;
+    std::size_t m_appended{ 0 };
+    std::size_t m_taken{ 0 };
+    std::size_t m_written{ 0 };
+    std::size_t m_synced{ 0 };
+    std::size_t m_commit_target{ 0 };
+    std::size_t m_commits{ 0 };
+
+    Metrics m_metrics;
+    OnBatch m_on_batch;
+
+    Result<> errorLocked() const noexcept;
+    void writeLocked(std::unique_lock<std::mutex>& lock, bool aligned, bool sync);
+    void run();
+};
+
 } // namespace file
 } // namespace hlib
 
@@ -0,0 +1,375 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include "hlib/base.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+//
+// Type safe formatting into a std::string, Buffer, Sink or FormatBuffer in a
+// single pass without intermediate allocations.
+//
+// Placeholders are written as "{}" or "{:spec}" where spec is
+// "[<|>][0][width][.precision][type]" and type is one of d, x, X, o, b, c, s,
+// f, e or g. "{{" and "}}" produce literal braces.
+//
+// The HLIB_FORMAT() and HLIB_FORMAT_TO() macros verify at compile time that
+// the format string is well formed and that the number of placeholders
+// matches the number of arguments.
+//
+// The format string is passed as part of __VA_ARGS__, so that the macros
+// also accept a format string without arguments.
+#define HLIB_FORMAT_FIRST(first, ...) first
+
+#define HLIB_FORMAT_ASSERT(...) \
+    static_cast<void>([&]() noexcept { \
+        static_assert(hlib::format_count_arguments(HLIB_FORMAT_FIRST(__VA_ARGS__, 0)) + 1 \
+            == static_cast<int>(decltype(hlib::format_arity(__VA_ARGS__))::value), \
+            "Format string does not match arguments"); \
+    })
+
+#define HLIB_FORMAT(...) \
+    (HLIB_FORMAT_ASSERT(__VA_ARGS__), hlib::format(__VA_ARGS__))
+
+#define HLIB_FORMAT_TO(output, ...) \
+    (HLIB_FORMAT_ASSERT(__VA_ARGS__), hlib::format_to(output, __VA_ARGS__))
+
+namespace hlib
+{
+
+class Buffer;
+class Sink;
+
+struct FormatSpec
+{
+    char align{ 0 };
+    char fill{ ' ' };
+    std::size_t width{ 0 };
+    int precision{ -1 };
+    char type{ 0 };
+};
+
+constexpr std::size_t format_parse_spec(std::string_view format_string, std::size_t pos, FormatSpec& spec) noexcept
+{
+    auto is_digit = [](char c) constexpr noexcept { return c >= '0' && c <= '9'; };
+
+    std::size_t const size = format_string.size();
+
+    // Skip the opening brace.
+    ++pos;
+
+    if (pos < size && ':' == format_string[pos]) {
+        ++pos;
+
+        if (pos < size && ('<' == format_string[pos] || '>' == format_string[pos])) {
+            spec.align = format_string[pos++];
+        }
+        if (pos < size && '0' == format_string[pos]) {
+            spec.fill = '0';
+            ++pos;
+        }
+        while (pos < size && true == is_digit(format_string[pos])) {
+            spec.width = spec.width * 10 + static_cast<std::size_t>(format_string[pos++] - '0');
+        }
+        if (pos < size && '.' == format_string[pos]) {
+            ++pos;
+            if (pos >= size || false == is_digit(format_string[pos])) {
+                return std::string_view::npos;
+            }
+
+            spec.precision = 0;
+            while (pos < size && true == is_digit(format_string[pos])) {
+                spec.precision = spec.precision * 10 + (format_string[pos++] - '0');
+            }
+        }
+        if (pos < size && std::string_view::npos != std::string_view("dxXobcsfeg").find(format_string[pos])) {
+            spec.type = format_string[pos++];
+        }
+    }
+
+    if (pos >= size || '}' != format_string[pos]) {
+        return std::string_view::npos;
+    }
+
+    return pos + 1;
+}
+
+constexpr int format_count_arguments(std::string_view format_string) noexcept
+{
+    int count = 0;
+
+    for (std::size_t pos = 0; pos < format_string.size();) {
+        char const c = format_string[pos];
+
+        if ('{' == c) {
+            if (pos + 1 < format_string.size() && '{' == format_string[pos + 1]) {
+                pos += 2;
+                continue;
+            }
+
+            FormatSpec spec;
+            pos = format_parse_spec(format_string, pos, spec);
+            if (std::string_view::npos == pos) {
+                return -1;
+            }
+            ++count;
+        }
+        else if ('}' == c) {
+            if (pos + 1 >= format_string.size() || '}' != format_string[pos + 1]) {
+                return -1;
+            }
+            pos += 2;
+        }
+        else {
+            ++pos;
+        }
+    }
+
+    return count;
+}
+
+template<typename... Args>
+std::integral_constant<std::size_t, sizeof...(Args)> format_arity(Args const&...) noexcept;
+
+class FormatArgument final
+{
+public:
+    enum Type
+    {
+        Bool,
+        Char,
+        Signed,
+        Unsigned,
+        Float,
+        String
+    };
+
+public:
+    FormatArgument(bool value) noexcept
+        : m_type{ Bool }
+        , m_integer{ value }
+    {
+    }
+
+    FormatArgument(char value) noexcept
+        : m_type{ Char }
+        , m_integer{ static_cast<unsigned char>(value) }
+    {
+    }
+
+    template<typename T, typename std::enable_if<std::is_integral<T>::value
+                                              && std::is_signed<T>::value
+                                              && !std::is_same<char, T>::value, int>::type = 0>
+    FormatArgument(T value) noexcept
+        : m_type{ Signed }
+        , m_integer{ static_cast<std::uint64_t>(static_cast<std::int64_t>(value)) }
+    {
+    }
+
+    template<typename T, typename std::enable_if<std::is_integral<T>::value
+                                              && std::is_unsigned<T>::value
+                                              && !std::is_same<bool, T>::value
+                                              && !std::is_same<char, T>::value, int>::type = 0>
+    FormatArgument(T value) noexcept
+        : m_type{ Unsigned }
+        , m_integer{ value }
+    {
+    }
+
+    template<typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+    FormatArgument(T value) noexcept
+        : m_type{ Float }
+        , m_float{ static_cast<double>(value) }
+    {
+    }
+
+    // Pointers other than strings would otherwise convert to bool.
+    template<typename T, typename std::enable_if<!std::is_same<char, typename std::remove_cv<T>::type>::value, int>::type = 0>
+    FormatArgument(T* value) = delete;
+
+    FormatArgument(char const* value) noexcept
+        : m_type{ String }
+        , m_string{ nullptr != value ? std::string_view(value) : std::string_view("(null)") }
+    {
+    }
+
+    FormatArgument(std::string_view value) noexcept
+        : m_type{ String }
+        , m_string{ value }
+    {
+    }
+
+    FormatArgument(std::string const& value) noexcept
+        : m_type{ String }
+        , m_string{ value }
+    {
+    }
+
+    Type type() const noexcept
+    {
+        return m_type;
+    }
+
+    std::int64_t getSigned() const noexcept
+    {
+        return static_cast<std::int64_t>(m_integer);
+    }
+
+    std::uint64_t getUnsigned() const noexcept
+    {
+        return m_integer;
+    }
+
+    double getFloat() const noexcept
+    {
+        return m_float;
+    }
+
+    std::string_view getString() const noexcept
+    {
+        return m_string;
+    }
+
+private:
+    Type m_type;
+    std::uint64_t m_integer{ 0 };
+    double m_float{ 0.0 };
+    std::string_view m_string;
+};
+
+class FormatOutput
+{
+public:
+    virtual bool write(char const* data, std::size_t size) noexcept = 0;
+
+protected:
+    FormatOutput() = default;
+    ~FormatOutput() = default;
+};
+
+template<std::size_t Capacity>
+class FormatBuffer final : public FormatOutput
+{
+public:
+    FormatBuffer() noexcept
+    {
+        m_data[0] = '\0';
+    }
+
+    FormatBuffer(FormatBuffer const& that) noexcept
+        : FormatOutput()
+        , m_size{ that.m_size }
+    {
+        std::char_traits<char>::copy(m_data, that.m_data, m_size + 1);
+    }
+
+    FormatBuffer& operator=(FormatBuffer const& that) noexcept
+    {
+        m_size = that.m_size;
+        std::char_traits<char>::copy(m_data, that.m_data, m_size + 1);
+        return *this;
+    }
+
+    bool write(char const* data, std::size_t size) noexcept override
+    {
+        std::size_t const length = std::min(size, Capacity - m_size);
+
+        std::char_traits<char>::copy(m_data + m_size, data, length);
+        m_size += length;
+        m_data[m_size] = '\0';
+
+        return length == size;
+    }
+
+    void clear() noexcept
+    {
+        m_size = 0;
+        m_data[0] = '\0';
+    }
+
+    bool empty() const noexcept
+    {
+        return 0 == m_size;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    static constexpr std::size_t capacity() noexcept
+    {
+        return Capacity;
+    }
+
+    char const* data() const noexcept
+    {
+        return m_data;
+    }
+
+    char const* c_str() const noexcept
+    {
+        return m_data;
+    }
+
+    std::string_view view() const noexcept
+    {
+        return std::string_view(m_data, m_size);
+    }
+
+private:
+    char m_data[Capacity + 1];
+    std::size_t m_size{ 0 };
+};
+
+bool vformat_to(FormatOutput& output, std::string_view format_string, FormatArgument const* arguments, std::size_t count) noexcept;
+bool vformat_to(std::string& string, std::string_view format_string, FormatArgument const* arguments, std::size_t count) noexcept;
+bool vformat_to(Buffer& buffer, std::string_view format_string, FormatArgument const* arguments, std::size_t count) noexcept;
+bool vformat_to(Sink& sink, std::string_view format_string, FormatArgument const* arguments, std::size_t count) noexcept;
+
+template<typename Output, typename... Args>
+bool format_to(Output& output, std::string_view format_string, Args const&... args) noexcept
+{
+    std::array<FormatArgument, sizeof...(Args)> const arguments{ { FormatArgument(args)... } };
+    return vformat_to(output, format_string, arguments.data(), arguments.size());
+}
+
+template<typename... Args>
+std::string format(std::string_view format_string, Args const&... args) noexcept
+{
+    std::string string;
+
+    if (false == format_to(string, format_string, args...)) {
+        return std::string();
+    }
+
+    return string;
+}
+
+} // namespace hlib
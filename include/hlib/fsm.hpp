@@ -23,14 +23,23 @@
 //
 #pragma once
 
+#include "hlib/base.hpp"
+#include <algorithm>
 #include <any>
+#include <array>
 #include <functional>
+#include <initializer_list>
 #include <unordered_map>
+#include <vector>
 
 namespace hlib
 {
 
-template<typename State, typename Event>
+// An FSM optionally records its most recent transitions in a fixed-size ring
+// buffer of TraceCapacity entries. With the default TraceCapacity of 0 no
+// trace storage exists and no tracing code is generated.
+//
+template<typename State, typename Event, std::size_t TraceCapacity = 0>
 class FSM final
 {
     static_assert(std::is_enum<State>::value, "State must be an enum type");
@@ -45,6 +54,14 @@ public:
     typedef std::function<void(State from, Event event, State to, std::any const& data)> TransitionCallback;
     typedef std::function<void(State state, Event event)> InvalidTransitionCallback;
 
+    struct Trace
+    {
+        State from;
+        Event event;
+        State to;
+        bool valid;
+    };
+
     struct Transition
     {
         State from;
@@ -107,12 +124,55 @@ public:
         m_state = m_initial;
     }
 
-    bool apply(Event event, std::any const& data) noexcept
+    // Make state a sub-state of parent. Events without a transition for a
+    // sub-state are looked up in its parent, recursively, so that transitions
+    // shared by several states need to be specified only once. Returns false,
+    // leaving the hierarchy unchanged, if parent is state or one of its
+    // sub-states, as the resulting cycle would never terminate a lookup.
+    bool setParent(State state, State parent)
     {
-        std::uint64_t const key = combine(m_state, event);
+        for (State ancestor = parent; ; ) {
+            if (ancestor == state) {
+                return false;
+            }
 
-        auto it = m_transitions.find(key);
+            auto it = m_parents.find(ancestor);
+            if (m_parents.end() == it) {
+                break;
+            }
+
+            ancestor = it->second;
+        }
+
+        m_parents[state] = parent;
+        return true;
+    }
+
+    // Returns whether the current state is state or one of its sub-states.
+    bool in(State state) const noexcept
+    {
+        State current = m_state;
+
+        while (true) {
+            if (current == state) {
+                return true;
+            }
+
+            auto it = m_parents.find(current);
+            if (m_parents.end() == it) {
+                return false;
+            }
+
+            current = it->second;
+        }
+    }
+
+    bool apply(Event event, std::any const& data) noexcept
+    {
+        auto it = find(m_state, event);
         if (m_transitions.end() == it) {
+            trace(m_state, event, m_state, false);
+
             if (nullptr != m_on_invalid_transition) {
                 m_on_invalid_transition(m_state, event);
             }
@@ -130,6 +190,8 @@ public:
             it->second.second(from, event, to, data);
         }
 
+        trace(from, event, to, true);
+
         m_state = to;
         return true;
     }
@@ -139,13 +201,110 @@ public:
         return apply(event, std::any());
     }
 
+    // Apply a burst of events in order, returns the number of valid transitions.
+    // Each event still invokes the before-transition callback on its own, as
+    // that callback reports the from and to state of a single transition and
+    // observers rely on seeing every intermediate state. Coalescing it per
+    // batch would need a different callback signature altogether.
+    std::size_t applyAll(Event const* events, std::size_t count, std::any const& data = std::any()) noexcept
+    {
+        std::size_t applied = 0;
+
+        for (std::size_t i = 0; i < count; ++i) {
+            applied += apply(events[i], data);
+        }
+
+        return applied;
+    }
+
+    std::size_t applyAll(std::initializer_list<Event> events, std::any const& data = std::any()) noexcept
+    {
+        return applyAll(events.begin(), events.size(), data);
+    }
+
+    std::size_t applyAll(std::vector<Event> const& events, std::any const& data = std::any()) noexcept
+    {
+        return applyAll(events.data(), events.size(), data);
+    }
+
+    // Returns the traced transitions, oldest first.
+    std::vector<Trace> traces() const
+    {
+        std::vector<Trace> result;
+
+        if constexpr (TraceCapacity > 0) {
+            std::size_t const count = std::min(m_trace.count, TraceCapacity);
+            result.reserve(count);
+
+            for (std::size_t i = m_trace.count - count; i < m_trace.count; ++i) {
+                result.push_back(m_trace.entries[i % TraceCapacity]);
+            }
+        }
+
+        return result;
+    }
+
+    void clearTraces() noexcept
+    {
+        if constexpr (TraceCapacity > 0) {
+            m_trace.count = 0;
+        }
+    }
+
 private:
+    struct TraceBuffer
+    {
+        std::array<Trace, TraceCapacity> entries;
+        std::size_t count{ 0 };
+    };
+
+    struct NoTraceBuffer
+    {
+    };
+
+    typedef std::unordered_map<std::uint64_t, std::pair<State, TransitionCallback>> Transitions;
+
     State m_initial = State();
     State m_state = State();
-    std::unordered_map<std::uint64_t, std::pair<State, TransitionCallback>> m_transitions;
+    Transitions m_transitions;
+    std::unordered_map<State, State> m_parents;
     TransitionCallback m_on_before_transition;
     InvalidTransitionCallback m_on_invalid_transition;
 
+    std::conditional_t<0 != TraceCapacity, TraceBuffer, NoTraceBuffer> m_trace{};
+
+    typename Transitions::const_iterator find(State state, Event event) const noexcept
+    {
+        auto it = m_transitions.find(combine(state, event));
+        if (m_transitions.end() != it || true == m_parents.empty()) {
+            return it;
+        }
+
+        // Look up the transition in the state's ancestors.
+        for (auto parent = m_parents.find(state); m_parents.end() != parent; parent = m_parents.find(parent->second)) {
+            it = m_transitions.find(combine(parent->second, event));
+            if (m_transitions.end() != it) {
+                return it;
+            }
+        }
+
+        return m_transitions.end();
+    }
+
+    void trace(State from, Event event, State to, bool valid) noexcept
+    {
+        if constexpr (TraceCapacity > 0) {
+            m_trace.entries[m_trace.count % TraceCapacity] = Trace{ from, event, to, valid };
+            ++m_trace.count;
+        }
+        else {
+            (void)from;
+            (void)event;
+            (void)to;
+            (void)valid;
+        }
+    }
+
     static constexpr std::uint64_t combine(State state, Event event) noexcept
     {
         return (static_cast<std::uint64_t>(state))
@@ -348,13 +348,13 @@ struct RatioValue final
         return *this = *this / that;
     }
 
-    T const& value() const noexcept
+    constexpr T const& value() const noexcept
     {
         return m_value;
     }
 
     template<typename Ratio, typename Type = T>
-    typename std::enable_if<IsRatio<Ratio>::value, RatioValue<Ratio, Type>>::type
+    constexpr typename std::enable_if<IsRatio<Ratio>::value, RatioValue<Ratio, Type>>::type
     to() const noexcept
     {
         using Factor = std::ratio_divide<R, Ratio>;
@@ -362,7 +362,7 @@ struct RatioValue final
     }
 
     template<typename TRatioValue>
-    typename std::enable_if<!IsRatio<TRatioValue>::value
+    constexpr typename std::enable_if<!IsRatio<TRatioValue>::value
                          && !std::is_floating_point<TRatioValue>::value, TRatioValue>::type
     to() const noexcept
     {
@@ -0,0 +1,147 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include "hlib/base.hpp"
+#include "hlib/event_loop.hpp"
+#include "hlib/memory.hpp"
+#include "hlib/sock_addr.hpp"
+#include "hlib/time.hpp"
+#include "hlib/timer.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace hlib
+{
+
+// Asynchronous DNS stub resolver. Queries A and AAAA records over UDP from
+// a single nameserver and caches answers for their TTL. Each query uses its
+// own socket, so that its ephemeral source port adds to the query ID in
+// guarding the cache against spoofed answers (RFC 5452). Literal addresses
+// and cached names complete synchronously, from within resolve() or
+// connect(). A resolver and its event loop must be used from one thread.
+class Resolver final
+{
+    HLIB_NOT_COPYABLE(Resolver);
+    HLIB_NOT_MOVABLE(Resolver);
+
+public:
+    struct Options
+    {
+        // Nameserver to query, the first nameserver in /etc/resolv.conf if
+        // empty. Port 53 is used if no port is set.
+        SockAddr nameserver;
+
+        // Time to wait for an answer before retransmitting a query, and
+        // the number of transmissions before failing with ETIMEDOUT.
+        time::DurationNs timeout{ time::MSec(1000) };
+        unsigned attempts{ 3 };
+
+        // Maximum number of cached answers, one per name and record type.
+        std::size_t cache_size{ 1024 };
+
+        // Delay before connect() tries the next address while earlier
+        // attempts are still pending (RFC 8305).
+        time::DurationNs connection_attempt_delay{ time::MSec(250) };
+
+        // Time connect() waits for the AAAA answer when the A answer
+        // arrives first (RFC 8305).
+        time::DurationNs resolution_delay{ time::MSec(50) };
+    };
+
+    // Resolved addresses with the requested port, IPv6 before IPv4, or an
+    // errno value on failure.
+    typedef std::function<void(std::vector<SockAddr> const& addresses, int error)> OnResolved;
+
+    // Connected non-blocking socket and its address, or an invalid handle
+    // and an errno value on failure.
+    typedef std::function<void(Handle<int, -1> fd, SockAddr const& address, int error)> OnConnected;
+
+public:
+    Resolver(std::weak_ptr<EventLoop> event_loop);
+    Resolver(std::weak_ptr<EventLoop> event_loop, Options options);
+    ~Resolver();
+
+    SockAddr const& nameserver() const noexcept;
+
+    void resolve(std::string_view host, std::uint16_t port, OnResolved callback,
+        SockAddr::Mask mask = SockAddr::IPv4 | SockAddr::IPv6);
+
+    // Resolves host and connects to its addresses alternating between IPv6
+    // and IPv4, starting a next attempt when the previous one fails or
+    // after the connection attempt delay. Attempts start with the first
+    // answer, or after the resolution delay if that is the A answer, and
+    // addresses answered later join them. The first connection wins.
+    void connect(std::string_view host, std::uint16_t port, int type, OnConnected callback,
+        SockAddr::Mask mask = SockAddr::IPv4 | SockAddr::IPv6);
+
+    // Cancels all pending resolves and connects without callback.
+    void cancel() noexcept;
+
+    void clearCache() noexcept;
+
+private:
+    struct Request;
+    struct Query;
+    struct Connection;
+
+    struct CacheEntry
+    {
+        std::vector<SockAddr> addresses;
+        time::TimePoint expires;
+    };
+
+    std::weak_ptr<EventLoop> m_event_loop;
+    Options m_options;
+
+    Timer m_timer;
+    std::mt19937 m_random;
+
+    std::unordered_map<std::uint16_t, std::shared_ptr<Query>> m_queries;
+    std::unordered_map<std::string, CacheEntry> m_cache;
+
+    std::uint64_t m_next_connection{ 0 };
+    std::unordered_map<std::uint64_t, std::shared_ptr<Connection>> m_connections;
+
+    void query(std::string const& name, std::uint16_t type, std::shared_ptr<Request> const& request);
+    void deliver(Query& query, std::vector<SockAddr> const& addresses, int error);
+    void updateTimer() noexcept;
+
+    void onReceive(std::uint16_t id, int fd);
+    void onResponse(std::uint16_t id, std::uint8_t const* data, std::size_t size);
+    void onTimeout();
+
+    void onLookup(std::uint64_t id, std::vector<SockAddr> const& addresses, int error, bool ipv6);
+    void attempt(std::uint64_t id);
+    void onAttempt(std::uint64_t id, int fd);
+    void finish(std::uint64_t id, Handle<int, -1> fd, SockAddr const& address, int error);
+};
+
+} // namespace hlib
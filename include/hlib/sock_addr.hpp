@@ -24,9 +24,11 @@
 #pragma once
 
 #include "hlib/base.hpp"
+#include <functional>
 #include <netinet/in.h>
 #include <sys/un.h>
 #include <string>
+#include <string_view>
 
 namespace hlib
 {
@@ -40,6 +42,10 @@ public:
     static constexpr Mask Unix{ 1 << AF_UNIX };
     static constexpr Mask All{ ~Mask(0) };
 
+    // Buffer size that fits any formatted address, including the zero
+    // terminator.
+    static constexpr std::size_t MaxStringSize{ sizeof(sockaddr_un::sun_path) + 1 };
+
 public:
     SockAddr() noexcept;
 
@@ -51,7 +57,7 @@ public:
     explicit SockAddr(sockaddr_un const& that) noexcept;
     explicit SockAddr(sockaddr_storage const& that) noexcept;
 
-    SockAddr(std::string const& that, Mask mask = All);
+    SockAddr(std::string_view that, Mask mask = All);
 
     SockAddr& operator = (SockAddr&& that) noexcept;
 
@@ -60,7 +66,10 @@ public:
     SockAddr& operator = (sockaddr_in6 const& that) noexcept;
     SockAddr& operator = (sockaddr_un const& that) noexcept;
     SockAddr& operator = (sockaddr_storage const& that) noexcept;
-    SockAddr& operator = (std::string const& that) noexcept;
+    SockAddr& operator = (std::string_view that) noexcept;
+
+    bool operator == (SockAddr const& that) const noexcept;
+    bool operator != (SockAddr const& that) const noexcept;
 
     sa_family_t family() const noexcept;
     std::size_t length() const noexcept;
@@ -68,6 +77,12 @@ public:
     std::string address() const;
     bool empty() const noexcept;
 
+    // Writes the zero terminated address into buffer. Returns the length
+    // of the address, or zero if it does not fit.
+    std::size_t address(char* buffer, std::size_t size) const noexcept;
+
+    std::size_t hash() const noexcept;
+
     explicit operator sockaddr const* () const noexcept;
     explicit operator sockaddr const* () noexcept;
     explicit operator sockaddr* () noexcept;
@@ -89,8 +104,8 @@ public:
 
     void clear() noexcept;
 
-    bool parse(std::string const& string, Mask mask, std::nothrow_t) noexcept;
-    void parse(std::string const& string, Mask mask = All);
+    bool parse(std::string_view string, Mask mask, std::nothrow_t) noexcept;
+    void parse(std::string_view string, Mask mask = All);
 
 private:
     union
@@ -105,5 +120,23 @@ private:
 
 std::string to_string(SockAddr const& sa);
 
+// Writes the zero terminated address and port, formatted like to_string(),
+// into buffer. Returns the length of the string, or zero if it does not fit.
+std::size_t format_sock_addr(char* buffer, std::size_t size, SockAddr const& sa) noexcept;
+
 } // namespace hlib
 
+namespace std
+{
+
+template<>
+struct hash<hlib::SockAddr>
+{
+    std::size_t operator()(hlib::SockAddr const& sa) const noexcept
+    {
+        return sa.hash();
+    }
+};
+
+} // namespace std
+
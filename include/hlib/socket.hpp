@@ -30,10 +30,35 @@
 #include "hlib/sock_addr.hpp"
 #include "hlib/source.hpp"
 #include <deque>
+#include <optional>
 
 namespace hlib
 {
 
+// Typed socket options. Options that are not set keep their current value.
+struct SocketOptions
+{
+    std::optional<bool> no_delay;           // TCP_NODELAY
+    std::optional<bool> cork;               // TCP_CORK
+    std::optional<bool> quick_ack;          // TCP_QUICKACK
+    std::optional<int> send_buffer;         // SO_SNDBUF, in bytes
+    std::optional<int> receive_buffer;      // SO_RCVBUF, in bytes
+    std::optional<int> busy_poll;           // SO_BUSY_POLL, in microseconds
+    std::optional<int> incoming_cpu;        // SO_INCOMING_CPU
+    std::optional<bool> fast_open_connect;  // TCP_FASTOPEN_CONNECT, before connecting
+
+    // Listening sockets only.
+    std::optional<int> defer_accept;        // TCP_DEFER_ACCEPT, in seconds
+    std::optional<int> fast_open;           // TCP_FASTOPEN, queue length
+
+    // Sends with MSG_MORE while more sources are queued, so that batched
+    // sends leave the socket as full segments.
+    bool coalesce{ false };
+};
+
+Result<> set_socket_options(int fd, SocketOptions const& options, std::nothrow_t) noexcept;
+void set_socket_options(int fd, SocketOptions const& options);
+
 class Socket final
 {
     HLIB_NOT_COPYABLE(Socket);
@@ -65,6 +90,15 @@ public:
     void setConnectedCallback(OnConnected callback) noexcept;
     void setCloseCallback(OnClose callback) noexcept;
 
+    // Applies options to the open socket, to sockets subsequently opened,
+    // and to the sockets accepted by a listening socket before they are
+    // passed to the accept callback. Connections, established or in
+    // progress, skip the listening and connecting options, and listening
+    // sockets skip the connecting options. An accepted socket whose options
+    // cannot be set is closed without callback.
+    Result<> setOptions(SocketOptions options, std::nothrow_t) noexcept;
+    void setOptions(SocketOptions options);
+
     Result<> open(Handle<int, -1> fd, std::nothrow_t) noexcept;
     void open(Handle<int, -1> fd);
 
@@ -80,6 +114,10 @@ public:
 
     void close() noexcept;
 
+    // Detaches the file descriptor from the socket and its event loop
+    // without closing it, discarding pending receives and sends.
+    Handle<int, -1> release() noexcept;
+
 private:
     std::weak_ptr<EventLoop> m_event_loop;
     Handle<int, -1> m_fd;
@@ -88,9 +126,12 @@ private:
     OnConnected m_on_connected;
     OnClose m_on_close;
 
+    SocketOptions m_options;
+
     std::mutex m_mutex;
 
     bool m_connected{ false };
+    bool m_listening{ false };
     std::uint32_t m_events{ 0 };
 
     std::shared_ptr<Sink> m_receive_sink;
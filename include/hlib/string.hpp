@@ -25,33 +25,36 @@
 
 #include "hlib/base.hpp"
 #include "hlib/buffer.hpp"
+#include <cstring>
 #include <functional>
+#include <iterator>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <type_traits>
 
 namespace hlib
 {
 
-std::optional<bool> stob(std::string const& value, std::nothrow_t);
+std::optional<bool> stob(std::string_view value, std::nothrow_t);
 
-std::optional<std::int8_t> stoi8(std::string const& value, int base, std::nothrow_t);
-std::optional<std::int16_t> stoi16(std::string const& value, int base, std::nothrow_t);
-std::optional<std::int32_t> stoi32(std::string const& value, int base, std::nothrow_t);
-std::optional<std::int64_t> stoi64(std::string const& value, int base, std::nothrow_t);
+std::optional<std::int8_t> stoi8(std::string_view value, int base, std::nothrow_t);
+std::optional<std::int16_t> stoi16(std::string_view value, int base, std::nothrow_t);
+std::optional<std::int32_t> stoi32(std::string_view value, int base, std::nothrow_t);
+std::optional<std::int64_t> stoi64(std::string_view value, int base, std::nothrow_t);
 
-std::optional<std::uint8_t> stoui8(std::string const& value, int base, std::nothrow_t);
-std::optional<std::uint16_t> stoui16(std::string const& value, int base, std::nothrow_t);
-std::optional<std::uint32_t> stoui32(std::string const& value, int base, std::nothrow_t);
-std::optional<std::uint64_t> stoui64(std::string const& value, int base, std::nothrow_t);
+std::optional<std::uint8_t> stoui8(std::string_view value, int base, std::nothrow_t);
+std::optional<std::uint16_t> stoui16(std::string_view value, int base, std::nothrow_t);
+std::optional<std::uint32_t> stoui32(std::string_view value, int base, std::nothrow_t);
+std::optional<std::uint64_t> stoui64(std::string_view value, int base, std::nothrow_t);
 
-std::optional<float> stof32(std::string const& value, std::nothrow_t);
-std::optional<double> stof64(std::string const& value, std::nothrow_t);
+std::optional<float> stof32(std::string_view value, std::nothrow_t);
+std::optional<double> stof64(std::string_view value, std::nothrow_t);
 
 template<typename T>
 typename std::enable_if<std::is_same<bool, T>::value, std::optional<bool>>::type
-string_to(std::string const& value, std::nothrow_t)
+string_to(std::string_view value, std::nothrow_t)
 {
     return stob(value, std::nothrow);
 }
@@ -61,7 +64,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_signed<T>::value
                      && 1 == sizeof(T), std::optional<T>>::type
-string_to(std::string const& value, int base, std::nothrow_t)
+string_to(std::string_view value, int base, std::nothrow_t)
 {
     return stoi8(value, base, std::nothrow);
 }
@@ -71,7 +74,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_signed<T>::value
                      && 2 == sizeof(T), std::optional<T>>::type
-string_to(std::string const& value, int base, std::nothrow_t)
+string_to(std::string_view value, int base, std::nothrow_t)
 {
     return stoi16(value, base, std::nothrow);
 }
@@ -81,7 +84,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_signed<T>::value
                      && 4 == sizeof(T), std::optional<T>>::type
-string_to(std::string const& value, int base, std::nothrow_t)
+string_to(std::string_view value, int base, std::nothrow_t)
 {
     return stoi32(value, base, std::nothrow);
 }
@@ -91,7 +94,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_signed<T>::value
                      && 8 == sizeof(T), std::optional<T>>::type
-string_to(std::string const& value, int base, std::nothrow_t)
+string_to(std::string_view value, int base, std::nothrow_t)
 {
     return stoi64(value, base, std::nothrow);
 }
@@ -101,7 +104,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_unsigned<T>::value
                      && 1 == sizeof(T), std::optional<T>>::type
-string_to(std::string const& value, int base, std::nothrow_t)
+string_to(std::string_view value, int base, std::nothrow_t)
 {
     return stoui8(value, base, std::nothrow);
 }
@@ -111,7 +114,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_unsigned<T>::value
                      && 2 == sizeof(T), std::optional<T>>::type
-string_to(std::string const& value, int base, std::nothrow_t)
+string_to(std::string_view value, int base, std::nothrow_t)
 {
     return stoui16(value, base, std::nothrow);
 }
@@ -121,7 +124,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_unsigned<T>::value
                      && 4 == sizeof(T), std::optional<T>>::type
-string_to(std::string const& value, int base, std::nothrow_t)
+string_to(std::string_view value, int base, std::nothrow_t)
 {
     return stoui32(value, base, std::nothrow);
 }
@@ -131,7 +134,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_unsigned<T>::value
                      && 8 == sizeof(T), std::optional<T>>::type
-string_to(std::string const& value, int base, std::nothrow_t)
+string_to(std::string_view value, int base, std::nothrow_t)
 {
     return stoui64(value, base, std::nothrow);
 }
@@ -139,7 +142,7 @@ string_to(std::string const& value, int base, std::nothrow_t)
 template<typename T>
 typename std::enable_if<std::is_floating_point<T>::value
                      && 4 == sizeof(T), std::optional<T>>::type
-string_to(std::string const& value, std::nothrow_t)
+string_to(std::string_view value, std::nothrow_t)
 {
     return stof32(value, std::nothrow);
 }
@@ -147,29 +150,29 @@ string_to(std::string const& value, std::nothrow_t)
 template<typename T>
 typename std::enable_if<std::is_floating_point<T>::value
                      && 8 == sizeof(T), std::optional<T>>::type
-string_to(std::string const& value, std::nothrow_t)
+string_to(std::string_view value, std::nothrow_t)
 {
     return stof64(value, std::nothrow);
 }
 
-bool stob(std::string const& value);
+bool stob(std::string_view value);
 
-std::int8_t stoi8(std::string const& value, int base = 10);
-std::int16_t stoi16(std::string const& value, int base = 10);
-std::int32_t stoi32(std::string const& value, int base = 10);
-std::int64_t stoi64(std::string const& value, int base = 10);
+std::int8_t stoi8(std::string_view value, int base = 10);
+std::int16_t stoi16(std::string_view value, int base = 10);
+std::int32_t stoi32(std::string_view value, int base = 10);
+std::int64_t stoi64(std::string_view value, int base = 10);
 
-std::uint8_t stoui8(std::string const& value, int base = 10);
-std::uint16_t stoui16(std::string const& value, int base = 10);
-std::uint32_t stoui32(std::string const& value, int base = 10);
-std::uint64_t stoui64(std::string const& value, int base = 10);
+std::uint8_t stoui8(std::string_view value, int base = 10);
+std::uint16_t stoui16(std::string_view value, int base = 10);
+std::uint32_t stoui32(std::string_view value, int base = 10);
+std::uint64_t stoui64(std::string_view value, int base = 10);
 
-float stof32(std::string const& value);
-double stof64(std::string const& value);
+float stof32(std::string_view value);
+double stof64(std::string_view value);
 
 template<typename T>
 typename std::enable_if<std::is_same<bool, T>::value, T>::type
-string_to(std::string const& value)
+string_to(std::string_view value)
 {
     return stob(value);
 }
@@ -179,7 +182,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_signed<T>::value
                      && 1 == sizeof(T), T>::type
-string_to(std::string const& value, int base = 10)
+string_to(std::string_view value, int base = 10)
 {
     return stoi8(value, base);
 }
@@ -189,7 +192,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_signed<T>::value
                      && 2 == sizeof(T), T>::type
-string_to(std::string const& value, int base = 10)
+string_to(std::string_view value, int base = 10)
 {
     return stoi16(value, base);
 }
@@ -199,7 +202,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_signed<T>::value
                      && 4 == sizeof(T), T>::type
-string_to(std::string const& value, int base = 10)
+string_to(std::string_view value, int base = 10)
 {
     return stoi32(value, base);
 }
@@ -209,7 +212,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_signed<T>::value
                      && 8 == sizeof(T), T>::type
-string_to(std::string const& value, int base = 10)
+string_to(std::string_view value, int base = 10)
 {
     return stoi64(value, base);
 }
@@ -219,7 +222,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_unsigned<T>::value
                      && 1 == sizeof(T), T>::type
-string_to(std::string const& value, int base = 10)
+string_to(std::string_view value, int base = 10)
 {
     return stoui8(value, base);
 }
@@ -229,7 +232,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_unsigned<T>::value
                      && 2 == sizeof(T), T>::type
-string_to(std::string const& value, int base = 10)
+string_to(std::string_view value, int base = 10)
 {
     return stoui16(value, base);
 }
@@ -239,7 +242,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_unsigned<T>::value
                      && 4 == sizeof(T), T>::type
-string_to(std::string const& value, int base = 10)
+string_to(std::string_view value, int base = 10)
 {
     return stoui32(value, base);
 }
@@ -249,7 +252,7 @@ typename std::enable_if<!std::is_same<bool, T>::value
                      && std::is_integral<T>::value
                      && std::is_unsigned<T>::value
                      && 8 == sizeof(T), T>::type
-string_to(std::string const& value, int base = 10)
+string_to(std::string_view value, int base = 10)
 {
     return stoui64(value, base);
 }
@@ -257,7 +260,7 @@ string_to(std::string const& value, int base = 10)
 template<typename T>
 typename std::enable_if<std::is_floating_point<T>::value
                      && 4 == sizeof(T), T>::type
-string_to(std::string const& value)
+string_to(std::string_view value)
 {
     return stof32(value);
 }
@@ -265,7 +268,7 @@ string_to(std::string const& value)
 template<typename T>
 typename std::enable_if<std::is_floating_point<T>::value
                      && 8 == sizeof(T), T>::type
-string_to(std::string const& value)
+string_to(std::string_view value)
 {
     return stof64(value);
 }
@@ -297,6 +300,177 @@ std::string fill_right(std::string const& string, std::size_t length, char c = '
 std::vector<std::string> split(std::string const& string, std::function<bool(char)> const& is_delimiter, bool filter_empty = false);
 std::vector<std::string> split(std::string const& string, char delimiter, bool filter_empty = false);
 
+std::string_view trim_left_view(std::string_view string, std::string_view chars = " \t\v\f\r\n") noexcept;
+std::string_view trim_right_view(std::string_view string, std::string_view chars = " \t\v\f\r\n") noexcept;
+std::string_view trim_view(std::string_view string, std::string_view chars = " \t\v\f\r\n") noexcept;
+
+//
+// Character class predicates for split_view(). These have dedicated
+// find_delimiter() overloads that scan many characters at once.
+//
+struct IsChar
+{
+    char character;
+
+    bool operator()(char c) const noexcept
+    {
+        return character == c;
+    }
+};
+
+struct IsSpace
+{
+    bool operator()(char c) const noexcept
+    {
+        return ' ' == c || (c >= '\t' && c <= '\r');
+    }
+};
+
+template<typename Predicate>
+char const* find_delimiter(char const* first, char const* last, Predicate const& is_delimiter)
+{
+    for (; first != last; ++first) {
+        if (is_delimiter(*first)) {
+            break;
+        }
+    }
+    return first;
+}
+
+inline char const* find_delimiter(char const* first, char const* last, IsChar const& is_delimiter) noexcept
+{
+    void const* pos = std::memchr(first, is_delimiter.character, static_cast<std::size_t>(last - first));
+    return nullptr != pos ? static_cast<char const*>(pos) : last;
+}
+
+char const* find_delimiter(char const* first, char const* last, IsSpace const& is_delimiter) noexcept;
+
+//
+// Lazily splits a string into std::string_view tokens that refer to the
+// viewed string, yielding the same tokens as split(). The viewed string must
+// outlive the view and its iterators.
+//
+template<typename Predicate>
+class SplitView final
+{
+public:
+    class Iterator final
+    {
+        friend class SplitView;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::string_view value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::string_view const* pointer;
+        typedef std::string_view const& reference;
+
+    public:
+        Iterator() = default;
+
+        reference operator*() const noexcept
+        {
+            return m_token;
+        }
+
+        pointer operator->() const noexcept
+        {
+            return &m_token;
+        }
+
+        Iterator& operator++()
+        {
+            next();
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator it(*this);
+            next();
+            return it;
+        }
+
+        bool operator==(Iterator const& other) const noexcept
+        {
+            return m_end == other.m_end && (true == m_end || m_token.data() == other.m_token.data());
+        }
+
+        bool operator!=(Iterator const& other) const noexcept
+        {
+            return !(*this == other);
+        }
+
+    private:
+        SplitView const* m_view{ nullptr };
+        char const* m_next{ nullptr };
+        std::string_view m_token;
+        bool m_end{ true };
+
+        explicit Iterator(SplitView const& view)
+            : m_view{ &view }
+            , m_next{ view.m_string.data() }
+            , m_end{ view.m_string.empty() }
+        {
+            if (false == m_end) {
+                next();
+            }
+        }
+
+        void next()
+        {
+            char const* last = m_view->m_string.data() + m_view->m_string.size();
+
+            while (nullptr != m_next) {
+                char const* pos = find_delimiter(m_next, last, m_view->m_is_delimiter);
+
+                m_token = std::string_view(m_next, static_cast<std::size_t>(pos - m_next));
+                m_next = last != pos ? pos + 1 : nullptr;
+
+                if (false == m_view->m_filter_empty || false == m_token.empty()) {
+                    return;
+                }
+            }
+
+            m_end = true;
+        }
+    };
+
+public:
+    SplitView(std::string_view string, Predicate is_delimiter, bool filter_empty = false)
+        : m_string{ string }
+        , m_is_delimiter(std::move(is_delimiter))
+        , m_filter_empty{ filter_empty }
+    {
+    }
+
+    Iterator begin() const
+    {
+        return Iterator(*this);
+    }
+
+    Iterator end() const noexcept
+    {
+        return Iterator();
+    }
+
+private:
+    std::string_view m_string;
+    Predicate m_is_delimiter;
+    bool m_filter_empty;
+};
+
+template<typename Predicate>
+SplitView<Predicate> split_view(std::string_view string, Predicate is_delimiter, bool filter_empty = false)
+{
+    return SplitView<Predicate>(string, std::move(is_delimiter), filter_empty);
+}
+
+inline SplitView<IsChar> split_view(std::string_view string, char delimiter, bool filter_empty = false)
+{
+    return SplitView<IsChar>(string, IsChar{ delimiter }, filter_empty);
+}
+
 std::string join(std::vector<std::string> const& vector, std::string const& separator = " ");
 
 template<typename Container>
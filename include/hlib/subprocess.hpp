@@ -30,10 +30,13 @@
 #include "hlib/result.hpp"
 #include "hlib/sink.hpp"
 #include "hlib/source.hpp"
+#include <array>
 #include <csignal>
+#include <deque>
 #include <fcntl.h>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <unistd.h>
 
@@ -138,5 +141,81 @@ private:
     Result<int> run(std::vector<char const*> argv);
 };
 
+class SubprocessPool final
+{
+    HLIB_NOT_COPYABLE(SubprocessPool);
+    HLIB_NOT_MOVABLE(SubprocessPool);
+
+public:
+    // Called with the return code, or the error when the subprocess could not
+    // be started, and the subprocess's stdout and stderr output. A subprocess
+    // terminated by a signal returns 128 + signal number.
+    typedef std::function<void(Result<int> const& return_code, Buffer& output, Buffer& error)> OnCompleted;
+
+public:
+    // SubprocessPool runs subprocesses through a forkserver, a small process
+    // that is forked when the pool is constructed and that spawns all
+    // subprocesses. Construct the pool early, before the process grows and
+    // starts threads, to keep spawning cheap.
+    //
+    // At most max_running subprocesses run concurrently, others are queued.
+    // The stdio of all subprocesses is multiplexed on the given event loop and
+    // the output is passed to the completion callback. The pool shall only be
+    // used from the event loop's thread. Destroying the pool kills running
+    // subprocesses without calling their callbacks.
+    //
+    SubprocessPool(std::weak_ptr<EventLoop> event_loop, std::size_t max_running);
+    ~SubprocessPool();
+
+    int pid() const noexcept;
+    std::size_t maxRunning() const noexcept;
+    std::size_t running() const noexcept;
+    std::size_t queued() const noexcept;
+
+    Result<> run(std::string const& command, std::vector<std::string> const& args, OnCompleted callback, std::nothrow_t) noexcept;
+    Result<> run(std::string const& command, std::vector<std::string> const& args, Buffer&& input, OnCompleted callback, std::nothrow_t) noexcept;
+
+    void run(std::string const& command, std::vector<std::string> const& args, OnCompleted callback);
+    void run(std::string const& command, std::vector<std::string> const& args, Buffer&& input, OnCompleted callback);
+
+private:
+    struct Job
+    {
+        std::uint32_t id;
+        std::string request;
+        OnCompleted callback;
+
+        int pid{ -1 };
+        int status{ 0 };
+        bool exited{ false };
+        std::array<int, 3> fds{ -1, -1, -1 };
+
+        Buffer input;
+        std::size_t input_offset{ 0 };
+        Buffer output;
+        Buffer error;
+    };
+
+    std::weak_ptr<EventLoop> m_event_loop;
+    std::size_t m_max_running;
+
+    int m_pid{ -1 };
+    int m_socket{ -1 };
+
+    std::uint32_t m_next_id{ 0 };
+    std::deque<std::unique_ptr<Job>> m_queue;
+    std::unordered_map<std::uint32_t, std::unique_ptr<Job>> m_running;
+    std::unordered_map<int, std::uint32_t> m_pids;
+
+    void onResponse(int fd, std::uint32_t events);
+    void onPipe(std::uint32_t id, Subprocess::Pipe pipe, int fd, std::uint32_t events);
+
+    void start(std::unique_ptr<Job> job);
+    void startQueued();
+    void complete(std::uint32_t id, Result<int> const& return_code);
+    void closePipe(Job& job, Subprocess::Pipe pipe) noexcept;
+    void stop() noexcept;
+};
+
 } // namespace hlib
 
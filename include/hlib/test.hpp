@@ -24,9 +24,14 @@
 #pragma once
 
 #include "hlib/base.hpp"
+#include "hlib/time.hpp"
+#include <atomic>
+#include <cstdlib>
 #include <functional>
+#include <new>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace hlib::test
@@ -50,6 +55,90 @@ public:
     Case(char const* a_file, int a_line, std::string const& a_tags, Function const& a_function);
 };
 
+// Timing state of a benchmark run, the benchmark function repeats the code
+// to measure while keepRunning() returns true. Setup before the first and
+// teardown after the last call are not measured.
+class BenchmarkState final
+{
+    HLIB_NOT_COPYABLE(BenchmarkState);
+    HLIB_NOT_MOVABLE(BenchmarkState);
+
+public:
+    explicit BenchmarkState(std::uint64_t iterations) noexcept;
+
+    bool keepRunning() noexcept
+    {
+        if (m_remaining > 0) {
+            --m_remaining;
+            return true;
+        }
+
+        return startOrStop();
+    }
+
+    std::uint64_t iterations() const noexcept;
+
+    // Bytes processed per iteration, to report throughput.
+    void setBytesProcessed(std::uint64_t bytes) noexcept;
+
+    void pauseTiming() noexcept;
+    void resumeTiming() noexcept;
+
+    time::DurationNs elapsed() const noexcept;
+    std::uint64_t bytesProcessed() const noexcept;
+    std::uint64_t allocations() const noexcept;
+
+private:
+    std::uint64_t const m_iterations;
+    std::uint64_t m_remaining{ 0 };
+    bool m_started{ false };
+    bool m_stopped{ false };
+
+    time::TimePoint m_start;
+    time::DurationNs m_elapsed;
+    std::uint64_t m_bytes{ 0 };
+    std::uint64_t m_allocations{ 0 };
+
+    bool startOrStop() noexcept;
+};
+
+class Benchmark final
+{
+    HLIB_NOT_COPYABLE(Benchmark);
+    HLIB_NOT_MOVABLE(Benchmark);
+
+    typedef void (*Function)(BenchmarkState& state);
+
+public:
+    char const* const file;
+    int const line;
+    std::string const name;
+    std::vector<std::string> const tags;
+    Function const function;
+
+    Benchmark(char const* a_file, int a_line, std::string const& a_name, std::string const& a_tags, Function const& a_function);
+};
+
+struct BenchmarkOptions
+{
+    // Time spent running the benchmark before measuring.
+    time::DurationNs warmup{ time::MSec(50) };
+
+    // Iterations are scaled to run at least this long.
+    time::DurationNs min_time{ time::MSec(200) };
+
+    std::uint64_t max_iterations{ 1000000000 };
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    std::uint64_t iterations{ 0 };
+    double ns_per_op{ 0 };
+    double bytes_per_second{ 0 };
+    double allocations_per_op{ 0 };
+};
+
 class Suite final
 {
     HLIB_NOT_COPYABLE(Suite);
@@ -64,6 +153,19 @@ public:
         std::uint32_t assertions_failed{ 0 };
     };
 
+    struct RunOptions
+    {
+        // Number of cases run concurrently. When larger than one, or when a
+        // timeout is set, every case runs isolated in a forked process.
+        unsigned jobs{ 1 };
+
+        // Cases running longer are killed and fail, zero disables.
+        time::DurationNs timeout{};
+    };
+
+    // Cases with this tag never run concurrently with other cases.
+    static constexpr char const* NonParallelTag = "!serial";
+
     static Suite& get();
 
 public:
@@ -75,15 +177,26 @@ public:
 
     void add(Case& tcase);
     void run(std::vector<std::string> const& tags = {});
+    void run(std::vector<std::string> const& tags, RunOptions const& options);
     void run(std::string const& tags);
 
+    void add(Benchmark& benchmark);
+    std::vector<BenchmarkResult> benchmark(std::vector<std::string> const& tags = {}, BenchmarkOptions const& options = {},
+        std::function<void(BenchmarkResult const&)> const& on_result = nullptr);
+    static BenchmarkResult benchmark(Benchmark const& benchmark, BenchmarkOptions const& options);
+
 private:
+    typedef std::vector<std::pair<std::string, Case*>> Selection;
+
     std::vector<Case*> m_test_cases;
+    std::vector<Benchmark*> m_benchmarks;
 
     std::string m_current_tag;
     Case* m_current_case{ nullptr };
 
+    Selection select(std::vector<std::string> const& tags) const;
     void run(std::string tag, Case* test_case);
+    void runIsolated(Selection const& selection, RunOptions const& options);
 };
 
 #define HLIB_TEST_CASE_INTERNAL(tags, line) \
@@ -91,7 +204,52 @@ private:
     static hlib::test::Case hlib_test_case_##line(__FILE__, __LINE__, tags, &hlib_test_case_##line##_function); \
     static void hlib_test_case_##line##_function()
 
-#define HLIB_TEST_CASE(tags) HLIB_TEST_CASE_INTERNAL(tags, __LINE__)
+#define HLIB_TEST_CASE_EXPAND(tags, line) HLIB_TEST_CASE_INTERNAL(tags, line)
+#define HLIB_TEST_CASE(tags) HLIB_TEST_CASE_EXPAND(tags, __LINE__)
+
+#define HLIB_BENCHMARK_INTERNAL(name, tags, line) \
+    static void hlib_benchmark_##line##_function(hlib::test::BenchmarkState& state); \
+    static hlib::test::Benchmark hlib_benchmark_##line(__FILE__, __LINE__, name, tags, &hlib_benchmark_##line##_function); \
+    static void hlib_benchmark_##line##_function([[maybe_unused]] hlib::test::BenchmarkState& state)
+
+#define HLIB_BENCHMARK_EXPAND(name, tags, line) HLIB_BENCHMARK_INTERNAL(name, tags, line)
+#define HLIB_BENCHMARK(name, tags) HLIB_BENCHMARK_EXPAND(name, tags, __LINE__)
+
+// Keeps the compiler from optimizing away the computation of value.
+template<typename T>
+inline void do_not_optimize(T const& value) noexcept
+{
+    __asm__ __volatile__("" : : "r,m"(value) : "memory");
+}
+
+// Keeps the compiler from optimizing away or reordering memory writes.
+inline void clobber_memory() noexcept
+{
+    __asm__ __volatile__("" : : : "memory");
+}
+
+// Number of allocations, counted when HLIB_BENCHMARK_COUNT_ALLOCATIONS()
+// replaces the global operator new in the benchmark executable.
+extern std::atomic<std::uint64_t> allocations;
+
+#define HLIB_BENCHMARK_COUNT_ALLOCATIONS() \
+    void* operator new(std::size_t size) \
+    { \
+        hlib::test::allocations.fetch_add(1, std::memory_order_relaxed); \
+        void* ptr = std::malloc(0 == size ? 1 : size); \
+        if (nullptr == ptr) { \
+            throw std::bad_alloc(); \
+        } \
+        return ptr; \
+    } \
+    void operator delete(void* ptr) noexcept \
+    { \
+        std::free(ptr); \
+    } \
+    void operator delete(void* ptr, std::size_t) noexcept \
+    { \
+        std::free(ptr); \
+    }
 
 enum class Assertion
 {
@@ -271,8 +429,16 @@ private:
 std::string to_string(Assertion assertion);
 std::string to_string(Operation operation);
 std::string to_string(Expression const& expression);
+std::string to_string(BenchmarkResult const& result);
+std::string to_json(std::vector<BenchmarkResult> const& results);
 
+// Runs test cases with the given tags. Options are -j <jobs>, -j<jobs>
+// and --timeout=<ms>.
 int main(int argc, char* argv[]);
 
+// Runs benchmarks with the given tags. Options are --json=<file>,
+// --min-time=<ms> and --warmup=<ms>.
+int benchmark_main(int argc, char* argv[]);
+
 } // namespace hlib::test
 
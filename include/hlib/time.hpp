@@ -25,9 +25,11 @@
 
 #include "hlib/base.hpp"
 #include "hlib/math.hpp"
+#include "hlib/result.hpp"
 #include <ctime>
 #include <cmath>
 #include <string>
+#include <string_view>
 #include <type_traits>
 
 namespace hlib
@@ -143,12 +145,279 @@ public:
     bool operator >=(std::timespec const& that) const noexcept;
 };
 
+// Compact 64-bit nanosecond alternatives to Duration and Clock for hot
+// paths. Trivially copyable, constexpr and convertible from and to the
+// timespec based types.
+class DurationNs final
+{
+public:
+    constexpr DurationNs() noexcept = default;
+
+    constexpr explicit DurationNs(std::int64_t nsecs) noexcept
+        : m_nsecs{ nsecs }
+    {
+    }
+
+    constexpr DurationNs(std::int64_t secs, long nsecs) noexcept
+        : m_nsecs{ secs * 1000000000LL + nsecs }
+    {
+    }
+
+    constexpr explicit DurationNs(std::timespec const& ts) noexcept
+        : DurationNs(ts.tv_sec, ts.tv_nsec)
+    {
+    }
+
+    DurationNs(Duration const& duration) noexcept
+        : DurationNs(static_cast<std::timespec const&>(duration))
+    {
+    }
+
+    template<typename R, typename T = std::int64_t>
+    constexpr DurationNs(math::RatioValue<R, T> const& value) noexcept
+        : m_nsecs{ static_cast<std::int64_t>(value.template to<std::nano, std::int64_t>().value()) }
+    {
+    }
+
+    operator Duration() const noexcept
+    {
+        return Duration(toTimespec());
+    }
+
+    constexpr std::int64_t count() const noexcept
+    {
+        return m_nsecs;
+    }
+
+    constexpr std::timespec toTimespec() const noexcept
+    {
+        std::int64_t secs = m_nsecs / 1000000000LL;
+        std::int64_t nsecs = m_nsecs % 1000000000LL;
+        if (nsecs < 0) {
+            secs -= 1;
+            nsecs += 1000000000LL;
+        }
+        return std::timespec{ static_cast<std::time_t>(secs), static_cast<long>(nsecs) };
+    }
+
+    template<typename T>
+    constexpr T to() const noexcept
+    {
+        return NSec(m_nsecs).to<typename T::Ratio, typename T::Type>();
+    }
+
+    constexpr DurationNs operator -() const noexcept
+    {
+        return DurationNs(-m_nsecs);
+    }
+
+    constexpr DurationNs operator +(DurationNs const& that) const noexcept
+    {
+        return DurationNs(m_nsecs + that.m_nsecs);
+    }
+
+    constexpr DurationNs operator -(DurationNs const& that) const noexcept
+    {
+        return DurationNs(m_nsecs - that.m_nsecs);
+    }
+
+    constexpr DurationNs operator *(std::int64_t that) const noexcept
+    {
+        return DurationNs(m_nsecs * that);
+    }
+
+    constexpr DurationNs operator /(std::int64_t that) const noexcept
+    {
+        return DurationNs(m_nsecs / that);
+    }
+
+    constexpr DurationNs& operator +=(DurationNs const& that) noexcept
+    {
+        m_nsecs += that.m_nsecs;
+        return *this;
+    }
+
+    constexpr DurationNs& operator -=(DurationNs const& that) noexcept
+    {
+        m_nsecs -= that.m_nsecs;
+        return *this;
+    }
+
+    constexpr bool operator !() const noexcept
+    {
+        return 0 == m_nsecs;
+    }
+
+    constexpr bool operator ==(DurationNs const& that) const noexcept
+    {
+        return m_nsecs == that.m_nsecs;
+    }
+
+    constexpr bool operator !=(DurationNs const& that) const noexcept
+    {
+        return m_nsecs != that.m_nsecs;
+    }
+
+    constexpr bool operator <(DurationNs const& that) const noexcept
+    {
+        return m_nsecs < that.m_nsecs;
+    }
+
+    constexpr bool operator >(DurationNs const& that) const noexcept
+    {
+        return m_nsecs > that.m_nsecs;
+    }
+
+    constexpr bool operator <=(DurationNs const& that) const noexcept
+    {
+        return m_nsecs <= that.m_nsecs;
+    }
+
+    constexpr bool operator >=(DurationNs const& that) const noexcept
+    {
+        return m_nsecs >= that.m_nsecs;
+    }
+
+private:
+    std::int64_t m_nsecs{ 0 };
+};
+
+class TimePoint final
+{
+public:
+    constexpr TimePoint() noexcept = default;
+
+    constexpr explicit TimePoint(std::int64_t nsecs) noexcept
+        : m_nsecs{ nsecs }
+    {
+    }
+
+    constexpr explicit TimePoint(std::timespec const& ts) noexcept
+        : m_nsecs{ ts.tv_sec * 1000000000LL + ts.tv_nsec }
+    {
+    }
+
+    TimePoint(Clock const& clock) noexcept
+        : TimePoint(static_cast<std::timespec const&>(clock))
+    {
+    }
+
+    operator Clock() const noexcept
+    {
+        return Clock(sinceEpoch().toTimespec());
+    }
+
+    constexpr DurationNs sinceEpoch() const noexcept
+    {
+        return DurationNs(m_nsecs);
+    }
+
+    constexpr DurationNs operator -(TimePoint const& that) const noexcept
+    {
+        return DurationNs(m_nsecs - that.m_nsecs);
+    }
+
+    constexpr TimePoint operator +(DurationNs const& that) const noexcept
+    {
+        return TimePoint(m_nsecs + that.count());
+    }
+
+    constexpr TimePoint operator -(DurationNs const& that) const noexcept
+    {
+        return TimePoint(m_nsecs - that.count());
+    }
+
+    constexpr TimePoint& operator +=(DurationNs const& that) noexcept
+    {
+        m_nsecs += that.count();
+        return *this;
+    }
+
+    constexpr TimePoint& operator -=(DurationNs const& that) noexcept
+    {
+        m_nsecs -= that.count();
+        return *this;
+    }
+
+    constexpr bool operator !() const noexcept
+    {
+        return 0 == m_nsecs;
+    }
+
+    constexpr bool operator ==(TimePoint const& that) const noexcept
+    {
+        return m_nsecs == that.m_nsecs;
+    }
+
+    constexpr bool operator !=(TimePoint const& that) const noexcept
+    {
+        return m_nsecs != that.m_nsecs;
+    }
+
+    constexpr bool operator <(TimePoint const& that) const noexcept
+    {
+        return m_nsecs < that.m_nsecs;
+    }
+
+    constexpr bool operator >(TimePoint const& that) const noexcept
+    {
+        return m_nsecs > that.m_nsecs;
+    }
+
+    constexpr bool operator <=(TimePoint const& that) const noexcept
+    {
+        return m_nsecs <= that.m_nsecs;
+    }
+
+    constexpr bool operator >=(TimePoint const& that) const noexcept
+    {
+        return m_nsecs >= that.m_nsecs;
+    }
+
+private:
+    std::int64_t m_nsecs{ 0 };
+};
+
+static_assert(8 == sizeof(DurationNs) && std::is_trivially_copyable<DurationNs>::value);
+static_assert(8 == sizeof(TimePoint) && std::is_trivially_copyable<TimePoint>::value);
+
 Clock now(clockid_t clock_id = CLOCK_MONOTONIC);
+TimePoint now_ns(clockid_t clock_id = CLOCK_MONOTONIC) noexcept;
 Clock now_utc(clockid_t clock_id = CLOCK_REALTIME);
 
+// CLOCK_MONOTONIC derived from the TSC, calibrated on first use and
+// re-anchored to CLOCK_MONOTONIC every second per thread. Avoids the
+// clock_gettime() call on hot paths. Monotonic per thread, but may differ
+// from now() by the drift of up to a second, so compare time points of
+// the same clock only. Falls back to now() when there is no invariant TSC.
+Clock fast_now() noexcept;
+bool fast_now_uses_tsc() noexcept;
+
 extern Clock const infinity;
 
-Clock to_clock(std::string const& iso8601);
+// ISO-8601 fields to format, in local time unless Utc is set.
+struct ISO8601 final
+{
+    static constexpr int Date{ 0x01 };
+    static constexpr int Time{ 0x02 };
+    static constexpr int Milliseconds{ 0x04 };
+    static constexpr int Microseconds{ 0x08 };
+    static constexpr int Utc{ 0x10 };
+
+    // Size of "YYYY-MM-DDTHH:MM:SS.ffffff+HH:MM".
+    static constexpr std::size_t MaxSize{ 32 };
+};
+
+// Formats clock into buffer without allocating or taking the timezone
+// lock. The date and time of the last second formatted and the local
+// timezone offset are cached per thread. Returns the number of characters
+// written, not null terminated, or 0 when buffer is too small.
+std::size_t format_iso8601(char* buffer, std::size_t size, Clock const& clock, int fields) noexcept;
+
+// Parses "YYYY-MM-DD" or "YYYY-MM-DDTHH:MM:SS[.f...][Z|+HH:MM|-HH:MM]",
+// times without an offset are taken as UTC.
+Result<Clock> to_clock(std::string_view const& iso8601, std::nothrow_t) noexcept;
+Clock to_clock(std::string_view const& iso8601);
 
 } // namespace time
 
@@ -28,6 +28,7 @@
 #include <ctime>
 #include <functional>
 #include <memory>
+#include <type_traits>
 
 namespace hlib
 {
@@ -39,17 +40,40 @@ class Timer final
     HLIB_NOT_COPYABLE(Timer);
     HLIB_NOT_MOVABLE(Timer);
 
+    // Arguments only time::Duration accepts, such as seconds as a double.
+    // Ratio values and braced lists go to the DurationNs overloads, which a
+    // plain time::Duration const& overload would make ambiguous.
+    template<typename T>
+    using IfDurationOnly = std::enable_if_t<
+        false == std::is_convertible<T, time::DurationNs>::value
+     && true == std::is_convertible<T, time::Duration>::value>;
+
 public:
     typedef std::function<void()> Callback;
 
 public:
     Timer(std::weak_ptr<EventLoop> event_loop, Callback callback);
     Timer(std::weak_ptr<EventLoop> event_loop, Callback callback,
-        time::Duration const& expire, time::Duration const& interval = {});
+        time::DurationNs expire, time::DurationNs interval = {});
+
+    template<typename T, typename = IfDurationOnly<T>>
+    Timer(std::weak_ptr<EventLoop> event_loop, Callback callback,
+            T const& expire, time::Duration const& interval = {})
+        : Timer(std::move(event_loop), std::move(callback),
+            time::DurationNs(time::Duration(expire)), time::DurationNs(interval))
+    {
+    }
+
     ~Timer();
 
     bool clear() noexcept;
-    bool set(time::Duration const& expire, time::Duration const& interval = {}) noexcept;
+    bool set(time::DurationNs expire, time::DurationNs interval = {}) noexcept;
+
+    template<typename T, typename = IfDurationOnly<T>>
+    bool set(T const& expire, time::Duration const& interval = {}) noexcept
+    {
+        return set(time::DurationNs(time::Duration(expire)), time::DurationNs(interval));
+    }
 
 private:
     std::weak_ptr<EventLoop> m_event_loop;
@@ -26,10 +26,27 @@
 #include "hlib/base.hpp"
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace hlib
 {
 
+//
+// URI components referring to the parsed string, which must outlive the view.
+// As with URI, an empty path is reported as "/" and an absent port as the
+// scheme's default port.
+//
+struct URIView
+{
+    std::string_view scheme;
+    std::string_view user_info;
+    std::string_view host;
+    std::uint16_t port{ 0 };
+    std::string_view path;
+    std::string_view query;
+    std::string_view fragment;
+};
+
 struct URI
 {
     std::string scheme;
@@ -42,8 +59,10 @@ struct URI
 
     URI() = default;
     URI(std::string const &that);
+    URI(URIView const& that);
 };
 
+URIView uri_parse_view(std::string_view string) noexcept;
 URI uri_parse(std::string const& string);
 
 std::string to_string(URI const& uri);
@@ -52,10 +71,10 @@ std::string uri_get_authority(URI const& uri);
 std::string uri_get_host_port(URI const& uri);
 std::string uri_get_path_query_fragment(URI const& uri);
 
-std::uint16_t uri_get_default_port_for_scheme(std::string const& scheme);
+std::uint16_t uri_get_default_port_for_scheme(std::string_view scheme) noexcept;
 
-std::string uri_encoding_escape(std::string const& string);
-std::string uri_encoding_unescape(std::string const& string);
+std::string uri_encoding_escape(std::string_view string);
+std::string uri_encoding_unescape(std::string_view string);
 
 std::string target_get_path(std::string const& target);
 std::string target_get_query(std::string const& target);
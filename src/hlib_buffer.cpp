@@ -243,6 +243,51 @@ void* Buffer::reserveZeroed(std::size_t capacity)
     return data;
 }
 
+void* Buffer::reserveAligned(std::size_t capacity, std::size_t alignment, std::nothrow_t) noexcept
+{
+    assert(m_size <= m_capacity);
+    assert(0 != alignment && 0 == (alignment & (alignment - 1)));
+
+    capacity = std::max(capacity, m_capacity);
+    if (0 == capacity) {
+        return m_data;
+    }
+
+    if (nullptr != m_data
+     && capacity == m_capacity
+     && 0 == (reinterpret_cast<std::uintptr_t>(m_data) & (alignment - 1))) {
+        return m_data;
+    }
+
+    if (capacity > m_maximum) {
+        return nullptr;
+    }
+
+    // Memory from posix_memalign() can be passed to realloc() and free().
+    void* data;
+    if (0 != posix_memalign(&data, std::max(alignment, sizeof(void*)), capacity)) {
+        return nullptr;
+    }
+
+    if (nullptr != m_data) {
+        memcpy(data, m_data, m_size);
+        free(m_data);
+    }
+
+    m_data = data;
+    m_capacity = capacity;
+    return m_data;
+}
+
+void* Buffer::reserveAligned(std::size_t capacity, std::size_t alignment)
+{
+    void* data = reserveAligned(capacity, alignment, std::nothrow);
+    if (nullptr == data && capacity > 0) {
+        throw std::bad_alloc();
+    }
+    return data;
+}
+
 void* Buffer::extend(std::size_t capacity, std::nothrow_t) noexcept
 {
     assert(m_size <= m_capacity);
@@ -0,0 +1,427 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/connection_pool.hpp"
+#include "hlib/error.hpp"
+#include "hlib/file.hpp"
+#include "hlib/utility.hpp"
+#include <sys/socket.h>
+#include <vector>
+
+using namespace hlib;
+
+//
+// Public (ConnectionPool::Metrics)
+//
+double ConnectionPool::Metrics::reuseRate() const noexcept
+{
+    return 0 == checkouts ? 0.0 : static_cast<double>(reused) / static_cast<double>(checkouts);
+}
+
+time::DurationNs ConnectionPool::Metrics::averageWaitTime() const noexcept
+{
+    return 0 == checkouts ? time::DurationNs() : wait_time / static_cast<std::int64_t>(checkouts);
+}
+
+//
+// Implementation (ConnectionPool)
+//
+ConnectionPool::Peer& ConnectionPool::peer(SockAddr const& address)
+{
+    auto it = m_peers.find(address);
+    if (m_peers.end() == it) {
+        it = m_peers.emplace(std::piecewise_construct, std::forward_as_tuple(address), std::forward_as_tuple()).first;
+        it->second.address = address;
+    }
+
+    return it->second;
+}
+
+void ConnectionPool::connect(Peer& peer, OnCheckout callback, time::TimePoint started)
+{
+    using namespace std::placeholders;
+
+    // Callbacks may forget the peer, so copy its address and prune it first.
+    SockAddr const address(peer.address);
+    prune(peer);
+
+    // Create socket.
+    Handle<int, -1> fd(
+        ::socket(address.family(), m_options.type | SOCK_NONBLOCK | SOCK_CLOEXEC, m_options.protocol),
+        file::fd_close
+    );
+    if (-1 == fd.get()) {
+        ++m_metrics.failures;
+        deliver(callback, started, std::move(fd), errno);
+        return;
+    }
+
+    // Set socket options.
+    Result<> result = set_socket_options(fd.get(), m_options.socket_options, std::nothrow);
+    if (true == result.failure()) {
+        ++m_metrics.failures;
+        deliver(callback, started, Handle<int, -1>(file::fd_close), result.error().code().value());
+        return;
+    }
+
+    // Connect to peer address.
+    if (0 == ::connect(fd.get(), static_cast<sockaddr const*>(address), address.length())) {
+        ++m_metrics.connects;
+        deliver(callback, started, std::move(fd), 0);
+        return;
+    }
+    if (EINPROGRESS != errno) {
+        ++m_metrics.failures;
+        deliver(callback, started, Handle<int, -1>(file::fd_close), errno);
+        return;
+    }
+
+    // Wait for the connect to complete.
+    int const raw_fd = fd.get();
+
+    bool success = with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        loop.add(raw_fd, EventLoop::Write, std::bind(&ConnectionPool::onConnect, this, _1, _2));
+    });
+    if (false == success) {
+        ++m_metrics.failures;
+        deliver(callback, started, Handle<int, -1>(file::fd_close), ENODEV);
+        return;
+    }
+
+    m_connecting.emplace(raw_fd, Connecting{ std::move(fd), std::move(callback), started });
+}
+
+bool ConnectionPool::reuse(Peer& peer, OnCheckout& callback, time::TimePoint started)
+{
+    if (true == peer.idle.empty()) {
+        return false;
+    }
+
+    // Most recently released first, leaving the oldest to expire.
+    auto it = std::prev(peer.idle.end());
+    Handle<int, -1> fd(std::move(it->fd));
+
+    with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        loop.remove(fd.get());
+    });
+
+    m_spare.splice(m_spare.end(), peer.idle, it);
+    prune(peer);
+
+    ++m_metrics.reused;
+    deliver(callback, started, std::move(fd), 0);
+    return true;
+}
+
+void ConnectionPool::deliver(OnCheckout const& callback, time::TimePoint started, Handle<int, -1> fd, int error)
+{
+    time::DurationNs const wait = time::now_ns() - started;
+
+    m_metrics.wait_time += wait;
+    if (m_metrics.max_wait_time < wait) {
+        m_metrics.max_wait_time = wait;
+    }
+
+    callback(std::move(fd), error);
+}
+
+void ConnectionPool::next()
+{
+    while (false == m_queue.empty() && m_connecting.size() < m_options.max_connecting) {
+        Peer& peer = *m_queue.front();
+        m_queue.pop_front();
+        --peer.queued;
+
+        // Skip entries of waiters that release() already served.
+        if (peer.waiters.size() <= peer.queued) {
+            prune(peer);
+            continue;
+        }
+
+        Waiter waiter = std::move(peer.waiters.front());
+        peer.waiters.pop_front();
+        --m_waiting;
+
+        if (false == reuse(peer, waiter.callback, waiter.started)) {
+            connect(peer, std::move(waiter.callback), waiter.started);
+        }
+    }
+}
+
+void ConnectionPool::retire(std::list<Idle>::iterator it) noexcept
+{
+    with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        loop.remove(it->fd.get());
+    });
+
+    it->fd.reset();
+    m_spare.splice(m_spare.end(), it->peer->idle, it);
+}
+
+void ConnectionPool::prune(Peer& peer) noexcept
+{
+    if (false == peer.idle.empty() || false == peer.waiters.empty() || 0 != peer.queued) {
+        return;
+    }
+
+    m_peers.erase(m_peers.find(peer.address));
+}
+
+void ConnectionPool::onConnect(int fd, std::uint32_t /* events */)
+{
+    auto it = m_connecting.find(fd);
+    assert(m_connecting.end() != it);
+
+    int const error = get_socket_error(fd);
+
+    with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        loop.remove(fd);
+    });
+
+    Connecting connecting = std::move(it->second);
+    m_connecting.erase(it);
+
+    // Start a waiting checkout in the freed connect slot.
+    next();
+
+    if (0 != error) {
+        ++m_metrics.failures;
+        deliver(connecting.callback, connecting.started, Handle<int, -1>(file::fd_close), error);
+        return;
+    }
+
+    ++m_metrics.connects;
+    deliver(connecting.callback, connecting.started, std::move(connecting.fd), 0);
+}
+
+void ConnectionPool::onIdle(std::list<Idle>::iterator it, std::uint32_t /* events */)
+{
+    // An idle connection is readable only if the peer closed it or sent
+    // data out of turn, either way it cannot be reused.
+    Peer& peer = *it->peer;
+
+    retire(it);
+    prune(peer);
+    ++m_metrics.closed;
+}
+
+void ConnectionPool::onTimeout()
+{
+    time::TimePoint const now = time::now_ns();
+    time::TimePoint deadline;
+
+    for (auto entry = m_peers.begin(); m_peers.end() != entry;) {
+        Peer& peer = entry->second;
+
+        while (false == peer.idle.empty() && peer.idle.front().since + m_options.idle_timeout <= now) {
+            retire(peer.idle.begin());
+            ++m_metrics.expired;
+        }
+
+        if (true == peer.idle.empty()) {
+            entry = true == peer.waiters.empty() && 0 == peer.queued ? m_peers.erase(entry) : std::next(entry);
+            continue;
+        }
+
+        if (!deadline || peer.idle.front().since < deadline) {
+            deadline = peer.idle.front().since;
+        }
+        ++entry;
+    }
+
+    m_timer_armed = !!deadline;
+    if (true == m_timer_armed) {
+        m_timer.set(deadline + m_options.idle_timeout - now);
+    }
+}
+
+//
+// Public (ConnectionPool)
+//
+ConnectionPool::ConnectionPool(std::weak_ptr<EventLoop> event_loop)
+    : ConnectionPool(std::move(event_loop), Options())
+{
+}
+
+ConnectionPool::ConnectionPool(std::weak_ptr<EventLoop> event_loop, Options options)
+    : m_event_loop(std::move(event_loop))
+    , m_options(std::move(options))
+    , m_timer(m_event_loop, std::bind(&ConnectionPool::onTimeout, this))
+{
+    if (0 == m_options.max_connecting) {
+        m_options.max_connecting = 1;
+    }
+}
+
+ConnectionPool::~ConnectionPool()
+{
+    clear();
+
+    with_weak_ptr_locked(m_event_loop, [this](EventLoop& loop) {
+        for (auto& entry : m_connecting) {
+            loop.remove(entry.first);
+        }
+    });
+
+    // Collect pending checkouts first, as calling back may release fds.
+    std::vector<OnCheckout> callbacks;
+    callbacks.reserve(m_connecting.size() + m_waiting);
+
+    for (auto& entry : m_connecting) {
+        callbacks.push_back(std::move(entry.second.callback));
+    }
+    for (auto& entry : m_peers) {
+        for (Waiter& waiter : entry.second.waiters) {
+            callbacks.push_back(std::move(waiter.callback));
+        }
+    }
+    m_connecting.clear();
+    m_peers.clear();
+    m_queue.clear();
+    m_waiting = 0;
+
+    for (OnCheckout const& callback : callbacks) {
+        callback(Handle<int, -1>(file::fd_close), ECANCELED);
+    }
+}
+
+void ConnectionPool::checkout(SockAddr const& address, OnCheckout callback)
+{
+    assert(nullptr != callback);
+
+    Peer& peer = this->peer(address);
+    time::TimePoint const now = time::now_ns();
+
+    ++m_metrics.checkouts;
+
+    if (true == reuse(peer, callback, now)) {
+        return;
+    }
+
+    if (m_connecting.size() < m_options.max_connecting) {
+        connect(peer, std::move(callback), now);
+        return;
+    }
+
+    ++m_metrics.waits;
+    peer.waiters.push_back(Waiter{ std::move(callback), now });
+    ++peer.queued;
+    m_queue.push_back(&peer);
+    ++m_waiting;
+}
+
+void ConnectionPool::release(SockAddr const& address, Handle<int, -1> fd)
+{
+    if (-1 == fd.get()) {
+        return;
+    }
+
+    Peer& peer = this->peer(address);
+
+    // Hand the connection to the longest waiting checkout for the peer.
+    // Its entry in m_queue is skipped by next().
+    if (false == peer.waiters.empty()) {
+        Waiter waiter = std::move(peer.waiters.front());
+        peer.waiters.pop_front();
+        --m_waiting;
+
+        ++m_metrics.reused;
+        deliver(waiter.callback, waiter.started, std::move(fd), 0);
+        return;
+    }
+
+    if (peer.idle.size() >= m_options.max_idle) {
+        ++m_metrics.discarded;
+        prune(peer);
+        return;
+    }
+
+    if (true == m_spare.empty()) {
+        m_spare.push_back(Idle{ Handle<int, -1>(file::fd_close), time::TimePoint(), nullptr });
+    }
+
+    auto it = m_spare.begin();
+    it->fd = std::move(fd);
+    it->since = time::now_ns();
+    it->peer = &peer;
+    peer.idle.splice(peer.idle.end(), m_spare, it);
+
+    // Watch the idle connection for the peer closing it.
+    bool success = with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        loop.add(it->fd.get(), EventLoop::Read | EventLoop::RdHup,
+            [this, it](int /* fd */, std::uint32_t events) {
+                onIdle(it, events);
+            }
+        );
+    });
+    if (false == success) {
+        it->fd.reset();
+        m_spare.splice(m_spare.end(), peer.idle, it);
+        prune(peer);
+        return;
+    }
+
+    // Newer connections expire later, so only an unarmed timer is set.
+    if (false == m_timer_armed && 0 != m_options.idle_timeout.count()) {
+        m_timer_armed = m_timer.set(m_options.idle_timeout);
+    }
+}
+
+std::size_t ConnectionPool::idle(SockAddr const& address) const noexcept
+{
+    auto it = m_peers.find(address);
+    return m_peers.end() == it ? 0 : it->second.idle.size();
+}
+
+std::size_t ConnectionPool::peers() const noexcept
+{
+    return m_peers.size();
+}
+
+std::size_t ConnectionPool::connecting() const noexcept
+{
+    return m_connecting.size();
+}
+
+std::size_t ConnectionPool::waiting() const noexcept
+{
+    return m_waiting;
+}
+
+ConnectionPool::Metrics const& ConnectionPool::metrics() const noexcept
+{
+    return m_metrics;
+}
+
+void ConnectionPool::clear() noexcept
+{
+    for (auto entry = m_peers.begin(); m_peers.end() != entry;) {
+        Peer& peer = entry->second;
+
+        while (false == peer.idle.empty()) {
+            retire(peer.idle.begin());
+        }
+
+        entry = true == peer.waiters.empty() && 0 == peer.queued ? m_peers.erase(entry) : std::next(entry);
+    }
+}
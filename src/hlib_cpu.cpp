@@ -22,10 +22,18 @@
 // SOFTWARE.
 //
 #include "hlib/cpu.hpp"
-#include "hlib_format.hpp"
+#include "hlib/format.hpp"
 #include "hlib/string.hpp"
+#include <algorithm>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
 #include <fstream>
+#include <pthread.h>
+#include <sched.h>
 #include <sstream>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
 using namespace hlib;
@@ -54,6 +62,146 @@ Result<std::string> read(std::string const& filepath, bool trim = false) noexcep
     }
 }
 
+// Returns the trimmed file contents, or an empty string if unreadable.
+std::string read_value(std::string const& filepath)
+{
+    Result<std::string> file = read(filepath, true);
+    return true == file.success() ? file.value() : std::string();
+}
+
+int read_int(std::string const& filepath, int fallback)
+{
+    return string_to<int>(read_value(filepath), 10, std::nothrow).value_or(fallback);
+}
+
+// Parses sizes like "48K" or "2M".
+std::size_t parse_size(std::string string)
+{
+    std::size_t factor = 1;
+
+    if (false == string.empty()) {
+        switch (string.back()) {
+        case 'K': factor = 1024; break;
+        case 'M': factor = 1024*1024; break;
+        case 'G': factor = 1024*1024*1024; break;
+        default:
+            break;
+        }
+    }
+
+    string = trim_right(string, "KMG");
+    return string_to<std::size_t>(string, 10, std::nothrow).value_or(0) * factor;
+}
+
+// Parses CPU and node lists like "0-3,8,10-11".
+std::vector<int> parse_list(std::string const& string)
+{
+    std::vector<int> result;
+
+    for (std::string_view range : split_view(string, ',', true)) {
+        std::size_t const dash = range.find('-');
+        std::optional<int> first = string_to<int>(range.substr(0, dash), 10, std::nothrow);
+        std::optional<int> last = std::string_view::npos == dash ? first : string_to<int>(range.substr(dash + 1), 10, std::nothrow);
+
+        if (std::nullopt == first || std::nullopt == last) {
+            continue;
+        }
+
+        for (int i = first.value(); i <= last.value(); ++i) {
+            result.push_back(i);
+        }
+    }
+
+    return result;
+}
+
+//
+// Scanning of /proc files without allocations.
+//
+char const* skip_spaces(char const* first, char const* last) noexcept
+{
+    while (first != last && ' ' == *first) {
+        ++first;
+    }
+    return first;
+}
+
+char const* skip_field(char const* first, char const* last) noexcept
+{
+    first = skip_spaces(first, last);
+    while (first != last && ' ' != *first && '\n' != *first) {
+        ++first;
+    }
+    return first;
+}
+
+std::int64_t scan_integer(char const*& first, char const* last) noexcept
+{
+    first = skip_spaces(first, last);
+
+    std::int64_t value = 0;
+    for (; first != last && *first >= '0' && *first <= '9'; ++first) {
+        value = value * 10 + (*first - '0');
+    }
+
+    return value;
+}
+
+// Returns the end of the complete cpu lines at the start of /proc/stat, or
+// nullptr if the buffer ends before them.
+char const* find_cpu_lines_end(char const* first, char const* last) noexcept
+{
+    while (last - first >= 3 && 0 == std::memcmp(first, "cpu", 3)) {
+        char const* eol = static_cast<char const*>(std::memchr(first, '\n', static_cast<std::size_t>(last - first)));
+        if (nullptr == eol) {
+            return nullptr;
+        }
+        first = eol + 1;
+    }
+
+    return last - first >= 3 ? first : nullptr;
+}
+
+time::DurationNs to_duration(timeval const& tv) noexcept
+{
+    return time::DurationNs(tv.tv_sec, tv.tv_usec * 1000);
+}
+
+time::DurationNs ticks_to_duration(std::int64_t ticks) noexcept
+{
+    static std::int64_t const ticks_per_second = sysconf(_SC_CLK_TCK);
+    return time::DurationNs(ticks / ticks_per_second, (ticks % ticks_per_second) * 1000000000 / ticks_per_second);
+}
+
+// Parses the id, name, user and system time from /proc/<pid>/task/<tid>/stat.
+bool parse_task_stat(char const* first, char const* last, CPUUsage& usage) noexcept
+{
+    char const* open = static_cast<char const*>(std::memchr(first, '(', static_cast<std::size_t>(last - first)));
+    char const* close = last;
+    while (close != first && ')' != *(close - 1)) {
+        --close;
+    }
+    if (nullptr == open || close == first || --close < open) {
+        return false;
+    }
+
+    usage.id = static_cast<pid_t>(scan_integer(first, open));
+
+    std::size_t const length = std::min<std::size_t>(static_cast<std::size_t>(close - open - 1), sizeof(usage.name) - 1);
+    std::memcpy(usage.name, open + 1, length);
+    usage.name[length] = '\0';
+
+    // Fields 3 to 13 precede utime and stime.
+    first = close + 1;
+    for (int field = 3; field <= 13; ++field) {
+        first = skip_field(first, last);
+    }
+
+    usage.user = ticks_to_duration(scan_integer(first, last));
+    usage.system = ticks_to_duration(scan_integer(first, last));
+    return true;
+}
+
 } // namespace
 
 //
@@ -63,7 +211,7 @@ Result<int> hlib::cpu_get_ticks_per_second() noexcept
 {
     int result = sysconf(_SC_CLK_TCK);
     if (-1 == result) {
-        return Error(make_system_error(errno));
+        return make_error(errno);
     }
 
     return static_cast<int>(result);
@@ -73,7 +221,7 @@ Result<int> hlib::cpu_get_count() noexcept
 {
     int result = sysconf(_SC_NPROCESSORS_CONF);
     if (-1 == result) {
-        return Error(make_system_error(errno));
+        return make_error(errno);
     }
 
     return static_cast<int>(result);
@@ -83,7 +231,7 @@ Result<int> hlib::cpu_get_frequency(int cpu) noexcept
 {
     assert(cpu < sysconf(_SC_NPROCESSORS_CONF));
 
-    Result<std::string> file = read(format("/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq", cpu), true);
+    Result<std::string> file = read(HLIB_FORMAT("/sys/devices/system/cpu/cpu{}/cpufreq/scaling_cur_freq", cpu), true);
     if (true == file.failure()) {
         return file.error();
     }
@@ -98,60 +246,343 @@ Result<std::size_t> hlib::cpu_get_cache_size(int cpu, int cache_index) noexcept
 {
     assert(cpu < sysconf(_SC_NPROCESSORS_CONF));
 
-    Result<std::string> file = read(format("/sys/devices/system/cpu/cpu%d/cache/index%d/size", cpu, cache_index), true);
+    Result<std::string> file = read(HLIB_FORMAT("/sys/devices/system/cpu/cpu{}/cache/index{}/size", cpu, cache_index), true);
     if (true == file.failure()) {
         return file.error();
     }
 
-    std::string string = file.value();
-    assert(false == string.empty());
+    assert(false == file.value().empty());
+    return parse_size(file.value());
+}
+
+Result<> hlib::cpu_set_affinity(std::vector<int> const& cpus) noexcept
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
 
-    std::size_t factor;
+    for (int cpu : cpus) {
+        assert(cpu >= 0 && cpu < CPU_SETSIZE);
+        CPU_SET(cpu, &set);
+    }
 
-    switch (string.back()) {
-    case 'K': factor = 1024; break;
-    case 'M': factor = 1024*1024; break;
-    default:
-        break;
+    if (-1 == sched_setaffinity(0, sizeof(set), &set)) {
+        return make_error(errno, "sched_setaffinity() failed");
     }
 
-    string = trim_right(string, "KM");
+    return {};
+}
 
-    std::optional<std::size_t> frequency = string_to<std::size_t>(string);
-    assert(std::nullopt != frequency);
+Result<> hlib::cpu_set_affinity(int cpu) noexcept
+{
+    assert(cpu >= 0 && cpu < CPU_SETSIZE);
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    if (-1 == sched_setaffinity(0, sizeof(set), &set)) {
+        return make_error(errno, "sched_setaffinity() failed");
+    }
+
+    return {};
+}
+
+Result<std::vector<int>> hlib::cpu_get_affinity() noexcept
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    if (-1 == sched_getaffinity(0, sizeof(set), &set)) {
+        return make_error(errno, "sched_getaffinity() failed");
+    }
+
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    return cpus;
+}
+
+Result<CPUUsage> hlib::cpu_get_thread_usage() noexcept
+{
+    rusage usage;
+    if (-1 == getrusage(RUSAGE_THREAD, &usage)) {
+        return make_error(errno, "getrusage() failed");
+    }
+
+    CPUUsage result;
+    result.id = static_cast<pid_t>(syscall(SYS_gettid));
+    pthread_getname_np(pthread_self(), result.name, sizeof(result.name));
+    result.user = to_duration(usage.ru_utime);
+    result.system = to_duration(usage.ru_stime);
+    return result;
+}
+
+Result<CPUUsage> hlib::cpu_get_process_usage() noexcept
+{
+    rusage usage;
+    if (-1 == getrusage(RUSAGE_SELF, &usage)) {
+        return make_error(errno, "getrusage() failed");
+    }
 
-    return frequency.value() * factor;
+    CPUUsage result;
+    result.id = getpid();
+    strncpy(result.name, program_invocation_short_name, sizeof(result.name) - 1);
+    result.user = to_duration(usage.ru_utime);
+    result.system = to_duration(usage.ru_stime);
+    return result;
+}
+
+Result<> hlib::cpu_get_thread_usages(std::vector<CPUUsage>& usages) noexcept
+{
+    usages.clear();
+
+    // Read the directory with getdents64 into a stack buffer, as opendir()
+    // allocates.
+    int const directory = ::open("/proc/self/task", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (-1 == directory) {
+        return make_error(errno, "open() failed");
+    }
+
+    alignas(8) char entries[4096];
+    long length;
+
+    while ((length = syscall(SYS_getdents64, directory, entries, sizeof(entries))) > 0) {
+        for (long offset = 0; offset < length;) {
+            struct dirent64 const* entry = reinterpret_cast<struct dirent64 const*>(entries + offset);
+            offset += entry->d_reclen;
+
+            if ('.' == entry->d_name[0]) {
+                continue;
+            }
+
+            char path[sizeof(entry->d_name) + 8];
+            snprintf(path, sizeof(path), "%s/stat", entry->d_name);
+
+            // Threads may exit while iterating.
+            int fd = openat(directory, path, O_RDONLY | O_CLOEXEC);
+            if (-1 == fd) {
+                continue;
+            }
+
+            char buffer[512];
+            ssize_t const size = ::read(fd, buffer, sizeof(buffer));
+            ::close(fd);
+
+            CPUUsage usage;
+            if (size > 0 && true == parse_task_stat(buffer, buffer + size, usage)) {
+                usages.push_back(usage);
+            }
+        }
+    }
+
+    int const error = errno;
+    ::close(directory);
+
+    if (-1 == length) {
+        return make_error(error, "getdents64() failed");
+    }
+    return {};
+}
+
+//
+// Implementation (CPUTopology)
+//
+void CPUTopology::load(std::string const& root)
+{
+    std::vector<int> online = parse_list(read_value(root + "/cpu/online"));
+    if (true == online.empty()) {
+        throw std::runtime_error("no online CPUs in " + root + "/cpu/online");
+    }
+
+    for (int id : online) {
+        std::string const directory = HLIB_FORMAT("{}/cpu/cpu{}", root, id);
+
+        CPU cpu;
+        cpu.id = id;
+        cpu.core = read_int(directory + "/topology/core_id", id);
+        cpu.package = read_int(directory + "/topology/physical_package_id", 0);
+        cpu.siblings = parse_list(read_value(directory + "/topology/thread_siblings_list"));
+        if (true == cpu.siblings.empty()) {
+            cpu.siblings.push_back(id);
+        }
+
+        for (int index = 0; ; ++index) {
+            std::string const cache_directory = HLIB_FORMAT("{}/cache/index{}", directory, index);
+
+            Cache cache;
+            cache.level = read_int(cache_directory + "/level", 0);
+            if (0 == cache.level) {
+                break;
+            }
+
+            cache.type = read_value(cache_directory + "/type");
+            cache.size = parse_size(read_value(cache_directory + "/size"));
+            cache.line_size = parse_size(read_value(cache_directory + "/coherency_line_size"));
+            cache.cpus = parse_list(read_value(cache_directory + "/shared_cpu_list"));
+            if (true == cache.cpus.empty()) {
+                cache.cpus.push_back(id);
+            }
+
+            // Caches shared by several CPUs are listed once.
+            auto it = std::find_if(m_caches.begin(), m_caches.end(), [&cache](Cache const& other) {
+                return cache.level == other.level && cache.type == other.type && cache.cpus == other.cpus;
+            });
+            if (m_caches.end() == it) {
+                it = m_caches.insert(m_caches.end(), std::move(cache));
+            }
+
+            cpu.caches.push_back(static_cast<std::size_t>(it - m_caches.begin()));
+        }
+
+        m_cpus.push_back(std::move(cpu));
+    }
+
+    m_nodes = parse_list(read_value(root + "/node/online"));
+    if (true == m_nodes.empty()) {
+        m_nodes.push_back(0);
+        return;
+    }
+
+    for (int node : m_nodes) {
+        for (int id : parse_list(read_value(HLIB_FORMAT("{}/node/node{}/cpulist", root, node)))) {
+            auto it = std::lower_bound(m_cpus.begin(), m_cpus.end(), id, [](CPU const& cpu, int value) {
+                return cpu.id < value;
+            });
+            if (m_cpus.end() != it && id == it->id) {
+                it->node = node;
+            }
+        }
+    }
+}
+
+//
+// Public (CPUTopology)
+//
+std::vector<CPUTopology::CPU> const& CPUTopology::cpus() const noexcept
+{
+    return m_cpus;
+}
+
+std::vector<CPUTopology::Cache> const& CPUTopology::caches() const noexcept
+{
+    return m_caches;
+}
+
+std::vector<int> const& CPUTopology::nodes() const noexcept
+{
+    return m_nodes;
+}
+
+CPUTopology::CPU const* CPUTopology::cpu(int id) const noexcept
+{
+    auto it = std::lower_bound(m_cpus.begin(), m_cpus.end(), id, [](CPU const& cpu, int value) {
+        return cpu.id < value;
+    });
+    return m_cpus.end() != it && id == it->id ? &*it : nullptr;
+}
+
+std::vector<int> CPUTopology::cpusOfNode(int node) const
+{
+    std::vector<int> result;
+
+    for (CPU const& cpu : m_cpus) {
+        if (node < 0 || node == cpu.node) {
+            result.push_back(cpu.id);
+        }
+    }
+
+    return result;
+}
+
+std::vector<int> CPUTopology::physicalCores(int node) const
+{
+    std::vector<int> result;
+    std::vector<std::pair<int, int>> cores;
+
+    // CPUs are ordered by id, so the first CPU seen of a core is its lowest
+    // numbered sibling.
+    for (CPU const& cpu : m_cpus) {
+        if (node >= 0 && node != cpu.node) {
+            continue;
+        }
+
+        std::pair<int, int> const core(cpu.package, cpu.core);
+        if (cores.end() != std::find(cores.begin(), cores.end(), core)) {
+            continue;
+        }
+
+        cores.push_back(core);
+        result.push_back(cpu.id);
+    }
+
+    return result;
+}
+
+std::vector<int> CPUTopology::sharingCache(int id, int level) const
+{
+    CPU const* entry = cpu(id);
+    if (nullptr == entry) {
+        return {};
+    }
+
+    for (std::size_t index : entry->caches) {
+        Cache const& cache = m_caches[index];
+        if (level == cache.level && "Instruction" != cache.type) {
+            return cache.cpus;
+        }
+    }
+
+    return {};
+}
+
+Result<> CPUTopology::initialize(std::string const& root) noexcept
+{
+    try {
+        m_cpus.clear();
+        m_caches.clear();
+        m_nodes.clear();
+
+        load(root);
+        return {};
+    }
+    catch (std::exception const& e) {
+        return Error(e);
+    }
 }
 
 //
 // Implementation (CPUMonitor)
 //
-CPUMonitor::Statistics CPUMonitor::parse(std::string const& line) const noexcept
+CPUMonitor::Statistics CPUMonitor::parse(char const*& first, char const* last) const noexcept
 {
-    std::vector<std::string> columns = split(line, ' ', true);
     std::int64_t total = 0;
 
-    auto parse_number = [&columns, &total](std::size_t index) -> std::int64_t {
-        std::optional<std::int64_t> result = string_to<std::int64_t>(columns[index]);
-        assert(std::nullopt != result);
-        total += result.value();
-        return result.value();
+    auto parse_number = [&first, last, &total]() -> std::int64_t {
+        std::int64_t const result = scan_integer(first, last);
+        total += result;
+        return result;
     };
 
-    Statistics statistics{
-        parse_number(1),
-        parse_number(2),
-        parse_number(3),
-        parse_number(4),
-        parse_number(5),
-        parse_number(6),
-        parse_number(7),
-        parse_number(8),
-        parse_number(9),
-        0
-    };
+    Statistics statistics{};
+    statistics.user = parse_number();
+    statistics.nice = parse_number();
+    statistics.system = parse_number();
+    statistics.idle = parse_number();
+    statistics.iowait = parse_number();
+    statistics.irq = parse_number();
+    statistics.softirq = parse_number();
+    statistics.steal = parse_number();
+    statistics.guest_nice = parse_number();
     statistics.total = total;
 
+    // Skip to the next line.
+    char const* eol = static_cast<char const*>(std::memchr(first, '\n', static_cast<std::size_t>(last - first)));
+    first = nullptr == eol ? last : eol + 1;
+
     return statistics;
 }
 
@@ -271,25 +702,64 @@ Result<> CPUMonitor::initialize() noexcept
     m_cpu_previous.resize(m_count, {});
     m_cpu_current.resize(m_count, {});
 
+    m_fd.reset(open("/proc/stat", O_RDONLY | O_CLOEXEC));
+    if (-1 == m_fd.get()) {
+        return make_error(errno, "open() failed");
+    }
+
+    // Room for the cpu lines, grown by update() if needed.
+    m_buffer.resize(static_cast<std::size_t>(m_count + 1) * 128);
+
     return update();
 }
 
 Result<> CPUMonitor::update() noexcept
 {
-    Result<std::string> file = read("/proc/stat");
-    if (true == file.failure()) {
-        return file.error();
-    }
+    assert(-1 != m_fd.get());
+
+    // Only the cpu lines at the start of /proc/stat are read.
+    char const* end;
+
+    while (true) {
+        ssize_t const size = pread(m_fd.get(), m_buffer.data(), m_buffer.size(), 0);
+        if (-1 == size) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return make_error(errno, "pread() failed");
+        }
+
+        end = find_cpu_lines_end(m_buffer.data(), m_buffer.data() + size);
+        if (nullptr != end) {
+            break;
+        }
+        if (static_cast<std::size_t>(size) < m_buffer.size()) {
+            end = m_buffer.data() + size;
+            break;
+        }
 
-    std::vector<std::string> lines = split(file.value(), '\n');
-    assert(lines.size() >= static_cast<std::size_t>(m_count + 1));
+        m_buffer.resize(m_buffer.size() * 2);
+    }
 
     m_total_previous = m_total_current;
-    m_total_current = parse(lines[0]);
+    std::copy(m_cpu_current.begin(), m_cpu_current.end(), m_cpu_previous.begin());
+
+    // Offline CPUs have no line and keep their statistics.
+    char const* first = m_buffer.data();
+    while (end - first > 3 && 0 == std::memcmp(first, "cpu", 3)) {
+        first += 3;
+
+        if (' ' == *first) {
+            m_total_current = parse(first, end);
+            continue;
+        }
+
+        std::int64_t const cpu = scan_integer(first, end);
+        Statistics const statistics = parse(first, end);
 
-    for (int cpu = 0; cpu < m_count; ++cpu) {
-        m_cpu_previous[cpu] = m_cpu_current[cpu];
-        m_cpu_current[cpu] = parse(lines[cpu + 1]);
+        if (cpu < m_count) {
+            m_cpu_current[cpu] = statistics;
+        }
     }
 
     return {};
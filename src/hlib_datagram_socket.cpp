@@ -0,0 +1,338 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/datagram_socket.hpp"
+#include "hlib/error.hpp"
+#include "hlib/file.hpp"
+#include "hlib/socket.hpp"
+#include "hlib/utility.hpp"
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+using namespace hlib;
+
+//
+// Implementation
+//
+namespace
+{
+
+// Room for a single UDP_GRO or UDP_SEGMENT control message.
+constexpr std::size_t control_size = CMSG_SPACE(sizeof(int));
+
+bool set_option(int fd, int level, int option, int value = 1) noexcept
+{
+    return 0 == setsockopt(fd, level, option, &value, sizeof(value));
+}
+
+std::uint16_t get_segment_size(msghdr const& header) noexcept
+{
+    for (cmsghdr const* cmsg = CMSG_FIRSTHDR(&header); nullptr != cmsg;
+            cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&header), const_cast<cmsghdr*>(cmsg))) {
+        if (SOL_UDP == cmsg->cmsg_level && UDP_GRO == cmsg->cmsg_type) {
+            int size;
+            std::memcpy(&size, CMSG_DATA(cmsg), sizeof(size));
+            return static_cast<std::uint16_t>(size);
+        }
+    }
+
+    return 0;
+}
+
+} // namespace
+
+void DatagramSocket::onReceive(int fd, std::uint32_t events)
+{
+    assert(m_fd.get() == fd);
+
+    if (0 == (EventLoop::Read & events)) {
+        int const error = get_socket_error(fd);
+        if (0 != error && nullptr != m_on_error) {
+            m_on_error(error);
+        }
+        return;
+    }
+
+    // Reset the in/out fields of the slots.
+    for (mmsghdr& header : m_headers) {
+        header.msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        header.msg_hdr.msg_controllen = true == m_gro ? control_size : 0;
+        header.msg_hdr.msg_flags = 0;
+    }
+
+    int const count = ::recvmmsg(fd, m_headers.data(), static_cast<unsigned>(m_headers.size()), MSG_DONTWAIT, nullptr);
+    if (-1 == count) {
+        if (EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno && nullptr != m_on_error) {
+            // Such as ECONNREFUSED on a connected socket.
+            m_on_error(errno);
+        }
+        return;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        msghdr const& header = m_headers[i].msg_hdr;
+        Datagram& datagram = m_datagrams[i];
+
+        datagram.size = m_headers[i].msg_len;
+
+        if (0 == header.msg_namelen) {
+            datagram.address.clear();
+        }
+        else {
+            datagram.address = m_addresses[i];
+        }
+
+        datagram.segment_size = true == m_gro ? get_segment_size(header) : 0;
+    }
+
+    if (nullptr != m_on_received) {
+        m_on_received(m_datagrams.data(), static_cast<std::size_t>(count));
+    }
+}
+
+//
+// Public
+//
+DatagramSocket::DatagramSocket(std::weak_ptr<EventLoop> event_loop,
+        std::size_t batch_size, std::size_t datagram_size)
+    : m_event_loop(std::move(event_loop))
+    , m_fd{ -1, file::fd_close }
+    , m_batch_size{ batch_size }
+    , m_datagram_size{ datagram_size }
+{
+    assert(batch_size > 0);
+    assert(datagram_size > 0);
+}
+
+DatagramSocket::~DatagramSocket()
+{
+    close();
+}
+
+int DatagramSocket::fd() const noexcept
+{
+    return m_fd.get();
+}
+
+SockAddr DatagramSocket::getLocalAddress() const noexcept
+{
+    sockaddr_storage storage{};
+    socklen_t length = sizeof(storage);
+
+    if (-1 == getsockname(m_fd.get(), reinterpret_cast<sockaddr*>(&storage), &length)) {
+        return SockAddr();
+    }
+
+    return SockAddr(storage);
+}
+
+void DatagramSocket::setErrorCallback(OnError callback) noexcept
+{
+    m_on_error = std::move(callback);
+}
+
+Result<> DatagramSocket::open(SockAddr const& address, int protocol, std::uint32_t options, std::nothrow_t) noexcept
+{
+    using namespace std::placeholders;
+
+    close();
+
+    // Create socket.
+    Handle<int, -1> fd(
+        ::socket(address.family(), SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol),
+        file::fd_close
+    );
+    if (-1 == fd.get()) {
+        return make_error(errno, "socket() failed");
+    }
+
+    // Set options.
+    if (0 != (ReuseAddr & options)
+     && false == set_option(fd.get(), SOL_SOCKET, SO_REUSEADDR)) {
+        return make_error(errno, "setsockopt(SO_REUSEADDR) failed");
+    }
+
+    if (0 != (ReusePort & options)
+     && false == set_option(fd.get(), SOL_SOCKET, SO_REUSEPORT)) {
+        return make_error(errno, "setsockopt(SO_REUSEPORT) failed");
+    }
+
+    if (0 != (GRO & options)
+     && false == set_option(fd.get(), SOL_UDP, UDP_GRO)) {
+        return make_error(errno, "setsockopt(UDP_GRO) failed");
+    }
+
+    // Bind socket to address.
+    if (-1 == ::bind(fd.get(), static_cast<sockaddr const*>(address), address.length())) {
+        return make_error(errno, "bind() failed");
+    }
+
+    // Allocate receive slots.
+    m_gro = 0 != (GRO & options);
+
+    m_buffer.resize(m_batch_size * m_datagram_size);
+    m_iovecs.resize(m_batch_size);
+    m_addresses.resize(m_batch_size);
+    m_control.resize(true == m_gro ? m_batch_size * control_size : 0);
+    m_headers.resize(m_batch_size);
+    m_datagrams.resize(m_batch_size);
+
+    for (std::size_t i = 0; i < m_batch_size; ++i) {
+        m_iovecs[i].iov_base = m_buffer.data() + i * m_datagram_size;
+        m_iovecs[i].iov_len = m_datagram_size;
+
+        msghdr& header = m_headers[i].msg_hdr;
+        header = msghdr{};
+        header.msg_name = &m_addresses[i];
+        header.msg_iov = &m_iovecs[i];
+        header.msg_iovlen = 1;
+        header.msg_control = true == m_gro ? m_control.data() + i * control_size : nullptr;
+
+        m_datagrams[i].data = m_buffer.data() + i * m_datagram_size;
+    }
+
+    // Add file descriptor to event loop.
+    std::uint32_t const events = nullptr != m_on_received ? EventLoop::Read : 0;
+
+    bool success = with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        loop.add(fd.get(), events, std::bind(&DatagramSocket::onReceive, this, _1, _2));
+    });
+    if (false == success) {
+        return make_error(ENODEV, "Event loop not available");
+    }
+
+    // Commit file descriptor.
+    m_fd = std::move(fd);
+    return {};
+}
+
+void DatagramSocket::open(SockAddr const& address, int protocol, std::uint32_t options)
+{
+    success_or_throw<>(open(address, protocol, options, std::nothrow));
+}
+
+Result<> DatagramSocket::connect(SockAddr const& address, std::nothrow_t) noexcept
+{
+    assert(-1 != m_fd.get());
+
+    if (-1 == ::connect(m_fd.get(), static_cast<sockaddr const*>(address), address.length())) {
+        return make_error(errno, "connect() failed");
+    }
+
+    return {};
+}
+
+void DatagramSocket::connect(SockAddr const& address)
+{
+    success_or_throw<>(connect(address, std::nothrow));
+}
+
+void DatagramSocket::receive(OnReceived callback)
+{
+    m_on_received = std::move(callback);
+
+    if (-1 == m_fd.get()) {
+        return;
+    }
+
+    with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        loop.modify(m_fd.get(), nullptr != m_on_received ? EventLoop::Read : 0);
+    });
+}
+
+Result<std::size_t> DatagramSocket::send(Datagram const* datagrams, std::size_t count, std::nothrow_t) noexcept
+{
+    assert(-1 != m_fd.get());
+
+    // Grow the send slots to the largest batch seen.
+    if (m_send_headers.size() < count) {
+        m_send_iovecs.resize(count);
+        m_send_control.resize(count * control_size);
+        m_send_headers.resize(count);
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        Datagram const& datagram = datagrams[i];
+
+        m_send_iovecs[i].iov_base = const_cast<std::uint8_t*>(datagram.data);
+        m_send_iovecs[i].iov_len = datagram.size;
+
+        msghdr& header = m_send_headers[i].msg_hdr;
+        header = msghdr{};
+        header.msg_iov = &m_send_iovecs[i];
+        header.msg_iovlen = 1;
+
+        if (false == datagram.address.empty()) {
+            header.msg_name = const_cast<sockaddr*>(static_cast<sockaddr const*>(datagram.address));
+            header.msg_namelen = static_cast<socklen_t>(datagram.address.length());
+        }
+
+        if (0 != datagram.segment_size) {
+            header.msg_control = m_send_control.data() + i * control_size;
+            header.msg_controllen = CMSG_SPACE(sizeof(std::uint16_t));
+
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&header);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(std::uint16_t));
+            std::memcpy(CMSG_DATA(cmsg), &datagram.segment_size, sizeof(std::uint16_t));
+        }
+    }
+
+    int const sent = ::sendmmsg(m_fd.get(), m_send_headers.data(), static_cast<unsigned>(count), MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (-1 == sent) {
+        if (EAGAIN == errno || EWOULDBLOCK == errno) {
+            return std::size_t(0);
+        }
+        return make_error(errno, "sendmmsg() failed");
+    }
+
+    return static_cast<std::size_t>(sent);
+}
+
+std::size_t DatagramSocket::send(Datagram const* datagrams, std::size_t count)
+{
+    return success_or_throw<>(send(datagrams, count, std::nothrow));
+}
+
+void DatagramSocket::close() noexcept
+{
+    if (-1 == m_fd.get()) {
+        return;
+    }
+
+    with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        loop.remove(m_fd.get());
+    });
+
+    m_fd.reset();
+}
@@ -39,16 +39,16 @@ constexpr std::size_t max_error_string = 256;
 //
 bool Error::empty() const noexcept
 {
-    return !m_exception;
+    return !m_code && !m_exception;
 }
 
 std::error_code Error::code() const
 {
-    try {
-        if (empty()) {
-            return {};
-        }
+    if (true == static_cast<bool>(m_code) || !m_exception) {
+        return m_code;
+    }
 
+    try {
         std::rethrow_exception(m_exception);
     }
     catch (std::system_error const& e) {
@@ -57,16 +57,20 @@ std::error_code Error::code() const
     catch (...) {
         return {};
     }
-
 }
 
 std::string Error::what() const
 {
-    try {
-        if (empty()) {
+    if (!m_exception) {
+        if (!m_code) {
             return {};
         }
 
+        // Same format as std::system_error::what().
+        return nullptr != m_context ? std::string(m_context) + ": " + m_code.message() : m_code.message();
+    }
+
+    try {
         std::rethrow_exception(m_exception);
     }
     catch (std::exception const& e) {
@@ -79,7 +83,15 @@ std::string Error::what() const
 
 [[noreturn]] void Error::toss() const
 {
-    if (m_exception) std::rethrow_exception(m_exception);
+    if (m_exception) {
+        std::rethrow_exception(m_exception);
+    }
+    if (m_code) {
+        if (nullptr != m_context) {
+            throw std::system_error(m_code, m_context);
+        }
+        throw std::system_error(m_code);
+    }
     throw std::logic_error("No exception stored");
 }
 
@@ -104,6 +116,16 @@ std::error_code hlib::make_error_code(int posix_errno)
     return std::make_error_code(static_cast<std::errc>(posix_errno));
 }
 
+Error hlib::make_error(int posix_errno) noexcept
+{
+    return Error(std::make_error_code(static_cast<std::errc>(posix_errno)));
+}
+
+Error hlib::make_error(int posix_errno, char const* context) noexcept
+{
+    return Error(std::make_error_code(static_cast<std::errc>(posix_errno)), context);
+}
+
 std::system_error hlib::make_system_error(int posix_errno)
 {
     return std::system_error(make_error_code(posix_errno));
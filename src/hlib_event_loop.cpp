@@ -28,6 +28,8 @@
 #include "hlib/scope_guard.hpp"
 #include "hlib/time.hpp"
 #include "hlib/utility.hpp"
+#include <algorithm>
+#include <climits>
 #include <fcntl.h>
 #include <stdexcept>
 #include <unistd.h>
@@ -50,11 +52,13 @@ void EventLoop::dispatch(time::Duration const* timeout)
         }
     );
 
-    time::MSec timeout_ms(-1);
-    time::Clock expire;
+    int timeout_ms = -1;
+    time::TimePoint expire;
+
+    m_now = time::now_ns();
 
     if (nullptr != timeout) {
-        expire = time::now() + *timeout;
+        expire = m_now + time::DurationNs(*timeout);
     }
 
     HLIB_UNIQUE_LOCK_DEFERRED(lock, m_mutex);
@@ -68,17 +72,19 @@ void EventLoop::dispatch(time::Duration const* timeout)
         }
 
         if (nullptr != timeout) {
-            time::Clock const current = time::now();
-            if (current < expire) {
-                timeout_ms = (expire - current).to<time::MSec>();
-            }
-            else {
-                timeout_ms = time::MSec(0);
-            }
+            // Round up, so not to wake up just before expiry.
+            std::int64_t const remaining = (expire - m_now).count();
+            timeout_ms = remaining > 0
+                ? static_cast<int>(std::min<std::int64_t>((remaining + 999999) / 1000000, INT_MAX))
+                : 0;
         }
 
         epoll_event event;
-        switch (epoll_wait(m_fd.get(), &event, 1, timeout_ms.value())) {
+        int const count = epoll_wait(m_fd.get(), &event, 1, timeout_ms);
+
+        m_now = time::now_ns();
+
+        switch (count) {
         case -1:
             if (EINTR != errno) {
                 throw make_system_error(errno, "epoll_wait() failed");
@@ -98,10 +104,15 @@ void EventLoop::dispatch(time::Duration const* timeout)
             lock.unlock();
 
             (*callback)(event.data.fd, event.events);
+
+            // Account for the callback in the remaining timeout.
+            if (nullptr != timeout) {
+                m_now = time::now_ns();
+            }
             break;
 
         default:
-            assert(timeout_ms >= time::MSec(0));
+            assert(timeout_ms >= 0);
             return;
         }
     }
@@ -147,6 +158,11 @@ std::thread::id EventLoop::threadId() const noexcept
     return m_thread_id;
 }
 
+time::TimePoint EventLoop::now() const noexcept
+{
+    return m_now;
+}
+
 void EventLoop::add(int fd, std::uint32_t events, Callback callback)
 {
     assert(-1 != fd);
@@ -180,7 +196,7 @@ Result<> EventLoop::modify(int fd, std::uint32_t events, std::nothrow_t) noexcep
     event.events = events;
     event.data.fd = fd;
     if (-1 == epoll_ctl(m_fd.get(), EPOLL_CTL_MOD, fd, &event)) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return {};
@@ -236,7 +252,7 @@ Result<> EventLoop::interrupt(std::nothrow_t) noexcept
     std::uint8_t const cmd = 0;
 
     if (1 != write(m_pipe[1], &cmd, 1)) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return {};
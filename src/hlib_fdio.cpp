@@ -29,12 +29,39 @@
 #include "hlib/socket.hpp"
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 using namespace hlib;
 
+namespace
+{
+
+// Largest number of bytes moved per splice(), sendfile() or read() call.
+constexpr std::size_t relay_chunk_size = 1024 * 1024;
+
+bool is_pollable(int fd) noexcept
+{
+    struct stat status;
+    if (-1 == fstat(fd, &status)) {
+        return false;
+    }
+
+    // Regular files and block devices are always ready and cannot be added to epoll.
+    return false == S_ISREG(status.st_mode) && false == S_ISBLK(status.st_mode);
+}
+
+bool is_mode(int fd, mode_t mode) noexcept
+{
+    struct stat status;
+    return 0 == fstat(fd, &status) && mode == (S_IFMT & status.st_mode);
+}
+
+} // namespace
+
 //
-// Implementation
+// Implementation (FileDescriptorIO)
 //
 void FileDescriptorIO::updateEventsLocked(std::uint32_t events) noexcept
 {
@@ -177,7 +204,143 @@ void FileDescriptorIO::callbackAndClose(int error)
 }
 
 //
-// Public
+// Implementation (FileDescriptorRelay)
+//
+void FileDescriptorRelay::onEvent(int /* fd */, std::uint32_t /* events */)
+{
+    // Edge triggered, errors and hang-ups surface from the next transfer.
+    transfer();
+}
+
+ssize_t FileDescriptorRelay::fill(std::size_t size) noexcept
+{
+    switch (m_mode) {
+    case Splice:
+        return splice(m_source.get(), nullptr, m_destination.get(), nullptr, size, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+    case SendFile:
+        return sendfile(m_destination.get(), m_source.get(), nullptr, size);
+
+    case SplicePipe:
+        return splice(m_source.get(), nullptr, m_pipe[1], nullptr, size, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+    case Copy:
+        m_buffer_offset = 0;
+        return ::read(m_source.get(), m_buffer.data(), size);
+
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+}
+
+ssize_t FileDescriptorRelay::drain() noexcept
+{
+    switch (m_mode) {
+    case SplicePipe:
+        return splice(m_pipe[0], nullptr, m_destination.get(), nullptr, m_staged, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+    case Copy:
+        return ::write(m_destination.get(), static_cast<std::uint8_t const*>(m_buffer.data()) + m_buffer_offset, m_staged);
+
+    default:
+        assert(0 == m_staged);
+        return 0;
+    }
+}
+
+void FileDescriptorRelay::transfer()
+{
+    // Direct modes move data from source to destination in a single call,
+    // staged modes fill a pipe or buffer from the source and drain it to the
+    // destination. Transfer until neither makes progress, the edge triggered
+    // readiness of the blocking side resumes the transfer.
+    while (-1 != m_source.get()) {
+        bool progress = false;
+        bool const direct = Splice == m_mode || SendFile == m_mode;
+
+        // Fill.
+        std::size_t const room = Copy == m_mode && 0 != m_staged ? 0 : m_capacity - m_staged;
+
+        if (false == m_eof && m_remaining > 0 && room > 0) {
+            ssize_t size = fill(std::min(m_remaining, room));
+            if (size > 0) {
+                progress = true;
+                m_remaining -= size;
+                if (true == direct) {
+                    m_transferred += size;
+                }
+                else {
+                    m_staged += size;
+                }
+            }
+            else if (0 == size) {
+                m_eof = true;
+            }
+            else if (EINTR == errno) {
+                continue;
+            }
+            else if ((EINVAL == errno || ENOSYS == errno) && Copy != m_mode && 0 == m_transferred && 0 == m_staged) {
+                // The file descriptors do not support splice() or sendfile().
+                m_pipe.close();
+                m_mode = Copy;
+                m_capacity = relay_chunk_size;
+                if (nullptr == m_buffer.reserve(m_capacity, std::nothrow)) {
+                    complete(ENOMEM);
+                    return;
+                }
+                continue;
+            }
+            else if (EAGAIN != errno && EWOULDBLOCK != errno) {
+                complete(errno);
+                return;
+            }
+        }
+
+        // Drain.
+        if (m_staged > 0) {
+            ssize_t size = drain();
+            if (size > 0) {
+                progress = true;
+                m_staged -= size;
+                m_buffer_offset += size;
+                m_transferred += size;
+            }
+            else if (-1 == size && EINTR == errno) {
+                continue;
+            }
+            else if (-1 == size && EAGAIN != errno && EWOULDBLOCK != errno) {
+                complete(errno);
+                return;
+            }
+        }
+
+        if ((true == m_eof || 0 == m_remaining) && 0 == m_staged) {
+            complete(0);
+            return;
+        }
+
+        if (false == progress) {
+            return;
+        }
+    }
+}
+
+void FileDescriptorRelay::complete(int error)
+{
+    auto callback = std::move(m_on_completed);
+    std::size_t const transferred = m_transferred;
+
+    cancel();
+
+    // May destroy the relay.
+    if (nullptr != callback) {
+        callback(transferred, error);
+    }
+}
+
+//
+// Public (FileDescriptorIO)
 //
 FileDescriptorIO::FileDescriptorIO(std::weak_ptr<EventLoop> event_loop) noexcept
     : m_event_loop(std::move(event_loop))
@@ -217,7 +380,7 @@ Result<> FileDescriptorIO::open(Handle<int, -1> fd, std::nothrow_t) noexcept
         loop.add(fd.get(), m_events, std::bind(&FileDescriptorIO::onEvent, this, _1, _2));
     });
     if (false == success) {
-        return make_system_error(ENODEV, "Failed to lock event loop");
+        return make_error(ENODEV, "Failed to lock event loop");
     }
 
     // Store socket's file descriptor and signal it is connected.
@@ -312,3 +475,139 @@ void FileDescriptorIO::close() noexcept
     m_write_queue.clear();
 }
 
+
+//
+// Public (FileDescriptorRelay)
+//
+FileDescriptorRelay::FileDescriptorRelay(std::weak_ptr<EventLoop> event_loop) noexcept
+    : m_event_loop(std::move(event_loop))
+    , m_source(file::fd_close)
+    , m_destination(file::fd_close)
+{
+}
+
+FileDescriptorRelay::~FileDescriptorRelay()
+{
+    cancel();
+}
+
+bool FileDescriptorRelay::active() const noexcept
+{
+    return -1 != m_source.get();
+}
+
+std::size_t FileDescriptorRelay::transferred() const noexcept
+{
+    return m_transferred;
+}
+
+Result<> FileDescriptorRelay::pipe(int source_fd, int destination_fd, OnCompleted callback, std::size_t size, std::nothrow_t) noexcept
+{
+    using namespace std::placeholders;
+
+    cancel();
+
+    m_source.reset(fcntl(source_fd, F_DUPFD_CLOEXEC, 0));
+    if (-1 == m_source.get()) {
+        return make_error(errno, "fcntl() failed");
+    }
+    m_destination.reset(fcntl(destination_fd, F_DUPFD_CLOEXEC, 0));
+    if (-1 == m_destination.get()) {
+        int const error = errno;
+        m_source.reset();
+        return make_error(error, "fcntl() failed");
+    }
+
+    m_eof = false;
+    m_remaining = size;
+    m_transferred = 0;
+    m_staged = 0;
+    m_buffer_offset = 0;
+    m_on_completed = std::move(callback);
+
+    // Select the transfer mode.
+    if (true == is_mode(m_source.get(), S_IFIFO) || true == is_mode(m_destination.get(), S_IFIFO)) {
+        m_mode = Splice;
+        m_capacity = relay_chunk_size;
+    }
+    else if (true == is_mode(m_source.get(), S_IFREG)) {
+        m_mode = SendFile;
+        m_capacity = relay_chunk_size;
+    }
+    else {
+        Result<> result = m_pipe.open(std::nothrow);
+        if (true == result.failure()) {
+            cancel();
+            return result;
+        }
+
+        // A larger pipe reduces the number of splice() calls, the default is used on failure.
+        fcntl(m_pipe[1], F_SETPIPE_SZ, static_cast<int>(relay_chunk_size));
+        int capacity = fcntl(m_pipe[1], F_GETPIPE_SZ);
+
+        m_mode = SplicePipe;
+        m_capacity = capacity > 0 ? static_cast<std::size_t>(capacity) : 65536;
+    }
+
+    // Add pollable file descriptors to the event loop, edge triggered as the
+    // transfer may block on either side.
+    m_source_polled = is_pollable(m_source.get());
+    m_destination_polled = is_pollable(m_destination.get());
+
+    try {
+        bool success = with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+            if (true == m_source_polled) {
+                file::fd_set_non_blocking(m_source.get(), true);
+                loop.add(m_source.get(), EventLoop::Read | EventLoop::RdHup | EventLoop::EdgeTriggered,
+                    std::bind(&FileDescriptorRelay::onEvent, this, _1, _2));
+            }
+            if (true == m_destination_polled) {
+                file::fd_set_non_blocking(m_destination.get(), true);
+                loop.add(m_destination.get(), EventLoop::Write | EventLoop::EdgeTriggered,
+                    std::bind(&FileDescriptorRelay::onEvent, this, _1, _2));
+            }
+        });
+        if (false == success) {
+            cancel();
+            return make_error(ENODEV, "Failed to lock event loop");
+        }
+    }
+    catch (...) {
+        cancel();
+        return std::current_exception();
+    }
+
+    // Neither side will signal readiness, transfer synchronously.
+    if (false == m_source_polled && false == m_destination_polled) {
+        transfer();
+    }
+
+    return {};
+}
+
+void FileDescriptorRelay::pipe(int source_fd, int destination_fd, OnCompleted callback, std::size_t size)
+{
+    success_or_throw(pipe(source_fd, destination_fd, std::move(callback), size, std::nothrow));
+}
+
+void FileDescriptorRelay::cancel() noexcept
+{
+    with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        if (true == m_source_polled) {
+            loop.remove(m_source.get());
+        }
+        if (true == m_destination_polled) {
+            loop.remove(m_destination.get());
+        }
+    });
+
+    m_source_polled = false;
+    m_destination_polled = false;
+
+    m_source.reset();
+    m_destination.reset();
+    m_pipe.close();
+    m_buffer.reset();
+    m_staged = 0;
+    m_on_completed = nullptr;
+}
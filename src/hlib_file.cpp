@@ -23,19 +23,343 @@
 //
 #include "hlib/file.hpp"
 #include "hlib/error.hpp"
+#include "hlib/lock.hpp"
 #include "hlib/scope_guard.hpp"
 #include "hlib/string.hpp"
+#include <atomic>
+#include <chrono>
+#include <climits>
 #include <cstring>
 #include <fcntl.h>
 #include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include <system_error>
+#include <thread>
 #include <unistd.h>
 #include <unordered_map>
 #include <pwd.h>
-#include <unistd.h>
 
 using namespace hlib;
 
+namespace
+{
+
+// Offset and size alignment of O_DIRECT I/O, the largest logical block size
+// in common use.
+constexpr std::size_t direct_io_alignment = 4096;
+
+std::size_t round_up(std::size_t value, std::size_t alignment) noexcept
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Returns the number of bytes remaining from offset in a regular file, plus
+// one to detect end-of-file without another allocation, or 0 when unknown.
+std::size_t get_remaining_size(int fd, off_t offset) noexcept
+{
+    struct stat status;
+    if (-1 == fstat(fd, &status) || false == S_ISREG(status.st_mode) || offset < 0 || offset >= status.st_size) {
+        return 0;
+    }
+
+    return static_cast<std::size_t>(status.st_size - offset) + 1;
+}
+
+// Reads size bytes at offset, returns less at end-of-file.
+Result<std::size_t> pread_all(int fd, void* data, std::size_t size, std::size_t offset) noexcept
+{
+    std::size_t total = 0;
+
+    while (total < size) {
+        ssize_t count = pread(fd, static_cast<std::uint8_t*>(data) + total, size - total, static_cast<off_t>(offset + total));
+        if (-1 == count) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return make_error(errno);
+        }
+        if (0 == count) {
+            break;
+        }
+
+        total += static_cast<std::size_t>(count);
+    }
+
+    return total;
+}
+
+// Writes chunks at offset with as few pwritev() calls as possible, returns
+// 0 or an errno.
+int pwrite_chunks(int fd, std::deque<Buffer> const& chunks, std::size_t offset) noexcept
+{
+    std::array<iovec, 64> iov;
+    auto chunk = chunks.begin();
+    std::size_t chunk_offset = 0;
+
+    while (chunks.end() != chunk) {
+        // Gather the next chunks.
+        std::size_t count = 0;
+        auto it = chunk;
+        for (std::size_t skip = chunk_offset; chunks.end() != it && count < iov.size(); ++it, skip = 0) {
+            if (skip < it->size()) {
+                iov[count].iov_base = static_cast<std::uint8_t*>(const_cast<void*>(it->data())) + skip;
+                iov[count].iov_len = it->size() - skip;
+                ++count;
+            }
+        }
+
+        ssize_t size = pwritev(fd, iov.data(), static_cast<int>(count), static_cast<off_t>(offset));
+        if (-1 == size) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return errno;
+        }
+
+        // Advance past the bytes written, which may end within a chunk.
+        offset += static_cast<std::size_t>(size);
+        std::size_t remaining = static_cast<std::size_t>(size);
+
+        while (chunks.end() != chunk && remaining >= chunk->size() - chunk_offset) {
+            remaining -= chunk->size() - chunk_offset;
+            chunk_offset = 0;
+            ++chunk;
+        }
+        chunk_offset += remaining;
+    }
+
+    return 0;
+}
+
+std::chrono::nanoseconds to_chrono(time::Duration const& duration) noexcept
+{
+    return std::chrono::nanoseconds(duration.to<time::NSec>().value());
+}
+
+//
+// MIME types
+//
+struct MimeExtension
+{
+    std::string_view extension;
+    std::string_view mime_type;
+};
+
+// Sorted by extension for binary search.
+constexpr MimeExtension mime_extensions[] =
+{
+    { "7z",    "application/x-7z-compressed" },
+    { "avi",   "video/x-msvideo" },
+    { "bmp",   "image/bmp" },
+    { "bz2",   "application/x-bzip2" },
+    { "css",   "text/css" },
+    { "csv",   "text/csv" },
+    { "flac",  "audio/flac" },
+    { "gif",   "image/gif" },
+    { "gz",    "application/gzip" },
+    { "htm",   "text/html" },
+    { "html",  "text/html" },
+    { "ico",   "image/x-icon" },
+    { "jpeg",  "image/jpeg" },
+    { "jpg",   "image/jpeg" },
+    { "js",    "text/javascript" },
+    { "json",  "application/json" },
+    { "mjs",   "text/javascript" },
+    { "mp3",   "audio/mpeg" },
+    { "mp4",   "video/mp4" },
+    { "ogg",   "audio/ogg" },
+    { "otf",   "font/otf" },
+    { "pdf",   "application/pdf" },
+    { "png",   "image/png" },
+    { "svg",   "image/svg+xml" },
+    { "tar",   "application/x-tar" },
+    { "tif",   "image/tiff" },
+    { "tiff",  "image/tiff" },
+    { "ttf",   "font/ttf" },
+    { "txt",   "text/plain" },
+    { "wasm",  "application/wasm" },
+    { "wav",   "audio/wav" },
+    { "webm",  "video/webm" },
+    { "webp",  "image/webp" },
+    { "woff",  "font/woff" },
+    { "woff2", "font/woff2" },
+    { "xml",   "text/xml" },
+    { "xz",    "application/x-xz" },
+    { "zip",   "application/zip" },
+    { "zst",   "application/zstd" }
+};
+
+constexpr bool is_sorted(MimeExtension const* begin, MimeExtension const* end) noexcept
+{
+    for (MimeExtension const* it = begin + 1; it < end; ++it) {
+        if (false == ((it - 1)->extension < it->extension)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(true == is_sorted(std::begin(mime_extensions), std::end(mime_extensions)), "mime_extensions must be sorted");
+
+// Bytes of data inspected by content sniffing.
+constexpr std::size_t mime_header_size = 16;
+
+struct MimeSignature
+{
+    std::size_t offset;
+    std::string_view magic;
+    std::string_view mime_type;
+
+    // Optional second magic, e.g. the format of a RIFF container.
+    std::size_t offset2{ 0 };
+    std::string_view magic2{};
+
+    constexpr bool matches(std::string_view const& header) const noexcept
+    {
+        return header.size() >= offset + magic.size()
+            && magic == header.substr(offset, magic.size())
+            && header.size() >= offset2 + magic2.size()
+            && magic2 == header.substr(offset2, magic2.size());
+    }
+};
+
+using namespace std::string_view_literals;
+
+// Signatures at offset 0, sorted by their first byte. Within a first byte,
+// more specific signatures come first.
+constexpr MimeSignature mime_signatures[] =
+{
+    { 0, "\x00\x00\x01\x00"sv,          "image/x-icon" },
+    { 0, "\x00\x01\x00\x00\x00"sv,      "font/ttf" },
+    { 0, "\x00" "asm"sv,                "application/wasm" },
+    { 0, "\x1A\x45\xDF\xA3"sv,          "video/webm" },
+    { 0, "\x1F\x8B"sv,                  "application/gzip" },
+    { 0, "%!PS"sv,                      "application/postscript" },
+    { 0, "%PDF-"sv,                     "application/pdf" },
+    { 0, "\x28\xB5\x2F\xFD"sv,          "application/zstd" },
+    { 0, "7z\xBC\xAF\x27\x1C"sv,        "application/x-7z-compressed" },
+    { 0, "<!DOCTYPE html"sv,            "text/html" },
+    { 0, "<!doctype html"sv,            "text/html" },
+    { 0, "<?xml"sv,                     "text/xml" },
+    { 0, "<html"sv,                     "text/html" },
+    { 0, "<svg"sv,                      "image/svg+xml" },
+    { 0, "BM"sv,                        "image/bmp" },
+    { 0, "BZh"sv,                       "application/x-bzip2" },
+    { 0, "GIF87a"sv,                    "image/gif" },
+    { 0, "GIF89a"sv,                    "image/gif" },
+    { 0, "ID3"sv,                       "audio/mpeg" },
+    { 0, "II*\x00"sv,                   "image/tiff" },
+    { 0, "MM\x00*"sv,                   "image/tiff" },
+    { 0, "OTTO"sv,                      "font/otf" },
+    { 0, "OggS"sv,                      "audio/ogg" },
+    { 0, "PK\x03\x04"sv,                "application/zip" },
+    { 0, "RIFF"sv,                      "image/webp", 8, "WEBP"sv },
+    { 0, "RIFF"sv,                      "audio/wav", 8, "WAVE"sv },
+    { 0, "RIFF"sv,                      "video/x-msvideo", 8, "AVI "sv },
+    { 0, "Rar!\x1A\x07"sv,              "application/vnd.rar" },
+    { 0, "fLaC"sv,                      "audio/flac" },
+    { 0, "wOF2"sv,                      "font/woff2" },
+    { 0, "wOFF"sv,                      "font/woff" },
+    { 0, "\x7F" "ELF"sv,                "application/x-executable" },
+    { 0, "\x89PNG\r\n\x1A\n"sv,         "image/png" },
+    { 0, "\xEF\xBB\xBF"sv,              "text/plain" },
+    { 0, "\xFD" "7zXZ\x00"sv,           "application/x-xz" },
+    { 0, "\xFE\xFF"sv,                  "text/plain" },
+    { 0, "\xFF\xD8\xFF"sv,              "image/jpeg" },
+    { 0, "\xFF\xFB"sv,                  "audio/mpeg" },
+    { 0, "\xFF\xFE"sv,                  "text/plain" }
+};
+
+// Signatures at other offsets, tested when no signature at offset 0 matches.
+constexpr MimeSignature mime_offset_signatures[] =
+{
+    { 4, "ftyp"sv,                      "video/mp4" }
+};
+
+constexpr std::uint8_t first_byte(MimeSignature const& signature) noexcept
+{
+    return static_cast<std::uint8_t>(signature.magic.front());
+}
+
+constexpr bool is_sorted(MimeSignature const* begin, MimeSignature const* end) noexcept
+{
+    for (MimeSignature const* it = begin; it < end; ++it) {
+        if (0 != it->offset || true == it->magic.empty() || (it > begin && first_byte(*(it - 1)) > first_byte(*it))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(true == is_sorted(std::begin(mime_signatures), std::end(mime_signatures)), "mime_signatures must be sorted");
+
+// Maps a first byte b to the range [table[b], table[b + 1]) of signatures
+// starting with it.
+constexpr std::array<std::uint8_t, 257> make_mime_jump_table() noexcept
+{
+    std::array<std::uint8_t, 257> table{};
+    std::size_t index = 0;
+
+    for (std::size_t byte = 0; byte < 256; ++byte) {
+        table[byte] = static_cast<std::uint8_t>(index);
+        while (index < std::size(mime_signatures) && byte == first_byte(mime_signatures[index])) {
+            ++index;
+        }
+    }
+    table[256] = static_cast<std::uint8_t>(index);
+
+    return table;
+}
+
+static_assert(std::size(mime_signatures) < 256);
+
+constexpr std::array<std::uint8_t, 257> mime_jump_table = make_mime_jump_table();
+
+// Content sniffing results of files, empty when no signature matched.
+struct MimeCacheKey
+{
+    dev_t device;
+    ino_t inode;
+
+    bool operator==(MimeCacheKey const& other) const noexcept
+    {
+        return device == other.device && inode == other.inode;
+    }
+};
+
+struct MimeCacheKeyHash
+{
+    std::size_t operator()(MimeCacheKey const& key) const noexcept
+    {
+        return std::hash<ino_t>()(key.inode) ^ (std::hash<dev_t>()(key.device) << 1);
+    }
+};
+
+struct MimeCacheEntry
+{
+    std::int64_t mtime;
+    std::size_t size;
+    std::string_view mime_type;
+};
+
+struct MimeCache
+{
+    std::mutex mutex;
+    std::unordered_map<MimeCacheKey, MimeCacheEntry, MimeCacheKeyHash> entries;
+};
+
+constexpr std::size_t mime_cache_capacity = 4096;
+
+MimeCache& mime_cache()
+{
+    static MimeCache cache;
+    return cache;
+}
+
+} // namespace
+
 //
 // Public
 //
@@ -119,7 +443,7 @@ Result<std::size_t> file::read(std::istream& stream, void* data, std::size_t siz
 {
     stream.read(static_cast<char*>(data), size);
     if (true == stream.fail()) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return stream.gcount();
@@ -135,7 +459,7 @@ Result<std::size_t> file::read(FILE* file, void* data, std::size_t size, std::no
 {
     std::size_t count = fread(data, 1, size, file);
     if (0 != ferror(file)) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return count;
@@ -150,7 +474,7 @@ Result<size_t> file::read(int fd, void* data, std::size_t size, std::nothrow_t)
 {
     ssize_t count = ::read(fd, data, size);
     if (count < 0) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return count;
@@ -168,16 +492,16 @@ Result<> file::read(std::istream& stream, Buffer& buffer, std::size_t size, std:
 {
     char* ptr = static_cast<char*>(buffer.extend(size, std::nothrow));
     if (ptr == nullptr) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
-    stream.read(ptr + buffer.size(), size);
-    if (true == stream.fail()) {
-        return make_system_error(errno);
+    stream.read(ptr, size);
+    if (true == stream.fail() && false == stream.eof()) {
+        return make_error(errno);
     }
 
     if (nullptr == buffer.resize(buffer.size() + stream.gcount(), std::nothrow)) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return {};
@@ -217,16 +541,16 @@ Result<std::size_t> file::read(FILE* file, Buffer& buffer, std::size_t size, std
 {
     uint8_t* ptr = static_cast<uint8_t*>(buffer.extend(size, std::nothrow));
     if (ptr == nullptr) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
-    std::size_t count = fread(ptr + buffer.size(), 1, size, file);
+    std::size_t count = fread(ptr, 1, size, file);
     if (nullptr == buffer.resize(buffer.size() + count, std::nothrow)) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     if (0 != ferror(file)) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return count;
@@ -245,8 +569,17 @@ Result<Buffer> file::read(FILE* file, std::size_t batch_size, std::nothrow_t) no
     Result<size_t> result;
     Buffer buffer;
 
+    // Preallocate the remainder of regular files.
+    std::size_t remaining = get_remaining_size(fileno(file), ftell(file));
+    if (remaining > 0 && nullptr == buffer.reserve(remaining, std::nothrow)) {
+        return make_error(ENOMEM);
+    }
+
     do {
-        result = read(file, buffer, batch_size, std::nothrow);
+        // Fill the preallocated space first, its extra byte detects the end
+        // of the file without growing the buffer.
+        std::size_t const room = buffer.capacity() - buffer.size();
+        result = read(file, buffer, 0 != room ? room : batch_size, std::nothrow);
         if (true == result.failure()) {
             return result.error();
         }
@@ -265,16 +598,16 @@ Result<size_t> file::read(int fd, Buffer& buffer, std::size_t size, std::nothrow
 {
     uint8_t* ptr = static_cast<uint8_t*>(buffer.extend(size, std::nothrow));
     if (ptr == nullptr) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
-    ssize_t count = ::read(fd, ptr + buffer.size(), size);
+    ssize_t count = ::read(fd, ptr, size);
     if (count < 0) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     if (nullptr == buffer.resize(buffer.size() + count, std::nothrow)) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return count;
@@ -293,8 +626,20 @@ Result<Buffer> file::read(int fd, std::size_t batch_size, std::nothrow_t) noexce
     Result<size_t> result;
     Buffer buffer;
 
+    // Preallocate the remainder of regular files.
+    std::size_t remaining = get_remaining_size(fd, lseek(fd, 0, SEEK_CUR));
+    if (remaining > 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        if (nullptr == buffer.reserve(remaining, std::nothrow)) {
+            return make_error(ENOMEM);
+        }
+    }
+
     do {
-        result = read(fd, buffer, batch_size, std::nothrow);
+        // Fill the preallocated space first, its extra byte detects the end
+        // of the file without growing the buffer.
+        std::size_t const room = buffer.capacity() - buffer.size();
+        result = read(fd, buffer, 0 != room ? room : batch_size, std::nothrow);
         if (true == result.failure()) {
             return result.error();
         }
@@ -311,32 +656,123 @@ Buffer file::read(int fd, std::size_t batch_size)
 
 Result<Buffer> file::read(std::string const& filepath, std::nothrow_t) noexcept
 {
-    std::error_code error_code;
+    return read(filepath, ReadOptions(), std::nothrow);
+}
 
-    std::size_t size = std::filesystem::file_size(filepath, error_code);
-    if (error_code) {
-        return std::system_error(error_code);
+Buffer file::read(std::string const& filepath)
+{
+    return success_or_throw<Buffer>(read(filepath, std::nothrow));
+}
+
+//
+// Ingestion
+//
+Result<Buffer> file::read(std::string const& filepath, ReadOptions const& options, std::nothrow_t) noexcept
+{
+    bool direct = options.direct;
+
+    Handle<int, -1> fd(::open(filepath.c_str(), O_RDONLY | O_CLOEXEC | (true == direct ? O_DIRECT : 0)), fd_close);
+    if (-1 == fd.get() && true == direct && EINVAL == errno) {
+        direct = false;
+        fd.reset(::open(filepath.c_str(), O_RDONLY | O_CLOEXEC));
+    }
+    if (-1 == fd.get()) {
+        return make_error(errno, "open() failed");
+    }
+
+    struct stat status;
+    if (-1 == fstat(fd.get(), &status)) {
+        return make_error(errno, "fstat() failed");
     }
 
+    std::size_t const chunk_size = std::max<std::size_t>(options.chunk_size, 1);
+
+    // Files without a size are read until end-of-file.
+    if (false == S_ISREG(status.st_mode) || 0 == status.st_size) {
+        if (true == direct) {
+            fcntl(fd.get(), F_SETFL, fcntl(fd.get(), F_GETFL) & ~O_DIRECT);
+        }
+        return read(fd.get(), chunk_size, std::nothrow);
+    }
+
+    // O_DIRECT requires aligned memory, offsets and sizes.
+    std::size_t const alignment = true == direct ? direct_io_alignment : 1;
+    std::size_t const size = static_cast<std::size_t>(status.st_size);
+    std::size_t const capacity = round_up(size, alignment);
+    std::size_t const chunk = round_up(chunk_size, alignment);
+    std::size_t const chunks = (capacity + chunk - 1) / chunk;
+    std::size_t const threads = std::min(std::max<std::size_t>(options.threads, 1), chunks);
+
     Buffer buffer;
+    std::uint8_t* data = static_cast<std::uint8_t*>(true == direct
+        ? buffer.reserveAligned(capacity, alignment, std::nothrow)
+        : buffer.reserve(capacity, std::nothrow));
+    if (nullptr == data) {
+        return make_error(ENOMEM);
+    }
 
-    if (0 == size) {
-        return buffer;
+    if (false == direct) {
+        posix_fadvise(fd.get(), 0, static_cast<off_t>(size), POSIX_FADV_SEQUENTIAL);
+    }
+
+    // Threads take chunks in order, a file shorter than its size at open
+    // limits the end.
+    std::atomic<std::size_t> next{ 0 };
+    std::atomic<std::size_t> end{ size };
+    std::atomic<int> error{ 0 };
+
+    auto reader = [&]() noexcept {
+        for (std::size_t index = next++; index < chunks && 0 == error; index = next++) {
+            std::size_t const offset = index * chunk;
+            std::size_t const length = std::min(chunk, capacity - offset);
+
+            // Start reading ahead what is likely this thread's next chunk.
+            if (false == direct && index + threads < chunks) {
+                posix_fadvise(fd.get(), static_cast<off_t>((index + threads) * chunk), static_cast<off_t>(chunk), POSIX_FADV_WILLNEED);
+            }
+
+            Result<std::size_t> count = pread_all(fd.get(), data + offset, length, offset);
+            if (true == count.failure()) {
+                int expected = 0;
+                error.compare_exchange_strong(expected, count.error().code().value());
+                return;
+            }
+
+            if (count.value() < length) {
+                std::size_t last = end;
+                while (offset + count.value() < last && false == end.compare_exchange_weak(last, offset + count.value())) {
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    try {
+        pool.reserve(threads - 1);
+        for (std::size_t i = 1; i < threads; ++i) {
+            pool.emplace_back(reader);
+        }
+    }
+    catch (...) {
+        // Continue with the threads that did start.
     }
 
-    std::ifstream stream(filepath);
+    reader();
+    for (auto& thread : pool) {
+        thread.join();
+    }
 
-    Result<> result = read(stream, buffer, size, std::nothrow);
-    if (true == result.failure()) {
-        return result.error();
+    if (0 != error) {
+        return make_error(error, "pread() failed");
     }
 
+    buffer.resize(std::min<std::size_t>(end, size));
     return buffer;
 }
 
-Buffer file::read(std::string const& filepath)
+Buffer file::read(std::string const& filepath, ReadOptions const& options)
 {
-    return success_or_throw<Buffer>(read(filepath, std::nothrow));
+    return success_or_throw<Buffer>(read(filepath, options, std::nothrow));
 }
 
 //
@@ -346,7 +782,7 @@ Result<std::size_t> file::write(std::ostream& stream, void const* data, std::siz
 {
     stream.write(static_cast<char const*>(data), size);
     if (true == stream.fail()) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return {};
@@ -362,7 +798,7 @@ Result<std::size_t> file::write(FILE* file, void const* data, std::size_t size,
 {
     std::size_t count = fwrite(data, 1, size, file);
     if (0 != ferror(file)) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return count;
@@ -375,9 +811,9 @@ std::size_t file::write(FILE* file, void const* data, std::size_t size)
 
 Result<std::size_t> file::write(int fd, void const* data, std::size_t size, std::nothrow_t) noexcept
 {
-    ssize_t count = write(fd, data, size);
+    ssize_t count = ::write(fd, data, size);
     if (-1 == count) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return count;
@@ -399,7 +835,7 @@ Result<> file::write(std::ostream& stream, Buffer const& buffer, std::size_t& of
 
     stream.write(static_cast<char const*>(buffer.data()) + offset, size);
     if (true == stream.fail()) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     offset += stream.tellp() - pos;
@@ -432,7 +868,7 @@ Result<std::size_t> file::write(FILE* file, Buffer const& buffer, std::size_t& o
     offset += count;
 
     if (0 != ferror(file)) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return count;
@@ -463,7 +899,7 @@ Result<std::size_t> write(int fd, Buffer const& buffer, std::size_t& offset, std
 
     ssize_t count = write(fd, static_cast<char const*>(buffer.data()) + offset, size);
     if (-1 == count) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     offset += count;
@@ -493,7 +929,7 @@ Result<> file::write(std::string const& filepath, Buffer const& buffer, std::not
 {
     std::ofstream stream(filepath);
     if (!stream) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return write(stream, buffer, std::nothrow);
@@ -504,82 +940,125 @@ void file::write(std::string const& filepath, Buffer const& buffer)
     success_or_throw<>(write(filepath, buffer, std::nothrow));
 }
 
-std::string file::get_mime_type_from_extension(std::string const& extension, std::string const& default_mime_type)
+std::string_view file::get_mime_type_from_extension(std::string_view extension, std::string_view default_mime_type) noexcept
 {
-    static std::unordered_map<std::string, std::string> const table =
-    {
-        { "txt",  "text/plain" },
-        { "htm",  "text/html" },
-        { "html", "text/html" },
-        { "js",   "text/javascript" },
-        { "xml",  "text/xml" },
-        { "json", "application/json" },
-        { "pdf",  "application/pdf" },
-        { "png",  "image/png" },
-        { "jpg",  "image/jpeg" },
-        { "jpeg", "image/jpeg" },
-        { "webp", "image/webp" },
-        { "gif",  "image/gif" },
-        { "bmp",  "image/bmp" }
-    };
+    while (false == extension.empty() && '.' == extension.front()) {
+        extension.remove_prefix(1);
+    }
+
+    auto it = std::lower_bound(std::begin(mime_extensions), std::end(mime_extensions), extension,
+        [](MimeExtension const& entry, std::string_view const& value) {
+            return entry.extension < value;
+        }
+    );
 
-    auto it = table.find(trim_left(extension, "."));
-    return table.end() != it ? it->second : default_mime_type;
+    return std::end(mime_extensions) != it && extension == it->extension ? it->mime_type : default_mime_type;
 }
 
-std::string file::get_mime_type_from_file(std::string const& pathname, std::string const& default_mime_type)
+std::string_view file::get_mime_type(void const* data, std::size_t size, std::string_view default_mime_type) noexcept
 {
-    std::filesystem::path path(pathname);
+    if (0 == size) {
+        return default_mime_type;
+    }
+
+    std::string_view const header(static_cast<char const*>(data), std::min(size, mime_header_size));
+    std::uint8_t const first = static_cast<std::uint8_t>(header.front());
 
-    if (false == std::filesystem::exists(path)) {
-        throw std::runtime_error("File not found");
+    // Only the signatures starting with the first byte are candidates.
+    for (std::size_t i = mime_jump_table[first]; i < mime_jump_table[first + 1]; ++i) {
+        if (true == mime_signatures[i].matches(header)) {
+            return mime_signatures[i].mime_type;
+        }
     }
 
-    if (std::filesystem::file_type::regular != std::filesystem::status(path).type()) {
-        throw std::runtime_error("File not a regular file");
+    for (MimeSignature const& signature : mime_offset_signatures) {
+        if (true == signature.matches(header)) {
+            return signature.mime_type;
+        }
     }
 
-    std::size_t size = std::filesystem::file_size(path);
-    std::array<char, 8> header;
-    std::ifstream file(pathname, std::ios::binary);
-    file.read(header.data(), 8);
+    return default_mime_type;
+}
+
+std::string_view file::get_mime_type(Source& source, std::string_view default_mime_type) noexcept
+{
+    std::size_t const size = source.available();
+    return get_mime_type(source.peek(size), size, default_mime_type);
+}
 
-    if (file.gcount() < 8) {
-        return get_mime_type_from_extension(path.extension(), default_mime_type);
+Result<std::string_view> file::get_mime_type_from_file(std::string const& pathname, std::string_view default_mime_type, std::nothrow_t) noexcept
+{
+    struct stat status;
+    if (-1 == stat(pathname.c_str(), &status)) {
+        return make_error(errno, "stat() failed");
+    }
+    if (false == S_ISREG(status.st_mode)) {
+        return make_error(EINVAL, "File not a regular file");
     }
 
-    auto matches = [&](char const* signature, std::size_t length) {
-        return !memcmp(header.data(), signature, length);
+    MimeCacheKey const key{ status.st_dev, status.st_ino };
+    MimeCacheEntry entry{
+        static_cast<std::int64_t>(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec,
+        static_cast<std::size_t>(status.st_size),
+        std::string_view()
     };
 
-    /* Look at data to make an educated guess. */
-    if (true == matches("\x89\x50\x4E\x47\x0D\x0A\x1A\x0A", 8)) {
-        return "image/png";
-    }
-    if (true == matches("RIFF", 4) || true == matches("WEBP", 4)) {
-        return "image/webp";
+    auto extension = [&] {
+        std::string_view const name(pathname);
+        std::size_t const dot = name.find_last_of("./");
+        return std::string_view::npos != dot && '.' == name[dot] ? name.substr(dot) : std::string_view();
+    };
+
+    MimeCache& cache = mime_cache();
+    {
+        HLIB_LOCK_GUARD(lock, cache.mutex);
+
+        auto it = cache.entries.find(key);
+        if (cache.entries.end() != it && entry.mtime == it->second.mtime && entry.size == it->second.size) {
+            return false == it->second.mime_type.empty()
+                ? it->second.mime_type : get_mime_type_from_extension(extension(), default_mime_type);
+        }
     }
-    if (true == matches("\xFF\xD8\xFF", 3)) {
-        return "image/jpeg";
+
+    Handle<int, -1> fd(open(pathname.c_str(), O_RDONLY | O_CLOEXEC), fd_close);
+    if (-1 == fd.get()) {
+        return make_error(errno, "open() failed");
     }
-    if (true == matches("GIF87a", 6) || true == matches("GIF89a", 6)) {
-        return "image/gif";
+
+    std::array<char, mime_header_size> header;
+    Result<std::size_t> size = pread_all(fd.get(), header.data(), header.size(), 0);
+    if (true == size.failure()) {
+        return size.error();
     }
-    if (true == matches("BM", 2)) {
-        return "image/bmp";
+
+    entry.mime_type = get_mime_type(header.data(), size.value(), std::string_view());
+
+    try {
+        HLIB_LOCK_GUARD(lock, cache.mutex);
+
+        if (cache.entries.size() >= mime_cache_capacity) {
+            cache.entries.clear();
+        }
+        cache.entries[key] = entry;
     }
-    if (size >= 8 && 0 == memcmp(header.data() + 4, "\x66\x74\x79\x70", 4)) {
-        return "video/mp4";
+    catch (std::bad_alloc const&) {
+        // Not caching is harmless.
     }
 
-    return get_mime_type_from_extension(path.extension(), default_mime_type);
+    return false == entry.mime_type.empty()
+        ? entry.mime_type : get_mime_type_from_extension(extension(), default_mime_type);
+}
+
+std::string_view file::get_mime_type_from_file(std::string const& pathname, std::string_view default_mime_type)
+{
+    return success_or_throw(get_mime_type_from_file(pathname, default_mime_type, std::nothrow));
 }
 
 Result<> file::fd_set_non_blocking(int fd, bool enable, std::nothrow_t) noexcept
 {
     int flags = fcntl(fd, F_GETFL, 0);
     if (-1 == flags) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     if (true == enable) {
@@ -590,7 +1069,7 @@ Result<> file::fd_set_non_blocking(int fd, bool enable, std::nothrow_t) noexcept
     }
 
     if (-1 == fcntl(fd, F_SETFL, flags)) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return {};
@@ -655,7 +1134,7 @@ Result<> file::File::open(std::string const& filepath, std::string const& mode,
 
     m_handle.reset(fopen(filepath.c_str(), mode.c_str()));
     if (nullptr == m_handle.get()) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     return {};
@@ -730,7 +1209,7 @@ Result<> file::Pipe::open(std::nothrow_t) noexcept
     close();
 
     if (-1 == ::pipe(fds.data())) {
-        return make_system_error(errno);
+        return make_error(errno);
     }
 
     m_fds[0].reset(fds[0]);
@@ -749,3 +1228,641 @@ void file::Pipe::close() noexcept
     m_fds[0].reset();
 }
 
+
+//
+// Public (MappedFile)
+//
+file::MappedFile::MappedFile(std::string const& filepath, std::uint32_t advice, std::error_code& error_code) noexcept
+{
+    Result<> result = open(filepath, advice, std::nothrow);
+    if (true == result.failure()) {
+        error_code = result.error().code();
+    }
+}
+
+file::MappedFile::MappedFile(std::string const& filepath, std::uint32_t advice)
+{
+    open(filepath, advice);
+}
+
+file::MappedFile::MappedFile(MappedFile&& that) noexcept
+    : m_data(that.m_data)
+    , m_size(that.m_size)
+{
+    that.m_data = nullptr;
+    that.m_size = 0;
+}
+
+file::MappedFile::~MappedFile()
+{
+    close();
+}
+
+file::MappedFile& file::MappedFile::operator =(MappedFile&& that) noexcept
+{
+    close();
+
+    std::swap(m_data, that.m_data);
+    std::swap(m_size, that.m_size);
+    return *this;
+}
+
+void const* file::MappedFile::data() const noexcept
+{
+    return m_data;
+}
+
+std::size_t file::MappedFile::size() const noexcept
+{
+    return m_size;
+}
+
+bool file::MappedFile::empty() const noexcept
+{
+    return 0 == m_size;
+}
+
+std::byte const* file::MappedFile::begin() const noexcept
+{
+    return static_cast<std::byte const*>(m_data);
+}
+
+std::byte const* file::MappedFile::end() const noexcept
+{
+    return static_cast<std::byte const*>(m_data) + m_size;
+}
+
+std::string_view file::MappedFile::view() const noexcept
+{
+    return std::string_view(static_cast<char const*>(m_data), m_size);
+}
+
+std::string_view file::MappedFile::view(std::size_t offset, std::size_t size) const noexcept
+{
+    assert(offset <= m_size);
+    return view().substr(offset, size);
+}
+
+std::string_view file::MappedFile::extract(std::size_t& offset, std::string_view const& sentinel, bool include_sentinel) const noexcept
+{
+    assert(offset <= m_size);
+
+    std::string_view const data = view();
+    std::size_t position = data.find(sentinel, offset);
+    if (std::string_view::npos == position) {
+        return std::string_view();
+    }
+
+    std::string_view result = data.substr(offset, position - offset + (true == include_sentinel ? sentinel.size() : 0));
+    offset = position + sentinel.size();
+    return result;
+}
+
+Result<> file::MappedFile::open(std::string const& filepath, std::uint32_t advice, std::nothrow_t) noexcept
+{
+    Handle<int, -1> fd(::open(filepath.c_str(), O_RDONLY | O_CLOEXEC), fd_close);
+    if (-1 == fd.get()) {
+        return make_error(errno, "open() failed");
+    }
+
+    return open(fd.get(), advice, std::nothrow);
+}
+
+void file::MappedFile::open(std::string const& filepath, std::uint32_t advice)
+{
+    success_or_throw(open(filepath, advice, std::nothrow));
+}
+
+Result<> file::MappedFile::open(int fd, std::uint32_t advice, std::nothrow_t) noexcept
+{
+    close();
+
+    struct stat status;
+    if (-1 == fstat(fd, &status)) {
+        return make_error(errno, "fstat() failed");
+    }
+
+    // Empty files cannot be mapped.
+    if (0 == status.st_size) {
+        return {};
+    }
+
+    void* data = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED == data) {
+        return make_error(errno, "mmap() failed");
+    }
+
+    m_data = data;
+    m_size = static_cast<std::size_t>(status.st_size);
+
+    // Hints are optional, e.g. MADV_HUGEPAGE fails for file systems without
+    // huge page support.
+    (void)advise(0, m_size, advice, std::nothrow);
+    return {};
+}
+
+void file::MappedFile::open(int fd, std::uint32_t advice)
+{
+    success_or_throw(open(fd, advice, std::nothrow));
+}
+
+void file::MappedFile::close() noexcept
+{
+    if (nullptr == m_data) {
+        return;
+    }
+
+    HVERIFY(0 == munmap(m_data, m_size));
+    m_data = nullptr;
+    m_size = 0;
+}
+
+Result<> file::MappedFile::advise(std::size_t offset, std::size_t size, std::uint32_t advice, std::nothrow_t) noexcept
+{
+    assert(offset <= m_size);
+
+    if (nullptr == m_data) {
+        return {};
+    }
+
+    // madvise() requires a page aligned address.
+    static std::size_t const page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+
+    std::size_t const aligned = offset & ~(page_size - 1);
+    size = std::min(size, m_size - offset) + (offset - aligned);
+
+    std::uint8_t* address = static_cast<std::uint8_t*>(m_data) + aligned;
+    int error = 0;
+
+    auto apply = [&](std::uint32_t flag, int madvice) {
+        if (0 != (flag & advice) && -1 == madvise(address, size, madvice) && 0 == error) {
+            error = errno;
+        }
+    };
+
+    // Normal has no flag of its own, it resets earlier access pattern hints.
+    if (Normal == advice && -1 == madvise(address, size, MADV_NORMAL)) {
+        error = errno;
+    }
+
+    apply(Sequential, MADV_SEQUENTIAL);
+    apply(Random, MADV_RANDOM);
+    apply(WillNeed, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+    apply(HugePage, MADV_HUGEPAGE);
+#endif
+
+    if (0 != error) {
+        return make_error(error, "madvise() failed");
+    }
+
+    return {};
+}
+
+void file::MappedFile::advise(std::size_t offset, std::size_t size, std::uint32_t advice)
+{
+    success_or_throw(advise(offset, size, advice, std::nothrow));
+}
+
+std::shared_ptr<SourceAdapter<file::MappedFile>> file::make_shared_source_mapped_file(std::string const& filepath, std::uint32_t advice)
+{
+    return make_shared_source(MappedFile(filepath, advice));
+}
+
+//
+// Implementation (FileWriter)
+//
+Result<> file::FileWriter::errorLocked() const noexcept
+{
+    if (0 != m_error) {
+        return make_error(m_error, "FileWriter failed");
+    }
+    if (-1 == m_fd.get()) {
+        return make_error(EBADF, "FileWriter not open");
+    }
+
+    return {};
+}
+
+void file::FileWriter::writeLocked(std::unique_lock<std::mutex>& lock, bool aligned, bool sync)
+{
+    // The caller has claimed writing.
+    assert(true == m_writing);
+
+    std::size_t length = m_appended - m_taken;
+    std::size_t const offset = m_written;
+    std::size_t const commits = m_commits;
+    std::deque<Buffer> chunks;
+
+    chunks.swap(m_chunks);
+    m_commits = 0;
+
+    // Hold back the remainder past the last block boundary for the next
+    // batch, as the file may start out at an unaligned size.
+    std::size_t remainder = true == aligned ? std::min(length, (offset + length) % m_options.alignment) : 0;
+    if (remainder > 0) {
+        Buffer tail(std::max(remainder, m_options.chunk_size));
+        tail.resize(remainder);
+
+        std::uint8_t* end = static_cast<std::uint8_t*>(tail.data()) + remainder;
+        while (remainder > 0) {
+            Buffer& chunk = chunks.back();
+            std::size_t size = std::min(remainder, chunk.size());
+
+            end -= size;
+            memcpy(end, static_cast<std::uint8_t const*>(chunk.data()) + chunk.size() - size, size);
+            chunk.resize(chunk.size() - size);
+            if (true == chunk.empty()) {
+                chunks.pop_back();
+            }
+
+            length -= size;
+            remainder -= size;
+        }
+
+        m_chunks.push_front(std::move(tail));
+    }
+
+    m_taken += length;
+
+    if (0 == length && (false == sync || m_synced == m_written)) {
+        m_writing = false;
+        m_condition.notify_all();
+        return;
+    }
+
+    lock.unlock();
+
+    time::Clock const start = time::now();
+
+    int error = pwrite_chunks(m_fd.get(), chunks, offset);
+    time::Clock const written = time::now();
+
+    if (0 == error && true == sync && -1 == fdatasync(m_fd.get())) {
+        error = errno;
+    }
+    time::Clock const synced = time::now();
+
+    chunks.clear();
+
+    lock.lock();
+
+    m_writing = false;
+
+    Batch const batch{ length, commits, written - start, synced - written };
+
+    if (0 != error) {
+        m_error = error;
+    }
+    else {
+        m_written += length;
+        if (true == sync) {
+            m_synced = m_written;
+        }
+
+        m_metrics.batches += 1;
+        m_metrics.bytes += length;
+        m_metrics.syncs += true == sync ? 1 : 0;
+        m_metrics.commits += commits;
+        m_metrics.write_latency += batch.write_latency;
+        m_metrics.sync_latency += batch.sync_latency;
+        m_metrics.max_batch_latency = std::max(m_metrics.max_batch_latency, synced - start);
+        m_metrics.max_batch_size = std::max(m_metrics.max_batch_size, length);
+    }
+
+    m_condition.notify_all();
+
+    if (0 == error && nullptr != m_on_batch) {
+        OnBatch callback = m_on_batch;
+
+        lock.unlock();
+        callback(batch);
+        lock.lock();
+    }
+}
+
+void file::FileWriter::run()
+{
+    HLIB_UNIQUE_LOCK(lock, m_mutex);
+
+    auto full = [this] {
+        return m_appended - m_taken >= m_options.batch_size;
+    };
+
+    while (true) {
+        m_condition.wait(lock, [&] {
+            return true == m_stop || true == full() || m_commit_target > m_synced;
+        });
+
+        if (0 != m_error) {
+            if (true == m_stop) {
+                break;
+            }
+            m_condition.wait(lock, [this] { return m_stop; });
+            break;
+        }
+
+        bool const sync = true == m_stop || m_commit_target > m_synced;
+
+        // Give other committers the latency budget to join.
+        if (false == m_stop && true == sync && false == full()) {
+            m_condition.wait_for(lock, to_chrono(m_options.commit_latency), [&] {
+                return true == m_stop || true == full();
+            });
+        }
+
+        m_writing = true;
+        writeLocked(lock, false == sync, sync);
+
+        if (true == m_stop && m_appended == m_taken) {
+            break;
+        }
+    }
+}
+
+//
+// Public (FileWriter)
+//
+file::FileWriter::FileWriter() noexcept
+    : m_fd(fd_close)
+{
+}
+
+file::FileWriter::FileWriter(std::string const& filepath, FileWriterOptions const& options)
+    : FileWriter()
+{
+    open(filepath, options);
+}
+
+file::FileWriter::~FileWriter()
+{
+    (void)close(std::nothrow);
+}
+
+std::size_t file::FileWriter::size() const noexcept
+{
+    HLIB_LOCK_GUARD(lock, m_mutex);
+    return m_appended;
+}
+
+file::FileWriter::Metrics file::FileWriter::metrics() const noexcept
+{
+    HLIB_LOCK_GUARD(lock, m_mutex);
+    return m_metrics;
+}
+
+void file::FileWriter::setBatchCallback(OnBatch callback) noexcept
+{
+    HLIB_LOCK_GUARD(lock, m_mutex);
+    m_on_batch = std::move(callback);
+}
+
+Result<> file::FileWriter::open(std::string const& filepath, FileWriterOptions const& options, std::nothrow_t) noexcept
+{
+    Result<> result = close(std::nothrow);
+    if (true == result.failure()) {
+        return result;
+    }
+
+    Handle<int, -1> fd(::open(filepath.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644), fd_close);
+    if (-1 == fd.get()) {
+        return make_error(errno, "open() failed");
+    }
+
+    struct stat status;
+    if (-1 == fstat(fd.get(), &status)) {
+        return make_error(errno, "fstat() failed");
+    }
+
+    HLIB_UNIQUE_LOCK(lock, m_mutex);
+
+    m_options = options;
+    m_options.alignment = std::max<std::size_t>(m_options.alignment, 1);
+
+    // A batch holds at least one aligned block, otherwise an aligned write
+    // holds everything back and a full batch never drains.
+    m_options.batch_size = std::max(m_options.batch_size, m_options.alignment);
+    m_options.chunk_size = std::max<std::size_t>(m_options.chunk_size, 1);
+
+    m_fd = std::move(fd);
+    m_stop = false;
+    m_error = 0;
+
+    // Append to the existing content.
+    m_appended = static_cast<std::size_t>(status.st_size);
+    m_taken = m_appended;
+    m_written = m_appended;
+    m_synced = m_appended;
+    m_commit_target = m_appended;
+    m_commits = 0;
+    m_metrics = Metrics();
+
+    if (true == m_options.io_thread) {
+        try {
+            m_thread = std::thread(&FileWriter::run, this);
+        }
+        catch (std::system_error const& e) {
+            m_fd.reset();
+            return e;
+        }
+    }
+
+    return {};
+}
+
+void file::FileWriter::open(std::string const& filepath, FileWriterOptions const& options)
+{
+    success_or_throw(open(filepath, options, std::nothrow));
+}
+
+Result<> file::FileWriter::append(void const* data, std::size_t size, std::nothrow_t) noexcept
+{
+    HLIB_UNIQUE_LOCK(lock, m_mutex);
+
+    Result<> result = errorLocked();
+    if (true == result.failure()) {
+        return result;
+    }
+
+    std::uint8_t const* bytes = static_cast<std::uint8_t const*>(data);
+
+    try {
+        while (size > 0) {
+            if (true == m_chunks.empty() || m_chunks.back().size() == m_chunks.back().capacity()) {
+                m_chunks.emplace_back(m_options.chunk_size);
+            }
+
+            Buffer& chunk = m_chunks.back();
+            std::size_t count = std::min(size, chunk.capacity() - chunk.size());
+
+            HVERIFY(true == chunk.append(bytes, count, std::nothrow));
+            m_appended += count;
+            bytes += count;
+            size -= count;
+        }
+    }
+    catch (std::bad_alloc const&) {
+        return make_error(ENOMEM);
+    }
+
+    if (m_appended - m_taken < m_options.batch_size) {
+        return {};
+    }
+
+    if (true == m_options.io_thread) {
+        m_condition.notify_all();
+    }
+    else if (false == m_writing) {
+        m_writing = true;
+        writeLocked(lock, true, false);
+    }
+    else {
+        // Wake a committer waiting for others to join.
+        m_condition.notify_all();
+    }
+
+    return errorLocked();
+}
+
+void file::FileWriter::append(void const* data, std::size_t size)
+{
+    success_or_throw(append(data, size, std::nothrow));
+}
+
+Result<> file::FileWriter::append(Buffer&& buffer, std::nothrow_t) noexcept
+{
+    if (true == buffer.empty()) {
+        return {};
+    }
+
+    HLIB_UNIQUE_LOCK(lock, m_mutex);
+
+    Result<> result = errorLocked();
+    if (true == result.failure()) {
+        return result;
+    }
+
+    // Write the buffer as is, without copying.
+    std::size_t const size = buffer.size();
+    try {
+        m_chunks.emplace_back(std::move(buffer));
+    }
+    catch (std::bad_alloc const&) {
+        return make_error(ENOMEM);
+    }
+    m_appended += size;
+
+    if (m_appended - m_taken >= m_options.batch_size) {
+        if (true == m_options.io_thread) {
+            m_condition.notify_all();
+        }
+        else if (false == m_writing) {
+            m_writing = true;
+            writeLocked(lock, true, false);
+        }
+    }
+
+    return errorLocked();
+}
+
+void file::FileWriter::append(Buffer&& buffer)
+{
+    success_or_throw(append(std::move(buffer), std::nothrow));
+}
+
+Result<> file::FileWriter::flush(std::nothrow_t) noexcept
+{
+    HLIB_UNIQUE_LOCK(lock, m_mutex);
+
+    std::size_t const target = m_appended;
+
+    while (0 == m_error && -1 != m_fd.get() && m_written < target) {
+        if (true == m_writing) {
+            m_condition.wait(lock);
+            continue;
+        }
+
+        m_writing = true;
+        writeLocked(lock, false, false);
+    }
+
+    return errorLocked();
+}
+
+void file::FileWriter::flush()
+{
+    success_or_throw(flush(std::nothrow));
+}
+
+Result<> file::FileWriter::commit(std::nothrow_t) noexcept
+{
+    HLIB_UNIQUE_LOCK(lock, m_mutex);
+
+    std::size_t const target = m_appended;
+    m_commits += 1;
+
+    if (true == m_options.io_thread) {
+        m_commit_target = std::max(m_commit_target, target);
+        m_condition.notify_all();
+        m_condition.wait(lock, [&] {
+            return m_synced >= target || 0 != m_error || -1 == m_fd.get();
+        });
+        return errorLocked();
+    }
+
+    while (0 == m_error && -1 != m_fd.get() && m_synced < target) {
+        if (true == m_writing) {
+            m_condition.wait(lock);
+            continue;
+        }
+
+        // Lead the group commit, give other committers the latency budget
+        // to join.
+        m_writing = true;
+        m_condition.wait_for(lock, to_chrono(m_options.commit_latency), [this] {
+            return m_appended - m_taken >= m_options.batch_size;
+        });
+
+        writeLocked(lock, false, true);
+    }
+
+    return errorLocked();
+}
+
+void file::FileWriter::commit()
+{
+    success_or_throw(commit(std::nothrow));
+}
+
+Result<> file::FileWriter::close(std::nothrow_t) noexcept
+{
+    Result<> result;
+
+    if (true == m_thread.joinable()) {
+        {
+            HLIB_LOCK_GUARD(lock, m_mutex);
+            m_stop = true;
+        }
+        m_condition.notify_all();
+        m_thread.join();
+    }
+    else if (-1 != m_fd.get()) {
+        result = commit(std::nothrow);
+    }
+
+    HLIB_LOCK_GUARD(lock, m_mutex);
+
+    if (true == result.success() && 0 != m_error) {
+        result = make_error(m_error, "FileWriter failed");
+    }
+
+    m_fd.reset();
+    m_chunks.clear();
+    m_condition.notify_all();
+    return result;
+}
+
+void file::FileWriter::close()
+{
+    success_or_throw(close(std::nothrow));
+}
@@ -21,70 +21,307 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 //
-#include "hlib_format.hpp"
-#include <cstdio>
-#include <stdarg.h>
+#include "hlib/format.hpp"
+#include "hlib/buffer.hpp"
+#include "hlib/sink.hpp"
+#include <charconv>
 
-#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+using namespace hlib;
 
 //
-// Public
+// Implementation
 //
-std::string hlib::format(char const* format_string, ...) noexcept
+namespace
+{
+
+class StringOutput final : public FormatOutput
+{
+public:
+    explicit StringOutput(std::string& string) noexcept
+        : m_string{ string }
+    {
+    }
+
+    bool write(char const* data, std::size_t size) noexcept override
+    {
+        try {
+            m_string.append(data, size);
+            return true;
+        }
+        catch (...) {
+            return false;
+        }
+    }
+
+private:
+    std::string& m_string;
+};
+
+class BufferOutput final : public FormatOutput
 {
-    va_list ap;
+public:
+    explicit BufferOutput(Buffer& buffer) noexcept
+        : m_buffer{ buffer }
+    {
+    }
+
+    bool write(char const* data, std::size_t size) noexcept override
+    {
+        return m_buffer.append(data, size, std::nothrow);
+    }
+
+private:
+    Buffer& m_buffer;
+};
+
+class SinkOutput final : public FormatOutput
+{
+public:
+    explicit SinkOutput(Sink& sink) noexcept
+        : m_sink{ sink }
+    {
+    }
+
+    bool write(char const* data, std::size_t size) noexcept override
+    {
+        // Write what fits, a full sink truncates the output.
+        std::size_t const length = std::min(size, m_sink.headroom(size));
+        if (length > 0) {
+            void* ptr = m_sink.produce(length);
+            if (nullptr == ptr) {
+                return false;
+            }
+            std::char_traits<char>::copy(static_cast<char*>(ptr), data, length);
+        }
 
-    va_start(ap, format_string);
-    int formatted_length = vsnprintf(nullptr, 0, format_string, ap);
-    va_end(ap);
+        return length == size;
+    }
+
+private:
+    Sink& m_sink;
+};
 
-    if (formatted_length < 0) {
-        return std::string();
+bool write_fill(FormatOutput& output, char fill, std::size_t count) noexcept
+{
+    char fills[16];
+    std::char_traits<char>::assign(fills, sizeof(fills), fill);
+
+    while (count > 0) {
+        std::size_t const size = std::min(count, sizeof(fills));
+        if (false == output.write(fills, size)) {
+            return false;
+        }
+        count -= size;
     }
 
-    std::string string;
+    return true;
+}
 
-    try {
-        string.resize(formatted_length + 1);
+bool write_padded(FormatOutput& output, FormatSpec const& spec, char const* data, std::size_t size, bool numeric) noexcept
+{
+    if (spec.width <= size) {
+        return output.write(data, size);
     }
-    catch (...) {
-        return std::string();
+
+    std::size_t const padding = spec.width - size;
+    char const align = 0 != spec.align ? spec.align : (true == numeric ? '>' : '<');
+
+    if ('<' == align) {
+        return output.write(data, size) && write_fill(output, ' ', padding);
     }
 
-    va_start(ap, format_string);
-    HVERIFY(vsnprintf(string.data(), formatted_length + 1, format_string, ap) >= 0);
-    va_end(ap);
+    // Zero padding goes between the sign and the digits.
+    if ('0' == spec.fill && true == numeric && size > 0 && '-' == data[0]) {
+        return output.write(data, 1)
+            && write_fill(output, '0', padding)
+            && output.write(data + 1, size - 1);
+    }
 
-    string.pop_back();
-    return string;
+    return write_fill(output, spec.fill, padding) && output.write(data, size);
 }
 
-bool hlib::format_to(std::string& string, char const* format_string, ...) noexcept
+bool write_integer(FormatOutput& output, FormatSpec const& spec, FormatArgument const& argument) noexcept
 {
-    va_list ap;
+    char buffer[66];
+    int base = 10;
+
+    switch (spec.type) {
+    case 'x':
+    case 'X':
+        base = 16;
+        break;
+    case 'o':
+        base = 8;
+        break;
+    case 'b':
+        base = 2;
+        break;
+    default:
+        break;
+    }
 
-    va_start(ap, format_string);
-    int formatted_length = vsnprintf(nullptr, 0, format_string, ap);
-    va_end(ap);
+    std::to_chars_result r = FormatArgument::Signed == argument.type()
+        ? std::to_chars(buffer, buffer + sizeof(buffer), argument.getSigned(), base)
+        : std::to_chars(buffer, buffer + sizeof(buffer), argument.getUnsigned(), base);
+    HASSERT(std::errc() == r.ec);
 
-    if (formatted_length < 0) {
-        return false;
+    if ('X' == spec.type) {
+        for (char* pos = buffer; pos != r.ptr; ++pos) {
+            if (*pos >= 'a' && *pos <= 'f') {
+                *pos = static_cast<char>(*pos - 'a' + 'A');
+            }
+        }
     }
 
-    std::size_t const string_length = string.length();
+    return write_padded(output, spec, buffer, static_cast<std::size_t>(r.ptr - buffer), true);
+}
+
+bool write_float(FormatOutput& output, FormatSpec const& spec, double value) noexcept
+{
+    // Large enough for any double in fixed notation with the precision limited to 100.
+    char buffer[512];
+    int const precision = std::min(spec.precision, 100);
+
+    std::to_chars_result r;
 
-    try {
-        string.resize(string_length + formatted_length + 1);
+    switch (spec.type) {
+    case 'e':
+        r = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::scientific, precision < 0 ? 6 : precision);
+        break;
+    case 'g':
+        r = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, precision < 0 ? 6 : precision);
+        break;
+    case 'f':
+        r = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, precision < 0 ? 6 : precision);
+        break;
+    default:
+        r = precision < 0
+            ? std::to_chars(buffer, buffer + sizeof(buffer), value)
+            : std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, precision);
+        break;
     }
-    catch (...) {
+
+    if (std::errc() != r.ec) {
         return false;
     }
 
-    va_start(ap, format_string);
-    HVERIFY(vsnprintf(string.data() + string_length, formatted_length + 1, format_string, ap) >= 0);
-    va_end(ap);
+    return write_padded(output, spec, buffer, static_cast<std::size_t>(r.ptr - buffer), true);
+}
 
-    string.pop_back();
-    return true;
+bool write_argument(FormatOutput& output, FormatSpec const& spec, FormatArgument const& argument) noexcept
+{
+    switch (argument.type()) {
+    case FormatArgument::Bool:
+        if (0 != spec.type && 's' != spec.type) {
+            return write_integer(output, spec, argument);
+        }
+        return 0 != argument.getUnsigned()
+            ? write_padded(output, spec, "true", 4, false)
+            : write_padded(output, spec, "false", 5, false);
+
+    case FormatArgument::Char:
+        if (0 != spec.type && 'c' != spec.type) {
+            return write_integer(output, spec, argument);
+        }
+        else {
+            char const c = static_cast<char>(argument.getUnsigned());
+            return write_padded(output, spec, &c, 1, false);
+        }
+
+    case FormatArgument::Signed:
+    case FormatArgument::Unsigned:
+        if ('c' == spec.type) {
+            char const c = static_cast<char>(argument.getUnsigned());
+            return write_padded(output, spec, &c, 1, false);
+        }
+        if ('f' == spec.type || 'e' == spec.type || 'g' == spec.type) {
+            double const value = FormatArgument::Signed == argument.type()
+                ? static_cast<double>(argument.getSigned())
+                : static_cast<double>(argument.getUnsigned());
+            return write_float(output, spec, value);
+        }
+        return write_integer(output, spec, argument);
+
+    case FormatArgument::Float:
+        return write_float(output, spec, argument.getFloat());
+
+    case FormatArgument::String:
+        {
+            std::string_view string = argument.getString();
+            if (spec.precision >= 0) {
+                string = string.substr(0, static_cast<std::size_t>(spec.precision));
+            }
+            return write_padded(output, spec, string.data(), string.size(), false);
+        }
+
+    default:
+        assert(false);
+        return false;
+    }
+}
+
+} // namespace
+
+//
+// Public
+//
+bool hlib::vformat_to(FormatOutput& output, std::string_view format_string, FormatArgument const* arguments, std::size_t count) noexcept
+{
+    std::size_t index = 0;
+    std::size_t pos = 0;
+
+    while (pos < format_string.size()) {
+        std::size_t const brace = format_string.find_first_of("{}", pos);
+        std::size_t const end = std::string_view::npos != brace ? brace : format_string.size();
+
+        if (end > pos && false == output.write(format_string.data() + pos, end - pos)) {
+            return false;
+        }
+        if (std::string_view::npos == brace) {
+            break;
+        }
+
+        // Escaped brace.
+        if (brace + 1 < format_string.size() && format_string[brace] == format_string[brace + 1]) {
+            if (false == output.write(format_string.data() + brace, 1)) {
+                return false;
+            }
+            pos = brace + 2;
+            continue;
+        }
+
+        if ('}' == format_string[brace] || index >= count) {
+            return false;
+        }
+
+        FormatSpec spec;
+        pos = format_parse_spec(format_string, brace, spec);
+        if (std::string_view::npos == pos) {
+            return false;
+        }
+
+        if (false == write_argument(output, spec, arguments[index++])) {
+            return false;
+        }
+    }
+
+    return index == count;
 }
 
+bool hlib::vformat_to(std::string& string, std::string_view format_string, FormatArgument const* arguments, std::size_t count) noexcept
+{
+    StringOutput output(string);
+    return vformat_to(output, format_string, arguments, count);
+}
+
+bool hlib::vformat_to(Buffer& buffer, std::string_view format_string, FormatArgument const* arguments, std::size_t count) noexcept
+{
+    BufferOutput output(buffer);
+    return vformat_to(output, format_string, arguments, count);
+}
+
+bool hlib::vformat_to(Sink& sink, std::string_view format_string, FormatArgument const* arguments, std::size_t count) noexcept
+{
+    SinkOutput output(sink);
+    return vformat_to(output, format_string, arguments, count);
+}
@@ -0,0 +1,919 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "hlib/resolver.hpp"
+#include "hlib/error.hpp"
+#include "hlib/file.hpp"
+#include "hlib/socket.hpp"
+#include "hlib/string.hpp"
+#include "hlib/utility.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace hlib;
+
+namespace
+{
+
+constexpr std::uint16_t dns_port = 53;
+constexpr std::uint16_t type_a = 1;
+constexpr std::uint16_t type_aaaa = 28;
+constexpr std::uint16_t class_in = 1;
+
+constexpr std::size_t header_size = 12;
+constexpr std::size_t max_name_size = 253;
+constexpr std::size_t max_label_size = 63;
+constexpr std::size_t max_message_size = 4096;
+
+constexpr std::uint16_t flag_qr = 0x8000;
+constexpr std::uint16_t flag_tc = 0x0200;
+constexpr std::uint16_t flag_rd = 0x0100;
+constexpr std::uint16_t rcode_mask = 0x000f;
+constexpr std::uint16_t rcode_nxdomain = 3;
+
+std::uint16_t get16(std::uint8_t const* data) noexcept
+{
+    return static_cast<std::uint16_t>((data[0] << 8) | data[1]);
+}
+
+std::uint32_t get32(std::uint8_t const* data) noexcept
+{
+    return (std::uint32_t(data[0]) << 24) | (std::uint32_t(data[1]) << 16)
+         | (std::uint32_t(data[2]) << 8) | std::uint32_t(data[3]);
+}
+
+void put16(std::vector<std::uint8_t>& packet, std::uint16_t value)
+{
+    packet.push_back(static_cast<std::uint8_t>(value >> 8));
+    packet.push_back(static_cast<std::uint8_t>(value));
+}
+
+// Lowercases host and strips a trailing dot. Returns false if host is not
+// a valid domain name.
+bool normalize_name(std::string_view host, std::string& name)
+{
+    if (false == host.empty() && '.' == host.back()) {
+        host.remove_suffix(1);
+    }
+    if (true == host.empty() || host.size() > max_name_size) {
+        return false;
+    }
+
+    name.clear();
+    name.reserve(host.size());
+
+    std::size_t label = 0;
+
+    for (char c : host) {
+        if ('.' == c) {
+            if (0 == label) {
+                return false;
+            }
+            label = 0;
+        }
+        else if (++label > max_label_size) {
+            return false;
+        }
+
+        name.push_back(static_cast<char>((c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c));
+    }
+
+    return 0 != label;
+}
+
+std::vector<std::uint8_t> make_query(std::uint16_t id, std::string const& name, std::uint16_t type)
+{
+    std::vector<std::uint8_t> packet;
+    packet.reserve(header_size + name.size() + 6);
+
+    put16(packet, id);
+    put16(packet, flag_rd);
+    put16(packet, 1);
+    put16(packet, 0);
+    put16(packet, 0);
+    put16(packet, 0);
+
+    for (std::string_view label : split_view(name, '.')) {
+        packet.push_back(static_cast<std::uint8_t>(label.size()));
+        packet.insert(packet.end(), label.begin(), label.end());
+    }
+    packet.push_back(0);
+
+    put16(packet, type);
+    put16(packet, class_in);
+
+    return packet;
+}
+
+// Reads the possibly compressed name at offset and advances offset past
+// it. If name is not null, appends the lowercased dotted name to it.
+bool read_name(std::uint8_t const* data, std::size_t size, std::size_t& offset, std::string* name)
+{
+    std::size_t position = offset;
+    bool jumped = false;
+    unsigned jumps = 0;
+
+    while (true) {
+        if (position >= size) {
+            return false;
+        }
+
+        std::uint8_t const length = data[position];
+
+        if (0xc0 == (0xc0 & length)) {
+            if (position + 2 > size || ++jumps > 16) {
+                return false;
+            }
+            if (false == jumped) {
+                offset = position + 2;
+                jumped = true;
+            }
+            position = ((length & 0x3f) << 8) | data[position + 1];
+            continue;
+        }
+        if (0 != (0xc0 & length)) {
+            return false;
+        }
+
+        if (0 == length) {
+            if (false == jumped) {
+                offset = position + 1;
+            }
+            return true;
+        }
+
+        if (position + 1 + length > size) {
+            return false;
+        }
+
+        if (nullptr != name) {
+            if (false == name->empty()) {
+                name->push_back('.');
+            }
+            for (std::size_t i = 0; i < length; ++i) {
+                char const c = static_cast<char>(data[position + 1 + i]);
+                name->push_back(static_cast<char>((c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c));
+            }
+        }
+
+        position += 1 + length;
+    }
+}
+
+std::string cache_key(std::string const& name, std::uint16_t type)
+{
+    return (type_a == type ? "4:" : "6:") + name;
+}
+
+void get_default_nameserver(SockAddr& nameserver)
+{
+    std::ifstream stream("/etc/resolv.conf");
+    std::string line;
+
+    while (std::getline(stream, line)) {
+        std::string_view view = trim_view(line);
+        if (0 != view.compare(0, 10, "nameserver")) {
+            continue;
+        }
+
+        if (true == nameserver.parse(trim_view(view.substr(10)), SockAddr::IPv4 | SockAddr::IPv6, std::nothrow)) {
+            break;
+        }
+    }
+
+    if (true == nameserver.empty()) {
+        nameserver.parse("127.0.0.1", SockAddr::IPv4);
+    }
+}
+
+// Merges added into the addresses from next on, which are yet to be
+// attempted, alternating between address families. IPv6 goes first unless
+// the last attempted address is IPv6.
+void merge_addresses(std::vector<SockAddr>& ordered, std::size_t next, std::vector<SockAddr> const& added)
+{
+    std::vector<SockAddr> ipv6;
+    std::vector<SockAddr> ipv4;
+
+    for (std::size_t i = next; i < ordered.size(); ++i) {
+        (AF_INET6 == ordered[i].family() ? ipv6 : ipv4).emplace_back(std::move(ordered[i]));
+    }
+    for (SockAddr const& address : added) {
+        (AF_INET6 == address.family() ? ipv6 : ipv4).emplace_back(address);
+    }
+    ordered.erase(ordered.begin() + static_cast<std::ptrdiff_t>(next), ordered.end());
+
+    bool prefer_ipv6 = 0 == next || AF_INET6 != ordered.back().family();
+    std::size_t i6 = 0;
+    std::size_t i4 = 0;
+
+    while (i6 < ipv6.size() || i4 < ipv4.size()) {
+        if ((true == prefer_ipv6 && i6 < ipv6.size()) || i4 == ipv4.size()) {
+            ordered.emplace_back(std::move(ipv6[i6++]));
+        }
+        else {
+            ordered.emplace_back(std::move(ipv4[i4++]));
+        }
+        prefer_ipv6 = AF_INET6 != ordered.back().family();
+    }
+}
+
+} // namespace
+
+//
+// Implementation (Resolver)
+//
+struct Resolver::Request
+{
+    OnResolved callback;
+    std::uint16_t port;
+    unsigned pending{ 0 };
+    int error{ 0 };
+    std::vector<SockAddr> ipv6;
+    std::vector<SockAddr> ipv4;
+
+    void add(std::vector<SockAddr> const& addresses, int result)
+    {
+        for (SockAddr const& address : addresses) {
+            std::vector<SockAddr>& list = AF_INET6 == address.family() ? ipv6 : ipv4;
+            list.emplace_back(address);
+            list.back().setPort(port, std::nothrow);
+        }
+
+        // Report the most specific error if all queries fail.
+        if (0 != result && (0 == error || ENOENT == error)) {
+            error = result;
+        }
+    }
+
+    void complete()
+    {
+        std::vector<SockAddr> addresses(std::move(ipv6));
+        for (SockAddr& address : ipv4) {
+            addresses.emplace_back(std::move(address));
+        }
+
+        if (true == addresses.empty()) {
+            callback(addresses, 0 != error ? error : ENOENT);
+        }
+        else {
+            callback(addresses, 0);
+        }
+    }
+};
+
+struct Resolver::Query
+{
+    std::uint16_t id;
+    std::string name;
+    std::uint16_t type;
+    std::vector<std::uint8_t> packet;
+    Handle<int, -1> fd{ file::fd_close };
+    unsigned transmissions{ 0 };
+    time::TimePoint expires;
+    std::vector<std::shared_ptr<Request>> requests;
+};
+
+struct Resolver::Connection
+{
+    struct Attempt
+    {
+        Handle<int, -1> fd;
+        SockAddr address;
+    };
+
+    int type;
+    OnConnected callback;
+    std::vector<SockAddr> addresses;
+    std::size_t next{ 0 };
+    std::vector<Attempt> attempts;
+    time::TimePoint deadline;
+    unsigned lookups{ 0 };
+    bool started{ false };
+    int error{ 0 };
+};
+
+void Resolver::query(std::string const& name, std::uint16_t type, std::shared_ptr<Request> const& request)
+{
+    ++request->pending;
+
+    // Join an identical query in flight.
+    for (auto& entry : m_queries) {
+        Query& query = *entry.second;
+        if (type == query.type && name == query.name) {
+            query.requests.push_back(request);
+            return;
+        }
+    }
+
+    using namespace std::placeholders;
+
+    // A fresh socket per query randomizes the source port. Connect, so that
+    // only the nameserver's responses are received and ICMP errors are
+    // reported.
+    Handle<int, -1> fd(
+        ::socket(m_options.nameserver.family(), SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0),
+        file::fd_close
+    );
+    if (-1 == fd.get()
+     || -1 == ::connect(fd.get(), static_cast<sockaddr const*>(m_options.nameserver), m_options.nameserver.length())) {
+        request->add({}, errno);
+        if (0 == --request->pending) {
+            request->complete();
+        }
+        return;
+    }
+
+    std::uint16_t id;
+    do {
+        id = static_cast<std::uint16_t>(m_random());
+    }
+    while (m_queries.end() != m_queries.find(id));
+
+    auto query = std::make_shared<Query>();
+    query->id = id;
+    query->name = name;
+    query->type = type;
+    query->packet = make_query(id, name, type);
+    query->requests.push_back(request);
+    query->transmissions = 1;
+    query->expires = time::now_ns() + m_options.timeout;
+
+    bool const added = with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        loop.add(fd.get(), EventLoop::Read, std::bind(&Resolver::onReceive, this, id, _1));
+    });
+    if (false == added) {
+        request->add({}, ENODEV);
+        if (0 == --request->pending) {
+            request->complete();
+        }
+        return;
+    }
+
+    query->fd = std::move(fd);
+    m_queries.emplace(id, query);
+
+    // A lost datagram is retransmitted on timeout.
+    (void)::send(query->fd.get(), query->packet.data(), query->packet.size(), MSG_NOSIGNAL);
+
+    updateTimer();
+}
+
+void Resolver::deliver(Query& query, std::vector<SockAddr> const& addresses, int error)
+{
+    m_queries.erase(query.id);
+    updateTimer();
+
+    with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        loop.remove(query.fd.get());
+    });
+    query.fd.reset();
+
+    for (std::shared_ptr<Request> const& request : query.requests) {
+        request->add(addresses, error);
+        if (0 == --request->pending) {
+            request->complete();
+        }
+    }
+}
+
+void Resolver::updateTimer() noexcept
+{
+    time::TimePoint deadline;
+
+    for (auto const& entry : m_queries) {
+        if (!deadline || entry.second->expires < deadline) {
+            deadline = entry.second->expires;
+        }
+    }
+    for (auto const& entry : m_connections) {
+        time::TimePoint const& next = entry.second->deadline;
+        if (!!next && (!deadline || next < deadline)) {
+            deadline = next;
+        }
+    }
+
+    if (!deadline) {
+        m_timer.clear();
+        return;
+    }
+
+    m_timer.set(std::max(deadline - time::now_ns(), time::DurationNs()));
+}
+
+void Resolver::onReceive(std::uint16_t id, int fd)
+{
+    std::uint8_t data[max_message_size];
+
+    // Stop once a response delivered the query, which closes fd.
+    for (auto it = m_queries.find(id); m_queries.end() != it; it = m_queries.find(id)) {
+        ssize_t const r = ::recv(fd, data, sizeof(data), 0);
+        if (r >= 0) {
+            onResponse(id, data, static_cast<std::size_t>(r));
+            continue;
+        }
+
+        if (EINTR == errno) {
+            continue;
+        }
+        if (EAGAIN == errno || EWOULDBLOCK == errno) {
+            return;
+        }
+
+        // The nameserver is unreachable.
+        std::shared_ptr<Query> query = it->second;
+        deliver(*query, {}, errno);
+        return;
+    }
+}
+
+void Resolver::onResponse(std::uint16_t id, std::uint8_t const* data, std::size_t size)
+{
+    if (size < header_size || id != get16(data)) {
+        return;
+    }
+
+    auto it = m_queries.find(id);
+    if (m_queries.end() == it) {
+        return;
+    }
+
+    // Keep query alive for the duration of the callbacks.
+    std::shared_ptr<Query> query = it->second;
+
+    std::uint16_t const flags = get16(data + 2);
+    std::uint16_t const qdcount = get16(data + 4);
+    std::uint16_t const ancount = get16(data + 6);
+
+    if (0 == (flag_qr & flags) || 1 != qdcount) {
+        return;
+    }
+
+    // Only accept a response that echoes the question.
+    std::size_t offset = header_size;
+    std::string name;
+
+    if (false == read_name(data, size, offset, &name) || offset + 4 > size
+     || name != query->name || query->type != get16(data + offset) || class_in != get16(data + offset + 2)) {
+        return;
+    }
+    offset += 4;
+
+    if (0 != (flag_tc & flags)) {
+        deliver(*query, {}, EMSGSIZE);
+        return;
+    }
+
+    switch (flags & rcode_mask) {
+    case 0:
+        break;
+    case rcode_nxdomain:
+        deliver(*query, {}, ENOENT);
+        return;
+    default:
+        deliver(*query, {}, EIO);
+        return;
+    }
+
+    // Collect the records of the queried type, which also includes those
+    // at the end of a CNAME chain.
+    std::vector<SockAddr> addresses;
+    std::uint32_t ttl = UINT32_MAX;
+
+    for (std::uint16_t i = 0; i < ancount; ++i) {
+        if (false == read_name(data, size, offset, nullptr) || offset + 10 > size) {
+            deliver(*query, {}, EIO);
+            return;
+        }
+
+        std::uint16_t const type = get16(data + offset);
+        std::uint16_t const klass = get16(data + offset + 2);
+        std::uint32_t const record_ttl = get32(data + offset + 4);
+        std::uint16_t const length = get16(data + offset + 8);
+        offset += 10;
+
+        if (offset + length > size) {
+            deliver(*query, {}, EIO);
+            return;
+        }
+
+        if (class_in == klass && type == query->type) {
+            if (type_a == type && 4 == length) {
+                sockaddr_in sin{};
+                sin.sin_family = AF_INET;
+                std::memcpy(&sin.sin_addr, data + offset, 4);
+                addresses.emplace_back(sin);
+                ttl = std::min(ttl, record_ttl);
+            }
+            else if (type_aaaa == type && 16 == length) {
+                sockaddr_in6 sin6{};
+                sin6.sin6_family = AF_INET6;
+                std::memcpy(&sin6.sin6_addr, data + offset, 16);
+                addresses.emplace_back(sin6);
+                ttl = std::min(ttl, record_ttl);
+            }
+        }
+
+        offset += length;
+    }
+
+    if (true == addresses.empty()) {
+        deliver(*query, {}, ENOENT);
+        return;
+    }
+
+    // Cache the answer for the shortest TTL of its records.
+    if (0 != ttl && 0 != m_options.cache_size) {
+        time::TimePoint const now = time::now_ns();
+
+        if (m_cache.size() >= m_options.cache_size) {
+            for (auto entry = m_cache.begin(); m_cache.end() != entry;) {
+                entry = entry->second.expires <= now ? m_cache.erase(entry) : std::next(entry);
+            }
+        }
+        if (m_cache.size() >= m_options.cache_size) {
+            m_cache.erase(m_cache.begin());
+        }
+
+        CacheEntry& entry = m_cache[cache_key(query->name, query->type)];
+        entry.addresses = addresses;
+        entry.expires = now + time::DurationNs(std::int64_t(ttl) * 1000000000);
+    }
+
+    deliver(*query, addresses, 0);
+}
+
+void Resolver::onTimeout()
+{
+    time::TimePoint const now = time::now_ns();
+
+    std::vector<std::shared_ptr<Query>> expired;
+    for (auto& entry : m_queries) {
+        if (entry.second->expires <= now) {
+            expired.push_back(entry.second);
+        }
+    }
+
+    for (std::shared_ptr<Query> const& query : expired) {
+        if (query->transmissions < m_options.attempts) {
+            ++query->transmissions;
+            query->expires = now + m_options.timeout;
+            (void)::send(query->fd.get(), query->packet.data(), query->packet.size(), MSG_NOSIGNAL);
+        }
+        else if (m_queries.end() != m_queries.find(query->id)) {
+            deliver(*query, {}, ETIMEDOUT);
+        }
+    }
+
+    std::vector<std::uint64_t> delayed;
+    for (auto& entry : m_connections) {
+        time::TimePoint const& deadline = entry.second->deadline;
+        if (!!deadline && deadline <= now) {
+            delayed.push_back(entry.first);
+        }
+    }
+
+    for (std::uint64_t id : delayed) {
+        attempt(id);
+    }
+
+    updateTimer();
+}
+
+void Resolver::onLookup(std::uint64_t id, std::vector<SockAddr> const& addresses, int error, bool ipv6)
+{
+    auto it = m_connections.find(id);
+    if (m_connections.end() == it) {
+        return;
+    }
+
+    std::shared_ptr<Connection> connection = it->second;
+    --connection->lookups;
+
+    // Report the most specific error if all lookups fail.
+    if (0 != error && (0 == connection->error || ENOENT == connection->error)) {
+        connection->error = error;
+    }
+
+    merge_addresses(connection->addresses, connection->next, addresses);
+
+    // Attempts in flight continue with the new addresses after the
+    // connection attempt delay.
+    if (false == connection->attempts.empty()) {
+        if (!connection->deadline && connection->next < connection->addresses.size()) {
+            connection->deadline = time::now_ns() + m_options.connection_attempt_delay;
+            updateTimer();
+        }
+        return;
+    }
+
+    // Give the AAAA answer the resolution delay to arrive after the A answer.
+    if (false == connection->started && false == ipv6 && 0 != connection->lookups) {
+        if (false == addresses.empty()) {
+            connection->deadline = time::now_ns() + m_options.resolution_delay;
+            updateTimer();
+        }
+        return;
+    }
+
+    attempt(id);
+}
+
+void Resolver::attempt(std::uint64_t id)
+{
+    using namespace std::placeholders;
+
+    auto it = m_connections.find(id);
+    if (m_connections.end() == it) {
+        return;
+    }
+
+    std::shared_ptr<Connection> connection = it->second;
+    connection->deadline = time::TimePoint();
+    connection->started = true;
+
+    while (connection->next < connection->addresses.size()) {
+        SockAddr const& address = connection->addresses[connection->next++];
+
+        Handle<int, -1> fd(
+            ::socket(address.family(), connection->type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0),
+            file::fd_close
+        );
+        if (-1 == fd.get()) {
+            connection->error = errno;
+            continue;
+        }
+
+        if (0 == ::connect(fd.get(), static_cast<sockaddr const*>(address), address.length())) {
+            finish(id, std::move(fd), address, 0);
+            return;
+        }
+        if (EINPROGRESS != errno) {
+            connection->error = errno;
+            continue;
+        }
+
+        bool const added = with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+            loop.add(fd.get(), EventLoop::Write, std::bind(&Resolver::onAttempt, this, id, _1));
+        });
+        if (false == added) {
+            connection->error = ENODEV;
+            break;
+        }
+
+        connection->attempts.push_back({ std::move(fd), SockAddr(address) });
+
+        // Start the next attempt after the delay, unless this one fails or
+        // succeeds first.
+        if (connection->next < connection->addresses.size()) {
+            connection->deadline = time::now_ns() + m_options.connection_attempt_delay;
+        }
+
+        updateTimer();
+        return;
+    }
+
+    // Fail once no attempt is left and no lookup can add addresses.
+    if (true == connection->attempts.empty() && 0 == connection->lookups) {
+        finish(id, Handle<int, -1>(file::fd_close), SockAddr(), 0 != connection->error ? connection->error : ENOENT);
+    }
+}
+
+void Resolver::onAttempt(std::uint64_t id, int fd)
+{
+    auto it = m_connections.find(id);
+    assert(m_connections.end() != it);
+
+    std::shared_ptr<Connection> connection = it->second;
+
+    auto attempt_it = std::find_if(connection->attempts.begin(), connection->attempts.end(),
+        [fd](Connection::Attempt const& attempt) { return fd == attempt.fd.get(); });
+    assert(connection->attempts.end() != attempt_it);
+
+    int const error = get_socket_error(fd);
+
+    with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        loop.remove(fd);
+    });
+
+    if (0 == error) {
+        Handle<int, -1> handle(std::move(attempt_it->fd));
+        SockAddr address(std::move(attempt_it->address));
+        connection->attempts.erase(attempt_it);
+
+        finish(id, std::move(handle), address, 0);
+        return;
+    }
+
+    connection->error = error;
+    connection->attempts.erase(attempt_it);
+
+    // Do not wait for the delay to expire when an attempt fails.
+    attempt(id);
+}
+
+void Resolver::finish(std::uint64_t id, Handle<int, -1> fd, SockAddr const& address, int error)
+{
+    auto it = m_connections.find(id);
+    assert(m_connections.end() != it);
+
+    std::shared_ptr<Connection> connection = std::move(it->second);
+    m_connections.erase(it);
+
+    // Abandon the attempts that lost the race.
+    with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        for (Connection::Attempt const& attempt : connection->attempts) {
+            loop.remove(attempt.fd.get());
+        }
+    });
+    connection->attempts.clear();
+
+    updateTimer();
+
+    connection->callback(std::move(fd), address, error);
+}
+
+//
+// Public (Resolver)
+//
+Resolver::Resolver(std::weak_ptr<EventLoop> event_loop)
+    : Resolver(std::move(event_loop), Options())
+{
+}
+
+Resolver::Resolver(std::weak_ptr<EventLoop> event_loop, Options options)
+    : m_event_loop(std::move(event_loop))
+    , m_options(std::move(options))
+    , m_timer(m_event_loop, std::bind(&Resolver::onTimeout, this))
+    , m_random(std::random_device()())
+{
+    if (true == m_options.nameserver.empty()) {
+        get_default_nameserver(m_options.nameserver);
+    }
+    if (0 == m_options.nameserver.port()) {
+        m_options.nameserver.setPort(dns_port);
+    }
+    if (0 == m_options.attempts) {
+        m_options.attempts = 1;
+    }
+}
+
+Resolver::~Resolver()
+{
+    cancel();
+}
+
+SockAddr const& Resolver::nameserver() const noexcept
+{
+    return m_options.nameserver;
+}
+
+void Resolver::resolve(std::string_view host, std::uint16_t port, OnResolved callback, SockAddr::Mask mask)
+{
+    assert(nullptr != callback);
+
+    mask &= SockAddr::IPv4 | SockAddr::IPv6;
+
+    // Literal addresses need no resolution.
+    SockAddr literal;
+    if (true == literal.parse(host, mask, std::nothrow)) {
+        literal.setPort(port, std::nothrow);
+
+        std::vector<SockAddr> addresses;
+        addresses.emplace_back(std::move(literal));
+        callback(addresses, 0);
+        return;
+    }
+
+    std::string name;
+    if (0 == mask || false == normalize_name(host, name)) {
+        callback({}, EINVAL);
+        return;
+    }
+
+    auto request = std::make_shared<Request>();
+    request->callback = std::move(callback);
+    request->port = port;
+
+    // Hold a reference, so that a synchronous completion from the cache
+    // does not complete the request before both types are looked up.
+    ++request->pending;
+
+    time::TimePoint const now = time::now_ns();
+
+    for (std::uint16_t type : { type_aaaa, type_a }) {
+        if (0 == (mask & (type_a == type ? SockAddr::IPv4 : SockAddr::IPv6))) {
+            continue;
+        }
+
+        auto it = m_cache.find(cache_key(name, type));
+        if (m_cache.end() != it) {
+            if (now < it->second.expires) {
+                request->add(it->second.addresses, 0);
+                continue;
+            }
+            m_cache.erase(it);
+        }
+
+        query(name, type, request);
+    }
+
+    if (0 == --request->pending) {
+        request->complete();
+    }
+}
+
+void Resolver::connect(std::string_view host, std::uint16_t port, int type, OnConnected callback, SockAddr::Mask mask)
+{
+    assert(nullptr != callback);
+
+    mask &= SockAddr::IPv4 | SockAddr::IPv6;
+
+    std::uint64_t const id = m_next_connection++;
+
+    auto connection = std::make_shared<Connection>();
+    connection->type = type;
+    connection->callback = std::move(callback);
+    m_connections.emplace(id, connection);
+
+    // Literal addresses need no resolution.
+    SockAddr literal;
+    if (true == literal.parse(host, mask, std::nothrow)) {
+        literal.setPort(port, std::nothrow);
+        connection->addresses.emplace_back(std::move(literal));
+        attempt(id);
+        return;
+    }
+
+    if (0 == mask) {
+        finish(id, Handle<int, -1>(file::fd_close), SockAddr(), EINVAL);
+        return;
+    }
+
+    // Look up each address family on its own, so that attempts need not
+    // wait for the slower answer.
+    for (SockAddr::Mask family : { SockAddr::IPv6, SockAddr::IPv4 }) {
+        if (0 != (mask & family)) {
+            ++connection->lookups;
+        }
+    }
+
+    for (SockAddr::Mask family : { SockAddr::IPv6, SockAddr::IPv4 }) {
+        // A lookup may complete the connection synchronously.
+        if (0 == (mask & family) || m_connections.end() == m_connections.find(id)) {
+            continue;
+        }
+
+        bool const ipv6 = SockAddr::IPv6 == family;
+        resolve(host, port, [this, id, ipv6](std::vector<SockAddr> const& addresses, int error) {
+            onLookup(id, addresses, error, ipv6);
+        }, family);
+    }
+}
+
+void Resolver::cancel() noexcept
+{
+    with_weak_ptr_locked(m_event_loop, [this](EventLoop& loop) {
+        for (auto& entry : m_connections) {
+            for (Connection::Attempt const& attempt : entry.second->attempts) {
+                loop.remove(attempt.fd.get());
+            }
+        }
+        for (auto& entry : m_queries) {
+            loop.remove(entry.second->fd.get());
+        }
+    });
+
+    m_connections.clear();
+    m_queries.clear();
+
+    m_timer.clear();
+}
+
+void Resolver::clearCache() noexcept
+{
+    m_cache.clear();
+}
@@ -22,13 +22,299 @@
 // SOFTWARE.
 //
 #include "hlib/sock_addr.hpp"
-#include "hlib/error.hpp"
-#include "hlib_format.hpp"
-#include "hlib/string.hpp"
+#include <algorithm>
 #include <arpa/inet.h>
+#include <cstring>
+#include <stdexcept>
 
 using namespace hlib;
 
+//
+// Implementation
+//
+namespace
+{
+
+bool parse_port(std::string_view string, std::uint16_t& port) noexcept
+{
+    if (true == string.empty() || string.size() > 5) {
+        return false;
+    }
+
+    std::uint32_t value = 0;
+    for (char c : string) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + static_cast<std::uint32_t>(c - '0');
+    }
+
+    if (value > 65535) {
+        return false;
+    }
+
+    port = static_cast<std::uint16_t>(value);
+    return true;
+}
+
+// Parses dotted decimal, rejecting leading zeros like inet_pton().
+bool parse_ipv4(std::string_view string, std::uint8_t* bytes) noexcept
+{
+    for (int i = 0; i < 4; ++i) {
+        if (i > 0) {
+            if (true == string.empty() || '.' != string[0]) {
+                return false;
+            }
+            string.remove_prefix(1);
+        }
+
+        std::size_t digits = 0;
+        std::uint32_t value = 0;
+
+        for (; digits < string.size() && string[digits] >= '0' && string[digits] <= '9'; ++digits) {
+            if (3 == digits) {
+                return false;
+            }
+            value = value * 10 + static_cast<std::uint32_t>(string[digits] - '0');
+        }
+
+        if (0 == digits || value > 255 || (digits > 1 && '0' == string[0])) {
+            return false;
+        }
+
+        bytes[i] = static_cast<std::uint8_t>(value);
+        string.remove_prefix(digits);
+    }
+
+    return true == string.empty();
+}
+
+int hex_value(char c) noexcept
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Parses RFC 4291 text, with "::" compression and an optional trailing
+// dotted decimal IPv4 address.
+bool parse_ipv6(std::string_view string, std::uint8_t* bytes) noexcept
+{
+    std::uint16_t words[8]{};
+    int count = 0;
+    int gap = -1;
+    std::size_t pos = 0;
+
+    if (string.size() >= 2 && ':' == string[0]) {
+        if (':' != string[1]) {
+            return false;
+        }
+        gap = 0;
+        pos = 2;
+    }
+
+    while (pos < string.size()) {
+        if (8 == count) {
+            return false;
+        }
+
+        std::size_t const end = string.find(':', pos);
+        std::string_view const group = string.substr(pos, std::string_view::npos == end ? end : end - pos);
+
+        if (std::string_view::npos == end && std::string_view::npos != group.find('.')) {
+            std::uint8_t ipv4[4];
+            if (count > 6 || false == parse_ipv4(group, ipv4)) {
+                return false;
+            }
+
+            words[count++] = static_cast<std::uint16_t>(ipv4[0] << 8 | ipv4[1]);
+            words[count++] = static_cast<std::uint16_t>(ipv4[2] << 8 | ipv4[3]);
+            break;
+        }
+
+        if (true == group.empty() || group.size() > 4) {
+            return false;
+        }
+
+        std::uint32_t word = 0;
+        for (char c : group) {
+            int const value = hex_value(c);
+            if (value < 0) {
+                return false;
+            }
+            word = word << 4 | static_cast<std::uint32_t>(value);
+        }
+        words[count++] = static_cast<std::uint16_t>(word);
+
+        if (std::string_view::npos == end) {
+            break;
+        }
+
+        pos = end + 1;
+        if (pos == string.size()) {
+            return false;
+        }
+        if (':' == string[pos]) {
+            if (gap >= 0) {
+                return false;
+            }
+            gap = count;
+            ++pos;
+        }
+    }
+
+    if ((gap < 0 && 8 != count) || (gap >= 0 && count > 7)) {
+        return false;
+    }
+
+    // Expand "::" to the missing zero words.
+    if (gap >= 0) {
+        int const missing = 8 - count;
+        std::copy_backward(words + gap, words + count, words + 8);
+        std::fill(words + gap, words + gap + missing, 0);
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        bytes[i * 2] = static_cast<std::uint8_t>(words[i] >> 8);
+        bytes[i * 2 + 1] = static_cast<std::uint8_t>(words[i]);
+    }
+
+    return true;
+}
+
+char* format_decimal(char* buffer, std::uint32_t value) noexcept
+{
+    char digits[10];
+    int count = 0;
+
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    while (0 != value);
+
+    while (count > 0) {
+        *buffer++ = digits[--count];
+    }
+
+    return buffer;
+}
+
+char* format_ipv4(char* buffer, std::uint8_t const* bytes) noexcept
+{
+    for (int i = 0; i < 4; ++i) {
+        if (i > 0) {
+            *buffer++ = '.';
+        }
+        buffer = format_decimal(buffer, bytes[i]);
+    }
+
+    return buffer;
+}
+
+// Formats like inet_ntop(): the first longest run of two or more zero words
+// is compressed and IPv4 mapped and compatible addresses end in dotted
+// decimal.
+char* format_ipv6(char* buffer, std::uint8_t const* bytes) noexcept
+{
+    static char const hex[] = "0123456789abcdef";
+
+    std::uint16_t words[8];
+    for (int i = 0; i < 8; ++i) {
+        words[i] = static_cast<std::uint16_t>(bytes[i * 2] << 8 | bytes[i * 2 + 1]);
+    }
+
+    int best_base = -1;
+    int best_length = 0;
+
+    for (int i = 0; i < 8;) {
+        if (0 != words[i]) {
+            ++i;
+            continue;
+        }
+
+        int length = 0;
+        while (i + length < 8 && 0 == words[i + length]) {
+            ++length;
+        }
+        if (length > best_length) {
+            best_base = i;
+            best_length = length;
+        }
+        i += length;
+    }
+
+    if (best_length < 2) {
+        best_base = -1;
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        if (best_base >= 0 && i >= best_base && i < best_base + best_length) {
+            if (i == best_base) {
+                *buffer++ = ':';
+            }
+            continue;
+        }
+
+        if (0 != i) {
+            *buffer++ = ':';
+        }
+
+        if (6 == i && 0 == best_base
+         && (6 == best_length
+          || (7 == best_length && 0x0001 != words[7])
+          || (5 == best_length && 0xffff == words[5]))) {
+            return format_ipv4(buffer, bytes + 12);
+        }
+
+        bool leading = true;
+        for (int shift = 12; shift >= 0; shift -= 4) {
+            int const nibble = (words[i] >> shift) & 0xf;
+            if (true == leading && 0 == nibble && 0 != shift) {
+                continue;
+            }
+            leading = false;
+            *buffer++ = hex[nibble];
+        }
+    }
+
+    if (best_base >= 0 && 8 == best_base + best_length) {
+        *buffer++ = ':';
+    }
+
+    return buffer;
+}
+
+std::uint64_t mix(std::uint64_t value) noexcept
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+std::size_t copy_string(char* buffer, std::size_t size, char const* string, std::size_t length) noexcept
+{
+    if (length + 1 > size) {
+        return 0;
+    }
+
+    memcpy(buffer, string, length);
+    buffer[length] = '\0';
+    return length;
+}
+
+} // namespace
+
 //
 // Public
 //
@@ -71,7 +357,7 @@ SockAddr::SockAddr(sockaddr_storage const& that) noexcept
     m_storage = that;
 }
 
-SockAddr::SockAddr(std::string const& that, Mask mask)
+SockAddr::SockAddr(std::string_view that, Mask mask)
 {
     parse(that, mask);
 }
@@ -116,12 +402,43 @@ SockAddr& SockAddr::operator = (sockaddr_storage const& that) noexcept
     return *this;
 }
 
-SockAddr& SockAddr::operator = (std::string const& that) noexcept
+SockAddr& SockAddr::operator = (std::string_view that) noexcept
 {
-    parse(that);
+    parse(that, All, std::nothrow);
     return *this;
 }
 
+bool SockAddr::operator == (SockAddr const& that) const noexcept
+{
+    if (m_family != that.m_family) {
+        return false;
+    }
+
+    switch (m_family) {
+    case AF_INET:
+        return m_inet.sin_addr.s_addr == that.m_inet.sin_addr.s_addr
+            && m_inet.sin_port == that.m_inet.sin_port;
+
+    case AF_INET6:
+        return 0 == memcmp(&m_inet6.sin6_addr, &that.m_inet6.sin6_addr, sizeof(in6_addr))
+            && m_inet6.sin6_port == that.m_inet6.sin6_port
+            && m_inet6.sin6_scope_id == that.m_inet6.sin6_scope_id;
+
+    case AF_UNIX:
+        // Abstract socket namespace paths start with a zero.
+        return m_unix.sun_path[0] == that.m_unix.sun_path[0]
+            && 0 == strncmp(m_unix.sun_path + 1, that.m_unix.sun_path + 1, sizeof(m_unix.sun_path) - 1);
+
+    default:
+        return true;
+    }
+}
+
+bool SockAddr::operator != (SockAddr const& that) const noexcept
+{
+    return !(*this == that);
+}
+
 sa_family_t SockAddr::family() const noexcept
 {
     return m_family;
@@ -150,28 +467,61 @@ uint16_t SockAddr::port() const noexcept
 
 std::string SockAddr::address() const
 {
-    static_assert(INET6_ADDRSTRLEN >= INET_ADDRSTRLEN, "INET6_ADDRSTRLEN < INET_ADDRSTRLEN");
-    char address[INET6_ADDRSTRLEN];
+    char buffer[MaxStringSize];
+    return std::string(buffer, address(buffer, sizeof(buffer)));
+}
+
+std::size_t SockAddr::address(char* buffer, std::size_t size) const noexcept
+{
+    assert(nullptr != buffer);
+
+    char string[MaxStringSize];
+    char* end = string;
 
     switch (m_family) {
     case AF_INET:
-        if (nullptr == inet_ntop(AF_INET, &m_inet.sin_addr, address, INET_ADDRSTRLEN)) {
-            throw make_system_error(errno, "inet_ntop() failed");
-        }
-        return address;
+        end = format_ipv4(string, reinterpret_cast<std::uint8_t const*>(&m_inet.sin_addr));
+        break;
 
     case AF_INET6:
-        if (nullptr == inet_ntop(AF_INET6, &m_inet6.sin6_addr, address, INET6_ADDRSTRLEN)) {
-            throw make_system_error(errno, "inet_ntop() failed");
-        }
-        return address;
+        end = format_ipv6(string, m_inet6.sin6_addr.s6_addr);
+        break;
 
     case AF_UNIX:
-        // TODO verify that it is always zero terminated!
-        return m_unix.sun_path;
+        return copy_string(buffer, size, m_unix.sun_path, strnlen(m_unix.sun_path, sizeof(m_unix.sun_path)));
 
     default:
-        return std::string();
+        break;
+    }
+
+    return copy_string(buffer, size, string, static_cast<std::size_t>(end - string));
+}
+
+std::size_t SockAddr::hash() const noexcept
+{
+    switch (m_family) {
+    case AF_INET:
+        return mix(std::uint64_t{ m_inet.sin_addr.s_addr } << 16 | m_inet.sin_port);
+
+    case AF_INET6:
+    {
+        std::uint64_t words[2];
+        memcpy(words, &m_inet6.sin6_addr, sizeof(words));
+        return mix(words[0] ^ mix(words[1] ^ (std::uint64_t{ m_inet6.sin6_port } << 32 | m_inet6.sin6_scope_id)));
+    }
+
+    case AF_UNIX:
+    {
+        // FNV-1a, hashing past the zero of an abstract namespace path.
+        std::uint64_t hash = 0xcbf29ce484222325ULL;
+        for (std::size_t i = 0; i < sizeof(m_unix.sun_path) && (0 == i || 0 != m_unix.sun_path[i]); ++i) {
+            hash = (hash ^ static_cast<unsigned char>(m_unix.sun_path[i])) * 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    default:
+        return 0;
     }
 }
 
@@ -279,12 +629,9 @@ void SockAddr::clear() noexcept
     memset(&m_storage, 0, sizeof(m_storage));
 }
 
-bool SockAddr::parse(std::string const& string, Mask mask, std::nothrow_t) noexcept
+bool SockAddr::parse(std::string_view string, Mask mask, std::nothrow_t) noexcept
 {
-    (void)mask;
-
-    std::string address;
-    std::optional<std::uint16_t> port;
+    std::uint16_t port = 0;
 
     auto to_unix = [&]()
     {
@@ -312,76 +659,65 @@ bool SockAddr::parse(std::string const& string, Mask mask, std::nothrow_t) noexc
     m_family = AF_UNSPEC;
 
     // An IPv6 address has always at least 2 ':' characters.
-    if (count(string, ':') >= 2) {
+    if (std::count(string.begin(), string.end(), ':') >= 2) {
         // IPv6 allowed?
         if (0 == (IPv6 & mask)) {
             clear();
             return false;
         }
 
-        in6_addr addr;
-        std::string::size_type const start = starts_with(string, '[');
-        std::string::size_type const end = string.rfind("]:");
+        std::string_view::size_type const start = false == string.empty() && '[' == string[0] ? 1 : 0;
+        std::string_view::size_type const end = string.rfind("]:");
 
         // String either has "[<ipv6>]:port" format or just "<ipv6>".
         if ((start > end)
-         || (1 == start && std::string::npos == end)
-         || (0 == start && std::string::npos != end)) {
+         || (1 == start && std::string_view::npos == end)
+         || (0 == start && std::string_view::npos != end)) {
             return to_unix();
         }
 
-        // Get address.
-        address = string.substr(start, end - 1);
-
         // Parse IPv6 address.
-        if (1 != inet_pton(AF_INET6, address.c_str(), &addr)) {
+        in6_addr addr;
+        if (false == parse_ipv6(string.substr(start, end - start), addr.s6_addr)) {
             return to_unix();
         }
-        m_inet6.sin6_family = AF_INET6;
-        m_inet6.sin6_addr = addr;
-        m_inet6.sin6_port = 0;
 
         // Port available?
-        if (std::string::npos != end) {
-            port = stoui16(string.substr(end + 2), 10, std::nothrow);
-            if (std::nullopt == port) {
-                return to_unix();
-            }
-            m_inet6.sin6_port = htons(port.value());
+        if (std::string_view::npos != end && false == parse_port(string.substr(end + 2), port)) {
+            return to_unix();
         }
+
+        m_inet6 = sockaddr_in6{};
+        m_inet6.sin6_family = AF_INET6;
+        m_inet6.sin6_addr = addr;
+        m_inet6.sin6_port = htons(port);
         return true;
     }
-    else if (3 == count(string, '.')) {
+    else if (3 == std::count(string.begin(), string.end(), '.')) {
         // IPv4 allowed?
         if (0 == (IPv4 & mask)) {
             clear();
             return false;
         }
 
-        in_addr addr;
-
         // Find optional port.
-        std::string::size_type pos = string.rfind(':');
-
-        // Get address.
-        address = string.substr(0, pos);
+        std::string_view::size_type const pos = string.rfind(':');
 
         // Parse IPv4 address.
-        if (1 != inet_pton(AF_INET, address.c_str(), &addr)) {
+        in_addr addr;
+        if (false == parse_ipv4(string.substr(0, pos), reinterpret_cast<std::uint8_t*>(&addr))) {
             return to_unix();
         }
-        m_inet.sin_family = AF_INET;
-        m_inet.sin_addr = addr;
-        m_inet.sin_port = 0;
 
         // Port available?
-        if (std::string::npos != pos) {
-            port = stoui16(string.substr(pos + 1), 10, std::nothrow);
-            if (std::nullopt == port) {
-                return to_unix();
-            }
-            m_inet.sin_port = htons(port.value());
+        if (std::string_view::npos != pos && false == parse_port(string.substr(pos + 1), port)) {
+            return to_unix();
         }
+
+        m_inet = sockaddr_in{};
+        m_inet.sin_family = AF_INET;
+        m_inet.sin_addr = addr;
+        m_inet.sin_port = htons(port);
         return true;
     }
     else {
@@ -389,7 +725,7 @@ bool SockAddr::parse(std::string const& string, Mask mask, std::nothrow_t) noexc
     }
 }
 
-void SockAddr::parse(std::string const& string, Mask mask)
+void SockAddr::parse(std::string_view string, Mask mask)
 {
     if (false == parse(string, mask, std::nothrow)) {
         if (string.length() + 1 > sizeof(sockaddr_un::sun_path)) {
@@ -403,26 +739,39 @@ void SockAddr::parse(std::string const& string, Mask mask)
 
 std::string hlib::to_string(SockAddr const& sa)
 {
-    std::string address = sa.address();
-    int port = sa.port();
+    char buffer[SockAddr::MaxStringSize];
+    return std::string(buffer, format_sock_addr(buffer, sizeof(buffer), sa));
+}
+
+std::size_t hlib::format_sock_addr(char* buffer, std::size_t size, SockAddr const& sa) noexcept
+{
+    assert(nullptr != buffer);
+
+    std::uint16_t const port = sa.port();
+    if (0 == port) {
+        return sa.address(buffer, size);
+    }
+
+    char string[SockAddr::MaxStringSize];
+    char* end = string;
 
     switch (sa.family()) {
     case AF_INET:
-        if (port > 0) {
-            return format("%s:%d", address.c_str(), port);
-        }
+        end += sa.address(end, sizeof(string));
         break;
 
     case AF_INET6:
-        if (port > 0) {
-            return format("[%s]:%d", address.c_str(), port);
-        }
+        *end++ = '[';
+        end += sa.address(end, sizeof(string) - 1);
+        *end++ = ']';
         break;
 
     default:
-        break;
+        return sa.address(buffer, size);
     }
 
-    return address;
-}
+    *end++ = ':';
+    end = format_decimal(end, port);
 
+    return copy_string(buffer, size, string, static_cast<std::size_t>(end - string));
+}
@@ -27,6 +27,8 @@
 #include "hlib/event_loop.hpp"
 #include "hlib/file.hpp"
 #include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
 
@@ -38,26 +40,49 @@ using namespace hlib;
 namespace
 {
 
+bool set_option(int fd, int level, int option, int value) noexcept
+{
+    return 0 == setsockopt(fd, level, option, &value, sizeof(value));
+}
+
 bool set_option(int fd, int option, int value = 1) noexcept
 {
-    return 0 == setsockopt(fd, SOL_SOCKET, option, &value, sizeof(value));
+    return set_option(fd, SOL_SOCKET, option, value);
 }
 
 Result<> set_reuse(int fd, std::uint32_t options) noexcept
 {
     if (0 != (Socket::ReuseAddr & options)
      && false == set_option(fd, SO_REUSEADDR, 1)) {
-        return make_system_error(errno, "setsocktopt(SO_REUSEADDR) failed");
+        return make_error(errno, "setsocktopt(SO_REUSEADDR) failed");
     }
 
     if (0 != (Socket::ReusePort & options)
      && false == set_option(fd, SO_REUSEPORT, 1)) {
-        return make_system_error(errno, "setsocktopt(SO_REUSEPORT) failed");
+        return make_error(errno, "setsocktopt(SO_REUSEPORT) failed");
     }
 
     return {};
 }
 
+// Options of an established connection, without those that only apply to
+// listening or connecting.
+SocketOptions get_connection_options(SocketOptions options) noexcept
+{
+    options.fast_open_connect.reset();
+    options.defer_accept.reset();
+    options.fast_open.reset();
+    return options;
+}
+
+// Options of a listening socket, without those that only apply to
+// connecting.
+SocketOptions get_listen_options(SocketOptions options) noexcept
+{
+    options.fast_open_connect.reset();
+    return options;
+}
+
 } // namespace
 
 void Socket::updateEventsLocked(std::uint32_t events) noexcept
@@ -101,6 +126,12 @@ void Socket::onAccept(int fd, std::uint32_t events)
         return;
     }
 
+    // Apply the listener's connection options. On failure drop only the
+    // accepted socket.
+    if (true == set_socket_options(socket.get(), get_connection_options(m_options), std::nothrow).failure()) {
+        return;
+    }
+
     // Callback.
     m_on_accept(std::move(socket), address);
 }
@@ -222,8 +253,11 @@ void Socket::onEvent(int fd, std::uint32_t events)
         assert(false == m_send_queue.empty());
         Source& source = *m_send_queue.front().source;
 
+        // Signal more data follows while more sources are queued.
+        int const flags = true == m_options.coalesce && m_send_queue.size() > 1 ? MSG_MORE : 0;
+
         // Progressively send from source.
-        ssize_t size = ::send(fd, source.peek(source.available()), source.available(), 0);
+        ssize_t size = ::send(fd, source.peek(source.available()), source.available(), flags);
         if (-1 == size) {
             lock.unlock();
 
@@ -321,6 +355,30 @@ void Socket::setCloseCallback(OnClose callback) noexcept
     m_on_close = std::move(callback);
 }
 
+Result<> Socket::setOptions(SocketOptions options, std::nothrow_t) noexcept
+{
+    HLIB_LOCK_GUARD(lock, m_mutex);
+
+    m_options = std::move(options);
+
+    if (-1 == m_fd.get()) {
+        return {};
+    }
+
+    // The kernel rejects the connecting options once a connect started and
+    // the listening options on connections, including those in progress.
+    if (true == m_listening) {
+        return set_socket_options(m_fd.get(), get_listen_options(m_options), std::nothrow);
+    }
+
+    return set_socket_options(m_fd.get(), get_connection_options(m_options), std::nothrow);
+}
+
+void Socket::setOptions(SocketOptions options)
+{
+    success_or_throw<>(setOptions(std::move(options), std::nothrow));
+}
+
 Result<> Socket::open(Handle<int, -1> fd, std::nothrow_t) noexcept
 {
     using namespace std::placeholders;
@@ -329,12 +387,18 @@ Result<> Socket::open(Handle<int, -1> fd, std::nothrow_t) noexcept
 
     m_events = EventLoop::Read;
 
+    // Set connection options.
+    Result<> result = set_socket_options(fd.get(), get_connection_options(m_options), std::nothrow);
+    if (true == result.failure()) {
+        return result;
+    }
+
     // Add socket's file descriptor to event loop.
     bool success = with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
         loop.add(fd.get(), m_events, std::bind(&Socket::onEvent, this, _1, _2));
     });
     if (false == success) {
-        return make_system_error(ENODEV, "Failed to lock event loop");
+        return make_error(ENODEV, "Failed to lock event loop");
     }
 
     // Store socket's file descriptor and signal it is connected.
@@ -362,12 +426,12 @@ Result<> Socket::listen(SockAddr const& address, int type, int protocol, int bac
         file::fd_close
     );
     if (-1 == fd.get()) {
-        return make_system_error(errno, "socket() failed");
+        return make_error(errno, "socket() failed");
     }
 
     // Set close-on-exec on listening sockets.
     if (-1 == fcntl(fd.get(), F_SETFD, FD_CLOEXEC)) {
-        return make_system_error(errno, "fcntl() failed");
+        return make_error(errno, "fcntl() failed");
     }
 
     Result<> result;
@@ -384,14 +448,20 @@ Result<> Socket::listen(SockAddr const& address, int type, int protocol, int bac
         return result;
     }
 
+    // Set socket options.
+    result = set_socket_options(fd.get(), m_options, std::nothrow);
+    if (true == result.failure()) {
+        return result;
+    }
+
     // Bind socket to address.
     if (-1 == ::bind(fd.get(), static_cast<sockaddr const*>(address), address.length())) {
-        return make_system_error(errno, "bind() failed");
+        return make_error(errno, "bind() failed");
     }
 
     // Listen for incoming connections
     if (-1 == ::listen(fd.get(), backlog)) {
-        return make_system_error(errno, "listen() failed");
+        return make_error(errno, "listen() failed");
     }
 
     // Add file descriptor to event loop.
@@ -399,11 +469,12 @@ Result<> Socket::listen(SockAddr const& address, int type, int protocol, int bac
         loop.add(fd.get(), m_events, std::bind(&Socket::onAccept, this, _1, _2));
     });
     if (false == success) {
-        return make_system_error(ENODEV, "Event loop not available");
+        return make_error(ENODEV, "Event loop not available");
     }
 
     // Commit file descriptor.
     m_fd = std::move(fd);
+    m_listening = true;
     return {};
 }
 
@@ -429,7 +500,7 @@ Result<> Socket::connect(SockAddr const& address, int type, int protocol, std::u
         file::fd_close
     );
     if (-1 == fd.get()) {
-        return make_system_error(errno, "socket() failed");
+        return make_error(errno, "socket() failed");
     }
 
     Result<> result;
@@ -446,10 +517,16 @@ Result<> Socket::connect(SockAddr const& address, int type, int protocol, std::u
         return result;
     }
 
+    // Set socket options.
+    result = set_socket_options(fd.get(), m_options, std::nothrow);
+    if (true == result.failure()) {
+        return result;
+    }
+
     // Connect to peer address.
     if (-1 == ::connect(fd.get(), static_cast<sockaddr const*>(address), address.length())) {
         if (EINPROGRESS != errno) {
-            return make_system_error(errno, "connect() failed");
+            return make_error(errno, "connect() failed");
         }
 
         callback = std::bind(&Socket::onConnect, this, _1, _2);
@@ -464,7 +541,7 @@ Result<> Socket::connect(SockAddr const& address, int type, int protocol, std::u
         loop.add(fd.get(), events, std::move(callback));
     });
     if (false == success) {
-        return make_system_error(ENODEV, "Event loop not available");
+        return make_error(ENODEV, "Event loop not available");
     }
 
     // Commit file descriptor.
@@ -525,26 +602,95 @@ void Socket::send(std::shared_ptr<Source> source)
 }
 
 void Socket::close() noexcept
+{
+    release();
+}
+
+Handle<int, -1> Socket::release() noexcept
 {
     HLIB_LOCK_GUARD(lock, m_mutex);
 
-    if (-1 == m_fd.get()) {
-        return;
+    Handle<int, -1> fd(std::move(m_fd));
+    m_fd = Handle<int, -1>(file::fd_close);
+
+    if (-1 == fd.get()) {
+        return fd;
     }
 
     with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
-        loop.remove(m_fd.get());
+        loop.remove(fd.get());
     });
 
-    m_fd.reset();
-
     m_connected = false;
+    m_listening = false;
     m_events = 0;
 
     m_receive_sink.reset();
     m_receive_callback = nullptr;
 
     m_send_queue.clear();
+
+    return fd;
+}
+
+Result<> hlib::set_socket_options(int fd, SocketOptions const& options, std::nothrow_t) noexcept
+{
+    if (true == options.no_delay.has_value()
+     && false == set_option(fd, IPPROTO_TCP, TCP_NODELAY, *options.no_delay)) {
+        return make_error(errno, "setsockopt(TCP_NODELAY) failed");
+    }
+
+    if (true == options.cork.has_value()
+     && false == set_option(fd, IPPROTO_TCP, TCP_CORK, *options.cork)) {
+        return make_error(errno, "setsockopt(TCP_CORK) failed");
+    }
+
+    if (true == options.quick_ack.has_value()
+     && false == set_option(fd, IPPROTO_TCP, TCP_QUICKACK, *options.quick_ack)) {
+        return make_error(errno, "setsockopt(TCP_QUICKACK) failed");
+    }
+
+    if (true == options.send_buffer.has_value()
+     && false == set_option(fd, SO_SNDBUF, *options.send_buffer)) {
+        return make_error(errno, "setsockopt(SO_SNDBUF) failed");
+    }
+
+    if (true == options.receive_buffer.has_value()
+     && false == set_option(fd, SO_RCVBUF, *options.receive_buffer)) {
+        return make_error(errno, "setsockopt(SO_RCVBUF) failed");
+    }
+
+    if (true == options.busy_poll.has_value()
+     && false == set_option(fd, SO_BUSY_POLL, *options.busy_poll)) {
+        return make_error(errno, "setsockopt(SO_BUSY_POLL) failed");
+    }
+
+    if (true == options.incoming_cpu.has_value()
+     && false == set_option(fd, SO_INCOMING_CPU, *options.incoming_cpu)) {
+        return make_error(errno, "setsockopt(SO_INCOMING_CPU) failed");
+    }
+
+    if (true == options.fast_open_connect.has_value()
+     && false == set_option(fd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, *options.fast_open_connect)) {
+        return make_error(errno, "setsockopt(TCP_FASTOPEN_CONNECT) failed");
+    }
+
+    if (true == options.defer_accept.has_value()
+     && false == set_option(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, *options.defer_accept)) {
+        return make_error(errno, "setsockopt(TCP_DEFER_ACCEPT) failed");
+    }
+
+    if (true == options.fast_open.has_value()
+     && false == set_option(fd, IPPROTO_TCP, TCP_FASTOPEN, *options.fast_open)) {
+        return make_error(errno, "setsockopt(TCP_FASTOPEN) failed");
+    }
+
+    return {};
+}
+
+void hlib::set_socket_options(int fd, SocketOptions const& options)
+{
+    success_or_throw<>(set_socket_options(fd, options, std::nothrow));
 }
 
 bool hlib::is_socket(int fd) noexcept
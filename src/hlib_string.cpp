@@ -24,209 +24,157 @@
 // Base64 code based on: https://github.com/tomcumming/base64.
 //
 #include "hlib/string.hpp"
+#include <charconv>
 #include <cstdlib>
 #include <climits>
 #include <cstring>
 #include <locale>
 #include <limits>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 // #pragma GCC diagnostic push
 // #pragma GCC diagnostic ignored "-Wunused-function"
 
 using namespace hlib;
 
 //
-// Public
+// Implementation
 //
-std::optional<bool> hlib::stob(std::string const& value, std::nothrow_t)
+namespace
 {
-    if ("true" == value) {
-        return true;
-    }
-    else if ("false" == value) {
-        return false;
-    }
-
-    return std::nullopt;
-}
 
-std::optional<std::int8_t> hlib::stoi8(std::string const& value, int base, std::nothrow_t)
+// Parses an integer without consulting the locale and without requiring a
+// null terminated string. Mirrors strtol() in accepting an optional sign, a
+// "0x" prefix for base 16 and prefix detection for base 0, but rejects
+// leading whitespace, trailing characters and negative unsigned values.
+template<typename T>
+std::errc parse_integer(std::string_view value, int base, T& result) noexcept
 {
-    if (true == value.empty() || isspace(value.front())) {
-        return std::nullopt;
-    }
+    char const* first = value.data();
+    char const* last = first + value.size();
 
-    char* pos = nullptr;
-    long r = strtol(value.c_str(), &pos, base);
-    if (nullptr == pos
-     || 0 != *pos
-     || r < std::numeric_limits<std::int8_t>::min()
-     || r > std::numeric_limits<std::int8_t>::max()) {
-        return std::nullopt;
+    bool negative = false;
+    if (first != last && ('-' == *first || '+' == *first)) {
+        negative = '-' == *first;
+        ++first;
     }
-    return r;
-}
 
-std::optional<std::int16_t> hlib::stoi16(std::string const& value, int base, std::nothrow_t)
-{
-    if (true == value.empty() || isspace(value.front())) {
-        return std::nullopt;
+    if ((16 == base || 0 == base) && last - first > 2
+     && '0' == first[0] && ('x' == first[1] || 'X' == first[1])) {
+        first += 2;
+        base = 16;
     }
-
-    char* pos = nullptr;
-    long r = strtol(value.c_str(), &pos, base);
-    if (nullptr == pos
-     || 0 != *pos
-     || r < std::numeric_limits<std::int16_t>::min()
-     || r > std::numeric_limits<std::int16_t>::max()) {
-        return std::nullopt;
+    else if (0 == base) {
+        base = (last - first > 1 && '0' == *first) ? 8 : 10;
     }
-    return r;
-}
 
-std::optional<std::int32_t> hlib::stoi32(std::string const& value, int base, std::nothrow_t)
-{
-    if (true == value.empty() || isspace(value.front())) {
-        return std::nullopt;
+    if (first == last || base < 2 || base > 36) {
+        return std::errc::invalid_argument;
     }
 
-    errno = 0;
+    std::uint64_t magnitude = 0;
 
-    char* pos = nullptr;
-    long r = strtol(value.c_str(), &pos, base);
-    if (nullptr == pos
-     || 0 != *pos
-     || r < std::numeric_limits<std::int32_t>::min()
-     || r > std::numeric_limits<std::int32_t>::max()
-     || ((LONG_MIN == r || LONG_MAX == r) && ERANGE == errno)) {
-        return std::nullopt;
+    // Up to 19 decimal digits always fit in 64 bits, so the common case needs
+    // no overflow checks at all.
+    if (10 == base && last - first <= 19) {
+        for (char const* pos = first; pos != last; ++pos) {
+            unsigned int digit = static_cast<unsigned char>(*pos) - static_cast<unsigned int>('0');
+            if (digit > 9) {
+                return std::errc::invalid_argument;
+            }
+            magnitude = magnitude * 10 + digit;
+        }
     }
-    return r;
-}
-
-std::optional<std::int64_t> hlib::stoi64(std::string const& value, int base, std::nothrow_t)
-{
-    if (true == value.empty() || isspace(value.front())) {
-        return std::nullopt;
+    else {
+        std::from_chars_result r = std::from_chars(first, last, magnitude, base);
+        if (last != r.ptr) {
+            return std::errc::invalid_argument;
+        }
+        if (std::errc() != r.ec) {
+            return r.ec;
+        }
     }
 
-    errno = 0;
-
-    char* pos = nullptr;
-    long long r = strtoll(value.c_str(), &pos, base);
-    if (nullptr == pos
-     || 0 != *pos
-     || ((LLONG_MIN == r || LLONG_MAX == r) && ERANGE == errno)) {
-        return std::nullopt;
-    }
-    return r;
-}
+    if constexpr (true == std::is_signed<T>::value) {
+        typedef typename std::make_unsigned<T>::type Unsigned;
 
-std::optional<std::uint8_t> hlib::stoui8(std::string const& value, int base, std::nothrow_t)
-{
-    if (true == value.empty() || isspace(value.front())) {
-        return std::nullopt;
-    }
+        std::uint64_t limit = static_cast<std::uint64_t>(std::numeric_limits<T>::max()) + (true == negative ? 1 : 0);
+        if (magnitude > limit) {
+            return std::errc::result_out_of_range;
+        }
 
-    char* pos = nullptr;
-    unsigned long r = strtoul(value.c_str(), &pos, base);
-    if (nullptr == pos
-     || 0 != *pos
-     || r < std::numeric_limits<std::uint8_t>::min()
-     || r > std::numeric_limits<std::uint8_t>::max()) {
-        return std::nullopt;
+        result = true == negative
+            ? static_cast<T>(static_cast<Unsigned>(0 - magnitude))
+            : static_cast<T>(magnitude);
     }
-    return r;
-}
+    else {
+        if ((true == negative && 0 != magnitude)
+         || magnitude > std::numeric_limits<T>::max()) {
+            return std::errc::result_out_of_range;
+        }
 
-std::optional<std::uint16_t> hlib::stoui16(std::string const& value, int base, std::nothrow_t)
-{
-    if (true == value.empty() || isspace(value.front())) {
-        return std::nullopt;
+        result = static_cast<T>(magnitude);
     }
 
-    char* pos = nullptr;
-    unsigned long r = strtoul(value.c_str(), &pos, base);
-    if (nullptr == pos
-     || 0 != *pos
-     || r < std::numeric_limits<std::uint16_t>::min()
-     || r > std::numeric_limits<std::uint16_t>::max()) {
-        return std::nullopt;
-    }
-    return r;
+    return std::errc();
 }
 
-std::optional<std::uint32_t> hlib::stoui32(std::string const& value, int base, std::nothrow_t)
+template<typename T>
+std::errc parse_float(std::string_view value, T& result) noexcept
 {
-    if (true == value.empty() || isspace(value.front())) {
-        return std::nullopt;
-    }
+    char const* first = value.data();
+    char const* last = first + value.size();
 
-    errno = 0;
-
-    char* pos = nullptr;
-    unsigned long r = strtoul(value.c_str(), &pos, base);
-    if (nullptr == pos
-     || 0 != *pos
-     || r < std::numeric_limits<std::uint32_t>::min()
-     || r > std::numeric_limits<std::uint32_t>::max()
-     || (ULONG_MAX == r && ERANGE == errno)) {
-        return std::nullopt;
+    // from_chars() does not accept the explicit plus sign strtod() does.
+    if (first != last && '+' == *first) {
+        ++first;
+        if (first != last && '-' == *first) {
+            return std::errc::invalid_argument;
+        }
     }
-    return r;
-}
 
-std::optional<std::uint64_t> hlib::stoui64(std::string const& value, int base, std::nothrow_t)
-{
-    if (true == value.empty() || isspace(value.front())) {
-        return std::nullopt;
+    if (first == last) {
+        return std::errc::invalid_argument;
     }
 
-    errno = 0;
-
-    char* pos = nullptr;
-    unsigned long long r = strtoull(value.c_str(), &pos, base);
-    if (nullptr == pos
-     || 0 != *pos
-     || (ULLONG_MAX == r && ERANGE == errno)) {
-        return std::nullopt;
+    std::from_chars_result r = std::from_chars(first, last, result);
+    if (last != r.ptr) {
+        return std::errc::invalid_argument;
     }
-    return r;
+    return r.ec;
 }
 
-std::optional<float> hlib::stof32(std::string const& value, std::nothrow_t)
+template<typename T>
+std::optional<T> to_optional(std::errc ec, T value) noexcept
 {
-    if (true == value.empty() || isspace(value.front())) {
+    if (std::errc() != ec) {
         return std::nullopt;
     }
-
-    char* pos = nullptr;
-    float r = strtof(value.c_str(), &pos);
-    if (nullptr == pos
-     || 0 != *pos
-     || ERANGE == errno) {
-        return std::nullopt;
-    }
-    return r;
+    return value;
 }
 
-std::optional<double> hlib::stof64(std::string const& value, std::nothrow_t)
+template<typename T>
+T value_or_throw(std::errc ec, T value, char const* what)
 {
-    if (true == value.empty() || isspace(value.front())) {
-        return std::nullopt;
+    if (std::errc() == ec) {
+        return value;
     }
-
-    char* pos = nullptr;
-    double r = strtod(value.c_str(), &pos);
-    if (nullptr == pos
-     || 0 != *pos
-     || ERANGE == errno) {
-        return std::nullopt;
+    else if (std::errc::result_out_of_range == ec) {
+        throw std::range_error(what);
     }
-    return r;
+
+    throw std::invalid_argument(what);
 }
 
-bool hlib::stob(std::string const& value)
+} // namespace
+
+//
+// Public
+//
+std::optional<bool> hlib::stob(std::string_view value, std::nothrow_t)
 {
     if ("true" == value) {
         return true;
@@ -235,193 +183,159 @@ bool hlib::stob(std::string const& value)
         return false;
     }
 
-    throw std::invalid_argument("stob");
+    return std::nullopt;
 }
 
-std::int8_t hlib::stoi8(std::string const& value, int base)
+std::optional<std::int8_t> hlib::stoi8(std::string_view value, int base, std::nothrow_t)
 {
-    if (true == value.empty() || isspace(value.front())) {
-        throw std::invalid_argument("stoi8");
-    }
-
-    char* pos = nullptr;
-    long r = strtol(value.c_str(), &pos, base);
-    if (nullptr == pos || 0 != *pos) {
-        throw std::invalid_argument("stoi8");
-    }
-    if (r < std::numeric_limits<std::int8_t>::min()
-     || r > std::numeric_limits<std::int8_t>::max()) {
-        throw std::range_error("stoi8");
-    }
-    return r;
+    std::int8_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return to_optional(ec, r);
 }
 
-std::int16_t hlib::stoi16(std::string const& value, int base)
+std::optional<std::int16_t> hlib::stoi16(std::string_view value, int base, std::nothrow_t)
 {
-    if (true == value.empty() || isspace(value.front())) {
-        throw std::invalid_argument("stoi16");
-    }
-
-    char* pos = nullptr;
-    long r = strtol(value.c_str(), &pos, base);
-    if (nullptr == pos || 0 != *pos) {
-        throw std::invalid_argument("stoi16");
-    }
-    if (r < std::numeric_limits<std::int16_t>::min()
-     || r > std::numeric_limits<std::int16_t>::max()) {
-        throw std::range_error("stoi16");
-    }
-    return r;
+    std::int16_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return to_optional(ec, r);
 }
 
-std::int32_t hlib::stoi32(std::string const& value, int base)
+std::optional<std::int32_t> hlib::stoi32(std::string_view value, int base, std::nothrow_t)
 {
-    if (true == value.empty() || isspace(value.front())) {
-        throw std::invalid_argument("stoi32");
-    }
-
-    errno = 0;
+    std::int32_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return to_optional(ec, r);
+}
 
-    char* pos = nullptr;
-    long r = strtol(value.c_str(), &pos, base);
-    if (nullptr == pos || 0 != *pos) {
-        throw std::invalid_argument("stoi32");
-    }
-    if (r < std::numeric_limits<std::int32_t>::min()
-     || r > std::numeric_limits<std::int32_t>::max()
-     || ((LONG_MIN == r || LONG_MAX == r) && ERANGE == errno)) {
-        throw std::range_error("stoi32");
-    }
-    return r;
+std::optional<std::int64_t> hlib::stoi64(std::string_view value, int base, std::nothrow_t)
+{
+    std::int64_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return to_optional(ec, r);
 }
 
-std::int64_t hlib::stoi64(std::string const& value, int base)
+std::optional<std::uint8_t> hlib::stoui8(std::string_view value, int base, std::nothrow_t)
 {
-    if (true == value.empty() || isspace(value.front())) {
-        throw std::invalid_argument("stoi64");
-    }
+    std::uint8_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return to_optional(ec, r);
+}
 
-    errno = 0;
+std::optional<std::uint16_t> hlib::stoui16(std::string_view value, int base, std::nothrow_t)
+{
+    std::uint16_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return to_optional(ec, r);
+}
 
-    char* pos = nullptr;
-    long long r = strtoll(value.c_str(), &pos, base);
-    if (nullptr == pos || 0 != *pos) {
-        throw std::invalid_argument("stoi64");
-    }
-    if (((LLONG_MIN == r || LLONG_MAX == r) && ERANGE == errno)) {
-        throw std::range_error("stoi64");
-    }
-    return r;
+std::optional<std::uint32_t> hlib::stoui32(std::string_view value, int base, std::nothrow_t)
+{
+    std::uint32_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return to_optional(ec, r);
 }
 
-std::uint8_t hlib::stoui8(std::string const& value, int base)
+std::optional<std::uint64_t> hlib::stoui64(std::string_view value, int base, std::nothrow_t)
 {
-    if (true == value.empty() || isspace(value.front())) {
-        throw std::invalid_argument("stoui8");
-    }
+    std::uint64_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return to_optional(ec, r);
+}
 
-    char* pos = nullptr;
-    unsigned long r = strtoul(value.c_str(), &pos, base);
-    if (nullptr == pos || 0 != *pos) {
-        throw std::invalid_argument("stoui8");
-    }
-    if (r < std::numeric_limits<std::uint8_t>::min()
-     || r > std::numeric_limits<std::uint8_t>::max()) {
-        throw std::range_error("stoui8");
-    }
-    return r;
+std::optional<float> hlib::stof32(std::string_view value, std::nothrow_t)
+{
+    float r = 0;
+    std::errc ec = parse_float(value, r);
+    return to_optional(ec, r);
 }
 
-std::uint16_t hlib::stoui16(std::string const& value, int base)
+std::optional<double> hlib::stof64(std::string_view value, std::nothrow_t)
 {
-    if (true == value.empty() || isspace(value.front())) {
-        throw std::invalid_argument("stoui16");
-    }
+    double r = 0;
+    std::errc ec = parse_float(value, r);
+    return to_optional(ec, r);
+}
 
-    char* pos = nullptr;
-    unsigned long r = strtoul(value.c_str(), &pos, base);
-    if (nullptr == pos || 0 != *pos) {
-        throw std::invalid_argument("stoui16");
+bool hlib::stob(std::string_view value)
+{
+    if ("true" == value) {
+        return true;
     }
-    if (r < std::numeric_limits<std::uint16_t>::min()
-     || r > std::numeric_limits<std::uint16_t>::max()) {
-        throw std::range_error("stoui16");
+    else if ("false" == value) {
+        return false;
     }
-    return r;
+
+    throw std::invalid_argument("stob");
 }
 
-std::uint32_t hlib::stoui32(std::string const& value, int base)
+std::int8_t hlib::stoi8(std::string_view value, int base)
 {
-    if (true == value.empty() || isspace(value.front())) {
-        throw std::invalid_argument("stoui32");
-    }
+    std::int8_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return value_or_throw(ec, r, "stoi8");
+}
 
-    errno = 0;
+std::int16_t hlib::stoi16(std::string_view value, int base)
+{
+    std::int16_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return value_or_throw(ec, r, "stoi16");
+}
 
-    char* pos = nullptr;
-    unsigned long r = strtoul(value.c_str(), &pos, base);
-    if (nullptr == pos || 0 != *pos) {
-        throw std::invalid_argument("stoui32");
-    }
-    if (r < std::numeric_limits<std::uint32_t>::min()
-     || r > std::numeric_limits<std::uint32_t>::max()
-     || (ULONG_MAX == r && ERANGE == errno)) {
-        throw std::range_error("stoui32");
-    }
-    return r;
+std::int32_t hlib::stoi32(std::string_view value, int base)
+{
+    std::int32_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return value_or_throw(ec, r, "stoi32");
 }
 
-std::uint64_t hlib::stoui64(std::string const& value, int base)
+std::int64_t hlib::stoi64(std::string_view value, int base)
 {
-    if (true == value.empty() || isspace(value.front())) {
-        throw std::invalid_argument("stoui32");
-    }
+    std::int64_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return value_or_throw(ec, r, "stoi64");
+}
 
-    errno = 0;
+std::uint8_t hlib::stoui8(std::string_view value, int base)
+{
+    std::uint8_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return value_or_throw(ec, r, "stoui8");
+}
 
-    char* pos = nullptr;
-    unsigned long long r = strtoull(value.c_str(), &pos, base);
-    if (nullptr == pos || 0 != *pos) {
-        throw std::invalid_argument("stoui32");
-    }
-    if ((ULLONG_MAX == r && ERANGE == errno)) {
-        throw std::range_error("stoui32");
-    }
-    return r;
+std::uint16_t hlib::stoui16(std::string_view value, int base)
+{
+    std::uint16_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return value_or_throw(ec, r, "stoui16");
 }
 
-float hlib::stof32(std::string const& value)
+std::uint32_t hlib::stoui32(std::string_view value, int base)
 {
-    if (true == value.empty() || isspace(value.front())) {
-        throw std::invalid_argument("stof32");
-    }
+    std::uint32_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return value_or_throw(ec, r, "stoui32");
+}
 
-    char* pos = nullptr;
-    float r = strtof(value.c_str(), &pos);
-    if (nullptr == pos || 0 != *pos) {
-        throw std::invalid_argument("stof32");
-    }
-    if (ERANGE == errno) {
-        throw std::range_error("stof32");
-    }
-    return r;
+std::uint64_t hlib::stoui64(std::string_view value, int base)
+{
+    std::uint64_t r = 0;
+    std::errc ec = parse_integer(value, base, r);
+    return value_or_throw(ec, r, "stoui64");
 }
 
-double hlib::stof64(std::string const& value)
+float hlib::stof32(std::string_view value)
 {
-    if (true == value.empty() || isspace(value.front())) {
-        throw std::invalid_argument("stof64");
-    }
+    float r = 0;
+    std::errc ec = parse_float(value, r);
+    return value_or_throw(ec, r, "stof32");
+}
 
-    char* pos = nullptr;
-    double r = strtod(value.c_str(), &pos);
-    if (nullptr == pos || 0 != *pos) {
-        throw std::invalid_argument("stof64");
-    }
-    if (ERANGE == errno) {
-        throw std::range_error("stof64");
-    }
-    return r;
+double hlib::stof64(std::string_view value)
+{
+    double r = 0;
+    std::errc ec = parse_float(value, r);
+    return value_or_throw(ec, r, "stof64");
 }
 
 bool hlib::iequals(std::string const &lhs, std::string const& rhs)
@@ -574,38 +488,69 @@ std::string hlib::trim(std::string string, std::string const& chars)
 std::vector<std::string> hlib::split(std::string const& string, std::function<bool(char)> const& is_delimiter, bool filter_empty)
 {
     std::vector<std::string> tokens;
-    std::string token;
-    std::size_t count = 0;
 
-    if (true == string.empty()) {
-        return {};
+    for (std::string_view token : split_view(string, std::cref(is_delimiter), filter_empty)) {
+        tokens.emplace_back(token);
     }
 
-    for (std::string::size_type i = 0; i < string.length(); ++i) {
-        char c = string[i];
-        if (true == is_delimiter(c)) {
-            if (false == token.empty() || filter_empty == false) {
-                tokens.emplace_back(std::move(token));
-                token.reserve(string.length() - i);
-            }
-            ++count;
-        }
-        else {
-            token += c;
-        }
-    }
+    return tokens;
+}
 
-    if (false == token.empty()
-     || (count > 0 && filter_empty == false)) {
-        tokens.emplace_back(std::move(token));
+std::vector<std::string> hlib::split(std::string const& string, char delimiter, bool filter_empty)
+{
+    std::vector<std::string> tokens;
+
+    for (std::string_view token : split_view(string, delimiter, filter_empty)) {
+        tokens.emplace_back(token);
     }
 
     return tokens;
 }
 
-std::vector<std::string> hlib::split(std::string const& string, char delimiter, bool filter_empty)
+std::string_view hlib::trim_left_view(std::string_view string, std::string_view chars) noexcept
+{
+    std::string_view::size_type pos = string.find_first_not_of(chars);
+    return std::string_view::npos != pos ? string.substr(pos) : std::string_view();
+}
+
+std::string_view hlib::trim_right_view(std::string_view string, std::string_view chars) noexcept
 {
-    return split(string, [delimiter](char c) noexcept { return delimiter == c; }, filter_empty);
+    std::string_view::size_type pos = string.find_last_not_of(chars);
+    return std::string_view::npos != pos ? string.substr(0, pos + 1) : std::string_view();
+}
+
+std::string_view hlib::trim_view(std::string_view string, std::string_view chars) noexcept
+{
+    return trim_right_view(trim_left_view(string, chars), chars);
+}
+
+char const* hlib::find_delimiter(char const* first, char const* last, IsSpace const& is_delimiter) noexcept
+{
+#if defined(__SSE2__)
+    // Matches ' ' and '\t'..'\r' in 16 byte blocks. The signed compares
+    // leave bytes >= 0x80 unmatched.
+    __m128i const space = _mm_set1_epi8(' ');
+    __m128i const below = _mm_set1_epi8('\t' - 1);
+    __m128i const above = _mm_set1_epi8('\r' + 1);
+
+    for (; last - first >= 16; first += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+        __m128i match = _mm_or_si128(_mm_cmpeq_epi8(block, space),
+            _mm_and_si128(_mm_cmpgt_epi8(block, below), _mm_cmplt_epi8(block, above)));
+
+        int mask = _mm_movemask_epi8(match);
+        if (0 != mask) {
+            return first + __builtin_ctz(static_cast<unsigned int>(mask));
+        }
+    }
+#endif
+
+    for (; first != last; ++first) {
+        if (true == is_delimiter(*first)) {
+            break;
+        }
+    }
+    return first;
 }
 
 std::string hlib::fill_left(std::string const& string, std::size_t length, char c)
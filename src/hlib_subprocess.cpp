@@ -22,15 +22,25 @@
 // SOFTWARE.
 //
 #include "hlib/subprocess.hpp"
-#include "hlib/container.hpp"
 #include "hlib/error.hpp"
 #include "hlib/file.hpp"
 #include "hlib/memory.hpp"
 #include <array>
-#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#ifndef CLOSE_RANGE_CLOEXEC
+#define CLOSE_RANGE_CLOEXEC (1U << 2)
+#endif
+
 using namespace hlib;
 
 namespace
@@ -55,6 +65,432 @@ std::vector<char const*> to_argv(std::string const& command, std::vector<std::st
     return argv;
 }
 
+// Everything the child needs, prepared by the parent. The child shares the
+// parent's memory until it calls execvp(), so it must not allocate, must not
+// modify any of the parent's objects and may only call async-signal-safe
+// functions.
+struct SpawnContext
+{
+    char const* const* argv;
+    std::array<int, 3> stdio;
+    std::array<int, 6> pipes;
+    std::set<int> const* keep_fds;
+    int max_fd;
+    sigset_t signal_mask;
+    int exec_error;
+};
+
+// Closes file descriptors [first, last] or, with CLOSE_RANGE_CLOEXEC in
+// flags, marks them close-on-exec. Prefers close_range(), then
+// /proc/self/fd enumeration and finally a brute force loop.
+void close_fd_range(unsigned int first, unsigned int last, int max_fd, unsigned int flags) noexcept
+{
+    if (first > last) {
+        return;
+    }
+
+    auto close_fd = [flags](int fd) {
+        if (0 != (CLOSE_RANGE_CLOEXEC & flags)) {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        else {
+            ::close(fd);
+        }
+    };
+
+#ifdef SYS_close_range
+    if (0 == syscall(SYS_close_range, first, last, flags)) {
+        return;
+    }
+#endif
+
+    int dir_fd = ::open("/proc/self/fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (-1 != dir_fd) {
+        alignas(8) char buffer[4096];
+        long size;
+
+        while ((size = syscall(SYS_getdents64, dir_fd, buffer, sizeof(buffer))) > 0) {
+            for (long offset = 0; offset < size;) {
+                struct dirent64 const* entry = reinterpret_cast<struct dirent64 const*>(buffer + offset);
+                offset += entry->d_reclen;
+
+                unsigned int fd = 0;
+                char const* name = entry->d_name;
+                if ('.' == *name) {
+                    continue;
+                }
+                for (; '\0' != *name; ++name) {
+                    fd = fd * 10 + static_cast<unsigned int>(*name - '0');
+                }
+
+                if (fd >= first && fd <= last && static_cast<int>(fd) != dir_fd) {
+                    close_fd(static_cast<int>(fd));
+                }
+            }
+        }
+
+        ::close(dir_fd);
+        if (0 == size) {
+            return;
+        }
+    }
+
+    for (unsigned int fd = first; fd <= last && fd < static_cast<unsigned int>(max_fd); ++fd) {
+        close_fd(static_cast<int>(fd));
+    }
+}
+
+// Signal handlers belong to the parent, restore default dispositions.
+void reset_signal_handlers() noexcept
+{
+    for (int signal = 1; signal < NSIG; ++signal) {
+        struct sigaction action;
+        if (0 == sigaction(signal, nullptr, &action)
+         && SIG_IGN != action.sa_handler
+         && SIG_DFL != action.sa_handler) {
+            action.sa_handler = SIG_DFL;
+            action.sa_flags = 0;
+            sigaction(signal, &action, nullptr);
+        }
+    }
+}
+
+int spawn_child(void* argument) noexcept
+{
+    SpawnContext* context = static_cast<SpawnContext*>(argument);
+
+    // Restore default signal dispositions before unblocking signals.
+    reset_signal_handlers();
+    sigprocmask(SIG_SETMASK, &context->signal_mask, nullptr);
+
+    // Change stdin, stdout and stderr to use the pipes.
+    for (int fd = 0; fd < 3; ++fd) {
+        if (-1 == dup2(context->stdio[fd], fd)) {
+            context->exec_error = errno;
+            _exit(127);
+        }
+    }
+
+    // Close pipes.
+    for (int fd : context->pipes) {
+        if (fd > STDERR_FILENO) {
+            ::close(fd);
+        }
+    }
+
+    // Close file descriptors on exec, except for those on the keep list.
+    if (nullptr != context->keep_fds) {
+        unsigned int first = 0;
+
+        for (int fd : *context->keep_fds) {
+            if (fd >= 0 && static_cast<unsigned int>(fd) >= first) {
+                if (static_cast<unsigned int>(fd) > first) {
+                    close_fd_range(first, static_cast<unsigned int>(fd) - 1, context->max_fd, CLOSE_RANGE_CLOEXEC);
+                }
+                first = static_cast<unsigned int>(fd) + 1;
+            }
+        }
+
+        close_fd_range(first, ~0U, context->max_fd, CLOSE_RANGE_CLOEXEC);
+    }
+
+    // Execute process.
+    execvp(context->argv[0], const_cast<char* const*>(context->argv));
+
+    context->exec_error = errno;
+    _exit(127);
+}
+
+// Starts the child with clone(CLONE_VM | CLONE_VFORK) like posix_spawn()
+// does. It avoids copying the parent's page tables and returns once the
+// child has called execvp() or has failed doing so. Returns the child's pid
+// or -1 with errno set. Does not allocate, so it can be used by the
+// forkserver.
+int clone_spawn(SpawnContext& context) noexcept
+{
+    // The child only needs a small stack for execvp().
+    constexpr std::size_t stack_size = 256 * 1024;
+
+    void* stack = mmap(nullptr, stack_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (MAP_FAILED == stack) {
+        return -1;
+    }
+
+    // Block all signals so no handler runs in the child on the parent's memory.
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &context.signal_mask);
+
+    context.exec_error = 0;
+
+    int pid = clone(&spawn_child, static_cast<char*>(stack) + stack_size, CLONE_VM | CLONE_VFORK | SIGCHLD, &context);
+    int error = errno;
+
+    pthread_sigmask(SIG_SETMASK, &context.signal_mask, nullptr);
+    munmap(stack, stack_size);
+
+    if (-1 != pid && 0 != context.exec_error) {
+        int status;
+        HVERIFY(pid == waitpid(pid, &status, 0));
+
+        pid = -1;
+        error = context.exec_error;
+    }
+
+    errno = error;
+    return pid;
+}
+
+Result<int> spawn(SpawnContext& context) noexcept
+{
+    int pid = clone_spawn(context);
+    if (-1 == pid) {
+        return make_error(errno, 0 != context.exec_error ? "execvp() failed" : "clone() failed");
+    }
+
+    return pid;
+}
+
+// Translates a wait status to a return code, like a shell does.
+int to_return_code(int status) noexcept
+{
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    if (WIFSIGNALED(status)) {
+        return 128 + WTERMSIG(status);
+    }
+
+    return status;
+}
+
+//
+// Forkserver
+//
+// Requests and responses are exchanged over a SOCK_SEQPACKET socket. A
+// request is followed by the NUL terminated argv strings and passes the
+// child's stdin, stdout and stderr as SCM_RIGHTS.
+//
+struct ForkserverRequest
+{
+    std::uint32_t id;
+    std::uint32_t argc;
+};
+
+struct ForkserverResponse
+{
+    enum Type : std::uint32_t
+    {
+        Started,
+        CloneFailed,
+        ExecFailed,
+        Exited
+    };
+
+    Type type;
+    std::uint32_t id;
+    std::int32_t pid;
+    std::int32_t value;
+};
+
+constexpr std::size_t forkserver_request_size = 64 * 1024;
+
+int forkserver_signal_fd = -1;
+
+void forkserver_on_child(int /* signal */) noexcept
+{
+    int const error = errno;
+    char const byte = 0;
+
+    ssize_t size = ::write(forkserver_signal_fd, &byte, 1);
+    (void)size;
+
+    errno = error;
+}
+
+void forkserver_respond(int fd, ForkserverResponse const& response) noexcept
+{
+    while (-1 == send(fd, &response, sizeof(response), MSG_NOSIGNAL) && EINTR == errno) {
+    }
+}
+
+ForkserverResponse forkserver_spawn(char const* buffer, std::size_t size, std::array<int, 3> const& stdio,
+    char const** argv, std::size_t argv_size, int max_fd) noexcept
+{
+    ForkserverResponse response{ ForkserverResponse::CloneFailed, 0, -1, EINVAL };
+
+    if (size < sizeof(ForkserverRequest)
+     || -1 == stdio[0] || -1 == stdio[1] || -1 == stdio[2]) {
+        return response;
+    }
+
+    ForkserverRequest request;
+    std::memcpy(&request, buffer, sizeof(request));
+    response.id = request.id;
+
+    if (0 == request.argc || request.argc >= argv_size) {
+        return response;
+    }
+
+    // Split argv strings.
+    char const* string = buffer + sizeof(request);
+    char const* end = buffer + size;
+
+    for (std::uint32_t i = 0; i < request.argc; ++i) {
+        char const* terminator = static_cast<char const*>(std::memchr(string, '\0', end - string));
+        if (nullptr == terminator) {
+            return response;
+        }
+
+        argv[i] = string;
+        string = terminator + 1;
+    }
+    argv[request.argc] = nullptr;
+
+    // All of the forkserver's file descriptors are close-on-exec.
+    SpawnContext context
+    {
+        argv,
+        stdio,
+        { stdio[0], stdio[1], stdio[2], -1, -1, -1 },
+        nullptr,
+        max_fd,
+        {},
+        0
+    };
+
+    int pid = clone_spawn(context);
+    if (-1 == pid) {
+        response.type = 0 != context.exec_error ? ForkserverResponse::ExecFailed : ForkserverResponse::CloneFailed;
+        response.value = errno;
+        return response;
+    }
+
+    response.type = ForkserverResponse::Started;
+    response.pid = pid;
+    response.value = 0;
+    return response;
+}
+
+// The forkserver's main loop. The forkserver may have been forked from a
+// multi-threaded process and shall therefore not allocate, its buffers are
+// allocated before forking.
+[[noreturn]] void forkserver_run(int socket_fd, char* buffer, char const** argv, std::size_t argv_size) noexcept
+{
+    int const max_fd = static_cast<int>(sysconf(_SC_OPEN_MAX));
+
+    reset_signal_handlers();
+
+    // Keep stdio and the socket only.
+    if (3 != socket_fd) {
+        if (-1 == dup3(socket_fd, 3, O_CLOEXEC)) {
+            _exit(EXIT_FAILURE);
+        }
+        socket_fd = 3;
+    }
+    close_fd_range(4, ~0U, max_fd, 0);
+
+    // Wake poll() on SIGCHLD.
+    int signal_pipe[2];
+    if (-1 == pipe2(signal_pipe, O_CLOEXEC | O_NONBLOCK)) {
+        _exit(EXIT_FAILURE);
+    }
+    forkserver_signal_fd = signal_pipe[1];
+
+    struct sigaction action{};
+    action.sa_handler = &forkserver_on_child;
+    action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGCHLD, &action, nullptr);
+
+    while (true) {
+        pollfd fds[2]{
+            { socket_fd, POLLIN, 0 },
+            { signal_pipe[0], POLLIN, 0 }
+        };
+
+        if (-1 == poll(fds, 2, -1)) {
+            if (EINTR == errno) {
+                continue;
+            }
+            _exit(EXIT_FAILURE);
+        }
+
+        // Reap exited children.
+        if (0 != fds[1].revents) {
+            char bytes[64];
+            while (read(signal_pipe[0], bytes, sizeof(bytes)) > 0) {
+            }
+
+            int status;
+            int pid;
+            while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+                forkserver_respond(socket_fd, { ForkserverResponse::Exited, 0, pid, status });
+            }
+        }
+
+        if (0 == fds[0].revents) {
+            continue;
+        }
+
+        // Receive and execute request.
+        alignas(cmsghdr) char control[CMSG_SPACE(3 * sizeof(int))];
+        iovec iov{ buffer, forkserver_request_size };
+
+        msghdr message{};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        ssize_t size = recvmsg(socket_fd, &message, MSG_CMSG_CLOEXEC);
+        if (-1 == size && EINTR == errno) {
+            continue;
+        }
+        if (size <= 0) {
+            // Pool has closed the socket.
+            _exit(EXIT_SUCCESS);
+        }
+
+        // Get the child's stdin, stdout and stderr. Any other descriptors
+        // received are closed, as are all of them when the request is
+        // rejected, so that none leak into later children.
+        std::array<int, 3> stdio{ -1, -1, -1 };
+        bool valid = 0 == ((MSG_TRUNC | MSG_CTRUNC) & message.msg_flags);
+
+        for (cmsghdr* header = CMSG_FIRSTHDR(&message); nullptr != header; header = CMSG_NXTHDR(&message, header)) {
+            if (SOL_SOCKET != header->cmsg_level || SCM_RIGHTS != header->cmsg_type) {
+                continue;
+            }
+
+            std::size_t const count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            if (true == valid && -1 == stdio[0] && stdio.size() == count) {
+                std::memcpy(stdio.data(), CMSG_DATA(header), sizeof(stdio));
+                continue;
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+                int fd;
+                std::memcpy(&fd, CMSG_DATA(header) + i * sizeof(int), sizeof(int));
+                ::close(fd);
+            }
+            valid = false;
+        }
+
+        if (false == valid) {
+            size = 0;
+        }
+
+        forkserver_respond(socket_fd, forkserver_spawn(buffer, static_cast<std::size_t>(size), stdio, argv, argv_size, max_fd));
+
+        for (int fd : stdio) {
+            if (-1 != fd) {
+                ::close(fd);
+            }
+        }
+    }
+}
+
 } // namespace
 
 //
@@ -91,74 +527,54 @@ Result<int> Subprocess::run(std::vector<char const*> argv)
     file::Pipe stdout_pipe(true);
     file::Pipe stderr_pipe(true);
 
-    // Fork.
-    switch (m_pid = fork()) {
-    case -1:
-        return make_system_error(errno, "fork() failed");
-
-    case 0:
-        // Change stdin, stdout and stderr to use the pipes.
-        HVERIFY(-1 != dup2(stdin_pipe.get<0>().get(), STDIN_FILENO));
-        HVERIFY(-1 != dup2(stdout_pipe.get<1>().get(), STDOUT_FILENO));
-        HVERIFY(-1 != dup2(stderr_pipe.get<1>().get(), STDERR_FILENO));
-
-        // Close pipes.
-        stdin_pipe.close();
-        stdout_pipe.close();
-        stderr_pipe.close();
-
-        // Close file descriptors?
-        if (true == m_close_fds) {
-            int const max_fd = sysconf(_SC_OPEN_MAX);
-
-            for (int fd = 0; fd < max_fd; ++fd) {
-                // Don't close file descriptors on the exception list.
-                if (true == container::contains(m_close_fds_exceptions, fd)) {
-                    continue;
-                }
-                ::close(fd);
-            }
-        }
-
-        // Execute process.
-        HVERIFY(0 == execvp(argv[0], const_cast<char * const *>(argv.data())));
+    SpawnContext context
+    {
+        argv.data(),
+        { stdin_pipe[0], stdout_pipe[1], stderr_pipe[1] },
+        { stdin_pipe[0], stdin_pipe[1], stdout_pipe[0], stdout_pipe[1], stderr_pipe[0], stderr_pipe[1] },
+        true == m_close_fds ? &m_close_fds_exceptions : nullptr,
+        static_cast<int>(sysconf(_SC_OPEN_MAX)),
+        {},
+        0
+    };
+
+    Result<int> pid = spawn(context);
+    if (true == pid.failure()) {
+        return pid.error();
+    }
 
-        fprintf(stderr, "execvp() failed (%s)", get_error_string().c_str());
-        abort();
-        return -1;
+    m_pid = pid.value();
 
-    default:
-        // Transfer relevant pipe sides to local file descriptors.
-        m_stdin->open(std::move(stdin_pipe.get<1>()));      // Parent is writer.
-        m_stdout->open(std::move(stdout_pipe.get<0>()));    // Parent is reader.
-        m_stderr->open(std::move(stderr_pipe.get<0>()));    // Parent is reader.
+    // Transfer relevant pipe sides to local file descriptors.
+    m_stdin->open(std::move(stdin_pipe.get<1>()));      // Parent is writer.
+    m_stdout->open(std::move(stdout_pipe.get<0>()));    // Parent is reader.
+    m_stderr->open(std::move(stderr_pipe.get<0>()));    // Parent is reader.
 
-        // Close pipes.
-        stdin_pipe.close();
-        stdout_pipe.close();
-        stderr_pipe.close();
+    // Close pipes.
+    stdin_pipe.close();
+    stdout_pipe.close();
+    stderr_pipe.close();
 
-        // Add source and sinks.
-        if (nullptr != m_stdin_source) {
-            m_stdin->write(m_stdin_source, std::bind(&Subprocess::onWritten, this, _1));
-        }
-        if (nullptr != m_stdout_sink) {
-            m_stdout->read(m_stdout_sink);
-        }
-        if (nullptr != m_stderr_sink) {
-            m_stderr->read(m_stderr_sink);
-        }
-
-        m_state = Running;
+    // Add source and sinks.
+    if (nullptr != m_stdin_source) {
+        m_stdin->write(m_stdin_source, std::bind(&Subprocess::onWritten, this, _1));
+    }
+    if (nullptr != m_stdout_sink) {
+        m_stdout->read(m_stdout_sink);
+    }
+    if (nullptr != m_stderr_sink) {
+        m_stderr->read(m_stderr_sink);
+    }
 
-        if (nullptr == m_event_loop_intern) {
-            return 0;
-        }
+    m_state = Running;
 
-        m_event_loop_intern->flush();
-        m_event_loop_intern->dispatch();
-        return wait();
+    if (nullptr == m_event_loop_intern) {
+        return 0;
     }
+
+    m_event_loop_intern->flush();
+    m_event_loop_intern->dispatch();
+    return wait();
 }
 
 //
@@ -338,7 +754,7 @@ Result<int> Subprocess::wait(std::nothrow_t) noexcept
     m_state = Failed;
 
     if (m_pid != waitpid(m_pid, &status, 0)) {
-        return make_system_error(errno, "waitpid() failed");
+        return make_error(errno, "waitpid() failed");
     }
 
     if (WIFEXITED(status)) {
@@ -363,7 +779,7 @@ Result<> Subprocess::kill(int signal, std::nothrow_t) noexcept
     }
 
     if (-1 == ::kill(m_pid, signal)) {
-        return make_system_error(errno, "kill() failed");
+        return make_error(errno, "kill() failed");
     }
 
     return Result<>();
@@ -379,3 +795,438 @@ void Subprocess::kill(int signal)
     success_or_throw(kill(signal, std::nothrow));
 }
 
+
+//
+// Implementation (SubprocessPool)
+//
+void SubprocessPool::onResponse(int fd, std::uint32_t /* events */)
+{
+    ForkserverResponse response;
+
+    while (true) {
+        ssize_t size = recv(fd, &response, sizeof(response), MSG_DONTWAIT);
+        if (-1 == size) {
+            if (EINTR == errno) {
+                continue;
+            }
+            if (EAGAIN == errno || EWOULDBLOCK == errno) {
+                return;
+            }
+            break;
+        }
+        if (sizeof(response) != size) {
+            break;
+        }
+
+        switch (response.type) {
+        case ForkserverResponse::Started:
+            {
+                auto it = m_running.find(response.id);
+                if (m_running.end() != it) {
+                    it->second->pid = response.pid;
+                    m_pids.emplace(response.pid, response.id);
+                }
+            }
+            break;
+
+        case ForkserverResponse::CloneFailed:
+            complete(response.id, make_error(response.value, "clone() failed"));
+            break;
+
+        case ForkserverResponse::ExecFailed:
+            complete(response.id, make_error(response.value, "execvp() failed"));
+            break;
+
+        case ForkserverResponse::Exited:
+            {
+                auto pid = m_pids.find(response.pid);
+                if (m_pids.end() == pid) {
+                    break;
+                }
+
+                std::uint32_t id = pid->second;
+                Job& job = *m_running.at(id);
+                job.exited = true;
+                job.status = response.value;
+
+                // Complete when stdout and stderr have been drained.
+                if (-1 == job.fds[Subprocess::StdOut] && -1 == job.fds[Subprocess::StdErr]) {
+                    complete(id, to_return_code(job.status));
+                }
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // The forkserver exited, fail all subprocesses.
+    stop();
+
+    while (false == m_running.empty()) {
+        complete(m_running.begin()->first, make_error(ECHILD, "Forkserver exited"));
+    }
+}
+
+void SubprocessPool::onPipe(std::uint32_t id, Subprocess::Pipe pipe, int fd, std::uint32_t /* events */)
+{
+    auto it = m_running.find(id);
+    if (m_running.end() == it) {
+        return;
+    }
+
+    Job& job = *it->second;
+
+    if (Subprocess::StdIn == pipe) {
+        while (job.input_offset < job.input.size()) {
+            ssize_t size = ::write(fd, static_cast<std::uint8_t const*>(job.input.data()) + job.input_offset,
+                job.input.size() - job.input_offset);
+            if (-1 == size) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                if (EAGAIN == errno || EWOULDBLOCK == errno) {
+                    return;
+                }
+                break;
+            }
+
+            job.input_offset += static_cast<std::size_t>(size);
+        }
+
+        // All input written or the subprocess stopped reading.
+        closePipe(job, pipe);
+        return;
+    }
+
+    // Drain the pipe.
+    constexpr std::size_t read_size = 64 * 1024;
+    Buffer& buffer = Subprocess::StdOut == pipe ? job.output : job.error;
+
+    while (true) {
+        void* data = buffer.extend(read_size, std::nothrow);
+        if (nullptr == data) {
+            break;
+        }
+
+        ssize_t size = ::read(fd, data, read_size);
+        if (size > 0) {
+            buffer.resize(buffer.size() + static_cast<std::size_t>(size));
+            continue;
+        }
+        if (-1 == size) {
+            if (EINTR == errno) {
+                continue;
+            }
+            if (EAGAIN == errno || EWOULDBLOCK == errno) {
+                return;
+            }
+        }
+        break;
+    }
+
+    closePipe(job, pipe);
+
+    // Complete when the subprocess exited and stdout and stderr have been drained.
+    if (true == job.exited && -1 == job.fds[Subprocess::StdOut] && -1 == job.fds[Subprocess::StdErr]) {
+        complete(id, to_return_code(job.status));
+    }
+}
+
+void SubprocessPool::start(std::unique_ptr<Job> job)
+{
+    using namespace std::placeholders;
+
+    std::uint32_t const id = job->id;
+
+    // Create pipes for stdin, stdout and stderr.
+    std::array<int, 6> pipes{ -1, -1, -1, -1, -1, -1 };
+    auto close_pipes = [&pipes] {
+        for (int& fd : pipes) {
+            if (-1 != fd) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+    };
+
+    for (std::size_t i = 0; i < pipes.size(); i += 2) {
+        if (-1 == pipe2(&pipes[i], O_CLOEXEC)) {
+            int const error = errno;
+            close_pipes();
+
+            m_running.emplace(id, std::move(job));
+            complete(id, make_error(error, "pipe2() failed"));
+            return;
+        }
+    }
+
+    job->fds = { pipes[1], pipes[2], pipes[4] };
+    Job& running = *m_running.emplace(id, std::move(job)).first->second;
+
+    auto close_child_pipes = [&pipes] {
+        ::close(pipes[0]);
+        ::close(pipes[3]);
+        ::close(pipes[5]);
+    };
+
+    // Multiplex the parent's pipe sides on the event loop before spawning,
+    // so that no child runs whose output cannot be drained.
+    bool const success = with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        for (Subprocess::Pipe pipe : { Subprocess::StdIn, Subprocess::StdOut, Subprocess::StdErr }) {
+            int const fd = running.fds[pipe];
+            file::fd_set_non_blocking(fd, true);
+            loop.add(fd, Subprocess::StdIn == pipe ? EventLoop::Write : EventLoop::Read,
+                std::bind(&SubprocessPool::onPipe, this, id, pipe, _1, _2));
+        }
+    });
+    if (false == success) {
+        close_child_pipes();
+        complete(id, make_error(ENODEV, "Failed to lock event loop"));
+        return;
+    }
+
+    // Pass the child's pipe sides to the forkserver.
+    std::array<int, 3> const stdio{ pipes[0], pipes[3], pipes[5] };
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(stdio))]{};
+    iovec iov{ running.request.data(), running.request.size() };
+
+    msghdr message{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(stdio));
+    std::memcpy(CMSG_DATA(header), stdio.data(), sizeof(stdio));
+
+    ssize_t size;
+    do {
+        size = sendmsg(m_socket, &message, MSG_NOSIGNAL);
+    }
+    while (-1 == size && EINTR == errno);
+    int const error = errno;
+
+    running.request = std::string();
+    close_child_pipes();
+
+    if (-1 == size) {
+        complete(id, make_error(error, "sendmsg() failed"));
+        return;
+    }
+
+    if (true == running.input.empty()) {
+        closePipe(running, Subprocess::StdIn);
+    }
+}
+
+void SubprocessPool::startQueued()
+{
+    while (m_running.size() < m_max_running && false == m_queue.empty()) {
+        std::unique_ptr<Job> job = std::move(m_queue.front());
+        m_queue.pop_front();
+
+        start(std::move(job));
+    }
+}
+
+void SubprocessPool::complete(std::uint32_t id, Result<int> const& return_code)
+{
+    auto it = m_running.find(id);
+    if (m_running.end() == it) {
+        return;
+    }
+
+    std::unique_ptr<Job> job = std::move(it->second);
+    m_running.erase(it);
+
+    if (-1 != job->pid) {
+        m_pids.erase(job->pid);
+    }
+
+    closePipe(*job, Subprocess::StdIn);
+    closePipe(*job, Subprocess::StdOut);
+    closePipe(*job, Subprocess::StdErr);
+
+    if (nullptr != job->callback) {
+        job->callback(return_code, job->output, job->error);
+    }
+
+    startQueued();
+}
+
+void SubprocessPool::closePipe(Job& job, Subprocess::Pipe pipe) noexcept
+{
+    int& fd = job.fds[pipe];
+    if (-1 == fd) {
+        return;
+    }
+
+    with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        loop.remove(fd);
+    });
+
+    ::close(fd);
+    fd = -1;
+}
+
+void SubprocessPool::stop() noexcept
+{
+    if (-1 == m_socket) {
+        return;
+    }
+
+    with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        loop.remove(m_socket);
+    });
+
+    // Closing the socket stops the forkserver.
+    ::close(m_socket);
+    m_socket = -1;
+
+    int status;
+    HVERIFY(m_pid == waitpid(m_pid, &status, 0));
+    m_pid = -1;
+}
+
+//
+// Public (SubprocessPool)
+//
+SubprocessPool::SubprocessPool(std::weak_ptr<EventLoop> event_loop, std::size_t max_running)
+    : m_event_loop(std::move(event_loop))
+    , m_max_running(std::max<std::size_t>(max_running, 1))
+{
+    using namespace std::placeholders;
+
+    // The forkserver may not allocate, allocate its buffers before forking.
+    std::vector<char> buffer(forkserver_request_size);
+    std::vector<char const*> argv(forkserver_request_size + 1);
+
+    int fds[2];
+    if (-1 == socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds)) {
+        throw make_system_error(errno, "socketpair() failed");
+    }
+
+    m_pid = fork();
+    if (-1 == m_pid) {
+        int const error = errno;
+        ::close(fds[0]);
+        ::close(fds[1]);
+        throw make_system_error(error, "fork() failed");
+    }
+
+    if (0 == m_pid) {
+        ::close(fds[0]);
+        forkserver_run(fds[1], buffer.data(), argv.data(), argv.size());
+    }
+
+    ::close(fds[1]);
+    m_socket = fds[0];
+
+    bool success = with_weak_ptr_locked(m_event_loop, [&](EventLoop& loop) {
+        loop.add(m_socket, EventLoop::Read, std::bind(&SubprocessPool::onResponse, this, _1, _2));
+    });
+    if (false == success) {
+        ::close(m_socket);
+        m_socket = -1;
+
+        int status;
+        HVERIFY(m_pid == waitpid(m_pid, &status, 0));
+        throw make_system_error(ENODEV, "Failed to lock event loop");
+    }
+}
+
+SubprocessPool::~SubprocessPool()
+{
+    for (auto& [id, job] : m_running) {
+        if (-1 != job->pid) {
+            ::kill(job->pid, SIGKILL);
+        }
+
+        closePipe(*job, Subprocess::StdIn);
+        closePipe(*job, Subprocess::StdOut);
+        closePipe(*job, Subprocess::StdErr);
+    }
+
+    stop();
+}
+
+int SubprocessPool::pid() const noexcept
+{
+    return m_pid;
+}
+
+std::size_t SubprocessPool::maxRunning() const noexcept
+{
+    return m_max_running;
+}
+
+std::size_t SubprocessPool::running() const noexcept
+{
+    return m_running.size();
+}
+
+std::size_t SubprocessPool::queued() const noexcept
+{
+    return m_queue.size();
+}
+
+Result<> SubprocessPool::run(std::string const& command, std::vector<std::string> const& args, OnCompleted callback, std::nothrow_t) noexcept
+{
+    return run(command, args, Buffer(), std::move(callback), std::nothrow);
+}
+
+Result<> SubprocessPool::run(std::string const& command, std::vector<std::string> const& args, Buffer&& input, OnCompleted callback, std::nothrow_t) noexcept
+{
+    if (-1 == m_socket) {
+        return make_error(ECHILD, "Forkserver exited");
+    }
+
+    // Size the request first, so that queued jobs hold only what they need.
+    std::size_t size = sizeof(ForkserverRequest) + command.size() + 1;
+    for (auto const& arg : args) {
+        size += arg.size() + 1;
+    }
+    if (size > forkserver_request_size) {
+        return make_error(E2BIG, "Arguments too long");
+    }
+
+    try {
+        auto job = std::make_unique<Job>();
+        job->id = ++m_next_id;
+        job->callback = std::move(callback);
+        job->input = std::move(input);
+
+        // Serialize request.
+        ForkserverRequest const request{ job->id, static_cast<std::uint32_t>(args.size() + 1) };
+
+        job->request.reserve(size);
+        job->request.append(reinterpret_cast<char const*>(&request), sizeof(request));
+        job->request.append(command.c_str(), command.size() + 1);
+        for (auto const& arg : args) {
+            job->request.append(arg.c_str(), arg.size() + 1);
+        }
+
+        m_queue.push_back(std::move(job));
+        startQueued();
+    }
+    catch (...) {
+        return std::current_exception();
+    }
+
+    return {};
+}
+
+void SubprocessPool::run(std::string const& command, std::vector<std::string> const& args, OnCompleted callback)
+{
+    success_or_throw(run(command, args, std::move(callback), std::nothrow));
+}
+
+void SubprocessPool::run(std::string const& command, std::vector<std::string> const& args, Buffer&& input, OnCompleted callback)
+{
+    success_or_throw(run(command, args, std::move(input), std::move(callback), std::nothrow));
+}
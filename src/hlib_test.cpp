@@ -23,11 +23,23 @@
 //
 #include "hlib/test.hpp"
 #include "hlib/container.hpp"
-#include "hlib_format.hpp"
+#include "hlib/error.hpp"
+#include "hlib/format.hpp"
 #include "hlib/string.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace hlib;
 
+std::atomic<std::uint64_t> test::allocations{ 0 };
+
 //
 // Implementation
 //
@@ -39,8 +51,162 @@ std::vector<std::string> parse_tags(std::string const& tags)
     return container::for_each(split(tags, ','), [](std::string& tag) { return trim(tag); });
 }
 
+std::string escape_json(std::string const& string)
+{
+    std::string result;
+    result.reserve(string.size());
+
+    for (char c : string) {
+        switch (c) {
+        case '"':   result += "\\\""; break;
+        case '\\':  result += "\\\\"; break;
+        case '\n':  result += "\\n"; break;
+        case '\t':  result += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                result += HLIB_FORMAT("\\u{:04x}", static_cast<unsigned>(c));
+            }
+            else {
+                result += c;
+            }
+            break;
+        }
+    }
+
+    return result;
+}
+
+// A test case running in a forked process.
+struct Job
+{
+    pid_t pid{ -1 };
+    int fd{ -1 };
+    std::size_t index{ 0 };
+    bool serial{ false };
+    time::TimePoint deadline;
+    std::string output;
+};
+
+bool is_serial(test::Case const& test_case)
+{
+    return true == container::contains(test_case.tags, std::string(test::Suite::NonParallelTag));
+}
+
+// Reads the output of a job, returns false on end of file.
+bool read_output(Job& job)
+{
+    char buffer[4096];
+
+    while (true) {
+        ssize_t const size = read(job.fd, buffer, sizeof(buffer));
+        if (size > 0) {
+            job.output.append(buffer, static_cast<std::size_t>(size));
+            continue;
+        }
+        if (-1 == size && EINTR == errno) {
+            continue;
+        }
+        return -1 == size && EAGAIN == errno;
+    }
+}
+
+void close_output(Job& job)
+{
+    if (-1 != job.fd) {
+        read_output(job);
+        close(job.fd);
+        job.fd = -1;
+    }
+}
+
 } // namespace
 
+//
+// Implementation (test::BenchmarkState)
+//
+bool test::BenchmarkState::startOrStop() noexcept
+{
+    if (false == m_started) {
+        m_started = true;
+        if (0 == m_iterations) {
+            m_stopped = true;
+            return false;
+        }
+
+        m_remaining = m_iterations - 1;
+        m_allocations = test::allocations.load(std::memory_order_relaxed);
+        m_start = time::now_ns();
+        return true;
+    }
+
+    if (false == m_stopped) {
+        pauseTiming();
+        m_stopped = true;
+        m_allocations = test::allocations.load(std::memory_order_relaxed) - m_allocations;
+    }
+
+    return false;
+}
+
+//
+// Public (test::BenchmarkState)
+//
+test::BenchmarkState::BenchmarkState(std::uint64_t iterations) noexcept
+    : m_iterations(iterations)
+{
+}
+
+std::uint64_t test::BenchmarkState::iterations() const noexcept
+{
+    return m_iterations;
+}
+
+void test::BenchmarkState::setBytesProcessed(std::uint64_t bytes) noexcept
+{
+    m_bytes = bytes;
+}
+
+void test::BenchmarkState::pauseTiming() noexcept
+{
+    m_elapsed += time::now_ns() - m_start;
+}
+
+void test::BenchmarkState::resumeTiming() noexcept
+{
+    m_start = time::now_ns();
+}
+
+time::DurationNs test::BenchmarkState::elapsed() const noexcept
+{
+    return m_elapsed;
+}
+
+std::uint64_t test::BenchmarkState::bytesProcessed() const noexcept
+{
+    return m_bytes;
+}
+
+std::uint64_t test::BenchmarkState::allocations() const noexcept
+{
+    return m_allocations;
+}
+
+//
+// Public (test::Benchmark)
+//
+test::Benchmark::Benchmark(char const* a_file, int a_line, std::string const& a_name, std::string const& a_tags, Function const& a_function)
+    : file(a_file)
+    , line(a_line)
+    , name(a_name)
+    , tags(parse_tags(a_tags))
+    , function(a_function)
+{
+    assert(nullptr != function);
+    assert(false == tags.empty());
+
+    test::Suite::get().add(*this);
+}
+
 //
 // Public (test::Case)
 //
@@ -88,6 +254,210 @@ void test::Suite::run(std::string tag, Case* test_case)
     ++statistics.cases_failed;
 }
 
+test::Suite::Selection test::Suite::select(std::vector<std::string> const& tags) const
+{
+    Selection selection;
+
+    if (true == tags.empty()) {
+        for (test::Case* test_case : m_test_cases) {
+            selection.emplace_back("*", test_case);
+        }
+        return selection;
+    }
+
+    for (test::Case* test_case : m_test_cases) {
+        for (std::string const& tag : tags) {
+            if (true == container::contains(test_case->tags, tag)) {
+                selection.emplace_back(tag, test_case);
+                break;
+            }
+        }
+    }
+
+    return selection;
+}
+
+void test::Suite::runIsolated(Selection const& selection, RunOptions const& options)
+{
+    std::size_t const jobs = std::max(1U, options.jobs);
+
+    // Statistics of each case, written by the forked process.
+    std::size_t const length = std::max<std::size_t>(1, selection.size()) * sizeof(Statistics);
+    void* const shared = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == shared) {
+        throw make_system_error(errno, "mmap() failed");
+    }
+    Statistics* const slots = new (shared) Statistics[std::max<std::size_t>(1, selection.size())];
+
+    std::vector<Job> running;
+    std::size_t next{ 0 };
+
+    auto start = [&](std::size_t index) {
+        std::string const& tag = selection[index].first;
+        Case* test_case = selection[index].second;
+
+        int fds[2];
+        if (-1 == pipe2(fds, O_CLOEXEC)) {
+            throw make_system_error(errno, "pipe2() failed");
+        }
+
+        fflush(stdout);
+        fflush(stderr);
+
+        pid_t const pid = fork();
+        if (-1 == pid) {
+            int const error = errno;
+            close(fds[0]);
+            close(fds[1]);
+            throw make_system_error(error, "fork() failed");
+        }
+
+        if (0 == pid) {
+            // Own process group, to kill processes spawned by the case too.
+            setpgid(0, 0);
+
+            dup2(fds[1], STDOUT_FILENO);
+            dup2(fds[1], STDERR_FILENO);
+            close(fds[0]);
+            close(fds[1]);
+
+            statistics = Statistics();
+            run(tag, test_case);
+
+            fflush(stdout);
+            fflush(stderr);
+
+            slots[index] = statistics;
+            _exit(EXIT_SUCCESS);
+        }
+
+        setpgid(pid, pid);
+        close(fds[1]);
+        fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+        Job job;
+        job.pid = pid;
+        job.fd = fds[0];
+        job.index = index;
+        job.serial = is_serial(*test_case);
+        if (0 != options.timeout.count()) {
+            job.deadline = time::now_ns() + options.timeout;
+        }
+        running.push_back(std::move(job));
+    };
+
+    auto finish = [&](Job& job, int status, bool timed_out) {
+        Case* test_case = selection[job.index].second;
+        std::string const tags = join(test_case->tags, ", ");
+
+        close_output(job);
+
+        if (true == timed_out) {
+            job.output += HLIB_FORMAT("{}:{}: test case with tags [{}] timed out after {} ms\n",
+                test_case->file, test_case->line, tags, options.timeout.count() / 1000000);
+        }
+        else if (true == WIFEXITED(status) && EXIT_SUCCESS == WEXITSTATUS(status)) {
+            Statistics const& result = slots[job.index];
+
+            statistics.cases += result.cases;
+            statistics.cases_failed += result.cases_failed;
+            statistics.assertions += result.assertions;
+            statistics.assertions_failed += result.assertions_failed;
+
+            test_case->assessed = 0 == result.cases_failed;
+        }
+        else if (true == WIFSIGNALED(status)) {
+            job.output += HLIB_FORMAT("{}:{}: test case with tags [{}] terminated by signal {}\n",
+                test_case->file, test_case->line, tags, WTERMSIG(status));
+        }
+        else {
+            job.output += HLIB_FORMAT("{}:{}: test case with tags [{}] exited with status {}\n",
+                test_case->file, test_case->line, tags, WEXITSTATUS(status));
+        }
+
+        if (false == test_case->assessed && true == job.output.empty()) {
+            job.output += HLIB_FORMAT("{}:{}: test case with tags [{}] failed\n", test_case->file, test_case->line, tags);
+        }
+
+        if (true == timed_out || false == WIFEXITED(status) || EXIT_SUCCESS != WEXITSTATUS(status)) {
+            ++statistics.cases;
+            ++statistics.cases_failed;
+            ++statistics.assertions_failed;
+        }
+
+        // Output of a case is written at once, to not interleave cases.
+        fwrite(job.output.data(), 1, job.output.size(), stderr);
+        fflush(stderr);
+    };
+
+    try {
+        while (next < selection.size() || false == running.empty()) {
+            // Start cases while slots are available. Non parallel cases
+            // start when nothing runs and block others until done.
+            while (next < selection.size() && running.size() < jobs
+                && (true == running.empty() || false == running.front().serial)
+                && (true == running.empty() || false == is_serial(*selection[next].second))) {
+                start(next++);
+            }
+
+            // Wait for output, exits and timeouts.
+            time::TimePoint const now = time::now_ns();
+            std::int64_t timeout_ms{ 10 };
+            std::vector<pollfd> fds;
+
+            for (Job const& job : running) {
+                if (-1 != job.fd) {
+                    fds.push_back(pollfd{ job.fd, POLLIN, 0 });
+                }
+                if (false == !job.deadline) {
+                    timeout_ms = std::max<std::int64_t>(0, std::min(timeout_ms, (job.deadline - now).count() / 1000000));
+                }
+            }
+
+            if (-1 == poll(fds.data(), fds.size(), static_cast<int>(timeout_ms)) && EINTR != errno) {
+                throw make_system_error(errno, "poll() failed");
+            }
+
+            for (Job& job : running) {
+                if (-1 != job.fd && false == read_output(job)) {
+                    close_output(job);
+                }
+            }
+
+            for (auto it = running.begin(); it != running.end();) {
+                int status{ 0 };
+                bool timed_out{ false };
+
+                pid_t pid = waitpid(it->pid, &status, WNOHANG);
+                if (0 == pid && false == !it->deadline && false == (time::now_ns() < it->deadline)) {
+                    kill(-it->pid, SIGKILL);
+                    pid = waitpid(it->pid, &status, 0);
+                    timed_out = true;
+                }
+
+                if (it->pid != pid) {
+                    ++it;
+                    continue;
+                }
+
+                finish(*it, status, timed_out);
+                it = running.erase(it);
+            }
+        }
+    }
+    catch (...) {
+        for (Job& job : running) {
+            kill(-job.pid, SIGKILL);
+            waitpid(job.pid, nullptr, 0);
+            close_output(job);
+        }
+        munmap(shared, length);
+        throw;
+    }
+
+    munmap(shared, length);
+}
+
 //
 // Public (test::Suite)
 //
@@ -118,26 +488,109 @@ void test::Suite::run(std::vector<std::string> const& tags)
         test_case->assessed = false;
     });
 
-    if (true == tags.empty()) {
-        for (test::Case* test_case : m_test_cases) {
-            run("*", test_case);
-        }
+    for (auto const& [tag, test_case] : select(tags)) {
+        run(tag, test_case);
+    }
+}
+
+void test::Suite::run(std::vector<std::string> const& tags, RunOptions const& options)
+{
+    if (options.jobs <= 1 && 0 == options.timeout.count()) {
+        run(tags);
         return;
     }
 
-    for (test::Case* test_case : m_test_cases) {
-        for (std::string const& tag : tags) {
-            if (false == test_case->assessed
-             && true == container::contains(test_case->tags, tag)) {
-                run(tag, test_case);
+    statistics = Statistics();
+
+    m_current_tag.clear();
+    m_current_case = nullptr;
+
+    container::for_each(m_test_cases, [](Case* test_case) {
+        test_case->assessed = false;
+    });
+
+    runIsolated(select(tags), options);
+}
+
+void test::Suite::run(std::string const& tags)
+{
+    run(parse_tags(tags));
+}
+
+void test::Suite::add(test::Benchmark& benchmark)
+{
+    m_benchmarks.push_back(&benchmark);
+}
+
+std::vector<test::BenchmarkResult> test::Suite::benchmark(std::vector<std::string> const& tags, BenchmarkOptions const& options,
+    std::function<void(BenchmarkResult const&)> const& on_result)
+{
+    std::vector<BenchmarkResult> results;
+
+    for (test::Benchmark* benchmark : m_benchmarks) {
+        bool const selected = true == tags.empty() || tags.end() != std::find_if(tags.begin(), tags.end(),
+            [benchmark](std::string const& tag) {
+                return tag == benchmark->name || true == container::contains(benchmark->tags, tag);
+            }
+        );
+
+        if (true == selected) {
+            results.push_back(Suite::benchmark(*benchmark, options));
+            if (nullptr != on_result) {
+                on_result(results.back());
             }
         }
     }
+
+    return results;
 }
 
-void test::Suite::run(std::string const& tags)
+test::BenchmarkResult test::Suite::benchmark(Benchmark const& benchmark, BenchmarkOptions const& options)
 {
-    run(parse_tags(tags));
+    auto run = [&benchmark](std::uint64_t iterations, BenchmarkResult& result) {
+        BenchmarkState state(iterations);
+        benchmark.function(state);
+
+        double const nsecs = static_cast<double>(std::max<std::int64_t>(state.elapsed().count(), 1));
+
+        result.iterations = iterations;
+        result.ns_per_op = nsecs / static_cast<double>(iterations);
+        result.bytes_per_second = static_cast<double>(state.bytesProcessed() * iterations) * 1e9 / nsecs;
+        result.allocations_per_op = static_cast<double>(state.allocations()) / static_cast<double>(iterations);
+        return state.elapsed();
+    };
+
+    // Predicts the iterations to run for duration, growing at most tenfold
+    // per run in case the first iterations were not representative.
+    auto scale = [&options](std::uint64_t iterations, time::DurationNs elapsed, time::DurationNs duration) {
+        double const factor = 1.2 * static_cast<double>(duration.count()) / static_cast<double>(std::max<std::int64_t>(elapsed.count(), 1));
+        double const scaled = std::min(static_cast<double>(iterations) * std::min(factor, 10.0), static_cast<double>(options.max_iterations));
+        return std::max(iterations + 1, static_cast<std::uint64_t>(scaled));
+    };
+
+    BenchmarkResult result;
+    result.name = benchmark.name;
+
+    // Warm up caches, branch predictors and lazy initialization, and
+    // calibrate the iterations.
+    std::uint64_t iterations = 1;
+    time::DurationNs elapsed = run(iterations, result);
+    time::DurationNs warmup = elapsed;
+
+    while (warmup < options.warmup && iterations < options.max_iterations) {
+        iterations = scale(iterations, elapsed, options.warmup - warmup);
+        elapsed = run(iterations, result);
+        warmup += elapsed;
+    }
+
+    // Measure.
+    do {
+        iterations = scale(iterations, elapsed, options.min_time);
+        elapsed = run(iterations, result);
+    }
+    while (elapsed < options.min_time && iterations < options.max_iterations);
+
+    return result;
 }
 
 //
@@ -189,16 +642,16 @@ std::string test::to_string(Expression const& expression)
 {
     switch (expression.assertion) {
     case Assertion::Require:
-        return format("%s(%s) => (%s %s %s)",
-            to_string(expression.assertion).c_str(),
+        return HLIB_FORMAT("{}({}) => ({} {} {})",
+            to_string(expression.assertion),
             expression.string,
-            expression.lhs.c_str(),
-            to_string(expression.operation).c_str(),
-            expression.rhs.c_str()
+            expression.lhs,
+            to_string(expression.operation),
+            expression.rhs
         );
     default:
-        return format("%s(%s)",
-            to_string(expression.assertion).c_str(),
+        return HLIB_FORMAT("{}({})",
+            to_string(expression.assertion),
             expression.string
         );
     }
@@ -207,11 +660,98 @@ std::string test::to_string(Expression const& expression)
 int test::main(int argc, char* argv[])
 {
     std::vector<std::string> tags;
+    Suite::RunOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string const argument(argv[i]);
+
+        if ("-j" == argument && i + 1 < argc) {
+            options.jobs = static_cast<unsigned>(std::stoul(argv[++i]));
+        }
+        else if (true == starts_with(argument, "-j")) {
+            options.jobs = static_cast<unsigned>(std::stoul(argument.substr(2)));
+        }
+        else if (true == starts_with(argument, "--timeout=")) {
+            options.timeout = time::MSec(std::stoll(argument.substr(10)));
+        }
+        else {
+            tags.push_back(argument);
+        }
+    }
+
+    Suite::get().run(tags, options);
+    return 0;
+}
+
+std::string test::to_string(BenchmarkResult const& result)
+{
+    std::string string = HLIB_FORMAT("{:<40} {:>12} iterations {:>12.1f} ns/op", result.name, result.iterations, result.ns_per_op);
+
+    if (result.bytes_per_second > 0) {
+        string += HLIB_FORMAT(" {:>10.1f} MB/s", result.bytes_per_second / 1e6);
+    }
+
+    string += HLIB_FORMAT(" {:>8.2f} allocs/op", result.allocations_per_op);
+    return string;
+}
+
+std::string test::to_json(std::vector<BenchmarkResult> const& results)
+{
+    std::string json = "{\n  \"benchmarks\": [";
+
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        BenchmarkResult const& result = results[i];
+
+        json += HLIB_FORMAT(
+            "{}\n    {{ \"name\": \"{}\", \"iterations\": {}, \"ns_per_op\": {:.3f}, "
+            "\"bytes_per_second\": {:.1f}, \"allocations_per_op\": {:.3f} }}",
+            0 == i ? "" : ",", escape_json(result.name), result.iterations, result.ns_per_op,
+            result.bytes_per_second, result.allocations_per_op
+        );
+    }
+
+    json += "\n  ]\n}\n";
+    return json;
+}
+
+int test::benchmark_main(int argc, char* argv[])
+{
+    std::vector<std::string> tags;
+    BenchmarkOptions options;
+    std::string json;
 
     for (int i = 1; i < argc; ++i) {
-        tags.push_back(argv[i]);
+        std::string const argument(argv[i]);
+
+        if (true == starts_with(argument, "--json=")) {
+            json = argument.substr(7);
+        }
+        else if (true == starts_with(argument, "--min-time=")) {
+            options.min_time = time::MSec(std::stoll(argument.substr(11)));
+        }
+        else if (true == starts_with(argument, "--warmup=")) {
+            options.warmup = time::MSec(std::stoll(argument.substr(9)));
+        }
+        else {
+            tags.push_back(argument);
+        }
+    }
+
+    std::vector<BenchmarkResult> const results = Suite::get().benchmark(tags, options,
+        [](BenchmarkResult const& result) {
+            printf("%s\n", to_string(result).c_str());
+            fflush(stdout);
+        }
+    );
+
+    if (false == json.empty()) {
+        std::ofstream stream(json);
+        stream << to_json(results);
+        if (!stream) {
+            fprintf(stderr, "failed to write %s\n", json.c_str());
+            return 1;
+        }
     }
 
-    Suite::get().run(tags);
     return 0;
 }
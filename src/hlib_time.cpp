@@ -23,8 +23,16 @@
 //
 #include "hlib/time.hpp"
 #include "hlib/error.hpp"
-#include "hlib_format.hpp"
-#include "hlib/string.hpp"
+#include "hlib/format.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define HLIB_TIME_TSC
+#endif
 
 using namespace hlib;
 
@@ -91,28 +99,287 @@ std::timespec timespec_divide(const timespec& lhs, double that)
     return result;
 }
 
-std::string localtime_offset_string(time::Clock const& clock)
+//
+// ISO-8601
+//
+constexpr std::int64_t secs_per_day{ 86400 };
+
+// Local timezone offsets only change on transitions, which are aligned to
+// at least 15 minutes.
+constexpr std::time_t timezone_window{ 900 };
+
+// Days since 1970-01-01 to a proleptic Gregorian date.
+constexpr void civil_from_days(std::int64_t days, std::int64_t& year, unsigned& month, unsigned& day) noexcept
+{
+    days += 719468;
+    std::int64_t const era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned const doe = static_cast<unsigned>(days - era * 146097);
+    unsigned const yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned const doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned const mp = (5 * doy + 2) / 153;
+
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<std::int64_t>(yoe) + era * 400 + (month <= 2 ? 1 : 0);
+}
+
+constexpr std::int64_t days_from_civil(std::int64_t year, unsigned month, unsigned day) noexcept
+{
+    year -= month <= 2 ? 1 : 0;
+    std::int64_t const era = (year >= 0 ? year : year - 399) / 400;
+    unsigned const yoe = static_cast<unsigned>(year - era * 400);
+    unsigned const doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned const doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+static_assert(0 == days_from_civil(1970, 1, 1));
+static_assert(19723 == days_from_civil(2024, 1, 1));
+
+constexpr unsigned days_in_month(std::int64_t year, unsigned month) noexcept
 {
-    struct tm time_info;
-    std::int32_t offset;
-    char sign;
+    constexpr unsigned char days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    bool const leap = 0 == year % 4 && (0 != year % 100 || 0 == year % 400);
+    return 2 == month && true == leap ? 29 : days[month - 1];
+}
 
-    // Get local time reentrant.
-    localtime_r(&clock.tv_sec, &time_info);
+constexpr std::time_t floor_div(std::time_t value, std::time_t divisor) noexcept
+{
+    return value / divisor - (value % divisor < 0 ? 1 : 0);
+}
 
-    // Determine sign and absolute offset.
-    if (time_info.tm_gmtoff >= 0) {
-        sign = '+';
-        offset = time_info.tm_gmtoff / 60;
+void write_digits(char* buffer, unsigned value, std::size_t count) noexcept
+{
+    while (count > 0) {
+        buffer[--count] = static_cast<char>('0' + value % 10);
+        value /= 10;
     }
-    else {
-        sign = '-';
-        offset = -(time_info.tm_gmtoff / 60);
+}
+
+long local_offset(std::time_t secs) noexcept
+{
+    struct Cache
+    {
+        std::time_t begin{ 1 };
+        std::time_t end{ 0 };
+        long offset{ 0 };
+    };
+    thread_local Cache cache;
+
+    if (secs < cache.begin || secs >= cache.end) {
+        struct tm time_info;
+        if (nullptr == localtime_r(&secs, &time_info)) {
+            return 0;
+        }
+
+        cache.begin = floor_div(secs, timezone_window) * timezone_window;
+        cache.end = cache.begin + timezone_window;
+        cache.offset = time_info.tm_gmtoff;
+    }
+
+    return cache.offset;
+}
+
+// "YYYY-MM-DDTHH:MM:SS" of the last second formatted.
+struct ISO8601Cache
+{
+    std::time_t secs{ 1 };
+    long offset{ 0 };
+    bool valid{ false };
+    std::array<char, 19> date_time;
+};
+
+ISO8601Cache const* format_date_time(std::time_t secs, bool utc) noexcept
+{
+    thread_local ISO8601Cache caches[2];
+
+    ISO8601Cache& cache = caches[true == utc ? 1 : 0];
+    long const offset = true == utc ? 0 : local_offset(secs);
+
+    if (true == cache.valid && secs == cache.secs && offset == cache.offset) {
+        return &cache;
+    }
+
+    std::int64_t const local = static_cast<std::int64_t>(secs) + offset;
+    std::int64_t const days = floor_div(local, secs_per_day);
+    unsigned const seconds = static_cast<unsigned>(local - days * secs_per_day);
+
+    std::int64_t year;
+    unsigned month, day;
+    civil_from_days(days, year, month, day);
+    if (year < 0 || year > 9999) {
+        return nullptr;
+    }
+
+    char* p = cache.date_time.data();
+    write_digits(p, static_cast<unsigned>(year), 4);
+    p[4] = '-';
+    write_digits(p + 5, month, 2);
+    p[7] = '-';
+    write_digits(p + 8, day, 2);
+    p[10] = 'T';
+    write_digits(p + 11, seconds / 3600, 2);
+    p[13] = ':';
+    write_digits(p + 14, (seconds / 60) % 60, 2);
+    p[16] = ':';
+    write_digits(p + 17, seconds % 60, 2);
+
+    cache.secs = secs;
+    cache.offset = offset;
+    cache.valid = true;
+    return &cache;
+}
+
+// Parses count digits at position, advancing position.
+bool parse_digits(std::string_view const& string, std::size_t& position, std::size_t count, unsigned& value) noexcept
+{
+    if (position + count > string.size()) {
+        return false;
+    }
+
+    value = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        char const c = string[position + i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + static_cast<unsigned>(c - '0');
+    }
+
+    position += count;
+    return true;
+}
+
+bool parse_char(std::string_view const& string, std::size_t& position, char c) noexcept
+{
+    if (position >= string.size() || c != string[position]) {
+        return false;
+    }
+
+    position += 1;
+    return true;
+}
+
+std::string to_string_iso8601(time::Clock const& clock, int fields)
+{
+    std::array<char, time::ISO8601::MaxSize> buffer;
+    std::size_t const size = time::format_iso8601(buffer.data(), buffer.size(), clock, fields);
+    return std::string(buffer.data(), size);
+}
+
+#ifdef HLIB_TIME_TSC
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+struct TscCalibration
+{
+    bool valid{ false };
+    std::uint64_t tsc{ 0 };
+    std::int64_t nsec{ 0 };
+
+    // Nanoseconds per tick as 32.32 fixed point.
+    std::uint64_t scale{ 0 };
+
+    // Ticks after which a thread re-anchors to CLOCK_MONOTONIC.
+    std::int64_t period{ 0 };
+};
+
+// Per thread anchor, so re-anchoring needs no synchronization.
+struct TscAnchor
+{
+    std::uint64_t tsc{ 0 };
+    std::int64_t nsec{ 0 };
+    std::uint64_t scale{ 0 };
+    std::int64_t last{ 0 };
+};
+
+bool has_invariant_tsc() noexcept
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (0 == __get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007) {
+        return false;
+    }
+    if (0 == __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+
+    return 0 != (edx & (1U << 8));
+}
+
+// Samples the TSC and CLOCK_MONOTONIC together, keeping the tightest of a
+// few attempts.
+void sample_tsc(std::uint64_t& tsc, std::int64_t& nsec) noexcept
+{
+    std::uint64_t best = UINT64_MAX;
+
+    for (int i = 0; i < 8; ++i) {
+        std::timespec ts;
+        std::uint64_t const before = __rdtsc();
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        std::uint64_t const after = __rdtsc();
+
+        if (after - before < best) {
+            best = after - before;
+            tsc = before + (after - before) / 2;
+            nsec = static_cast<std::int64_t>(ts.tv_sec) * nsec_per_sec + ts.tv_nsec;
+        }
+    }
+}
+
+TscCalibration calibrate_tsc() noexcept
+{
+    TscCalibration calibration;
+
+    if (false == has_invariant_tsc()) {
+        return calibration;
+    }
+
+    std::uint64_t start_tsc;
+    std::int64_t start_nsec;
+    sample_tsc(start_tsc, start_nsec);
+
+    std::timespec interval{ 0, 10000000L };
+    while (-1 == nanosleep(&interval, &interval) && EINTR == errno) {
+    }
+
+    sample_tsc(calibration.tsc, calibration.nsec);
+    if (calibration.tsc <= start_tsc || calibration.nsec <= start_nsec) {
+        return calibration;
     }
 
-    return format("%c%02d:%02d", sign, offset / 60, offset % 60);
+    calibration.scale = static_cast<std::uint64_t>(
+        (static_cast<uint128_t>(calibration.nsec - start_nsec) << 32) / (calibration.tsc - start_tsc)
+    );
+    calibration.valid = 0 != calibration.scale;
+    if (true == calibration.valid) {
+        calibration.period = static_cast<std::int64_t>((static_cast<uint128_t>(nsec_per_sec) << 32) / calibration.scale);
+    }
+    return calibration;
+}
+
+TscCalibration const& tsc_calibration() noexcept
+{
+    static TscCalibration const calibration = calibrate_tsc();
+    return calibration;
+}
+
+// Resamples CLOCK_MONOTONIC, so the offset cannot drift, and refines the
+// scale over the longer interval since calibration.
+void reanchor_tsc(TscAnchor& anchor, TscCalibration const& calibration) noexcept
+{
+    sample_tsc(anchor.tsc, anchor.nsec);
+
+    if (anchor.tsc > calibration.tsc && anchor.nsec > calibration.nsec) {
+        anchor.scale = static_cast<std::uint64_t>(
+            (static_cast<uint128_t>(anchor.nsec - calibration.nsec) << 32) / (anchor.tsc - calibration.tsc)
+        );
+    }
 }
 
+#endif
+
 } // namespace
 
 //
@@ -331,6 +598,52 @@ time::Clock time::now(clockid_t clock_id)
     return Clock(clock_id);
 }
 
+time::TimePoint time::now_ns(clockid_t clock_id) noexcept
+{
+    std::timespec ts;
+    HVERIFY(0 == clock_gettime(clock_id, &ts));
+    return TimePoint(ts);
+}
+
+time::Clock time::fast_now() noexcept
+{
+#ifdef HLIB_TIME_TSC
+    TscCalibration const& calibration = tsc_calibration();
+
+    if (true == calibration.valid) {
+        thread_local TscAnchor anchor{ calibration.tsc, calibration.nsec, calibration.scale, 0 };
+
+        std::int64_t ticks = static_cast<std::int64_t>(__rdtsc() - anchor.tsc);
+        if (ticks >= calibration.period) {
+            reanchor_tsc(anchor, calibration);
+            ticks = static_cast<std::int64_t>(__rdtsc() - anchor.tsc);
+        }
+
+        // Invariant TSCs are synchronized across cores, but guard against
+        // reading one slightly behind the anchor, or a re-anchor stepping
+        // back.
+        std::int64_t nsec = ticks > 0
+            ? anchor.nsec + static_cast<std::int64_t>((static_cast<uint128_t>(ticks) * anchor.scale) >> 32)
+            : anchor.nsec;
+        nsec = std::max(nsec, anchor.last);
+        anchor.last = nsec;
+
+        return Clock(static_cast<std::time_t>(nsec / nsec_per_sec), static_cast<long>(nsec % nsec_per_sec));
+    }
+#endif
+
+    return Clock(CLOCK_MONOTONIC, std::nothrow);
+}
+
+bool time::fast_now_uses_tsc() noexcept
+{
+#ifdef HLIB_TIME_TSC
+    return tsc_calibration().valid;
+#else
+    return false;
+#endif
+}
+
 time::Clock time::now_utc(clockid_t clock_id)
 {
     assert(
@@ -343,166 +656,221 @@ time::Clock time::now_utc(clockid_t clock_id)
 
 time::Clock const time::infinity(0x7fffffff, 0);
 
-time::Clock time::to_clock(std::string const& iso8601)
+std::size_t time::format_iso8601(char* buffer, std::size_t size, Clock const& clock, int fields) noexcept
 {
-    std::tm tm_time{};
-    std::timespec timespec;
+    bool const utc = 0 != (ISO8601::Utc & fields);
+    bool const date = 0 != (ISO8601::Date & fields);
+    bool const time = 0 != (ISO8601::Time & fields);
 
-    auto parse = [&](char const* format)
-    {
-        char* r = strptime(iso8601.c_str(), format, &tm_time);
-        if (nullptr == r || 0 != *r) {
-            throw std::logic_error("Invalid ISO8601 string");
-        }
+    ISO8601Cache const* cache = format_date_time(clock.tv_sec, utc);
+    if (nullptr == cache) {
+        return 0;
+    }
+
+    std::array<char, ISO8601::MaxSize> string;
+    std::size_t length = 0;
+
+    auto append = [&](char const* data, std::size_t count) {
+        memcpy(string.data() + length, data, count);
+        length += count;
     };
 
-    // Date only?
-    if (false == contains(iso8601, 'T')) {
-        parse("%Y-%m-%d");
-        timespec.tv_sec = timegm(&tm_time);
-        timespec.tv_nsec = 0;
+    if (true == date) {
+        append(cache->date_time.data(), 10);
+    }
+    if (true == date && true == time) {
+        append("T", 1);
+    }
+    if (true == time) {
+        append(cache->date_time.data() + 11, 8);
     }
-    // Without millisecond part?
-    else if (false == contains(iso8601, '.')) {
-        parse("%Y-%m-%dT%H:%M:%S%z");
-        timespec.tv_sec = timegm(&tm_time);
-        timespec.tv_nsec = 0;
+    if (0 != (ISO8601::Microseconds & fields)) {
+        string[length] = '.';
+        write_digits(string.data() + length + 1, static_cast<unsigned>(clock.tv_nsec / 1000) % 1000000, 6);
+        length += 7;
+    }
+    else if (0 != (ISO8601::Milliseconds & fields)) {
+        string[length] = '.';
+        write_digits(string.data() + length + 1, static_cast<unsigned>(clock.tv_nsec / 1000000) % 1000, 3);
+        length += 4;
+    }
+
+    if (true == utc) {
+        append("Z", 1);
     }
     else {
-        char* r = strptime(iso8601.c_str(), "%Y-%m-%dT%H:%M:%S", &tm_time);
-        if (nullptr == r || '.' != *r) {
-            throw std::logic_error("Invalid ISO8601 string");
+        long const offset = cache->offset;
+        unsigned const minutes = static_cast<unsigned>(offset >= 0 ? offset : -offset) / 60;
+
+        string[length] = offset >= 0 ? '+' : '-';
+        write_digits(string.data() + length + 1, minutes / 60, 2);
+        string[length + 3] = ':';
+        write_digits(string.data() + length + 4, minutes % 60, 2);
+        length += 6;
+    }
+
+    if (length > size) {
+        return 0;
+    }
+
+    memcpy(buffer, string.data(), length);
+    return length;
+}
+
+Result<time::Clock> time::to_clock(std::string_view const& iso8601, std::nothrow_t) noexcept
+{
+    std::size_t position = 0;
+    unsigned year, month, day;
+    unsigned hour = 0, minute = 0, second = 0;
+    long nsecs = 0;
+    long offset = 0;
+
+    auto invalid = [] {
+        return make_error(EINVAL, "Invalid ISO8601 string");
+    };
+
+    if (false == parse_digits(iso8601, position, 4, year)
+     || false == parse_char(iso8601, position, '-')
+     || false == parse_digits(iso8601, position, 2, month)
+     || false == parse_char(iso8601, position, '-')
+     || false == parse_digits(iso8601, position, 2, day)
+     || month < 1 || month > 12 || day < 1 || day > days_in_month(year, month)) {
+        return invalid();
+    }
+
+    if (true == parse_char(iso8601, position, 'T')) {
+        if (false == parse_digits(iso8601, position, 2, hour)
+         || false == parse_char(iso8601, position, ':')
+         || false == parse_digits(iso8601, position, 2, minute)
+         || false == parse_char(iso8601, position, ':')
+         || false == parse_digits(iso8601, position, 2, second)
+         || hour > 23 || minute > 59 || second > 60) {
+            return invalid();
         }
 
-        int milliseconds;
-        if (1 != sscanf(r, ".%03d", &milliseconds)) {
-            throw std::logic_error("Invalid ISO8601 string");
+        // Fraction of up to nanosecond resolution.
+        if (true == parse_char(iso8601, position, '.')) {
+            std::size_t const start = position;
+            long scale = 100000000;
+
+            while (position < iso8601.size() && iso8601[position] >= '0' && iso8601[position] <= '9') {
+                nsecs += (iso8601[position] - '0') * scale;
+                scale /= 10;
+                ++position;
+            }
+            if (start == position) {
+                return invalid();
+            }
         }
 
-        r = strptime(r + 4, "%z", &tm_time);
-        if (nullptr == r || 0 != *r) {
-            throw std::logic_error("Invalid ISO8601 string");
+        if (false == parse_char(iso8601, position, 'Z')
+         && position < iso8601.size() && ('+' == iso8601[position] || '-' == iso8601[position])) {
+            long const sign = '+' == iso8601[position] ? 1 : -1;
+            unsigned offset_hours, offset_minutes = 0;
+
+            position += 1;
+            if (false == parse_digits(iso8601, position, 2, offset_hours)) {
+                return invalid();
+            }
+            if (position < iso8601.size()) {
+                (void)parse_char(iso8601, position, ':');
+                if (false == parse_digits(iso8601, position, 2, offset_minutes)) {
+                    return invalid();
+                }
+            }
+            if (offset_hours > 23 || offset_minutes > 59) {
+                return invalid();
+            }
+
+            offset = sign * static_cast<long>(offset_hours * 3600 + offset_minutes * 60);
         }
+    }
 
-        timespec.tv_sec = timegm(&tm_time);
-        timespec.tv_nsec = milliseconds * 1000000;
+    if (position != iso8601.size()) {
+        return invalid();
     }
 
-    return Clock(timespec);
+    std::int64_t const secs = days_from_civil(year, month, day) * secs_per_day
+        + hour * 3600 + minute * 60 + second - offset;
+
+    return Clock(static_cast<std::time_t>(secs), nsecs);
+}
+
+time::Clock time::to_clock(std::string_view const& iso8601)
+{
+    Result<Clock> clock = to_clock(iso8601, std::nothrow);
+    if (true == clock.failure()) {
+        throw std::logic_error("Invalid ISO8601 string");
+    }
+
+    return clock.value();
 }
 
 std::string hlib::to_string(time::Duration const& duration, bool milliseconds)
 {
-    std::string string = format("%02ld:%02ld:%02ld",
+    FormatBuffer<32> string;
+
+    HVERIFY(HLIB_FORMAT_TO(string, "{:02}:{:02}:{:02}",
         (duration.tv_sec / 3600),
         (duration.tv_sec / 60) % 60,
         (duration.tv_sec / 1) % 60
-    );
+    ));
 
     if (true == milliseconds) {
-        format_to(string, ".%03ld", duration.tv_nsec / 1000000);
+        HVERIFY(HLIB_FORMAT_TO(string, ".{:03}", duration.tv_nsec / 1000000));
     }
 
-    return string;
+    return std::string(string.view());
 }
 
 std::string hlib::to_string_utc_date(time::Clock const& clock)
 {
-    char string[12]; // ISO 8601 format: "YYYY-MM-DDZ\0"
-    strftime(string, sizeof(string), "%Y-%m-%dZ", gmtime(&(clock.tv_sec)));
-    return string;
+    return to_string_iso8601(clock, time::ISO8601::Date | time::ISO8601::Utc);
 }
 
 std::string hlib::to_string_utc_date_and_time(time::Clock const& clock)
 {
-    char string[21]; // ISO 8601 format: "YYYY-MM-DDTHH:MM:SSZ\0"
-    strftime(string, sizeof(string), "%Y-%m-%dT%H:%M:%SZ", gmtime(&(clock.tv_sec)));
-    return string;
+    return to_string_iso8601(clock, time::ISO8601::Date | time::ISO8601::Time | time::ISO8601::Utc);
 }
 
 std::string hlib::to_string_utc_time(time::Clock const& clock)
 {
-    char string[10]; // ISO 8601 format: "HH:MM:SSZ\0"
-    strftime(string, sizeof(string), "%H:%M:%SZ", gmtime(&(clock.tv_sec)));
-    return string;
+    return to_string_iso8601(clock, time::ISO8601::Time | time::ISO8601::Utc);
 }
 
 std::string hlib::to_string_utc_time_milliseconds(time::Clock const& clock)
 {
-    char string[14]; // ISO 8601 format: "HH:MM:SS[.MMM]Z\0"
-    constexpr std::size_t millisecond_offset = 8;
-
-    strftime(string, sizeof(string), "%H:%M:%S", gmtime(&(clock.tv_sec)));
-
-    // Satisfy the compiler's buffer overflow checker by limiting the argument to a range of 0 - 999.
-    const std::uint32_t ms = (clock.tv_nsec / 1000000) % 1000;
-    snprintf(string + millisecond_offset, sizeof(string) - millisecond_offset, ".%03dZ", ms);
-    return string;
+    return to_string_iso8601(clock, time::ISO8601::Time | time::ISO8601::Milliseconds | time::ISO8601::Utc);
 }
 
 std::string hlib::to_string_utc(time::Clock const& clock, bool milliseconds)
 {
-    char string[25]; // ISO 8601 format: "YYYY-MM-DDTHH:MM:SS[.MMM]Z\0"
-    constexpr std::size_t millisecond_offset = 19;
-
-    strftime(string, sizeof(string), "%Y-%m-%dT%H:%M:%SZ", gmtime(&(clock.tv_sec)));
-
-    if (true == milliseconds) {
-        // Satisfy the compiler's buffer overflow checker by limiting the argument to a range of 0 - 999.
-        const std::uint32_t ms = (clock.tv_nsec / 1000000) % 1000;
-        snprintf(string + millisecond_offset, sizeof(string) - millisecond_offset, ".%03dZ", ms);
-    }
-
-    return string;
+    return to_string_iso8601(clock, time::ISO8601::Date | time::ISO8601::Time | time::ISO8601::Utc
+        | (true == milliseconds ? time::ISO8601::Milliseconds : 0));
 }
 
 std::string hlib::to_string_local_date(time::Clock const& clock)
 {
-    char string[11]; // ISO 8601 format: "YYYY-MM-DD\0"
-    strftime(string, sizeof(string), "%Y-%m-%d", localtime(&(clock.tv_sec)));
-    return string + localtime_offset_string(clock);
+    return to_string_iso8601(clock, time::ISO8601::Date);
 }
 
 std::string hlib::to_string_local_date_and_time(time::Clock const& clock)
 {
-    char string[20]; // ISO 8601 format: "YYYY-MM-DDTHH:MM:SS\0"
-    strftime(string, sizeof(string), "%Y-%m-%dT%H:%M:%S", localtime(&(clock.tv_sec)));
-    return string + localtime_offset_string(clock);
+    return to_string_iso8601(clock, time::ISO8601::Date | time::ISO8601::Time);
 }
 
 std::string hlib::to_string_local_time(time::Clock const& clock)
 {
-    char string[9]; // ISO 8601 format: "HH:MM:SS\0"
-    strftime(string, sizeof(string), "%H:%M:%S", localtime(&(clock.tv_sec)));
-    return string + localtime_offset_string(clock);
+    return to_string_iso8601(clock, time::ISO8601::Time);
 }
 
 std::string hlib::to_string_local_time_milliseconds(time::Clock const& clock)
 {
-    char string[14]; // ISO 8601 format: "HH:MM:SS[.MMM]\0"
-    constexpr std::size_t millisecond_offset = 8;
-
-    strftime(string, sizeof(string), "%H:%M:%S", gmtime(&(clock.tv_sec)));
-
-    // Satisfy the compiler's buffer overflow checker by limiting the argument to a range of 0 - 999.
-    const std::uint32_t ms = (clock.tv_nsec / 1000000) % 1000;
-    snprintf(string + millisecond_offset, sizeof(string) - millisecond_offset, ".%03d", ms);
-    return string + localtime_offset_string(clock);
+    return to_string_iso8601(clock, time::ISO8601::Time | time::ISO8601::Milliseconds);
 }
 
 std::string hlib::to_string_local(time::Clock const& clock, bool milliseconds)
 {
-    char string[24]; // ISO 8601 format: "YYYY-MM-DDTHH:MM:SS[.MMM]\0"
-    constexpr std::size_t millisecond_offset = 19;
-
-    strftime(string, sizeof(string), "%Y-%m-%dT%H:%M:%S", gmtime(&(clock.tv_sec)));
-
-    if (true == milliseconds) {
-        // Satisfy the compiler's buffer overflow checker by limiting the argument to a range of 0 - 999.
-        const std::uint32_t ms = (clock.tv_nsec / 1000000) % 1000;
-        snprintf(string + millisecond_offset, sizeof(string) - millisecond_offset, ".%03d", ms);
-    }
-
-    return string + localtime_offset_string(clock);
+    return to_string_iso8601(clock, time::ISO8601::Date | time::ISO8601::Time
+        | (true == milliseconds ? time::ISO8601::Milliseconds : 0));
 }
-
@@ -73,7 +73,7 @@ Timer::Timer(std::weak_ptr<EventLoop> event_loop, Callback callback)
 }
 
 Timer::Timer(std::weak_ptr<EventLoop> event_loop, Callback callback,
-        time::Duration const& expire, time::Duration const& interval)
+        time::DurationNs expire, time::DurationNs interval)
     : Timer(std::move(event_loop), std::move(callback))
 {
     set(expire, interval);
@@ -89,7 +89,7 @@ Timer::~Timer()
         loop.remove(m_fd);
     });
 
-    if (-1 == m_fd) {
+    if (-1 != m_fd) {
         close(m_fd);
     }
 }
@@ -105,18 +105,18 @@ bool Timer::clear() noexcept
     return true;
 }
 
-bool Timer::set(time::Duration const& expire, time::Duration const& interval) noexcept
+bool Timer::set(time::DurationNs expire, time::DurationNs interval) noexcept
 {
-    itimerspec ts = {};
-    ts.it_value = expire;
-    ts.it_interval = interval;
-
     // Replace 0 expire with a small timer value so instead as to cancel
     // the timer, it almost immediately expires.
-    if (0 == ts.it_value.tv_sec && 0 == ts.it_value.tv_nsec) {
-        ts.it_value.tv_nsec = immediate_nsec;
+    if (0 == expire.count()) {
+        expire = time::DurationNs(immediate_nsec);
     }
 
+    itimerspec ts;
+    ts.it_value = expire.toTimespec();
+    ts.it_interval = interval.toTimespec();
+
     if (-1 == timerfd_settime(m_fd, 0, &ts, nullptr)) {
         return false;
     }
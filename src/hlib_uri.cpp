@@ -22,82 +22,162 @@
 // SOFTWARE.
 //
 #include "hlib/uri.hpp"
-#include "hlib_format.hpp"
+#include "hlib/format.hpp"
 #include "hlib/string.hpp"
-#include <regex>
-#include <unordered_map>
+#include <array>
 
 using namespace hlib;
 
+//
+// Implementation
+//
+namespace
+{
+
+constexpr std::array<bool, 256> make_unreserved_table() noexcept
+{
+    std::array<bool, 256> table{};
+
+    for (char c = '0'; c <= '9'; ++c) {
+        table[static_cast<unsigned char>(c)] = true;
+    }
+    for (char c = 'A'; c <= 'Z'; ++c) {
+        table[static_cast<unsigned char>(c)] = true;
+        table[static_cast<unsigned char>(c - 'A' + 'a')] = true;
+    }
+
+    table['-'] = true;
+    table['.'] = true;
+    table['_'] = true;
+    table['~'] = true;
+    return table;
+}
+
+constexpr std::array<std::uint8_t, 256> make_hex_table() noexcept
+{
+    std::array<std::uint8_t, 256> table{};
+
+    for (std::size_t i = 0; i < table.size(); ++i) {
+        table[i] = 0xff;
+    }
+    for (std::uint8_t i = 0; i < 10; ++i) {
+        table['0' + i] = i;
+    }
+    for (std::uint8_t i = 0; i < 6; ++i) {
+        table['A' + i] = 10 + i;
+        table['a' + i] = 10 + i;
+    }
+    return table;
+}
+
+constexpr std::array<bool, 256> unreserved_table = make_unreserved_table();
+constexpr std::array<std::uint8_t, 256> hex_table = make_hex_table();
+
+std::string_view substr(std::string_view string, std::size_t begin, std::size_t end) noexcept
+{
+    return string.substr(begin, (std::string_view::npos != end ? end : string.size()) - begin);
+}
+
+} // namespace
+
 //
 // Public
 //
 URI::URI(std::string const& that)
+    : URI(uri_parse_view(that))
 {
-    *this = uri_parse(that);
 }
 
-URI hlib::uri_parse(std::string const& string)
+URI::URI(URIView const& that)
+    : scheme(that.scheme)
+    , user_info(that.user_info)
+    , host(that.host)
+    , port{ that.port }
+    , path(that.path)
+    , query(that.query)
+    , fragment(that.fragment)
 {
-    // See https://datatracker.ietf.org/doc/html/rfc3986#appendix-B.
-    static std::regex const uri_regex(
-        R"(^(([^:\/?#]+):)?(//([^\/?#]*))?([^?#]*)(\?([^#]*))?(#(.*))?)",
-        std::regex::extended
-    );
-
-    URI uri;
-    std::string::size_type pos;
-
-    std::smatch matches;
-    if (false == std::regex_match(string, matches, uri_regex)) {
-        throw std::invalid_argument("string argument not a valid URI");
+}
+
+URIView hlib::uri_parse_view(std::string_view string) noexcept
+{
+    // Splits the components the way the regular expression of
+    // https://datatracker.ietf.org/doc/html/rfc3986#appendix-B does, in a
+    // single pass over the string.
+    URIView uri;
+    std::size_t pos = 0;
+    std::size_t end;
+
+    // Scheme, when terminated by ':' before any of "/?#".
+    end = string.find_first_of(":/?#");
+    if (std::string_view::npos != end && end > 0 && ':' == string[end]) {
+        uri.scheme = string.substr(0, end);
+        pos = end + 1;
     }
-    assert(10 == matches.size());
 
-    // Get scheme match.
-    uri.scheme = matches[2].str();
+    // Authority, when prefixed by "//".
+    if (string.size() - pos >= 2 && '/' == string[pos] && '/' == string[pos + 1]) {
+        pos += 2;
+        end = string.find_first_of("/?#", pos);
 
-    // Get authority match.
-    std::string authority = matches[4];
+        std::string_view authority = substr(string, pos, end);
+        pos += authority.size();
 
-    // User-info (username[:password]@) present?
-    pos = authority.find('@');
-    if (std::string::npos != pos) {
-        uri.user_info = authority.substr(0, pos);
-        authority = authority.substr(pos + 1);
-    }
+        // User-info (username[:password]@) present?
+        std::size_t at = authority.find('@');
+        if (std::string_view::npos != at) {
+            uri.user_info = authority.substr(0, at);
+            authority.remove_prefix(at + 1);
+        }
 
-    // Port present?
-    pos = authority.rfind(':');
-    if (std::string::npos != pos) {
-        // Parse characters after ':', if it is parsable as uint16_t, it is a port.
-        std::optional<std::uint16_t> port = stoui16(authority.substr(pos + 1), 10, std::nothrow);
-        if (std::nullopt != port) {
-            uri.port = port.value();
-            authority = authority.substr(0, pos);
+        // Port present? If the characters after ':' parse as uint16_t, it is a port.
+        std::size_t colon = authority.rfind(':');
+        if (std::string_view::npos != colon) {
+            std::optional<std::uint16_t> port = stoui16(authority.substr(colon + 1), 10, std::nothrow);
+            if (std::nullopt != port) {
+                uri.port = port.value();
+                authority = authority.substr(0, colon);
+            }
         }
+
+        // Remaining authority string is host.
+        uri.host = authority;
+    }
+
+    // Path, up to the query or fragment.
+    end = string.find_first_of("?#", pos);
+    uri.path = substr(string, pos, end);
+    pos += uri.path.size();
+
+    // Query, up to the fragment.
+    if (pos < string.size() && '?' == string[pos]) {
+        end = string.find('#', pos + 1);
+        uri.query = substr(string, pos + 1, end);
+        pos += uri.query.size() + 1;
     }
 
-    // Remaining authority string is host.
-    uri.host = std::move(authority);
+    // Fragment, up to the end.
+    if (pos < string.size() && '#' == string[pos]) {
+        uri.fragment = string.substr(pos + 1);
+    }
 
     // Default port?
     if (0 == uri.port) {
         uri.port = uri_get_default_port_for_scheme(uri.scheme);
     }
 
-    // Get path match.
-    uri.path = matches[5].str();
     if (true == uri.path.empty()) {
         uri.path = "/";
     }
 
-    // Get query and fragment matches.
-    uri.query = matches[7].str();
-    uri.fragment = matches[9];
     return uri;
 }
 
+URI hlib::uri_parse(std::string const& string)
+{
+    return URI(uri_parse_view(string));
+}
+
 std::string hlib::to_string(URI const& uri)
 {
     std::size_t const length = uri.scheme.length() + 3
@@ -111,30 +191,30 @@ std::string hlib::to_string(URI const& uri)
     string.reserve(length);
 
     if (false == uri.scheme.empty()) {
-        format_to(string, "%s:", uri.scheme.c_str());
+        HLIB_FORMAT_TO(string, "{}:", uri.scheme);
     }
 
     if (false == uri.host.empty()) {
         string += "//";
 
         if (false == uri.user_info.empty()) {
-            format_to(string, "%s@", uri.user_info.c_str());
+            HLIB_FORMAT_TO(string, "{}@", uri.user_info);
         }
 
         string += uri.host;
         if (0 != uri.port && uri_get_default_port_for_scheme(uri.scheme) != uri.port) {
-            format_to(string, ":%u", uri.port);
+            HLIB_FORMAT_TO(string, ":{}", uri.port);
         }
     }
 
     string += false == uri.path.empty() ? uri.path.c_str() : "/";
 
     if (false == uri.query.empty()) {
-        format_to(string, "?%s", uri.query.c_str());
+        HLIB_FORMAT_TO(string, "?{}", uri.query);
     }
 
     if (false == uri.fragment.empty()) {
-        format_to(string, "#%s", uri.fragment.c_str());
+        HLIB_FORMAT_TO(string, "#{}", uri.fragment);
     }
 
     return string;
@@ -147,7 +227,7 @@ std::string hlib::uri_get_host_port(URI const& uri)
 
     string = uri.host;
     if (uri.port != 0 && uri.port != uri_get_default_port_for_scheme(uri.scheme)) {
-        format_to(string, ":%u", uri.port);
+        HLIB_FORMAT_TO(string, ":{}", uri.port);
     }
 
     return string;
@@ -160,18 +240,18 @@ std::string hlib::uri_get_path_query_fragment(URI const& uri)
 
     string = uri.path;
     if (uri.query.empty() == false) {
-        format_to(string, "?%s", uri.query.c_str());
+        HLIB_FORMAT_TO(string, "?{}", uri.query);
     }
     if (uri.fragment.empty() == false) {
-        format_to(string, "#%s", uri.fragment.c_str());
+        HLIB_FORMAT_TO(string, "#{}", uri.fragment);
     }
 
     return string;
 }
 
-std::uint16_t hlib::uri_get_default_port_for_scheme(std::string const& scheme)
+std::uint16_t hlib::uri_get_default_port_for_scheme(std::string_view scheme) noexcept
 {
-    static std::unordered_map<std::string, std::uint16_t> const table =
+    static constexpr std::pair<std::string_view, std::uint16_t> table[] =
     {
         { "ftp",    22 },
         { "gopher", 70 },
@@ -188,66 +268,71 @@ std::uint16_t hlib::uri_get_default_port_for_scheme(std::string const& scheme)
         { "wss",    443 }
     };
 
+    for (auto const& entry : table) {
+        if (entry.first == scheme) {
+            return entry.second;
+        }
+    }
 
-    auto it = table.find(scheme);
-    return table.end() != it ? it->second : 0;
+    return 0;
 }
 
-std::string hlib::uri_encoding_escape(std::string const& string)
+std::string hlib::uri_encoding_escape(std::string_view string)
 {
-    static char const *hdigit{ "0123456789ABCDEF" };
+    static char const hdigit[]{ "0123456789ABCDEF" };
 
-    auto needs_escaping = [](char const c)
-    {
-        return !(isalnum(c) || '-' == c || '.' == c || '_' == c || '~' == c);
-    };
+    // Size the result up front, every reserved character expands to "%XX".
+    std::size_t length = string.length();
+    for (char c : string) {
+        if (false == unreserved_table[static_cast<unsigned char>(c)]) {
+            length += 2;
+        }
+    }
 
-    std::string escaped;
-    escaped.reserve(string.length());
+    std::string escaped(length, '\0');
+    char* pos = escaped.data();
 
-    for(std::size_t i = 0; i < string.length(); ++i) {
-        char const c = string[i];
-        if (true == needs_escaping(c)) {
-            format_to(escaped, "%%%c%c", 
-                hdigit[(c >> 4) & 0x0f],
-                hdigit[(c >> 0) & 0x0f]
-            );
+    for (char c : string) {
+        unsigned char const u = static_cast<unsigned char>(c);
+        if (true == unreserved_table[u]) {
+            *pos++ = c;
         }
         else {
-            escaped += c;
+            *pos++ = '%';
+            *pos++ = hdigit[u >> 4];
+            *pos++ = hdigit[u & 0x0f];
         }
     }
 
     return escaped;
 }
 
-std::string hlib::uri_encoding_unescape(std::string const& string)
+std::string hlib::uri_encoding_unescape(std::string_view string)
 {
-    std::string unescaped;
-    unescaped.reserve(string.length());
+    std::string unescaped(string.length(), '\0');
+    char* pos = unescaped.data();
 
-    char hex[4]{};
-
-    for(std::size_t i = 0; i < string.length(); ++i) {
+    for (std::size_t i = 0; i < string.length(); ++i) {
         char c = string[i];
         if ('%' == c) {
             if (i + 3 > string.length()) {
                 break;
             }
 
-            hex[0] = string[++i];
-            hex[1] = string[++i];
-
-            if (!isxdigit(hex[0]) || !isxdigit(hex[1])) {
+            std::uint8_t const high = hex_table[static_cast<unsigned char>(string[i + 1])];
+            std::uint8_t const low = hex_table[static_cast<unsigned char>(string[i + 2])];
+            if (0xff == high || 0xff == low) {
                 break;
             }
 
-            c = static_cast<char>(::strtoul(hex, nullptr, 16));
+            c = static_cast<char>((high << 4) | low);
+            i += 2;
         }
 
-        unescaped += hex;
+        *pos++ = c;
     }
 
+    unescaped.resize(static_cast<std::size_t>(pos - unescaped.data()));
     return unescaped;
 }
 
@@ -22,7 +22,7 @@
 // SOFTWARE.
 //
 #include "hlib/usage.hpp"
-#include "hlib_format.hpp"
+#include "hlib/format.hpp"
 #include "hlib/string.hpp"
 #include <getopt.h>
 #include <sstream>
@@ -169,7 +169,7 @@ Result<std::size_t> Usage::parse(int argc, char const* const* argv)
         }
 
         if (index >= m_options.size()) {
-            return Error(std::invalid_argument(format("invalid option '%s'", arg.c_str())));
+            return Error(std::invalid_argument(HLIB_FORMAT("invalid option '{}'", arg)));
         }
 
         m_option_set[index] = true;
@@ -177,7 +177,7 @@ Result<std::size_t> Usage::parse(int argc, char const* const* argv)
         if (false == m_options[index].arg_name.empty()) {
             if (true == value.empty()) {
                 if (index + 1 >= static_cast<std::size_t>(argc)) {
-                    return Error(std::invalid_argument(format("option '%s' requires an argument", arg.c_str())));
+                    return Error(std::invalid_argument(HLIB_FORMAT("option '{}' requires an argument", arg)));
                 }
                 value = argv[++i];
             }
@@ -186,7 +186,7 @@ Result<std::size_t> Usage::parse(int argc, char const* const* argv)
 
             switch (m_options[index].arg_value.index()) {
             case None:
-                return Error(std::invalid_argument(format("option '%s' does not take an argument", arg.c_str())));
+                return Error(std::invalid_argument(HLIB_FORMAT("option '{}' does not take an argument", arg)));
             case String:    result = value; break;
             case Integer:   result = stoi64(value, 0, std::nothrow); break;
             case Float:     result = stof64(value, std::nothrow); break;
@@ -196,7 +196,7 @@ Result<std::size_t> Usage::parse(int argc, char const* const* argv)
                 return Error(std::logic_error("invalid option argument index"));
             }
             if (std::nullopt == result) {
-                return Error(std::invalid_argument(format("invalid '%s' argument '%s'", arg.c_str(), value.c_str())));
+                return Error(std::invalid_argument(HLIB_FORMAT("invalid '{}' argument '{}'", arg, value)));
             }
 
             m_option_values[index] = std::move(*result);
@@ -211,12 +211,12 @@ Result<std::size_t> Usage::parse(int argc, char const* const* argv)
     }
 
     if (index < m_arguments.size() && false == (optional|m_arguments[index].optional)) {
-        return Error(std::invalid_argument(format("missing argument '%s'", m_arguments[index].name.c_str())));
+        return Error(std::invalid_argument(HLIB_FORMAT("missing argument '{}'", m_arguments[index].name)));
     }
 
     if (argc > i) {
         if (false == m_varargs) {
-            return Error(std::invalid_argument(format("too many arguments")));
+            return Error(std::invalid_argument("too many arguments"));
         }
 
         for (; i < argc; ++i) {
@@ -268,13 +268,13 @@ std::string Usage::toString(std::string const& executable) const
 
     if (false == m_options.empty()) {
         auto prefix = [](Option const& option) -> std::string {
-            std::string str = 0 != option.brief ? format("-%c", option.brief) : "  ";
+            std::string str = 0 != option.brief ? HLIB_FORMAT("-{}", option.brief) : "  ";
             if (false == option.extended.empty()) {
                 str += 0 != option.brief ? ", ":"  ";
-                str += format("--%s", option.extended.c_str());
+                str += HLIB_FORMAT("--{}", option.extended);
             }
             if (false == option.arg_name.empty()) {
-                str += format("=%s", option.arg_name.c_str());
+                str += HLIB_FORMAT("={}", option.arg_name);
             }
             return str;
         };
@@ -22,7 +22,7 @@
 // SOFTWARE.
 //
 #include "hlib/uuid.hpp"
-#include "hlib_format.hpp"
+#include "hlib/format.hpp"
 
 using namespace hlib;
 
@@ -36,12 +36,16 @@ UUID::UUID()
 
 std::string hlib::to_string(UUID const& uuid)
 {
-    return format("%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+    FormatBuffer<36> string;
+
+    HVERIFY(HLIB_FORMAT_TO(string, "{:02x}{:02x}{:02x}{:02x}-{:02x}{:02x}-{:02x}{:02x}-{:02x}{:02x}-{:02x}{:02x}{:02x}{:02x}{:02x}{:02x}",
         uuid.octets[0], uuid.octets[1], uuid.octets[2], uuid.octets[3],
         uuid.octets[4], uuid.octets[5],
         uuid.octets[6], uuid.octets[7],
         uuid.octets[8], uuid.octets[9],
         uuid.octets[10], uuid.octets[11], uuid.octets[12], uuid.octets[13], uuid.octets[14], uuid.octets[15]
-    );
+    ));
+
+    return std::string(string.view());
 }
 
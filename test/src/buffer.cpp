@@ -124,3 +124,18 @@ TEST_CASE("Buffer Zeroed", "[buffer]")
     REQUIRE(true == isZero(buffer, 8, 8));
 }
 
+TEST_CASE("Buffer Aligned", "[buffer]")
+{
+    Buffer buffer("Hello World!");
+
+    void* data = buffer.reserveAligned(8192, 4096);
+    REQUIRE(nullptr != data);
+    REQUIRE(0 == reinterpret_cast<std::uintptr_t>(data) % 4096);
+    REQUIRE(8192 == buffer.capacity());
+    REQUIRE("Hello World!" == to_string(buffer));
+
+    // Already aligned and large enough.
+    REQUIRE(data == buffer.reserveAligned(4096, 4096));
+    REQUIRE(8192 == buffer.capacity());
+}
+
@@ -0,0 +1,268 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "test.hpp"
+#include "hlib/connection_pool.hpp"
+#include "hlib/file.hpp"
+#include <memory>
+#include <sys/socket.h>
+
+using namespace hlib;
+
+namespace
+{
+
+// TCP listener on the loopback interface that keeps accepted connections.
+class Listener final
+{
+public:
+    SockAddr address;
+    std::vector<Handle<int, -1>> connections;
+
+    Listener(std::shared_ptr<EventLoop> const& event_loop)
+        : m_event_loop(event_loop)
+        , m_fd(socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0), file::fd_close)
+    {
+        sockaddr_storage storage{};
+        socklen_t length = sizeof(storage);
+
+        address.parse("127.0.0.1:0");
+        REQUIRE(0 == bind(m_fd.get(), static_cast<sockaddr const*>(address), address.length()));
+        REQUIRE(0 == listen(m_fd.get(), 16));
+        REQUIRE(0 == getsockname(m_fd.get(), reinterpret_cast<sockaddr*>(&storage), &length));
+        address = storage;
+
+        event_loop->add(m_fd.get(), EventLoop::Read, [this](int fd, std::uint32_t) {
+            connections.emplace_back(accept(fd, nullptr, nullptr), file::fd_close);
+        });
+    }
+
+    ~Listener()
+    {
+        with_weak_ptr_locked(m_event_loop, [this](EventLoop& loop) {
+            loop.remove(m_fd.get());
+        });
+    }
+
+private:
+    std::weak_ptr<EventLoop> m_event_loop;
+    Handle<int, -1> m_fd;
+};
+
+template<typename Predicate>
+void dispatch_until(EventLoop& event_loop, Predicate predicate)
+{
+    for (int i = 0; i < 1000 && false == predicate(); ++i) {
+        event_loop.dispatch(time::Duration(time::MSec(10)));
+    }
+}
+
+} // namespace
+
+TEST_CASE("ConnectionPool", "[connection_pool]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+    Listener listener(event_loop);
+    SockAddr const& address = listener.address;
+
+    ConnectionPool pool(event_loop);
+
+    Handle<int, -1> connection(file::fd_close);
+    pool.checkout(address, [&](Handle<int, -1> fd, int error) {
+        REQUIRE(0 == error);
+        connection = std::move(fd);
+    });
+    dispatch_until(*event_loop, [&] { return -1 != connection.get() && 1 == listener.connections.size(); });
+
+    REQUIRE(-1 != connection.get());
+    REQUIRE(1 == pool.metrics().connects);
+
+    // Released connections are reused.
+    int const fd = connection.get();
+    pool.release(address, std::move(connection));
+    REQUIRE(1 == pool.idle(address));
+
+    pool.checkout(address, [&](Handle<int, -1> reused, int error) {
+        REQUIRE(0 == error);
+        connection = std::move(reused);
+    });
+    REQUIRE(fd == connection.get());
+    REQUIRE(0 == pool.idle(address));
+    REQUIRE(1 == pool.metrics().reused);
+    REQUIRE(0.5 == pool.metrics().reuseRate());
+
+    // Connections released by a Socket are reused too.
+    Socket socket(event_loop);
+    socket.open(std::move(connection));
+    pool.release(address, socket.release());
+    REQUIRE(-1 == socket.fd());
+    REQUIRE(1 == pool.idle(address));
+
+    // Idle connections closed by the peer are dropped.
+    listener.connections.clear();
+    dispatch_until(*event_loop, [&] { return 0 == pool.idle(address); });
+
+    REQUIRE(0 == pool.idle(address));
+    REQUIRE(1 == pool.metrics().closed);
+
+    // Peers without idle connections are forgotten.
+    REQUIRE(0 == pool.peers());
+}
+
+TEST_CASE("ConnectionPool Limits", "[connection_pool]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+    Listener listener(event_loop);
+    SockAddr const& address = listener.address;
+
+    ConnectionPool::Options options;
+    options.max_idle = 2;
+    options.max_connecting = 1;
+    options.idle_timeout = time::MSec(20);
+    ConnectionPool pool(event_loop, options);
+
+    std::vector<Handle<int, -1>> connections;
+    for (int i = 0; i < 3; ++i) {
+        pool.checkout(address, [&](Handle<int, -1> fd, int error) {
+            REQUIRE(0 == error);
+            connections.push_back(std::move(fd));
+        });
+    }
+    REQUIRE(1 >= pool.connecting());
+    REQUIRE(pool.waiting() + pool.connecting() + connections.size() == 3);
+
+    dispatch_until(*event_loop, [&] { return 3 == connections.size(); });
+
+    REQUIRE(3 == connections.size());
+    REQUIRE(3 == pool.metrics().connects);
+    REQUIRE(0 == pool.waiting());
+
+    // Only max_idle connections are kept, and those expire.
+    for (Handle<int, -1>& connection : connections) {
+        pool.release(address, std::move(connection));
+    }
+    REQUIRE(2 == pool.idle(address));
+    REQUIRE(1 == pool.metrics().discarded);
+
+    dispatch_until(*event_loop, [&] { return 0 == pool.idle(address); });
+
+    REQUIRE(0 == pool.idle(address));
+    REQUIRE(2 == pool.metrics().expired);
+}
+
+TEST_CASE("ConnectionPool Failure", "[connection_pool]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+
+    // Take a free port and close it again.
+    SockAddr address;
+    {
+        Listener listener(event_loop);
+        address = listener.address;
+    }
+
+    ConnectionPool pool(event_loop);
+
+    int error = 0;
+    pool.checkout(address, [&](Handle<int, -1> fd, int result) {
+        REQUIRE(-1 == fd.get());
+        error = result;
+    });
+    dispatch_until(*event_loop, [&] { return 0 != error; });
+
+    REQUIRE(ECONNREFUSED == error);
+    REQUIRE(1 == pool.metrics().failures);
+    REQUIRE(0 == pool.connecting());
+}
+
+TEST_CASE("ConnectionPool Release To Waiter", "[connection_pool]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+    Listener listener(event_loop);
+    SockAddr const& address = listener.address;
+
+    // A listener that never accepts, so that once its backlog is full
+    // connects to it stay in progress.
+    Handle<int, -1> stalled(socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0), file::fd_close);
+    SockAddr stalled_address;
+    {
+        sockaddr_storage storage{};
+        socklen_t length = sizeof(storage);
+
+        stalled_address.parse("127.0.0.1:0");
+        REQUIRE(0 == bind(stalled.get(), static_cast<sockaddr const*>(stalled_address), stalled_address.length()));
+        REQUIRE(0 == listen(stalled.get(), 0));
+        REQUIRE(0 == getsockname(stalled.get(), reinterpret_cast<sockaddr*>(&storage), &length));
+        stalled_address = storage;
+    }
+    Handle<int, -1> backlog(socket(AF_INET, SOCK_STREAM, 0), file::fd_close);
+    REQUIRE(0 == ::connect(backlog.get(), static_cast<sockaddr const*>(stalled_address), stalled_address.length()));
+
+    ConnectionPool::Options options;
+    options.max_connecting = 1;
+    auto pool_ptr = std::make_unique<ConnectionPool>(event_loop, options);
+    ConnectionPool& pool = *pool_ptr;
+
+    Handle<int, -1> connection(file::fd_close);
+    pool.checkout(address, [&](Handle<int, -1> fd, int error) {
+        REQUIRE(0 == error);
+        connection = std::move(fd);
+    });
+    dispatch_until(*event_loop, [&] { return -1 != connection.get(); });
+    REQUIRE(-1 != connection.get());
+
+    // Occupy the only connect slot, so the next checkout waits.
+    int stalled_error = 0;
+    pool.checkout(stalled_address, [&](Handle<int, -1> /* fd */, int error) noexcept {
+        stalled_error = error;
+    });
+    event_loop->dispatch(time::Duration(time::MSec(10)));
+    REQUIRE(1 == pool.connecting());
+
+    Handle<int, -1> handed(file::fd_close);
+    pool.checkout(address, [&](Handle<int, -1> fd, int error) {
+        REQUIRE(0 == error);
+        handed = std::move(fd);
+    });
+    REQUIRE(1 == pool.waiting());
+
+    // Releasing to the peer serves its waiting checkout.
+    int const fd = connection.get();
+    pool.release(address, std::move(connection));
+
+    REQUIRE(fd == handed.get());
+    REQUIRE(0 == pool.waiting());
+    REQUIRE(0 == pool.idle(address));
+    REQUIRE(1 == pool.metrics().reused);
+
+    // Destroying the pool cancels checkouts still connecting or waiting.
+    int waiting_error = 0;
+    pool.checkout(address, [&](Handle<int, -1> /* fd */, int error) noexcept {
+        waiting_error = error;
+    });
+    REQUIRE(1 == pool.waiting());
+
+    pool_ptr.reset();
+    REQUIRE(ECANCELED == stalled_error);
+    REQUIRE(ECANCELED == waiting_error);
+}
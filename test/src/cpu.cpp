@@ -23,10 +23,72 @@
 //
 #include "test.hpp"
 #include "hlib/cpu.hpp"
+#include "hlib/format.hpp"
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <pthread.h>
+#include <thread>
 #include <unistd.h>
 
 using namespace hlib;
 
+namespace
+{
+
+void write_file(std::filesystem::path const& path, std::string const& content)
+{
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path) << content << "\n";
+}
+
+// Two nodes with one package each, two cores per package and two SMT
+// threads per core. Threads of a core are numbered n and n + 4.
+std::filesystem::path make_sysfs()
+{
+    std::filesystem::path root = std::filesystem::temp_directory_path() / HLIB_FORMAT("hlib_sysfs_{}", getpid());
+    std::filesystem::remove_all(root);
+
+    write_file(root / "cpu/online", "0-7");
+    write_file(root / "node/online", "0-1");
+    write_file(root / "node/node0/cpulist", "0-1,4-5");
+    write_file(root / "node/node1/cpulist", "2-3,6-7");
+
+    for (int id = 0; id < 8; ++id) {
+        int const core = id % 4;
+        int const package = core / 2;
+        std::filesystem::path const directory = root / HLIB_FORMAT("cpu/cpu{}", id);
+
+        write_file(directory / "topology/core_id", std::to_string(core % 2));
+        write_file(directory / "topology/physical_package_id", std::to_string(package));
+        write_file(directory / "topology/thread_siblings_list", HLIB_FORMAT("{},{}", core, core + 4));
+
+        write_file(directory / "cache/index0/level", "1");
+        write_file(directory / "cache/index0/type", "Data");
+        write_file(directory / "cache/index0/size", "48K");
+        write_file(directory / "cache/index0/coherency_line_size", "64");
+        write_file(directory / "cache/index0/shared_cpu_list", HLIB_FORMAT("{},{}", core, core + 4));
+
+        write_file(directory / "cache/index1/level", "3");
+        write_file(directory / "cache/index1/type", "Unified");
+        write_file(directory / "cache/index1/size", "32M");
+        write_file(directory / "cache/index1/coherency_line_size", "64");
+        write_file(directory / "cache/index1/shared_cpu_list", 0 == package ? "0-1,4-5" : "2-3,6-7");
+    }
+
+    return root;
+}
+
+void burn_cpu(time::DurationNs const& duration)
+{
+    time::TimePoint const end = time::now_ns() + duration;
+    while (time::now_ns() < end) {
+    }
+}
+
+} // namespace
+
 TEST_CASE("CPU", "[cpu]")
 {
     REQUIRE(cpu_get_ticks_per_second().value() > 0);   
@@ -42,3 +104,136 @@ TEST_CASE("CPUMonitor", "[cpu]")
     REQUIRE(cpu_monitor.count() > 0);
     REQUIRE(true == cpu_monitor.update().success());
 }
+
+TEST_CASE("CPUTopology", "[cpu_topology]")
+{
+    std::filesystem::path const root = make_sysfs();
+
+    CPUTopology topology;
+    REQUIRE(true == topology.initialize(root.string()).success());
+
+    REQUIRE(8 == topology.cpus().size());
+    REQUIRE(std::vector<int>{ 0, 1 } == topology.nodes());
+
+    // Four L1 caches and two L3 caches.
+    REQUIRE(6 == topology.caches().size());
+
+    CPUTopology::CPU const* cpu = topology.cpu(6);
+    REQUIRE(nullptr != cpu);
+    REQUIRE(6 == cpu->id);
+    REQUIRE(1 == cpu->package);
+    REQUIRE(0 == cpu->core);
+    REQUIRE(1 == cpu->node);
+    REQUIRE(std::vector<int>{ 2, 6 } == cpu->siblings);
+    REQUIRE(2 == cpu->caches.size());
+    REQUIRE(nullptr == topology.cpu(8));
+
+    REQUIRE(std::vector<int>{ 0, 1, 4, 5 } == topology.cpusOfNode(0));
+    REQUIRE(8 == topology.cpusOfNode().size());
+
+    REQUIRE(std::vector<int>{ 0, 1, 2, 3 } == topology.physicalCores());
+    REQUIRE(std::vector<int>{ 2, 3 } == topology.physicalCores(1));
+    REQUIRE(true == topology.physicalCores(2).empty());
+
+    REQUIRE(std::vector<int>{ 1, 5 } == topology.sharingCache(5, 1));
+    REQUIRE(std::vector<int>{ 0, 1, 4, 5 } == topology.sharingCache(5, 3));
+    REQUIRE(48 * 1024 == topology.caches()[topology.cpu(0)->caches[0]].size);
+    REQUIRE(32 * 1024 * 1024 == topology.caches()[topology.cpu(0)->caches[1]].size);
+
+    std::filesystem::remove_all(root);
+
+    REQUIRE(true == topology.initialize(root.string()).failure());
+}
+
+TEST_CASE("CPUTopology System", "[cpu_topology]")
+{
+    CPUTopology topology;
+    REQUIRE(true == topology.initialize().success());
+    REQUIRE(false == topology.cpus().empty());
+    REQUIRE(false == topology.nodes().empty());
+    REQUIRE(false == topology.physicalCores().empty());
+    REQUIRE(topology.physicalCores().size() <= topology.cpus().size());
+}
+
+TEST_CASE("CPU Affinity", "[cpu_topology]")
+{
+    Result<std::vector<int>> affinity = cpu_get_affinity();
+    REQUIRE(true == affinity.success());
+    REQUIRE(false == affinity.value().empty());
+
+    std::vector<int> const original = affinity.value();
+
+    REQUIRE(true == cpu_set_affinity(original.back()).success());
+    REQUIRE(std::vector<int>{ original.back() } == cpu_get_affinity().value());
+
+    REQUIRE(true == cpu_set_affinity(original).success());
+    REQUIRE(original == cpu_get_affinity().value());
+}
+
+TEST_CASE("CPUMonitor Update", "[cpu_usage]")
+{
+    CPUMonitor cpu_monitor;
+    REQUIRE(true == cpu_monitor.initialize().success());
+    REQUIRE(cpu_monitor.count() > 0);
+    REQUIRE(cpu_monitor.current(-1).total > 0);
+    REQUIRE(cpu_monitor.current(-1).total >= cpu_monitor.current(0).total);
+
+    burn_cpu(time::MSec(50));
+    REQUIRE(true == cpu_monitor.update().success());
+
+    REQUIRE(cpu_monitor.total() > 0);
+    REQUIRE(cpu_monitor.busy() >= 0);
+    REQUIRE(cpu_monitor.busy() <= cpu_monitor.total());
+
+    std::int64_t total = 0;
+    for (int cpu = 0; cpu < cpu_monitor.count(); ++cpu) {
+        REQUIRE(cpu_monitor.total(cpu) >= 0);
+        total += cpu_monitor.current(cpu).total;
+    }
+    REQUIRE(total > 0);
+}
+
+TEST_CASE("CPU Usage", "[cpu_usage]")
+{
+    std::atomic<bool> burnt{ false };
+    std::atomic<bool> done{ false };
+    CPUUsage thread_usage;
+
+    std::thread thread([&]() {
+        pthread_setname_np(pthread_self(), "hlib_burn");
+        burn_cpu(time::MSec(100));
+
+        thread_usage = cpu_get_thread_usage().value();
+        burnt = true;
+
+        while (false == done) {
+            usleep(1000);
+        }
+    });
+
+    while (false == burnt) {
+        usleep(1000);
+    }
+
+    std::vector<CPUUsage> usages;
+    Result<> result = cpu_get_thread_usages(usages);
+    done = true;
+    thread.join();
+
+    REQUIRE(true == result.success());
+    REQUIRE(usages.size() >= 2);
+
+    REQUIRE(0 == std::strcmp("hlib_burn", thread_usage.name));
+    REQUIRE((thread_usage.user + thread_usage.system).count() >= time::DurationNs(time::MSec(50)).count());
+
+    auto it = std::find_if(usages.begin(), usages.end(), [&](CPUUsage const& usage) {
+        return usage.id == thread_usage.id;
+    });
+    REQUIRE(usages.end() != it);
+    REQUIRE(0 == std::strcmp("hlib_burn", it->name));
+    REQUIRE((it->user + it->system).count() >= time::DurationNs(time::MSec(50)).count());
+
+    CPUUsage process_usage = cpu_get_process_usage().value();
+    REQUIRE(getpid() == process_usage.id);
+    REQUIRE((process_usage.user + process_usage.system).count() >= (thread_usage.user + thread_usage.system).count());
+}
@@ -0,0 +1,191 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "test.hpp"
+#include "hlib/datagram_socket.hpp"
+#include <string>
+
+using namespace hlib;
+
+namespace
+{
+
+std::string to_string(DatagramSocket::Datagram const& datagram)
+{
+    return std::string(reinterpret_cast<char const*>(datagram.data), datagram.size);
+}
+
+} // namespace
+
+TEST_CASE("DatagramSocket", "[datagram_socket]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+
+    DatagramSocket server(event_loop, 16, 64);
+    server.open(SockAddr("127.0.0.1:0"), 0, 0);
+
+    DatagramSocket client(event_loop, 16, 64);
+    client.open(SockAddr("127.0.0.1:0"), 0, 0);
+
+    SockAddr const server_address = server.getLocalAddress();
+    SockAddr const client_address = client.getLocalAddress();
+
+    std::vector<std::string> received;
+
+    // Echo every batch back to its senders.
+    server.receive([&](DatagramSocket::Datagram const* datagrams, std::size_t count) {
+        REQUIRE(count <= 16);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            REQUIRE(client_address == datagrams[i].address);
+            REQUIRE(0 == datagrams[i].segment_size);
+        }
+
+        REQUIRE(count == server.send(datagrams, count));
+    });
+
+    client.receive([&](DatagramSocket::Datagram const* datagrams, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            REQUIRE(server_address == datagrams[i].address);
+            received.push_back(to_string(datagrams[i]));
+        }
+
+        if (100 == received.size()) {
+            event_loop->interrupt();
+        }
+    });
+
+    std::vector<std::string> payloads;
+    std::vector<DatagramSocket::Datagram> datagrams(100);
+
+    for (std::size_t i = 0; i < datagrams.size(); ++i) {
+        payloads.push_back("datagram " + std::to_string(i));
+    }
+    for (std::size_t i = 0; i < datagrams.size(); ++i) {
+        datagrams[i].data = reinterpret_cast<std::uint8_t const*>(payloads[i].data());
+        datagrams[i].size = payloads[i].size();
+        datagrams[i].address = server_address;
+    }
+
+    REQUIRE(100 == client.send(datagrams.data(), datagrams.size()));
+
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE(payloads == received);
+}
+
+TEST_CASE("DatagramSocket Connected", "[datagram_socket]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+
+    DatagramSocket server(event_loop);
+    server.open(SockAddr("127.0.0.1:0"), 0, 0);
+
+    DatagramSocket client(event_loop);
+    client.open(SockAddr("127.0.0.1:0"), 0, 0);
+    client.connect(server.getLocalAddress());
+
+    std::string received;
+
+    server.receive([&](DatagramSocket::Datagram const* datagrams, std::size_t count) {
+        REQUIRE(1 == count);
+        REQUIRE(client.getLocalAddress() == datagrams[0].address);
+        received = to_string(datagrams[0]);
+        event_loop->interrupt();
+    });
+
+    DatagramSocket::Datagram datagram;
+    datagram.data = reinterpret_cast<std::uint8_t const*>("connected");
+    datagram.size = 9;
+
+    REQUIRE(1 == client.send(&datagram, 1));
+
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE("connected" == received);
+
+    // Nobody listens on the closed server port.
+    int error = 0;
+
+    server.close();
+    client.setErrorCallback([&](int result) {
+        error = result;
+        event_loop->interrupt();
+    });
+    client.receive([&](DatagramSocket::Datagram const*, std::size_t) {
+    });
+
+    REQUIRE(1 == client.send(&datagram, 1));
+
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE(ECONNREFUSED == error);
+}
+
+TEST_CASE("DatagramSocket Segmentation", "[datagram_socket]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+
+    DatagramSocket server(event_loop, 8, 65536);
+    if (true == server.open(SockAddr("127.0.0.1:0"), 0, DatagramSocket::GRO, std::nothrow).failure()) {
+        WARN("UDP GRO not supported");
+        return;
+    }
+
+    DatagramSocket client(event_loop);
+    client.open(SockAddr("127.0.0.1:0"), 0, 0);
+
+    std::size_t received = 0;
+
+    server.receive([&](DatagramSocket::Datagram const* datagrams, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            REQUIRE((0 == datagrams[i].segment_size || 1000 == datagrams[i].segment_size));
+            REQUIRE(0 == datagrams[i].size % 1000);
+            received += datagrams[i].size;
+        }
+
+        if (3000 == received) {
+            event_loop->interrupt();
+        }
+    });
+
+    // One send, split into three UDP datagrams by the kernel (GSO).
+    std::vector<std::uint8_t> payload(3000, 0x5a);
+
+    DatagramSocket::Datagram datagram;
+    datagram.data = payload.data();
+    datagram.size = payload.size();
+    datagram.address = server.getLocalAddress();
+    datagram.segment_size = 1000;
+
+    auto result = client.send(&datagram, 1, std::nothrow);
+    if (true == result.failure()) {
+        WARN("UDP GSO not supported");
+        return;
+    }
+    REQUIRE(1 == *result);
+
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE(3000 == received);
+}
@@ -23,6 +23,7 @@
 //
 #include "test.hpp"
 #include "hlib/error.hpp"
+#include "hlib/result.hpp"
 #include "hlib/string.hpp"
 
 using namespace hlib;
@@ -57,6 +58,36 @@ TEST_CASE("Error", "[error]")
     REQUIRE_THROWS_AS(bad_alloc.toss(), std::bad_alloc);
 }
 
+TEST_CASE("Error Code", "[error]")
+{
+    Error error = make_error(EAGAIN, "read() failed");
+    REQUIRE(false == error.empty());
+    REQUIRE(std::errc::resource_unavailable_try_again == error.code());
+    REQUIRE(std::system_error(make_error_code(EAGAIN), "read() failed").what() == error.what());
+
+    try {
+        error.toss();
+        FAIL();
+    }
+    catch (std::system_error const& e) {
+        REQUIRE(std::errc::resource_unavailable_try_again == e.code());
+        REQUIRE(error.what() == e.what());
+    }
+
+    Error without_context = make_error(ENOENT);
+    REQUIRE(make_error_code(ENOENT) == without_context.code());
+    REQUIRE(make_error_code(ENOENT).message() == without_context.what());
+    REQUIRE_THROWS_AS(without_context.toss(), std::system_error);
+
+    // Codes of system errors are available without rethrowing.
+    Error system_error(make_system_error(EINVAL, "system error"));
+    REQUIRE(make_error_code(EINVAL) == system_error.code());
+
+    system_error = std::logic_error("logic error");
+    REQUIRE(std::error_code() == system_error.code());
+    REQUIRE("logic error" == system_error.what());
+}
+
 TEST_CASE("Error Boolean", "[error]")
 {
     Error error;
@@ -71,4 +102,3 @@ TEST_CASE("Error Boolean", "[error]")
     REQUIRE(bad_alloc == true);
     REQUIRE(bad_alloc != false);
 }
-
@@ -23,7 +23,10 @@
 //
 #include "test.hpp"
 #include "hlib/event_loop.hpp"
+#include "hlib/timer.hpp"
 #include <thread>
+#include <unistd.h>
+#include <vector>
 
 using namespace hlib;
 
@@ -39,3 +42,83 @@ TEST_CASE("EventLoop", "[events]")
     thread.join();
 }
 
+TEST_CASE("EventLoop Now", "[events]")
+{
+    EventLoop event_loop;
+    file::Pipe pipe;
+    pipe.open();
+
+    std::vector<time::Clock> times;
+    event_loop.add(pipe[0], EventLoop::Read, [&](int fd, std::uint32_t) {
+        std::uint8_t byte;
+        HVERIFY(1 == read(fd, &byte, 1));
+        times.push_back(event_loop.now());
+    });
+
+    time::Clock const start = time::now();
+    HVERIFY(1 == write(pipe[1], "x", 1));
+    event_loop.dispatch(time::Duration(time::MSec(5)));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    HVERIFY(1 == write(pipe[1], "x", 1));
+    event_loop.dispatch(time::Duration(time::MSec(5)));
+
+    REQUIRE(2 == times.size());
+    REQUIRE(start <= times[0]);
+    REQUIRE(times[1] - times[0] >= time::Duration(time::MSec(2)));
+    REQUIRE(time::now() >= event_loop.now());
+
+    event_loop.remove(pipe[0]);
+}
+
+TEST_CASE("EventLoop Timeout", "[events]")
+{
+    EventLoop event_loop;
+    file::Pipe pipe;
+    pipe.open();
+
+    event_loop.add(pipe[0], EventLoop::Read, [&](int fd, std::uint32_t) {
+        std::uint8_t byte;
+        HVERIFY(1 == read(fd, &byte, 1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(90));
+    });
+
+    // The callback consumes most of the timeout, which must not restart.
+    time::Clock const start = time::now();
+    HVERIFY(1 == write(pipe[1], "x", 1));
+    event_loop.dispatch(time::Duration(time::MSec(100)));
+
+    REQUIRE(time::now() - start < time::Duration(time::MSec(150)));
+
+    event_loop.remove(pipe[0]);
+}
+
+TEST_CASE("Timer", "[events]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+
+    int expired = 0;
+    Timer timer(event_loop, [&] {
+        ++expired;
+        event_loop->interrupt();
+    });
+
+    // Durations of either type, ratio values and seconds as a double.
+    REQUIRE(true == timer.set(time::DurationNs(time::MSec(1))));
+    REQUIRE(true == timer.set(time::Duration(time::MSec(1))));
+    REQUIRE(true == timer.set({ 0, 1000000 }));
+    REQUIRE(true == timer.set(0.001));
+    REQUIRE(true == timer.set(time::MSec(1)));
+    event_loop->dispatch(time::Sec(10));
+    REQUIRE(1 == expired);
+
+    Timer periodic(event_loop, [&] {
+        ++expired;
+        event_loop->interrupt();
+    }, 0.001, 0.001);
+    event_loop->dispatch(time::Sec(10));
+    event_loop->dispatch(time::Sec(10));
+    REQUIRE(3 == expired);
+
+    REQUIRE(true == periodic.clear());
+}
@@ -0,0 +1,205 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "test.hpp"
+#include "hlib/fdio.hpp"
+#include "hlib/file.hpp"
+#include "hlib/string.hpp"
+#include <cstdio>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace hlib;
+
+namespace
+{
+
+std::string make_payload(std::size_t size)
+{
+    std::string payload(size, '\0');
+    for (std::size_t i = 0; i < size; ++i) {
+        payload[i] = static_cast<char>('a' + i % 26);
+    }
+    return payload;
+}
+
+void write_all(int fd, std::string const& data)
+{
+    for (std::size_t offset = 0; offset < data.size();) {
+        ssize_t size = ::write(fd, data.data() + offset, data.size() - offset);
+        REQUIRE(size > 0);
+        offset += size;
+    }
+}
+
+std::string read_all(int fd)
+{
+    std::string data;
+    char buffer[65536];
+    ssize_t size;
+
+    while ((size = ::read(fd, buffer, sizeof(buffer))) > 0) {
+        data.append(buffer, size);
+    }
+    return data;
+}
+
+struct Relayed
+{
+    std::size_t size{ 0 };
+    int error{ -1 };
+};
+
+// Pipes source to destination on an event loop, closing the original
+// destination on completion so readers see end-of-file.
+Relayed relay(int source_fd, int destination_fd, std::size_t size = FileDescriptorRelay::Unlimited)
+{
+    auto event_loop = std::make_shared<EventLoop>();
+    FileDescriptorRelay relay(event_loop);
+    Relayed relayed;
+
+    relay.pipe(source_fd, destination_fd, [&](std::size_t transferred, int error) {
+        relayed.size = transferred;
+        relayed.error = error;
+        ::close(destination_fd);
+        event_loop->interrupt();
+    }, size);
+
+    if (true == relay.active()) {
+        event_loop->dispatch(time::Sec(10));
+    }
+    return relayed;
+}
+
+} // namespace
+
+TEST_CASE("FileDescriptorRelay Pipe", "[fdio]")
+{
+    std::string const payload = make_payload(1024 * 1024);
+
+    file::Pipe source(true);
+    file::Pipe destination(true);
+
+    std::thread writer([&] {
+        write_all(source[1], payload);
+        source.close<1>();
+    });
+
+    std::string received;
+    std::thread reader([&] {
+        received = read_all(destination[0]);
+    });
+
+    Relayed relayed = relay(source[0], destination.get<1>().release());
+
+    writer.join();
+    reader.join();
+
+    REQUIRE(0 == relayed.error);
+    REQUIRE(payload.size() == relayed.size);
+    REQUIRE(payload == received);
+}
+
+TEST_CASE("FileDescriptorRelay File to Socket", "[fdio]")
+{
+    std::string const payload = make_payload(1024 * 1024 + 13);
+
+    FILE* file = tmpfile();
+    REQUIRE(nullptr != file);
+    write_all(fileno(file), payload);
+    REQUIRE(0 == lseek(fileno(file), 0, SEEK_SET));
+
+    int sockets[2];
+    REQUIRE(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+
+    std::string received;
+    std::thread reader([&] {
+        received = read_all(sockets[1]);
+    });
+
+    Relayed relayed = relay(fileno(file), sockets[0]);
+    reader.join();
+
+    REQUIRE(0 == relayed.error);
+    REQUIRE(payload.size() == relayed.size);
+    REQUIRE(payload == received);
+
+    ::close(sockets[1]);
+    fclose(file);
+}
+
+TEST_CASE("FileDescriptorRelay Socket to Socket", "[fdio]")
+{
+    std::string const payload = make_payload(1024 * 1024 + 7);
+
+    int source[2];
+    int destination[2];
+    REQUIRE(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, source));
+    REQUIRE(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, destination));
+
+    std::thread writer([&] {
+        write_all(source[1], payload);
+        ::shutdown(source[1], SHUT_WR);
+    });
+
+    std::string received;
+    std::thread reader([&] {
+        received = read_all(destination[1]);
+    });
+
+    Relayed relayed = relay(source[0], destination[0]);
+
+    writer.join();
+    reader.join();
+
+    REQUIRE(0 == relayed.error);
+    REQUIRE(payload.size() == relayed.size);
+    REQUIRE(payload == received);
+
+    ::close(source[0]);
+    ::close(source[1]);
+    ::close(destination[1]);
+}
+
+TEST_CASE("FileDescriptorRelay Size", "[fdio]")
+{
+    FILE* source = tmpfile();
+    FILE* destination = tmpfile();
+    REQUIRE(nullptr != source);
+    REQUIRE(nullptr != destination);
+
+    write_all(fileno(source), "Hello World!");
+    REQUIRE(0 == lseek(fileno(source), 0, SEEK_SET));
+
+    // Neither side is pollable, relay completes synchronously.
+    Relayed relayed = relay(fileno(source), dup(fileno(destination)), 5);
+    REQUIRE(0 == relayed.error);
+    REQUIRE(5 == relayed.size);
+
+    REQUIRE(0 == lseek(fileno(destination), 0, SEEK_SET));
+    REQUIRE("Hello" == read_all(fileno(destination)));
+
+    fclose(source);
+    fclose(destination);
+}
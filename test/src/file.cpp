@@ -0,0 +1,450 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "test.hpp"
+#include "hlib/file.hpp"
+#include "hlib/serial.hpp"
+#include "hlib/string.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+using namespace hlib;
+
+namespace
+{
+
+std::string make_payload(std::size_t size)
+{
+    std::string payload(size, '\0');
+    for (std::size_t i = 0; i < size; ++i) {
+        payload[i] = static_cast<char>(i * 31 + i / 251);
+    }
+    return payload;
+}
+
+std::string make_temporary_file(std::string const& name, std::string const& content)
+{
+    std::string filepath = (std::filesystem::temp_directory_path() / name).string();
+
+    std::ofstream stream(filepath, std::ios::binary);
+    stream.write(content.data(), content.size());
+    return filepath;
+}
+
+// Returns the VmFlags of the mapping containing address, e.g. "rr" for
+// MADV_RANDOM and "sr" for MADV_SEQUENTIAL.
+std::string get_vm_flags(void const* address)
+{
+    std::uintptr_t const value = reinterpret_cast<std::uintptr_t>(address);
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    bool found = false;
+
+    while (std::getline(smaps, line)) {
+        unsigned long start;
+        unsigned long end;
+
+        if (2 == sscanf(line.c_str(), "%lx-%lx ", &start, &end)) {
+            found = start <= value && value < end;
+        }
+        else if (true == found && 0 == line.compare(0, 8, "VmFlags:")) {
+            return line.substr(8);
+        }
+    }
+
+    return {};
+}
+
+} // namespace
+
+TEST_CASE("MappedFile", "[file]")
+{
+    std::string const content = "Hello\nWorld\n!";
+    std::string const filepath = make_temporary_file("hlib_mapped_file.txt", content);
+
+    file::MappedFile mapped(filepath, file::MappedFile::Sequential | file::MappedFile::WillNeed);
+    REQUIRE(content.size() == mapped.size());
+    REQUIRE(false == mapped.empty());
+    REQUIRE(content == mapped.view());
+    REQUIRE("World" == mapped.view(6, 5));
+    REQUIRE(1 == std::count(mapped.begin(), mapped.end(), std::byte('!')));
+
+    std::size_t offset = 0;
+    REQUIRE("Hello" == mapped.extract(offset, "\n", false));
+    REQUIRE("World\n" == mapped.extract(offset, "\n", true));
+    REQUIRE(12 == offset);
+    REQUIRE(true == mapped.extract(offset, "\n", false).empty());
+    REQUIRE(12 == offset);
+
+    // Hints are best effort, huge pages may not be supported for files.
+    REQUIRE_NOTHROW(mapped.advise(0, mapped.size(), file::MappedFile::Random, std::nothrow));
+    REQUIRE(std::string::npos != get_vm_flags(mapped.data()).find(" rr"));
+
+    // Normal resets the access pattern.
+    REQUIRE(true == mapped.advise(0, mapped.size(), file::MappedFile::Normal, std::nothrow).success());
+    REQUIRE(std::string::npos == get_vm_flags(mapped.data()).find(" rr"));
+    REQUIRE(std::string::npos == get_vm_flags(mapped.data()).find(" sr"));
+
+    file::MappedFile moved(std::move(mapped));
+    REQUIRE(true == mapped.empty());
+    REQUIRE(nullptr == mapped.data());
+    REQUIRE(content == moved.view());
+
+    moved.close();
+    REQUIRE(true == moved.empty());
+
+    std::filesystem::remove(filepath);
+}
+
+TEST_CASE("MappedFile Source", "[file]")
+{
+    std::string const content("\x01\x02\x03\x04Hello", 9);
+    std::string const filepath = make_temporary_file("hlib_mapped_file.bin", content);
+
+    auto source = file::make_shared_source_mapped_file(filepath);
+    REQUIRE(9 == source->available());
+    REQUIRE(source->get().data() == source->peek(1));
+
+    std::uint32_t value;
+    std::string string;
+    be::Deserializer deserializer(*source);
+    deserializer.transform(value);
+    deserializer.transform(string, 5);
+
+    REQUIRE(0x01020304 == value);
+    REQUIRE("Hello" == string);
+    REQUIRE(true == source->empty());
+
+    std::filesystem::remove(filepath);
+}
+
+TEST_CASE("MappedFile Errors", "[file]")
+{
+    std::error_code error_code;
+    file::MappedFile missing("/nonexistent/hlib_mapped_file", file::MappedFile::Normal, error_code);
+    REQUIRE(ENOENT == error_code.value());
+    REQUIRE(true == missing.empty());
+
+    std::string const filepath = make_temporary_file("hlib_mapped_file.empty", "");
+    file::MappedFile empty(filepath);
+    REQUIRE(true == empty.empty());
+    REQUIRE(true == empty.view().empty());
+    REQUIRE(empty.begin() == empty.end());
+
+    std::filesystem::remove(filepath);
+}
+
+TEST_CASE("File Read Batches", "[file]")
+{
+    std::string const content = make_payload(100000);
+    std::string const filepath = make_temporary_file("hlib_file_read.bin", content);
+
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    REQUIRE(-1 != fd);
+    REQUIRE(content == to_string(file::read(fd, 4096)));
+    REQUIRE(7 == lseek(fd, 7, SEEK_SET));
+    REQUIRE(content.substr(7) == to_string(file::read(fd, 4096)));
+
+    // The preallocated buffer is not grown to detect the end of the file.
+    REQUIRE(0 == lseek(fd, 0, SEEK_SET));
+    Buffer buffer = file::read(fd, 4096);
+    REQUIRE(content.size() == buffer.size());
+    REQUIRE(buffer.capacity() < content.size() + 4096);
+    ::close(fd);
+
+    FILE* file = fopen(filepath.c_str(), "rb");
+    REQUIRE(nullptr != file);
+    REQUIRE(content == to_string(file::read(file, 4096)));
+    REQUIRE(0 == fseek(file, 0, SEEK_SET));
+    REQUIRE(file::read(file, 4096).capacity() < content.size() + 4096);
+    fclose(file);
+
+    std::ifstream stream(filepath, std::ios::binary);
+    REQUIRE(content == to_string(file::read(stream, 4096)));
+
+    std::filesystem::remove(filepath);
+}
+
+TEST_CASE("File Read Options", "[file]")
+{
+    std::string const content = make_payload(10 * 1024 * 1024 + 123);
+    std::string const filepath = make_temporary_file("hlib_file_read_options.bin", content);
+
+    REQUIRE(content == to_string(file::read(filepath)));
+
+    file::ReadOptions options;
+    options.chunk_size = 1024 * 1024;
+    options.threads = 4;
+    REQUIRE(content == to_string(file::read(filepath, options)));
+
+    // Falls back to buffered reads when O_DIRECT is not supported.
+    options.direct = true;
+    options.chunk_size = 1000;
+    REQUIRE(content == to_string(file::read(filepath, options)));
+
+    // Files without a size are read until end-of-file.
+    REQUIRE(false == file::read("/proc/self/status", options).empty());
+
+    Result<Buffer> missing = file::read("/nonexistent/hlib_file", options, std::nothrow);
+    REQUIRE(true == missing.failure());
+    REQUIRE(ENOENT == missing.error().code().value());
+
+    std::filesystem::remove(filepath);
+}
+
+TEST_CASE("FileWriter", "[file]")
+{
+    std::string const filepath = make_temporary_file("hlib_file_writer.bin", "header");
+    std::string const payload = make_payload(100 * 1000);
+
+    for (bool io_thread : { false, true }) {
+        make_temporary_file("hlib_file_writer.bin", "header");
+
+        file::FileWriterOptions options;
+        options.batch_size = 16 * 1024;
+        options.chunk_size = 1000;
+        options.io_thread = io_thread;
+
+        std::size_t batched = 0;
+        file::FileWriter writer(filepath, options);
+        writer.setBatchCallback([&](file::FileWriter::Batch const& batch) {
+            batched += batch.size;
+        });
+        REQUIRE(6 == writer.size());
+
+        // Small records, batched into aligned writes.
+        for (std::size_t offset = 0; offset < payload.size(); offset += 100) {
+            writer.append(payload.data() + offset, 100);
+        }
+        Buffer trailer;
+        trailer.append("trailer", 7);
+        writer.append(std::move(trailer));
+        writer.commit();
+
+        REQUIRE(6 + payload.size() + 7 == writer.size());
+        REQUIRE("header" + payload + "trailer" == to_string(file::read(filepath)));
+
+        file::FileWriter::Metrics metrics = writer.metrics();
+        REQUIRE(payload.size() + 7 == metrics.bytes);
+        REQUIRE(payload.size() + 7 == batched);
+        REQUIRE(1 <= metrics.syncs);
+        REQUIRE(1 == metrics.commits);
+        REQUIRE(metrics.max_batch_size <= metrics.bytes);
+        REQUIRE(metrics.batches < payload.size() / 100);
+
+        // Nothing left to commit.
+        writer.commit();
+        REQUIRE(metrics.syncs == writer.metrics().syncs);
+
+        writer.append("!", 1);
+        writer.close();
+        REQUIRE("header" + payload + "trailer!" == to_string(file::read(filepath)));
+        REQUIRE(true == writer.append("?", 1, std::nothrow).failure());
+    }
+
+    std::filesystem::remove(filepath);
+}
+
+TEST_CASE("FileWriter Group Commit", "[file]")
+{
+    std::string const filepath = make_temporary_file("hlib_file_writer_group.bin", "");
+
+    for (bool io_thread : { false, true }) {
+        make_temporary_file("hlib_file_writer_group.bin", "");
+
+        file::FileWriterOptions options;
+        options.commit_latency = time::MSec(2);
+        options.io_thread = io_thread;
+
+        file::FileWriter writer(filepath, options);
+
+        constexpr std::size_t threads = 8;
+        constexpr std::size_t records = 50;
+        std::vector<std::thread> committers;
+
+        for (std::size_t i = 0; i < threads; ++i) {
+            committers.emplace_back([&writer, i] {
+                std::string const record(64, static_cast<char>('a' + i));
+                for (std::size_t j = 0; j < records; ++j) {
+                    writer.append(record.data(), record.size());
+                    writer.commit();
+                }
+            });
+        }
+        for (std::thread& committer : committers) {
+            committer.join();
+        }
+
+        file::FileWriter::Metrics metrics = writer.metrics();
+        REQUIRE(threads * records * 64 == metrics.bytes);
+        REQUIRE(threads * records == metrics.commits);
+        REQUIRE(metrics.syncs < metrics.commits);
+
+        writer.close();
+
+        std::string const content = to_string(file::read(filepath));
+        REQUIRE(threads * records * 64 == content.size());
+        for (std::size_t i = 0; i < threads; ++i) {
+            REQUIRE(records * 64 == static_cast<std::size_t>(std::count(content.begin(), content.end(), 'a' + i)));
+        }
+    }
+
+    std::filesystem::remove(filepath);
+}
+
+TEST_CASE("FileWriter Small Batch", "[file]")
+{
+    std::string const filepath = make_temporary_file("hlib_file_writer_small.bin", "");
+    std::string const payload = make_payload(200);
+
+    // A batch size below the alignment must not stall the writer.
+    for (bool io_thread : { false, true }) {
+        make_temporary_file("hlib_file_writer_small.bin", "");
+
+        file::FileWriterOptions options;
+        options.batch_size = 100;
+        options.alignment = 4096;
+        options.io_thread = io_thread;
+
+        file::FileWriter writer(filepath, options);
+        writer.append(payload.data(), payload.size());
+
+        // Let the I/O thread see the full batch before committing.
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        writer.commit();
+
+        REQUIRE(payload == to_string(file::read(filepath)));
+        REQUIRE(1 == writer.metrics().syncs);
+
+        writer.close();
+    }
+
+    std::filesystem::remove(filepath);
+}
+
+TEST_CASE("FileWriter Unaligned Journal", "[file]")
+{
+    std::string const existing = make_payload(100);
+    std::string const filepath = make_temporary_file("hlib_file_writer_unaligned.bin", existing);
+    std::string const payload = make_payload(20000);
+
+    file::FileWriterOptions options;
+    options.batch_size = 4096;
+    options.alignment = 4096;
+
+    file::FileWriter writer(filepath, options);
+
+    std::vector<std::size_t> sizes;
+    writer.setBatchCallback([&](file::FileWriter::Batch const& batch) {
+        sizes.push_back(batch.size);
+    });
+
+    for (std::size_t offset = 0; offset < payload.size(); offset += 1000) {
+        writer.append(payload.data() + offset, 1000);
+    }
+    REQUIRE(false == sizes.empty());
+
+    // Batches end on block boundaries of the file, not of the batch.
+    std::size_t end = existing.size();
+    for (std::size_t size : sizes) {
+        end += size;
+        REQUIRE(0 == end % options.alignment);
+    }
+
+    writer.commit();
+    REQUIRE(existing + payload == to_string(file::read(filepath)));
+
+    writer.close();
+    std::filesystem::remove(filepath);
+}
+
+TEST_CASE("FileWriter Errors", "[file]")
+{
+    file::FileWriter writer;
+    REQUIRE(true == writer.append("x", 1, std::nothrow).failure());
+    REQUIRE(true == writer.commit(std::nothrow).failure());
+    REQUIRE(true == writer.close(std::nothrow).success());
+
+    Result<> result = writer.open("/nonexistent/hlib_file_writer", file::FileWriterOptions(), std::nothrow);
+    REQUIRE(true == result.failure());
+    REQUIRE(ENOENT == result.error().code().value());
+}
+
+TEST_CASE("MIME Type", "[file]")
+{
+    using namespace std::string_view_literals;
+
+    auto sniff = [](std::string_view const& data) {
+        return file::get_mime_type(data.data(), data.size(), "application/octet-stream");
+    };
+
+    REQUIRE("image/png" == sniff("\x89PNG\r\n\x1A\n\0\0\0\rIHDR"sv));
+    REQUIRE("image/jpeg" == sniff("\xFF\xD8\xFF\xE0"sv));
+    REQUIRE("image/gif" == sniff("GIF89a"));
+    REQUIRE("image/webp" == sniff("RIFF\x10\0\0\0WEBPVP8 "sv));
+    REQUIRE("audio/wav" == sniff("RIFF\x10\0\0\0WAVEfmt "sv));
+    REQUIRE("video/mp4" == sniff("\0\0\0\x18" "ftypmp42"sv));
+    REQUIRE("application/wasm" == sniff("\0asm\1\0\0\0"sv));
+    REQUIRE("application/pdf" == sniff("%PDF-1.7"));
+    REQUIRE("text/html" == sniff("<!DOCTYPE html>"));
+    REQUIRE("application/octet-stream" == sniff("RIFF\x10\0\0\0"sv));
+    REQUIRE("application/octet-stream" == sniff("hello"));
+    REQUIRE("application/octet-stream" == sniff(""));
+
+    std::shared_ptr<SourceAdapter<Buffer>> source = make_shared_source_buffer("xx%PDF-1.4");
+    source->consume(2);
+    REQUIRE("application/pdf" == file::get_mime_type(*source, ""));
+    REQUIRE(8 == source->available());
+
+    REQUIRE("text/html" == file::get_mime_type_from_extension(".html", ""));
+    REQUIRE("font/woff2" == file::get_mime_type_from_extension("woff2", ""));
+    REQUIRE("none" == file::get_mime_type_from_extension("unknown", "none"));
+    REQUIRE("none" == file::get_mime_type_from_extension("", "none"));
+}
+
+TEST_CASE("MIME Type From File", "[file]")
+{
+    std::string const png = make_temporary_file("hlib_mime_type.dat", "\x89PNG\r\n\x1A\n");
+    REQUIRE("image/png" == file::get_mime_type_from_file(png, ""));
+    REQUIRE("image/png" == file::get_mime_type_from_file(png, ""));
+
+    // The cache is invalidated by modifications.
+    make_temporary_file("hlib_mime_type.dat", "GIF87a and more");
+    REQUIRE("image/gif" == file::get_mime_type_from_file(png, ""));
+    std::filesystem::remove(png);
+
+    // Unknown content falls back to the extension.
+    std::string const json = make_temporary_file("hlib_mime_type.json", "{}");
+    REQUIRE("application/json" == file::get_mime_type_from_file(json, ""));
+    std::filesystem::remove(json);
+
+    Result<std::string_view> missing = file::get_mime_type_from_file("/nonexistent/hlib_mime", "", std::nothrow);
+    REQUIRE(true == missing.failure());
+    REQUIRE(ENOENT == missing.error().code().value());
+    REQUIRE(true == file::get_mime_type_from_file(std::filesystem::temp_directory_path().string(), "", std::nothrow).failure());
+}
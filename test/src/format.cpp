@@ -0,0 +1,106 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "test.hpp"
+#include "hlib/format.hpp"
+#include "hlib/buffer.hpp"
+#include "hlib/sink.hpp"
+#include <limits>
+
+using namespace hlib;
+
+TEST_CASE("Format Count Arguments", "[format]")
+{
+    static_assert(0 == format_count_arguments(""));
+    static_assert(0 == format_count_arguments("foo {{}} bar"));
+    static_assert(1 == format_count_arguments("{}"));
+    static_assert(3 == format_count_arguments("{:<8}{:08.3f}{:X}"));
+    static_assert(-1 == format_count_arguments("{"));
+    static_assert(-1 == format_count_arguments("}"));
+    static_assert(-1 == format_count_arguments("{:.}"));
+    static_assert(-1 == format_count_arguments("{:q}"));
+}
+
+TEST_CASE("Format", "[format]")
+{
+    REQUIRE("foo" == format("foo"));
+    REQUIRE("{foo}" == format("{{foo}}"));
+    REQUIRE("1 2 3" == HLIB_FORMAT("{} {} {}", 1, 2u, std::int64_t(3)));
+    REQUIRE("-42" == HLIB_FORMAT("{}", -42));
+    REQUIRE("-9223372036854775808" == HLIB_FORMAT("{}", std::numeric_limits<std::int64_t>::min()));
+    REQUIRE("18446744073709551615" == HLIB_FORMAT("{}", std::numeric_limits<std::uint64_t>::max()));
+    REQUIRE("2a 2A 52 101010" == HLIB_FORMAT("{:x} {:X} {:o} {:b}", 42, 42, 42, 42));
+    REQUIRE("0f" == HLIB_FORMAT("{:02x}", std::uint8_t(15)));
+    REQUIRE("-007" == HLIB_FORMAT("{:04}", -7));
+    REQUIRE("   7|7   " == HLIB_FORMAT("{:4}|{:<4}", 7, 7));
+    REQUIRE("foo  |  foo" == HLIB_FORMAT("{:5}|{:>5}", "foo", "foo"));
+    REQUIRE("fo" == HLIB_FORMAT("{:.2}", std::string("foo")));
+    REQUIRE("x 120" == HLIB_FORMAT("{} {:d}", 'x', 'x'));
+    REQUIRE("true false 1" == HLIB_FORMAT("{} {} {:d}", true, false, true));
+    REQUIRE("0.5 1.250 1.000000e+00" == HLIB_FORMAT("{} {:.3f} {:e}", 0.5, 1.25, 1.0));
+    REQUIRE("3.000" == HLIB_FORMAT("{:.3f}", 3));
+    REQUIRE("(null)" == HLIB_FORMAT("{}", static_cast<char const*>(nullptr)));
+    REQUIRE("foo" == HLIB_FORMAT("foo"));
+    REQUIRE("{}" == HLIB_FORMAT("{{}}"));
+
+    // Only string pointers are arguments, others do not decay to bool.
+    static_assert(false == std::is_constructible<FormatArgument, void*>::value);
+    static_assert(false == std::is_constructible<FormatArgument, int const*>::value);
+    static_assert(true == std::is_constructible<FormatArgument, char*>::value);
+    static_assert(true == std::is_constructible<FormatArgument, char const*>::value);
+
+    // Invalid format strings or argument counts produce an empty string.
+    REQUIRE(true == format("{}").empty());
+    REQUIRE(true == format("{", 1).empty());
+    REQUIRE(true == format("}", 1).empty());
+    REQUIRE(true == format("{}", 1, 2).empty());
+}
+
+TEST_CASE("Format To", "[format]")
+{
+    std::string string = "foo";
+    REQUIRE(true == HLIB_FORMAT_TO(string, " {}", "bar"));
+    REQUIRE("foo bar" == string);
+    REQUIRE(true == HLIB_FORMAT_TO(string, "!"));
+    REQUIRE("foo bar!" == string);
+
+    Buffer buffer;
+    REQUIRE(true == HLIB_FORMAT_TO(buffer, "{}-{}", 1, 2));
+    REQUIRE("1-2" == to_string(buffer));
+
+    auto sink = make_sink<std::string>(4);
+    REQUIRE(true == HLIB_FORMAT_TO(sink, "{}", 1234));
+    REQUIRE("1234" == sink.get());
+    REQUIRE(false == HLIB_FORMAT_TO(sink, "{}", 5));
+    REQUIRE("1234" == sink.get());
+
+    FormatBuffer<8> fixed;
+    REQUIRE(true == HLIB_FORMAT_TO(fixed, "{:04}", 42));
+    REQUIRE("0042" == fixed.view());
+    REQUIRE(false == HLIB_FORMAT_TO(fixed, "{}", 123456));
+    REQUIRE("00421234" == fixed.view());
+    REQUIRE(std::string("00421234") == fixed.c_str());
+
+    fixed.clear();
+    REQUIRE(true == fixed.empty());
+}
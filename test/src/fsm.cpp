@@ -96,3 +96,140 @@ TEST_CASE("FSM", "[fsm]")
     REQUIRE(Prev            == last_event);
 }
 
+
+TEST_CASE("FSM Apply All", "[fsm]")
+{
+    enum State
+    {
+        Begin,
+        Intermediate,
+        End
+    };
+
+    enum Event
+    {
+        Next,
+        Prev
+    };
+
+    std::size_t transitions = 0;
+    std::size_t invalid_transitions = 0;
+
+    FSM<State, Event> fsm(Begin, {
+            { Begin,        Next, Intermediate },
+            { Intermediate, Next, End },
+            { End,          Prev, Intermediate },
+            { Intermediate, Prev, Begin }
+        },
+        [&](State, Event, State, std::any const&) noexcept { ++transitions; },
+        [&](State, Event) noexcept { ++invalid_transitions; }
+    );
+
+    REQUIRE(2       == fsm.applyAll({ Next, Next, Next }));
+    REQUIRE(End     == fsm.state());
+    REQUIRE(2       == transitions);
+    REQUIRE(1       == invalid_transitions);
+
+    std::vector<Event> const events{ Prev, Prev };
+    REQUIRE(2       == fsm.applyAll(events));
+    REQUIRE(Begin   == fsm.state());
+    REQUIRE(4       == transitions);
+    REQUIRE(1       == invalid_transitions);
+}
+
+TEST_CASE("FSM Hierarchical", "[fsm]")
+{
+    enum State
+    {
+        Idle,
+        Connected,
+        Authenticating,
+        Streaming,
+        Closed
+    };
+
+    enum Event
+    {
+        Connect,
+        Authenticated,
+        Disconnect
+    };
+
+    FSM<State, Event> fsm(Idle, {
+        { Idle,             Connect,        Authenticating },
+        { Authenticating,   Authenticated,  Streaming },
+
+        // Shared by all sub-states of Connected.
+        { Connected,        Disconnect,     Closed }
+    });
+
+    REQUIRE(true            == fsm.setParent(Authenticating, Connected));
+    REQUIRE(true            == fsm.setParent(Streaming, Connected));
+
+    // Cycles are rejected.
+    REQUIRE(false           == fsm.setParent(Connected, Connected));
+    REQUIRE(false           == fsm.setParent(Connected, Streaming));
+    REQUIRE(true            == fsm.setParent(Connected, Idle));
+    REQUIRE(false           == fsm.setParent(Idle, Authenticating));
+
+    REQUIRE(false           == fsm.in(Connected));
+    REQUIRE(false           == fsm.apply(Disconnect));
+
+    REQUIRE(true            == fsm.apply(Connect));
+    REQUIRE(true            == fsm.in(Connected));
+    REQUIRE(true            == fsm.in(Authenticating));
+    REQUIRE(true            == fsm.apply(Disconnect));
+    REQUIRE(Closed          == fsm.state());
+
+    fsm.reset();
+    REQUIRE(2               == fsm.applyAll({ Connect, Authenticated }));
+    REQUIRE(Streaming       == fsm.state());
+    REQUIRE(true            == fsm.apply(Disconnect));
+    REQUIRE(Closed          == fsm.state());
+    REQUIRE(false           == fsm.in(Connected));
+}
+
+TEST_CASE("FSM Trace", "[fsm]")
+{
+    enum State
+    {
+        Off,
+        On
+    };
+
+    enum Event
+    {
+        Toggle,
+        Unused
+    };
+
+    FSM<State, Event, 2> fsm(Off, {
+        { Off,  Toggle, On },
+        { On,   Toggle, Off }
+    });
+
+    REQUIRE(true    == fsm.traces().empty());
+
+    REQUIRE(1       == fsm.applyAll({ Toggle, Unused }));
+
+    auto traces = fsm.traces();
+    REQUIRE(2       == traces.size());
+    REQUIRE(Off     == traces[0].from);
+    REQUIRE(Toggle  == traces[0].event);
+    REQUIRE(On      == traces[0].to);
+    REQUIRE(true    == traces[0].valid);
+    REQUIRE(On      == traces[1].from);
+    REQUIRE(Unused  == traces[1].event);
+    REQUIRE(false   == traces[1].valid);
+
+    // Ring buffer only keeps the most recent transitions.
+    REQUIRE(true    == fsm.apply(Toggle));
+    traces = fsm.traces();
+    REQUIRE(2       == traces.size());
+    REQUIRE(Unused  == traces[0].event);
+    REQUIRE(On      == traces[1].from);
+    REQUIRE(Off     == traces[1].to);
+
+    fsm.clearTraces();
+    REQUIRE(true    == fsm.traces().empty());
+}
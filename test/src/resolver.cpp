@@ -0,0 +1,377 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Maarten Hoeben
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "test.hpp"
+#include "hlib/event_loop.hpp"
+#include "hlib/file.hpp"
+#include "hlib/resolver.hpp"
+#include <arpa/inet.h>
+#include <map>
+#include <set>
+#include <sys/socket.h>
+
+using namespace hlib;
+
+namespace
+{
+
+// Minimal DNS server answering A and AAAA queries from a table.
+class StubServer final
+{
+public:
+    struct Answer
+    {
+        std::vector<std::string> addresses;
+        std::uint32_t ttl{ 60 };
+        std::uint16_t rcode{ 0 };
+        bool drop{ false };
+    };
+
+    std::map<std::string, Answer> answers;
+    SockAddr address;
+    unsigned queries{ 0 };
+    std::set<std::uint16_t> ports;
+
+    StubServer(std::shared_ptr<EventLoop> const& event_loop)
+        : m_event_loop(event_loop)
+        , m_fd(socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0), file::fd_close)
+    {
+        sockaddr_storage storage{};
+        socklen_t length = sizeof(storage);
+
+        address.parse("127.0.0.1:0");
+        REQUIRE(0 == bind(m_fd.get(), static_cast<sockaddr const*>(address), address.length()));
+        REQUIRE(0 == getsockname(m_fd.get(), reinterpret_cast<sockaddr*>(&storage), &length));
+        address = storage;
+
+        event_loop->add(m_fd.get(), EventLoop::Read, [this](int fd, std::uint32_t) {
+            onQuery(fd);
+        });
+    }
+
+    ~StubServer()
+    {
+        with_weak_ptr_locked(m_event_loop, [this](EventLoop& loop) {
+            loop.remove(m_fd.get());
+        });
+    }
+
+private:
+    std::weak_ptr<EventLoop> m_event_loop;
+    Handle<int, -1> m_fd;
+
+    void onQuery(int fd)
+    {
+        std::uint8_t data[512];
+        sockaddr_storage peer{};
+        socklen_t peer_length = sizeof(peer);
+
+        ssize_t const size = recvfrom(fd, data, sizeof(data), 0, reinterpret_cast<sockaddr*>(&peer), &peer_length);
+        REQUIRE(size > 12);
+        ++queries;
+        ports.insert(SockAddr(peer).port());
+
+        // Decode the question.
+        std::string name;
+        std::size_t offset = 12;
+        while (0 != data[offset]) {
+            if (false == name.empty()) {
+                name += '.';
+            }
+            name.append(reinterpret_cast<char const*>(data + offset + 1), data[offset]);
+            offset += 1 + data[offset];
+        }
+        offset += 1;
+
+        std::uint16_t const type = static_cast<std::uint16_t>((data[offset] << 8) | data[offset + 1]);
+        std::size_t const question_end = offset + 4;
+
+        auto it = answers.find(name + (1 == type ? "/A" : "/AAAA"));
+        Answer answer;
+        if (answers.end() != it) {
+            answer = it->second;
+        }
+        else {
+            answer.rcode = 3;
+        }
+
+        if (true == answer.drop) {
+            return;
+        }
+
+        // Echo the question and append the answers, compressing their
+        // names to the question's.
+        std::vector<std::uint8_t> response(data, data + question_end);
+        response[2] = 0x81;
+        response[3] = static_cast<std::uint8_t>(0x80 | answer.rcode);
+        response[6] = 0;
+        response[7] = static_cast<std::uint8_t>(answer.addresses.size());
+
+        for (std::string const& string : answer.addresses) {
+            std::uint8_t rdata[16];
+            std::uint8_t const length = 1 == type ? 4 : 16;
+            REQUIRE(1 == inet_pton(1 == type ? AF_INET : AF_INET6, string.c_str(), rdata));
+
+            std::uint8_t const record[] = {
+                0xc0, 0x0c,
+                0x00, static_cast<std::uint8_t>(type),
+                0x00, 0x01,
+                static_cast<std::uint8_t>(answer.ttl >> 24), static_cast<std::uint8_t>(answer.ttl >> 16),
+                static_cast<std::uint8_t>(answer.ttl >> 8), static_cast<std::uint8_t>(answer.ttl),
+                0x00, length
+            };
+            response.insert(response.end(), record, record + sizeof(record));
+            response.insert(response.end(), rdata, rdata + length);
+        }
+
+        sendto(fd, response.data(), response.size(), 0, reinterpret_cast<sockaddr*>(&peer), peer_length);
+    }
+};
+
+struct Resolved
+{
+    bool done{ false };
+    int error{ -1 };
+    std::vector<std::string> addresses;
+};
+
+Resolver::OnResolved on_resolved(Resolved& resolved, std::shared_ptr<EventLoop> const& event_loop)
+{
+    return [&resolved, event_loop](std::vector<SockAddr> const& addresses, int error) {
+        resolved.done = true;
+        resolved.error = error;
+        for (SockAddr const& address : addresses) {
+            resolved.addresses.push_back(to_string(address));
+        }
+        event_loop->interrupt();
+    };
+}
+
+} // namespace
+
+TEST_CASE("Resolver", "[resolver]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+
+    StubServer server(event_loop);
+    server.answers["host.example/A"].addresses = { "10.0.0.1", "10.0.0.2" };
+    server.answers["host.example/AAAA"].addresses = { "2001:db8::1" };
+
+    Resolver::Options options;
+    options.nameserver = server.address;
+    Resolver resolver(event_loop, options);
+
+    Resolved resolved;
+    resolver.resolve("host.example", 80, on_resolved(resolved, event_loop));
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE(true == resolved.done);
+    REQUIRE(0 == resolved.error);
+    REQUIRE(std::vector<std::string>{ "[2001:db8::1]:80", "10.0.0.1:80", "10.0.0.2:80" } == resolved.addresses);
+    REQUIRE(2 == server.queries);
+
+    // Each query has its own source port.
+    REQUIRE(2 == server.ports.size());
+
+    // Answered from the cache without querying the nameserver.
+    Resolved cached;
+    resolver.resolve("HOST.example.", 443, on_resolved(cached, event_loop), SockAddr::IPv4);
+    event_loop->flush();
+
+    REQUIRE(true == cached.done);
+    REQUIRE(std::vector<std::string>{ "10.0.0.1:443", "10.0.0.2:443" } == cached.addresses);
+    REQUIRE(2 == server.queries);
+
+    resolver.clearCache();
+
+    Resolved refreshed;
+    resolver.resolve("host.example", 443, on_resolved(refreshed, event_loop), SockAddr::IPv4);
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE(2 == refreshed.addresses.size());
+    REQUIRE(3 == server.queries);
+}
+
+TEST_CASE("Resolver TTL", "[resolver]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+
+    StubServer server(event_loop);
+    server.answers["short.example/A"].addresses = { "10.0.0.1" };
+    server.answers["short.example/A"].ttl = 0;
+
+    Resolver::Options options;
+    options.nameserver = server.address;
+    Resolver resolver(event_loop, options);
+
+    for (unsigned i = 1; i <= 2; ++i) {
+        Resolved resolved;
+        resolver.resolve("short.example", 80, on_resolved(resolved, event_loop), SockAddr::IPv4);
+        event_loop->dispatch(time::Sec(10));
+
+        REQUIRE(std::vector<std::string>{ "10.0.0.1:80" } == resolved.addresses);
+        REQUIRE(i == server.queries);
+    }
+}
+
+TEST_CASE("Resolver Errors", "[resolver]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+
+    StubServer server(event_loop);
+    server.answers["lost.example/A"].drop = true;
+    server.answers["failed.example/A"].rcode = 2;
+
+    Resolver::Options options;
+    options.nameserver = server.address;
+    options.timeout = time::MSec(20);
+    options.attempts = 2;
+    Resolver resolver(event_loop, options);
+
+    Resolved missing;
+    resolver.resolve("missing.example", 80, on_resolved(missing, event_loop));
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE(ENOENT == missing.error);
+    REQUIRE(true == missing.addresses.empty());
+
+    Resolved failed;
+    resolver.resolve("failed.example", 80, on_resolved(failed, event_loop), SockAddr::IPv4);
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE(EIO == failed.error);
+
+    server.queries = 0;
+
+    Resolved lost;
+    resolver.resolve("lost.example", 80, on_resolved(lost, event_loop), SockAddr::IPv4);
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE(ETIMEDOUT == lost.error);
+    REQUIRE(2 == server.queries);
+
+    Resolved invalid;
+    resolver.resolve("invalid..example", 80, on_resolved(invalid, event_loop));
+    event_loop->flush();
+
+    REQUIRE(EINVAL == invalid.error);
+
+    Resolved literal;
+    resolver.resolve("::1", 80, on_resolved(literal, event_loop));
+    event_loop->flush();
+
+    REQUIRE(0 == literal.error);
+    REQUIRE(std::vector<std::string>{ "[::1]:80" } == literal.addresses);
+}
+
+TEST_CASE("Resolver Connect", "[resolver]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+
+    StubServer server(event_loop);
+    server.answers["dual.example/A"].addresses = { "127.0.0.1" };
+    server.answers["dual.example/AAAA"].addresses = { "::1" };
+
+    // Listen on IPv4 only, so that the preferred IPv6 attempt fails.
+    Handle<int, -1> listener(socket(AF_INET, SOCK_STREAM, 0), file::fd_close);
+    SockAddr address("127.0.0.1:0");
+    REQUIRE(0 == bind(listener.get(), static_cast<sockaddr const*>(address), address.length()));
+    REQUIRE(0 == listen(listener.get(), 1));
+
+    sockaddr_storage storage{};
+    socklen_t length = sizeof(storage);
+    REQUIRE(0 == getsockname(listener.get(), reinterpret_cast<sockaddr*>(&storage), &length));
+    address = storage;
+
+    Resolver::Options options;
+    options.nameserver = server.address;
+    Resolver resolver(event_loop, options);
+
+    int error = -1;
+    std::string connected;
+
+    resolver.connect("dual.example", address.port(), SOCK_STREAM,
+        [&](Handle<int, -1> fd, SockAddr const& peer, int result) {
+            error = result;
+            connected = to_string(peer);
+            REQUIRE((0 == result) == (-1 != fd.get()));
+            event_loop->interrupt();
+        }
+    );
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE(0 == error);
+    REQUIRE(to_string(address) == connected);
+
+    error = -1;
+    resolver.connect("missing.example", address.port(), SOCK_STREAM,
+        [&](Handle<int, -1> fd, SockAddr const& /* peer */, int result) {
+            error = result;
+            REQUIRE(-1 == fd.get());
+            event_loop->interrupt();
+        }
+    );
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE(ENOENT == error);
+}
+
+TEST_CASE("Resolver Connect Lost AAAA", "[resolver]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+
+    StubServer server(event_loop);
+    server.answers["lost.example/A"].addresses = { "127.0.0.1" };
+    server.answers["lost.example/AAAA"].drop = true;
+
+    Handle<int, -1> listener(socket(AF_INET, SOCK_STREAM, 0), file::fd_close);
+    SockAddr address("127.0.0.1:0");
+    REQUIRE(0 == bind(listener.get(), static_cast<sockaddr const*>(address), address.length()));
+    REQUIRE(0 == listen(listener.get(), 1));
+
+    sockaddr_storage storage{};
+    socklen_t length = sizeof(storage);
+    REQUIRE(0 == getsockname(listener.get(), reinterpret_cast<sockaddr*>(&storage), &length));
+    address = storage;
+
+    Resolver::Options options;
+    options.nameserver = server.address;
+    Resolver resolver(event_loop, options);
+
+    // The A answer is used after the resolution delay, without waiting for
+    // the AAAA query to time out.
+    int error = -1;
+    time::TimePoint const start = time::now_ns();
+
+    resolver.connect("lost.example", address.port(), SOCK_STREAM,
+        [&](Handle<int, -1> /* fd */, SockAddr const& /* peer */, int result) {
+            error = result;
+            event_loop->interrupt();
+        }
+    );
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE(0 == error);
+    REQUIRE(time::now_ns() - start >= options.resolution_delay);
+    REQUIRE(time::now_ns() - start < time::DurationNs(time::MSec(500)));
+}
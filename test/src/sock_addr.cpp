@@ -23,6 +23,10 @@
 //
 #include "test.hpp"
 #include "hlib/sock_addr.hpp"
+#include <arpa/inet.h>
+#include <cstring>
+#include <random>
+#include <unordered_map>
 
 using namespace hlib;
 
@@ -54,3 +58,139 @@ TEST_CASE("SockAddr", "[sockaddr]")
     test(AF_INET6, "::ffff:192.168.1.251",         80, "[::ffff:192.168.1.251]:80");
 }
 
+
+TEST_CASE("SockAddr Parse", "[sockaddr]")
+{
+    // Parse from a view that is not zero terminated.
+    std::string_view const view = std::string_view("10.0.0.1:8080,10.0.0.2").substr(0, 13);
+    SockAddr sa(view);
+    REQUIRE(AF_INET == sa.family());
+    REQUIRE("10.0.0.1" == sa.address());
+    REQUIRE(8080 == sa.port());
+
+    REQUIRE(true == sa.parse("1:2:3:4:5:6:7:8", SockAddr::IPv6, std::nothrow));
+    REQUIRE("1:2:3:4:5:6:7:8" == sa.address());
+    REQUIRE(true == sa.parse("1::", SockAddr::IPv6, std::nothrow));
+    REQUIRE("1::" == sa.address());
+    REQUIRE(true == sa.parse("FE80:0:0:0:0:0:0:1", SockAddr::IPv6, std::nothrow));
+    REQUIRE("fe80::1" == sa.address());
+    REQUIRE(true == sa.parse("[::ffff:10.0.0.1]:65535", SockAddr::IPv6, std::nothrow));
+    REQUIRE(65535 == sa.port());
+
+    std::string_view const invalid[] = {
+        "1.2.3.256",
+        "01.2.3.4",
+        "1.2.3.4:65536",
+        "1.2.3.4:",
+        "1.2..4",
+        "1::2::3",
+        ":1::2",
+        "1:2:3:4:5:6:7:8:9",
+        "1:2:3:4:5:6:7::8",
+        "12345::1",
+        "::g",
+        "1:2:",
+        "::1.2.3.4.5",
+        "[::1]",
+        "[::1]:port"
+    };
+
+    for (std::string_view string : invalid) {
+        REQUIRE(false == sa.parse(string, SockAddr::IPv4 | SockAddr::IPv6, std::nothrow));
+        REQUIRE(true == sa.parse(string, SockAddr::All, std::nothrow));
+        REQUIRE(AF_UNIX == sa.family());
+    }
+}
+
+TEST_CASE("SockAddr Compare inet_pton/inet_ntop", "[sockaddr]")
+{
+    std::mt19937 random(1971);
+
+    for (int i = 0; i < 2000; ++i) {
+        // Random addresses with runs of zero words.
+        in6_addr addr;
+        for (int word = 0; word < 8; ++word) {
+            std::uint16_t const value = 0 == random() % 3 ? 0 : static_cast<std::uint16_t>(random() >> (random() % 16));
+            addr.s6_addr[word * 2] = static_cast<std::uint8_t>(value >> 8);
+            addr.s6_addr[word * 2 + 1] = static_cast<std::uint8_t>(value);
+        }
+        if (0 == random() % 4) {
+            memset(addr.s6_addr, 0, 10);
+            addr.s6_addr[10] = addr.s6_addr[11] = 0xff;
+        }
+
+        char expected[INET6_ADDRSTRLEN];
+        REQUIRE(nullptr != inet_ntop(AF_INET6, &addr, expected, sizeof(expected)));
+
+        sockaddr_in6 sin6{};
+        sin6.sin6_family = AF_INET6;
+        sin6.sin6_addr = addr;
+
+        SockAddr sa(sin6);
+        REQUIRE(expected == sa.address());
+
+        SockAddr parsed(expected);
+        REQUIRE(AF_INET6 == parsed.family());
+        REQUIRE(0 == memcmp(&addr, &static_cast<sockaddr_in6 const*>(parsed)->sin6_addr, sizeof(addr)));
+        REQUIRE(sa == parsed);
+
+        in_addr addr4;
+        addr4.s_addr = static_cast<std::uint32_t>(random());
+        REQUIRE(nullptr != inet_ntop(AF_INET, &addr4, expected, sizeof(expected)));
+
+        sockaddr_in sin{};
+        sin.sin_family = AF_INET;
+        sin.sin_addr = addr4;
+        REQUIRE(expected == SockAddr(sin).address());
+        REQUIRE(SockAddr(sin) == SockAddr(expected));
+    }
+}
+
+TEST_CASE("SockAddr Format", "[sockaddr]")
+{
+    char buffer[SockAddr::MaxStringSize];
+
+    SockAddr sa("[fe80::1b39:432b:a559:b42c]:443");
+    std::size_t const length = format_sock_addr(buffer, sizeof(buffer), sa);
+    REQUIRE("[fe80::1b39:432b:a559:b42c]:443" == std::string(buffer, length));
+    REQUIRE(length == strlen(buffer));
+
+    REQUIRE(length == format_sock_addr(buffer, length + 1, sa));
+    REQUIRE(0 == format_sock_addr(buffer, length, sa));
+    REQUIRE(0 == sa.address(buffer, 4));
+
+    REQUIRE(25 == sa.address(buffer, 26));
+    REQUIRE(0 == sa.address(buffer, 25));
+    REQUIRE("fe80::1b39:432b:a559:b42c" == std::string(buffer));
+    REQUIRE(15 == format_sock_addr(buffer, sizeof(buffer), SockAddr("255.255.255.255")));
+
+    sa.parse("/tmp/hlib.sock");
+    REQUIRE(AF_UNIX == sa.family());
+    REQUIRE(14 == format_sock_addr(buffer, sizeof(buffer), sa));
+    REQUIRE("/tmp/hlib.sock" == std::string(buffer));
+}
+
+TEST_CASE("SockAddr Hash", "[sockaddr]")
+{
+    REQUIRE(SockAddr("10.0.0.1:80") == SockAddr("10.0.0.1:80"));
+    REQUIRE(SockAddr("10.0.0.1:80") != SockAddr("10.0.0.1:81"));
+    REQUIRE(SockAddr("10.0.0.1:80") != SockAddr("10.0.0.2:80"));
+    REQUIRE(SockAddr("[::1]:80") == SockAddr("[0:0:0:0:0:0:0:1]:80"));
+    REQUIRE(SockAddr("[::1]:80") != SockAddr("::1"));
+    REQUIRE(SockAddr("/tmp/a") == SockAddr("/tmp/a"));
+    REQUIRE(SockAddr("/tmp/a") != SockAddr("/tmp/b"));
+    REQUIRE(SockAddr() == SockAddr());
+    REQUIRE(SockAddr() != SockAddr("10.0.0.1"));
+
+    REQUIRE(SockAddr("10.0.0.1:80").hash() == SockAddr("10.0.0.1:80").hash());
+    REQUIRE(SockAddr("10.0.0.1:80").hash() != SockAddr("10.0.0.1:81").hash());
+
+    std::unordered_map<SockAddr, int> peers;
+    for (int i = 0; i < 1000; ++i) {
+        ++peers[SockAddr(std::string("10.0.") + std::to_string(i / 250) + "." + std::to_string(i % 250) + ":80")];
+        ++peers[SockAddr(std::string("10.0.") + std::to_string(i / 250) + "." + std::to_string(i % 250) + ":80")];
+    }
+
+    REQUIRE(1000 == peers.size());
+    REQUIRE(2 == peers[SockAddr("10.0.3.249:80")]);
+}
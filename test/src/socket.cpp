@@ -23,8 +23,11 @@
 //
 #include "test.hpp"
 #include "hlib/buffer.hpp"
+#include "hlib/file.hpp"
 #include "hlib/socket.hpp"
 #include "hlib/string.hpp"
+#include <netinet/tcp.h>
+#include <sys/socket.h>
 
 using namespace hlib;
 
@@ -82,3 +85,138 @@ TEST_CASE("Socket Fixed Size", "[socket]")
     event_loop->dispatch();
 }
 
+
+TEST_CASE("Socket Options", "[socket]")
+{
+    auto get_option = [](int fd, int level, int option) {
+        int value = -1;
+        socklen_t length = sizeof(value);
+        REQUIRE(0 == getsockopt(fd, level, option, &value, &length));
+        return value;
+    };
+
+    auto event_loop = std::make_shared<EventLoop>();
+
+    SocketOptions options;
+    options.no_delay = true;
+    options.receive_buffer = 65536;
+    options.defer_accept = 1;
+    options.coalesce = true;
+
+    std::string received;
+
+    Socket server_connection(event_loop);
+    server_connection.receive(make_shared_sink<std::string>(9), [&](auto const& sink) {
+        received = get<std::string>(*sink);
+        event_loop->interrupt();
+    });
+
+    // Accepted sockets inherit the listener's options.
+    Socket server(event_loop);
+    server.setOptions(options);
+    server.listen(SockAddr("0.0.0.0:6502"), SOCK_STREAM, 0, 1, Socket::ReusePort);
+    server.setAcceptCallback([&](Handle<int, -1> fd, SockAddr const& /*address*/) {
+        REQUIRE(1 == get_option(fd.get(), IPPROTO_TCP, TCP_NODELAY));
+        REQUIRE(65536 <= get_option(fd.get(), SOL_SOCKET, SO_RCVBUF));
+        server_connection.open(std::move(fd));
+    });
+
+    REQUIRE(0 < get_option(server.fd(), IPPROTO_TCP, TCP_DEFER_ACCEPT));
+
+    // Coalesced sends arrive in order.
+    Socket client(event_loop);
+    client.setOptions(options);
+    client.connect(SockAddr("0.0.0.0:6502"), SOCK_STREAM, 0, 0);
+    client.send(make_shared_source<std::string>("one"));
+    client.send(make_shared_source<std::string>("two"));
+    client.send(make_shared_source<std::string>("three"));
+
+    REQUIRE(1 == get_option(client.fd(), IPPROTO_TCP, TCP_NODELAY));
+
+    SocketOptions corked;
+    corked.cork = true;
+    set_socket_options(client.fd(), corked);
+    REQUIRE(1 == get_option(client.fd(), IPPROTO_TCP, TCP_CORK));
+    corked.cork = false;
+    set_socket_options(client.fd(), corked);
+
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE("onetwothr" == received);
+}
+
+TEST_CASE("Socket Options Accept", "[socket]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+
+    // Connecting options do not apply to accepted sockets.
+    SocketOptions options;
+    options.fast_open_connect = true;
+    options.no_delay = true;
+
+    bool accepted = false;
+    bool closed = false;
+
+    Socket server(event_loop);
+    server.setOptions(options);
+    server.setCloseCallback([&](int /* error */) {
+        closed = true;
+        event_loop->interrupt();
+    });
+    server.listen(SockAddr("0.0.0.0:6502"), SOCK_STREAM, 0, 1, Socket::ReusePort);
+    server.setAcceptCallback([&](Handle<int, -1> fd, SockAddr const& /*address*/) {
+        accepted = -1 != fd.get();
+        event_loop->interrupt();
+    });
+
+    Socket client(event_loop);
+    client.setOptions(options);
+    client.connect(SockAddr("0.0.0.0:6502"), SOCK_STREAM, 0, 0);
+
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE(true == accepted);
+    REQUIRE(false == closed);
+    REQUIRE(-1 != server.fd());
+
+    // Nor to established connections.
+    REQUIRE(true == client.setOptions(options, std::nothrow).success());
+
+    // Nor to listening sockets.
+    REQUIRE(true == server.setOptions(options, std::nothrow).success());
+}
+
+TEST_CASE("Socket Options Connecting", "[socket]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+
+    // A listener that never accepts, so that once its backlog is full
+    // connects to it stay in progress.
+    Handle<int, -1> stalled(socket(AF_INET, SOCK_STREAM, 0), file::fd_close);
+    SockAddr address;
+    {
+        sockaddr_storage storage{};
+        socklen_t length = sizeof(storage);
+
+        address.parse("127.0.0.1:0");
+        REQUIRE(0 == bind(stalled.get(), static_cast<sockaddr const*>(address), address.length()));
+        REQUIRE(0 == ::listen(stalled.get(), 0));
+        REQUIRE(0 == getsockname(stalled.get(), reinterpret_cast<sockaddr*>(&storage), &length));
+        address = storage;
+    }
+    Handle<int, -1> backlog(socket(AF_INET, SOCK_STREAM, 0), file::fd_close);
+    REQUIRE(0 == ::connect(backlog.get(), static_cast<sockaddr const*>(address), address.length()));
+
+    Socket client(event_loop);
+    client.connect(address, SOCK_STREAM, 0, 0);
+    REQUIRE(false == client.connected());
+
+    // Listening and connecting options do not apply to connects in progress.
+    SocketOptions options;
+    options.fast_open_connect = true;
+    options.defer_accept = 1;
+    options.fast_open = 5;
+    options.no_delay = true;
+
+    REQUIRE(true == client.setOptions(options, std::nothrow).success());
+}
@@ -23,6 +23,7 @@
 //
 #include "test.hpp"
 #include "hlib/string.hpp"
+#include <cmath>
 #include <map>
 
 using namespace hlib;
@@ -225,6 +226,39 @@ TEST_CASE("String To", "[string]")
     REQUIRE_THROWS(string_to<double>("0.0 "));
 }
 
+TEST_CASE("String To View", "[string]")
+{
+    std::string_view const line = "Content-Length: 1234\r\n";
+    REQUIRE(1234 == stoui32(line.substr(16, 4)));
+    REQUIRE(1234 == string_to<int>(line.substr(16, 4), 10, std::nothrow).value());
+    REQUIRE(false == stoui32(line.substr(16, 5), 10, std::nothrow).has_value());
+
+    REQUIRE(  42 == stoi32("+42"));
+    REQUIRE(  42 == stoi32("052", 0));
+    REQUIRE(  42 == stoi32("0x2a", 0));
+    REQUIRE( -42 == stoi32("-0X2A", 16));
+    REQUIRE(0x2a == stoui32("2a", 16));
+    REQUIRE(   0 == stoui32("-0"));
+
+    REQUIRE(false == stoi32("", 10, std::nothrow).has_value());
+    REQUIRE(false == stoi32("-", 10, std::nothrow).has_value());
+    REQUIRE(false == stoi32("+-1", 10, std::nothrow).has_value());
+    REQUIRE(false == stoi32("0x", 16, std::nothrow).has_value());
+    REQUIRE(false == stoi32("1", 1, std::nothrow).has_value());
+    REQUIRE(false == stoui32("-1", 10, std::nothrow).has_value());
+    REQUIRE_THROWS_AS(stoui32("-1"), std::range_error);
+    REQUIRE_THROWS_AS(stoi64("99999999999999999999"), std::range_error);
+    REQUIRE_THROWS_AS(stoi64("9999999999999999999x"), std::invalid_argument);
+    REQUIRE_THROWS_AS(stoui64("18446744073709551616"), std::range_error);
+
+    REQUIRE(  0.5 == stof64("+0.5"));
+    REQUIRE(1.5e3 == stof64("1.5e3"));
+    REQUIRE(true == std::isinf(stof64("inf")));
+    REQUIRE(false == stof64("+-1", std::nothrow).has_value());
+    REQUIRE_THROWS_AS(stof32("1e99"), std::range_error);
+    REQUIRE_THROWS_AS(stof64("1e999"), std::range_error);
+}
+
 TEST_CASE("String C++20", "[string]")
 {
     REQUIRE(true  == starts_with("foobar", "foo"));
@@ -266,6 +300,21 @@ TEST_CASE("String Trim", "[string]")
     REQUIRE(true == trim(" \t\f\v\r\n").empty());
 }
 
+TEST_CASE("String Trim View", "[string]")
+{
+    REQUIRE("foo" == trim_view(" \tfoo\r\n"));
+    REQUIRE("foo bar" == trim_view(" \tfoo bar\r\n"));
+    REQUIRE("foo-bar" == trim_view("*#*foo-bar#*#", "#*-"));
+    REQUIRE(true == trim_view(" \t\f\v\r\n").empty());
+    REQUIRE("foo \n" == trim_left_view(" \tfoo \n"));
+    REQUIRE(" \tfoo" == trim_right_view(" \tfoo \n"));
+
+    std::string_view const line = "  Host: example.com  ";
+    std::string_view const trimmed = trim_view(line);
+    REQUIRE("Host: example.com" == trimmed);
+    REQUIRE(line.data() + 2 == trimmed.data());
+}
+
 TEST_CASE("String Fill", "[string]")
 {
     REQUIRE("foo   " == fill_right("foo", 6));
@@ -324,6 +373,35 @@ TEST_CASE("String Split", "[string]")
     REQUIRE(std::vector<std::string>{ "foo", "bar", "baz", "xxx", "yyy" } == tokens);
 }
 
+TEST_CASE("String Split View", "[string]")
+{
+    auto tokens = [](auto view) {
+        return std::vector<std::string>(view.begin(), view.end());
+    };
+
+    char const* strings[] = { "", "foo bar", "foo,bar,baz", "foo,bar,baz,", "foo,bar,,baz", ",foo,bar,baz", ",", ",,", "," };
+    for (char const* string : strings) {
+        REQUIRE(split(string, ',') == tokens(split_view(string, ',')));
+        REQUIRE(split(string, ',', true) == tokens(split_view(string, ',', true)));
+    }
+
+    REQUIRE(std::vector<std::string>{ "foo", "bar", "baz", "xxx", "yyy" } == tokens(split_view("foo bar\tbaz\nxxx\ryyy", IsSpace())));
+    REQUIRE(std::vector<std::string>{ "a", "b" } == tokens(split_view("a; b", [](char c) noexcept { return ';' == c || ' ' == c; }, true)));
+
+    // Exercise the block scan of IsSpace with delimiters on both sides of a 16 byte boundary.
+    std::string const string = "0123456789abcdef0123 456789abcdef\x80\xff\v0123456789abcde";
+    REQUIRE(std::vector<std::string>{ "0123456789abcdef0123", "456789abcdef\x80\xff", "0123456789abcde" } == tokens(split_view(string, IsSpace())));
+
+    std::string_view const line = "GET /index.html HTTP/1.1";
+    auto view = split_view(line, ' ');
+    auto it = view.begin();
+    REQUIRE("GET" == *it);
+    REQUIRE(line.data() == it->data());
+    REQUIRE("/index.html" == *++it);
+    REQUIRE("HTTP/1.1" == *++it);
+    REQUIRE(view.end() == ++it);
+}
+
 TEST_CASE("String Join", "[string]")
 {
     REQUIRE("foo bar" == join({ "foo", "bar" }, " "));
@@ -22,8 +22,14 @@
 // SOFTWARE.
 //
 #include "test.hpp"
+#include "hlib/container.hpp"
+#include "hlib/event_loop.hpp"
 #include "hlib/file.hpp"
 #include "hlib/subprocess.hpp"
+#include "hlib/string.hpp"
+#include <filesystem>
+#include <map>
+#include <thread>
 #include <unistd.h>
 
 using namespace hlib;
@@ -62,6 +68,44 @@ TEST_CASE("Subprocess Stdin to Stdout", "[subprocess]")
     REQUIRE(Subprocess::Exited == process->state());
 }
 
+TEST_CASE("Subprocess Command Not Found", "[subprocess]")
+{
+    Subprocess process;
+    Result<int> result = process.run("hlib-command-that-does-not-exist", {}, std::nothrow);
+    REQUIRE(true == result.failure());
+    REQUIRE(ENOENT == result.error().code().value());
+    REQUIRE(Subprocess::Failed == process.state());
+}
+
+TEST_CASE("Subprocess Close FDs", "[subprocess]")
+{
+    int const fd = 100;
+    REQUIRE(fd == dup2(STDIN_FILENO, fd));
+
+    auto list_fds = [](Subprocess& process)
+    {
+        process.run("ls", { "/proc/self/fd" });
+        return split(to_string(*process.output()), '\n', true);
+    };
+
+    Subprocess closed;
+    std::vector<std::string> fds = list_fds(closed);
+    REQUIRE(true == container::contains(fds, std::string("0")));
+    REQUIRE(false == container::contains(fds, std::string("100")));
+
+    Subprocess kept;
+    kept.setCloseFDs(true, { fd });
+    fds = list_fds(kept);
+    REQUIRE(true == container::contains(fds, std::string("100")));
+
+    Subprocess inherited;
+    inherited.setCloseFDs(false, {});
+    fds = list_fds(inherited);
+    REQUIRE(true == container::contains(fds, std::string("100")));
+
+    ::close(fd);
+}
+
 TEST_CASE("Subprocess EventLoop No Data", "[subprocess]")
 {
     auto event_loop = std::make_shared<EventLoop>();
@@ -97,3 +141,106 @@ TEST_CASE("Subprocess EventLoop With Data", "[subprocess]")
     REQUIRE("Hello world!" == to_string(result));
 }
 
+
+TEST_CASE("Subprocess Pool", "[subprocess]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+    SubprocessPool pool(event_loop, 2);
+    REQUIRE(pool.pid() > 0);
+    REQUIRE(2 == pool.maxRunning());
+
+    std::size_t completed = 0;
+    std::map<std::string, std::string> outputs;
+
+    auto on_completed = [&](std::string const& name, int expected)
+    {
+        return [&, name, expected](Result<int> const& return_code, Buffer& output, Buffer& /* error */)
+        {
+            REQUIRE(true == return_code.success());
+            REQUIRE(expected == return_code.value());
+            REQUIRE(pool.running() <= pool.maxRunning());
+
+            outputs[name] = to_string(output);
+            if (6 == ++completed) {
+                event_loop->interrupt();
+            }
+        };
+    };
+
+    for (int i = 0; i < 4; ++i) {
+        pool.run("echo", { std::to_string(i) }, on_completed("echo" + std::to_string(i), 0));
+    }
+    pool.run("cat", { "-" }, Buffer("Hello World!"), on_completed("cat", 0));
+    pool.run("sh", { "-c", "exit 3" }, on_completed("exit", 3));
+
+    REQUIRE(2 == pool.running());
+    REQUIRE(4 == pool.queued());
+
+    event_loop->dispatch(time::Sec(10));
+
+    REQUIRE(6 == completed);
+    REQUIRE(0 == pool.running());
+    REQUIRE(0 == pool.queued());
+    REQUIRE("0\n" == outputs["echo0"]);
+    REQUIRE("3\n" == outputs["echo3"]);
+    REQUIRE("Hello World!" == outputs["cat"]);
+    REQUIRE(true == outputs["exit"].empty());
+}
+
+TEST_CASE("Subprocess Pool Command Not Found", "[subprocess]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+    SubprocessPool pool(event_loop, 1);
+
+    int error = 0;
+    pool.run("hlib-command-that-does-not-exist", {}, [&](Result<int> const& return_code, Buffer& /* output */, Buffer& /* error */)
+    {
+        REQUIRE(true == return_code.failure());
+        error = return_code.error().code().value();
+        event_loop->interrupt();
+    });
+
+    event_loop->dispatch(time::Sec(10));
+    REQUIRE(ENOENT == error);
+}
+
+TEST_CASE("Subprocess Pool Event Loop Gone", "[subprocess]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+    SubprocessPool pool(event_loop, 2);
+    event_loop.reset();
+
+    std::string const filepath = (std::filesystem::temp_directory_path() / "hlib_subprocess_pool.gone").string();
+    std::filesystem::remove(filepath);
+
+    // Jobs complete with an error rather than staying pending, and without
+    // spawning the command.
+    int completed = 0;
+    for (int i = 0; i < 3; ++i) {
+        pool.run("touch", { filepath }, [&](Result<int> const& return_code, Buffer& /* output */, Buffer& /* error */) {
+            REQUIRE(true == return_code.failure());
+            REQUIRE(ENODEV == return_code.error().code().value());
+            ++completed;
+        });
+    }
+
+    REQUIRE(3 == completed);
+    REQUIRE(0 == pool.running());
+    REQUIRE(0 == pool.queued());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(false == std::filesystem::exists(filepath));
+}
+
+TEST_CASE("Subprocess Pool Arguments Too Long", "[subprocess]")
+{
+    auto event_loop = std::make_shared<EventLoop>();
+    SubprocessPool pool(event_loop, 1);
+
+    Result<> result = pool.run("echo", { std::string(64 * 1024, 'x') }, [](Result<int> const&, Buffer&, Buffer&) {
+        FAIL();
+    }, std::nothrow);
+    REQUIRE(true == result.failure());
+    REQUIRE(E2BIG == result.error().code().value());
+    REQUIRE(0 == pool.queued());
+}
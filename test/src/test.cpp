@@ -24,6 +24,11 @@
 #include "catch2/catch_test_macros.hpp"
 #include "test.hpp"
 #include "hlib/subprocess.hpp"
+#include <atomic>
+#include <new>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 using namespace hlib;
 
@@ -33,6 +38,104 @@ HLIB_TEST_CASE("foo,bar")
 {
 }
 
+namespace
+{
+
+// Only sleep and fail when run by the parallel test.
+bool parallel{ false };
+
+// Shared with the forked cases, to observe which of them run concurrently.
+struct Concurrency
+{
+    std::atomic<int> running{ 0 };
+    std::atomic<int> max_running{ 0 };
+    std::atomic<int> finished{ 0 };
+
+    // Running and finished cases seen by the serial case.
+    int serial_running{ -1 };
+    int serial_finished{ -1 };
+};
+
+Concurrency* concurrency{ nullptr };
+
+int run_parallel_case()
+{
+    if (nullptr == concurrency) {
+        return 0;
+    }
+
+    int const running = ++concurrency->running;
+
+    int max_running = concurrency->max_running;
+    while (running > max_running && false == concurrency->max_running.compare_exchange_weak(max_running, running)) {
+    }
+
+    int const result = usleep(100000);
+
+    --concurrency->running;
+    ++concurrency->finished;
+    return result;
+}
+
+} // namespace
+
+HLIB_TEST_CASE("parallel")
+{
+    HLIB_REQUIRE(0 == run_parallel_case());
+}
+
+HLIB_TEST_CASE("parallel")
+{
+    HLIB_REQUIRE(0 == run_parallel_case());
+}
+
+HLIB_TEST_CASE("parallel")
+{
+    HLIB_REQUIRE(0 == run_parallel_case());
+}
+
+HLIB_TEST_CASE("parallel")
+{
+    HLIB_REQUIRE(0 == run_parallel_case());
+}
+
+HLIB_TEST_CASE("parallel,!serial")
+{
+    if (nullptr != concurrency) {
+        concurrency->serial_running = concurrency->running;
+        concurrency->serial_finished = concurrency->finished;
+    }
+    HLIB_REQUIRE(0 == run_parallel_case());
+}
+
+HLIB_TEST_CASE("parallel_failure")
+{
+    HLIB_REQUIRE(false == parallel);
+}
+
+HLIB_TEST_CASE("parallel_failure")
+{
+    sleep(true == parallel ? 10 : 0);
+}
+
+HLIB_TEST_CASE("parallel_failure")
+{
+    if (true == parallel) {
+        kill(getpid(), SIGKILL);
+    }
+}
+
+HLIB_BENCHMARK("Test Benchmark", "[test]")
+{
+    std::uint64_t sum{ 0 };
+
+    state.setBytesProcessed(sizeof(sum));
+    while (true == state.keepRunning()) {
+        sum += state.iterations();
+        test::do_not_optimize(sum);
+    }
+}
+
 //
 // Scratch tests.
 //
@@ -41,6 +144,73 @@ TEST_CASE("Test")
     test::Suite::get().run();
 }
 
+TEST_CASE("Parallel", "[test]")
+{
+    parallel = true;
+
+    void* memory = mmap(nullptr, sizeof(Concurrency), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    REQUIRE(MAP_FAILED != memory);
+    concurrency = new (memory) Concurrency();
+
+    test::Suite::RunOptions options;
+    options.jobs = 4;
+    options.timeout = time::MSec(5000);
+
+    test::Suite::get().run({ "parallel" }, options);
+
+    test::Suite::Statistics statistics = test::Suite::get().statistics;
+    REQUIRE(5 == statistics.cases);
+    REQUIRE(0 == statistics.cases_failed);
+    REQUIRE(5 == statistics.assertions);
+    REQUIRE(0 == statistics.assertions_failed);
+
+    // Up to four concurrent cases followed by the non parallel case alone,
+    // instead of five cases in sequence.
+    REQUIRE(1 < concurrency->max_running);
+    REQUIRE(4 >= concurrency->max_running);
+    REQUIRE(0 == concurrency->serial_running);
+    REQUIRE(4 == concurrency->serial_finished);
+
+    concurrency->~Concurrency();
+    munmap(memory, sizeof(Concurrency));
+    concurrency = nullptr;
+
+    // Failed, timed out and crashed cases.
+    options.timeout = time::MSec(200);
+    test::Suite::get().run({ "parallel_failure" }, options);
+
+    statistics = test::Suite::get().statistics;
+    REQUIRE(3 == statistics.cases);
+    REQUIRE(3 == statistics.cases_failed);
+
+    parallel = false;
+}
+
+TEST_CASE("Benchmark", "[test]")
+{
+    test::BenchmarkOptions options;
+    options.warmup = time::MSec(1);
+    options.min_time = time::MSec(10);
+
+    std::size_t reported{ 0 };
+    std::vector<test::BenchmarkResult> results = test::Suite::get().benchmark({ "Test Benchmark" }, options,
+        [&](test::BenchmarkResult const&) noexcept { ++reported; });
+
+    REQUIRE(1 == results.size());
+    REQUIRE(1 == reported);
+    REQUIRE("Test Benchmark" == results[0].name);
+    REQUIRE(results[0].iterations > 0);
+    REQUIRE(results[0].ns_per_op > 0);
+    REQUIRE(results[0].bytes_per_second > 0);
+
+    REQUIRE(1 == test::Suite::get().benchmark({ "[test]" }, options).size());
+    REQUIRE(true == test::Suite::get().benchmark({ "Unknown" }, options).empty());
+
+    std::string const json = test::to_json(results);
+    REQUIRE(std::string::npos != json.find("\"name\": \"Test Benchmark\""));
+    REQUIRE(std::string::npos != test::to_string(results[0]).find("ns/op"));
+}
+
 //
 // Public
 //
@@ -23,6 +23,9 @@
 //
 #include "test.hpp"
 #include "hlib/time.hpp"
+#include <array>
+#include <cstdio>
+#include <thread>
 
 using namespace hlib;
 
@@ -61,3 +64,119 @@ TEST_CASE("Clock UTC Strings", "[time]")
     REQUIRE(iso8601 == to_string_local(time::to_clock(iso8601)));
 }
 
+TEST_CASE("ISO8601", "[time]")
+{
+    std::array<char, time::ISO8601::MaxSize> buffer;
+    auto format = [&](time::Clock const& clock, int fields) {
+        return std::string(buffer.data(), time::format_iso8601(buffer.data(), buffer.size(), clock, fields));
+    };
+
+    time::Clock const clock(1709217045, 123456789);
+    int const all = time::ISO8601::Date | time::ISO8601::Time | time::ISO8601::Utc;
+
+    REQUIRE("2024-02-29T14:30:45Z" == format(clock, all));
+    REQUIRE("2024-02-29T14:30:45.123Z" == format(clock, all | time::ISO8601::Milliseconds));
+    REQUIRE("2024-02-29T14:30:45.123456Z" == format(clock, all | time::ISO8601::Microseconds));
+    REQUIRE("14:30:45Z" == format(clock, time::ISO8601::Time | time::ISO8601::Utc));
+    REQUIRE("1970-01-01Z" == format(time::Clock(0, 0), time::ISO8601::Date | time::ISO8601::Utc));
+    REQUIRE(0 == time::format_iso8601(buffer.data(), 10, clock, all));
+
+    // Local time matches localtime_r(), also across cached seconds.
+    for (std::time_t secs : { 1709217045L, 1709217045L, 1709217046L, 1719792000L }) {
+        struct tm time_info;
+        localtime_r(&secs, &time_info);
+
+        char expected[32];
+        std::size_t size = strftime(expected, sizeof(expected), "%Y-%m-%dT%H:%M:%S", &time_info);
+        long const offset = (time_info.tm_gmtoff >= 0 ? time_info.tm_gmtoff : -time_info.tm_gmtoff) / 60;
+        snprintf(expected + size, sizeof(expected) - size, "%c%02ld:%02ld", time_info.tm_gmtoff >= 0 ? '+' : '-', offset / 60, offset % 60);
+
+        REQUIRE(expected == format(time::Clock(secs, 0), time::ISO8601::Date | time::ISO8601::Time));
+        REQUIRE(time::Clock(secs, 0) == time::to_clock(expected));
+    }
+
+    REQUIRE(time::Clock(1709217045, 0) == time::to_clock("2024-02-29T14:30:45Z"));
+    REQUIRE(time::Clock(1709217045, 0) == time::to_clock("2024-02-29T14:30:45"));
+    REQUIRE(time::Clock(1709217045, 123000000) == time::to_clock("2024-02-29T14:30:45.123Z"));
+    REQUIRE(time::Clock(1709217045, 123456789) == time::to_clock("2024-02-29T14:30:45.123456789Z"));
+    REQUIRE(time::Clock(1709217045, 0) == time::to_clock("2024-02-29T16:00:45+01:30"));
+    REQUIRE(time::Clock(1709217045, 0) == time::to_clock("2024-02-29T09:30:45-0500"));
+    REQUIRE(time::Clock(1709164800, 0) == time::to_clock("2024-02-29"));
+    REQUIRE(time::Clock(-86400, 0) == time::to_clock("1969-12-31"));
+
+    for (char const* invalid : { "", "2024", "2023-02-29", "2024-13-01", "2024-02-29T24:00:00Z",
+            "2024-02-29T14:30", "2024-02-29T14:30:45.Z", "2024-02-29T14:30:45+1", "2024-02-29T14:30:45Zx" }) {
+        REQUIRE(true == time::to_clock(invalid, std::nothrow).failure());
+    }
+    REQUIRE_THROWS_AS(time::to_clock("invalid"), std::logic_error);
+}
+
+TEST_CASE("DurationNs", "[time]")
+{
+    constexpr time::DurationNs d1(time::MSec(1234));
+    static_assert(1234000000 == d1.count());
+    static_assert(1234 == d1.to<time::MSec>().value());
+    static_assert(time::DurationNs(1, 500) - time::DurationNs(0, 1000) == time::DurationNs(999999500));
+
+    constexpr std::timespec ts = (-d1).toTimespec();
+    static_assert(-2 == ts.tv_sec && 766000000 == ts.tv_nsec);
+
+    time::Duration const d2 = d1;
+    REQUIRE(1 == d2.tv_sec);
+    REQUIRE(234000000 == d2.tv_nsec);
+    REQUIRE(d1 == time::DurationNs(d2));
+    REQUIRE(d1 * 2 == time::DurationNs(time::Sec(2)) + time::DurationNs(time::MSec(468)));
+}
+
+TEST_CASE("TimePoint", "[time]")
+{
+    constexpr time::TimePoint t1(time::DurationNs(time::Sec(10)).count());
+    constexpr time::TimePoint t2 = t1 + time::DurationNs(time::USec(1));
+    static_assert(1000 == (t2 - t1).count());
+    static_assert(t1 < t2);
+
+    time::Clock const now = time::now();
+    time::TimePoint const point = now;
+    time::Clock const clock = point;
+    REQUIRE(now == clock);
+
+    time::TimePoint const before = time::now_ns();
+    REQUIRE(before <= time::TimePoint(time::now()));
+}
+
+TEST_CASE("Fast Now", "[time]")
+{
+    time::Clock previous = time::fast_now();
+
+    for (int i = 0; i < 100; ++i) {
+        time::Clock const before = time::now();
+        time::Clock const fast = time::fast_now();
+        time::Clock const after = time::now();
+
+        // Within calibration error of CLOCK_MONOTONIC.
+        REQUIRE(fast >= before - time::Duration(time::USec(100)));
+        REQUIRE(fast <= after + time::Duration(time::USec(100)));
+        REQUIRE(fast >= previous);
+        previous = fast;
+
+        if (0 == i % 10) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+TEST_CASE("Fast Now Anchor", "[time]")
+{
+    time::Clock const previous = time::fast_now();
+
+    // Past the re-anchor period, fast_now() tracks CLOCK_MONOTONIC again.
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+    time::Clock const before = time::now();
+    time::Clock const fast = time::fast_now();
+    time::Clock const after = time::now();
+
+    REQUIRE(fast >= previous);
+    REQUIRE(fast >= before - time::Duration(time::USec(100)));
+    REQUIRE(fast <= after + time::Duration(time::USec(100)));
+}
@@ -149,6 +149,61 @@ TEST_CASE("URI Wikipedia Examples", "[uri]")
     REQUIRE("urn:oasis:names:specification:docbook:dtd:xml:4.1.2" == to_string(uri));
 }
 
+TEST_CASE("URI View", "[uri]")
+{
+    std::string const string = "http://user@example.com:8080/a/b?x=1&y=2#frag";
+    URIView view = uri_parse_view(string);
+    REQUIRE("http" == view.scheme);
+    REQUIRE("user" == view.user_info);
+    REQUIRE("example.com" == view.host);
+    REQUIRE(8080 == view.port);
+    REQUIRE("/a/b" == view.path);
+    REQUIRE("x=1&y=2" == view.query);
+    REQUIRE("frag" == view.fragment);
+    REQUIRE(string.data() + 7 == view.user_info.data());
+
+    URI uri(view);
+    REQUIRE(string == to_string(uri));
+
+    view = uri_parse_view("/path?query?more#frag#ment");
+    REQUIRE(true == view.scheme.empty());
+    REQUIRE(true == view.host.empty());
+    REQUIRE("/path" == view.path);
+    REQUIRE("query?more" == view.query);
+    REQUIRE("frag#ment" == view.fragment);
+
+    view = uri_parse_view("http://host:/#");
+    REQUIRE("host:" == view.host);
+    REQUIRE(80 == view.port);
+    REQUIRE("/" == view.path);
+    REQUIRE(true == view.query.empty());
+    REQUIRE(true == view.fragment.empty());
+
+    view = uri_parse_view("");
+    REQUIRE(true == view.scheme.empty());
+    REQUIRE("/" == view.path);
+
+    view = uri_parse_view(":foo");
+    REQUIRE(true == view.scheme.empty());
+    REQUIRE(":foo" == view.path);
+}
+
+TEST_CASE("URI Encoding", "[uri]")
+{
+    REQUIRE("foo-bar_baz.~" == uri_encoding_escape("foo-bar_baz.~"));
+    REQUIRE("a%20b%2Fc%3F%FF" == uri_encoding_escape("a b/c?\xff"));
+    REQUIRE("a b/c?\xff" == uri_encoding_unescape("a%20b%2Fc%3f%FF"));
+    REQUIRE("abc" == uri_encoding_unescape("abc"));
+    REQUIRE("ab" == uri_encoding_unescape("ab%2"));
+    REQUIRE("ab" == uri_encoding_unescape("ab%zz"));
+
+    std::string binary;
+    for (int c = 0; c < 256; ++c) {
+        binary += static_cast<char>(c);
+    }
+    REQUIRE(binary == uri_encoding_unescape(uri_encoding_escape(binary)));
+}
+
 TEST_CASE("URI Target Utilities", "[uri]")
 {
     REQUIRE("path" == target_get_path("path"));
@@ -175,4 +230,3 @@ TEST_CASE("URI Target Utilities", "[uri]")
     REQUIRE("fragment" == target_get_fragment("?query#fragment"));
     REQUIRE("fragment" == target_get_fragment("#fragment"));
 }
-